@@ -1,6 +1,11 @@
 #include "application.h"
 #include "src/utils/global.h"
 
+#include <algorithm>
+#include <chrono>
+#include <limits>
+#include <random>
+
 namespace webgpu {
 
 bool Application::Initialize() {
@@ -43,24 +48,42 @@ void Application::InitInstance(){
 	// 获取 device
 	LOG("Requesting device...\n");
 	wgpu::RequiredLimits requiredLimits = wgpu::Default;
-	requiredLimits.limits.maxVertexAttributes = 3;
+	requiredLimits.limits.maxVertexAttributes = 4;
 	requiredLimits.limits.maxVertexBuffers = 1;
-	requiredLimits.limits.maxBufferSize = 100000 * sizeof(VertexAttributes);
+	requiredLimits.limits.maxBufferSize = std::min<uint64_t>(supportedLimits.limits.maxBufferSize, 256ull << 20);
 	requiredLimits.limits.maxVertexBufferArrayStride = sizeof(VertexAttributes);
 	requiredLimits.limits.minStorageBufferOffsetAlignment = supportedLimits.limits.minStorageBufferOffsetAlignment;
 	requiredLimits.limits.minUniformBufferOffsetAlignment = supportedLimits.limits.minUniformBufferOffsetAlignment;
-	requiredLimits.limits.maxInterStageShaderComponents = 6;
+	// 颜色、法向量、纹理坐标、世界空间位置和视图深度
+	requiredLimits.limits.maxInterStageShaderComponents = 12;
 	requiredLimits.limits.maxBindGroups = 1;
-	requiredLimits.limits.maxUniformBuffersPerShaderStage = 1;
-	requiredLimits.limits.maxUniformBufferBindingSize = 16 * 4 * sizeof(float);
-	requiredLimits.limits.maxTextureDimension1D = wgpuGLFWWindow.window_size.width;
-	requiredLimits.limits.maxTextureDimension2D = wgpuGLFWWindow.window_size.height;
-	requiredLimits.limits.maxTextureArrayLayers = 1;
+	// 片元着色器同时使用全局 uniform、虚拟纹理参数、分簇参数和阴影参数
+	requiredLimits.limits.maxUniformBuffersPerShaderStage = 4;
+	requiredLimits.limits.maxUniformBufferBindingSize = std::max({ sizeof(Uniform), sizeof(LightClusterUniform), sizeof(ShadowUniform), sizeof(OcclusionCullUniform) });
+	// 纹理尺寸限制取适配器支持的上限，与窗口尺寸无关（窗口可以缩放）
+	requiredLimits.limits.maxTextureDimension1D = supportedLimits.limits.maxTextureDimension1D;
+	// 2D 纹理既要容纳深度缓冲区，也要容纳加载的贴图
+	requiredLimits.limits.maxTextureDimension2D = supportedLimits.limits.maxTextureDimension2D;
+	// 级联阴影贴图每级一层
+	requiredLimits.limits.maxTextureArrayLayers = ShadowRenderer::kCascadeCount;
 	
 	wgpu::DeviceDescriptor deviceDesc = {};
 	deviceDesc.nextInChain = nullptr;
 	deviceDesc.label = "Physical Device"; // <--  随便命名
-	deviceDesc.requiredFeatureCount = 0; // <--  没有特殊需求
+	// 间接绘制使用非 0 的 firstInstance 需要该特性（meshlet 剔除按实例间接绘制）
+	std::vector<wgpu::FeatureName> requiredFeatures;
+	if (adapter.hasFeature(wgpu::FeatureName::IndirectFirstInstance)) {
+		requiredFeatures.push_back(wgpu::FeatureName::IndirectFirstInstance);
+		indirectFirstInstanceSupported = true;
+	}
+	// 烘焙纹理的 BC7/ETC2 载荷需要对应的块压缩特性，都没有时纹理管理器在 CPU 上转码为 RGBA8
+	for (wgpu::FeatureName feature : { wgpu::FeatureName::TextureCompressionBC, wgpu::FeatureName::TextureCompressionETC2 }) {
+		if (adapter.hasFeature(feature)) {
+			requiredFeatures.push_back(feature);
+		}
+	}
+	deviceDesc.requiredFeatureCount = requiredFeatures.size();
+	deviceDesc.requiredFeatures = (WGPUFeatureName*)requiredFeatures.data();
 	deviceDesc.requiredLimits = &requiredLimits; // <--  限制条件
 	deviceDesc.defaultQueue.nextInChain = nullptr;
 	deviceDesc.defaultQueue.label = "The default queue";
@@ -97,14 +120,7 @@ void Application::InitInstance(){
 	if(swapChainFormat == wgpu::TextureFormat::Undefined){
 		std::cerr << "surface.getPreferredFormat(adapter) == wgpu::TextureFormat::Undefined" << '\n';
 	}
-	wgpu::SwapChainDescriptor swapChainDesc;
-	swapChainDesc.width = wgpuGLFWWindow.window_size.width;
-	swapChainDesc.height = wgpuGLFWWindow.window_size.height;
-	swapChainDesc.usage = wgpu::TextureUsage::RenderAttachment;
-	swapChainDesc.format = swapChainFormat;
-	swapChainDesc.presentMode = wgpu::PresentMode::Fifo;
-	swapChain = device.createSwapChain(surface, swapChainDesc);
-	LOG("Swapchain %p\n", static_cast<void*>(&swapChain));
+	CreateSwapChain();
 	LOG("Creating shader module...\n");
 	shaderModule = loadShaderModule(shaderCodeFilePath, device);
 	LOG("shader module %p\n", static_cast<void*>(&shaderModule));
@@ -158,30 +174,58 @@ void Application::InitializePipeline(){
 	wgpu::RenderPipelineDescriptor pipelineDesc = {};
 
 	// 获取顶点属性
-	std::vector<wgpu::VertexAttribute> vertexAttribs(3);
-
-	// 位置属性
-	vertexAttribs[0].shaderLocation = 0;
-	vertexAttribs[0].format = wgpu::VertexFormat::Float32x3;
-	vertexAttribs[0].offset = 0;
-
-	// 法向量属性
-	vertexAttribs[1].shaderLocation = 1;
-	vertexAttribs[1].format = wgpu::VertexFormat::Float32x3;
-	vertexAttribs[1].offset = offsetof(VertexAttributes, normal);
-
-	// 颜色属性
-	vertexAttribs[2].shaderLocation = 2;
-	vertexAttribs[2].format = wgpu::VertexFormat::Float32x3;
-	vertexAttribs[2].offset = offsetof(VertexAttributes, color);
+	std::vector<wgpu::VertexAttribute> vertexAttribs(4);
+
+	if (useCompactVertexFormat) {
+		// 紧凑格式：位置 Snorm16x4（着色器中反量化），法向量八面体编码 Snorm16x2，颜色 Unorm8x4，纹理坐标 Float16x2
+		vertexAttribs[0].shaderLocation = 0;
+		vertexAttribs[0].format = wgpu::VertexFormat::Snorm16x4;
+		vertexAttribs[0].offset = offsetof(CompactVertexAttributes, position);
+
+		vertexAttribs[1].shaderLocation = 1;
+		vertexAttribs[1].format = wgpu::VertexFormat::Snorm16x2;
+		vertexAttribs[1].offset = offsetof(CompactVertexAttributes, normal);
+
+		vertexAttribs[2].shaderLocation = 2;
+		vertexAttribs[2].format = wgpu::VertexFormat::Unorm8x4;
+		vertexAttribs[2].offset = offsetof(CompactVertexAttributes, color);
+
+		vertexAttribs[3].shaderLocation = 3;
+		vertexAttribs[3].format = wgpu::VertexFormat::Float16x2;
+		vertexAttribs[3].offset = offsetof(CompactVertexAttributes, uv);
+	} else {
+		// 位置属性
+		vertexAttribs[0].shaderLocation = 0;
+		vertexAttribs[0].format = wgpu::VertexFormat::Float32x3;
+		vertexAttribs[0].offset = 0;
+
+		// 法向量属性
+		vertexAttribs[1].shaderLocation = 1;
+		vertexAttribs[1].format = wgpu::VertexFormat::Float32x3;
+		vertexAttribs[1].offset = offsetof(VertexAttributes, normal);
+
+		// 颜色属性
+		vertexAttribs[2].shaderLocation = 2;
+		vertexAttribs[2].format = wgpu::VertexFormat::Float32x3;
+		vertexAttribs[2].offset = offsetof(VertexAttributes, color);
+
+		// 纹理坐标属性
+		vertexAttribs[3].shaderLocation = 3;
+		vertexAttribs[3].format = wgpu::VertexFormat::Float32x2;
+		vertexAttribs[3].offset = offsetof(VertexAttributes, uv);
+	}
 
 	wgpu::VertexBufferLayout vertexBufferLayout = {};
 	vertexBufferLayout.attributeCount = (uint32_t)vertexAttribs.size();
 	vertexBufferLayout.attributes = vertexAttribs.data();
-	vertexBufferLayout.arrayStride = sizeof(VertexAttributes);
+	vertexBufferLayout.arrayStride = useCompactVertexFormat ? sizeof(CompactVertexAttributes) : sizeof(VertexAttributes);
 
 	vertexBufferLayout.stepMode = wgpu::VertexStepMode::Vertex;
 
+	// 只含位置的顶点流的格式（深度预通道和阴影使用）
+	positionStride = useCompactVertexFormat ? sizeof(CompactVertexAttributes::position) : sizeof(glm::vec3);
+	positionFormat = useCompactVertexFormat ? wgpu::VertexFormat::Snorm16x4 : wgpu::VertexFormat::Float32x3;
+
 	// 使用一个顶点缓冲区
 	pipelineDesc.vertex.bufferCount = 1;
 	pipelineDesc.vertex.buffers = &vertexBufferLayout;
@@ -189,8 +233,12 @@ void Application::InitializePipeline(){
 	// 指定可编程顶点着色器阶段由着色器模块中的 `vs_main` 函数描述
 	pipelineDesc.vertex.module = shaderModule;
 	pipelineDesc.vertex.entryPoint = "vs_main";
-	pipelineDesc.vertex.constantCount = 0;
-	pipelineDesc.vertex.constants = nullptr;
+	// 通过 override 常量告诉着色器顶点格式
+	wgpu::ConstantEntry vertexConstant = wgpu::Default;
+	vertexConstant.key = "compactVertex";
+	vertexConstant.value = useCompactVertexFormat ? 1.0 : 0.0;
+	pipelineDesc.vertex.constantCount = 1;
+	pipelineDesc.vertex.constants = &vertexConstant;
 
 	// 每三个顶点构成一个三角形
 	pipelineDesc.primitive.topology = wgpu::PrimitiveTopology::TriangleList;
@@ -208,23 +256,18 @@ void Application::InitializePipeline(){
 	wgpu::FragmentState fragmentState;
 	fragmentState.module = shaderModule;
 	fragmentState.entryPoint = "fs_main";
-	fragmentState.constantCount = 0;
-	fragmentState.constants = nullptr;
+	// 漫反射贴图是否走虚拟纹理
+	wgpu::ConstantEntry fragmentConstant = wgpu::Default;
+	fragmentConstant.key = "virtualTexture";
+	fragmentConstant.value = useVirtualTexture ? 1.0 : 0.0;
+	fragmentState.constantCount = 1;
+	fragmentState.constants = &fragmentConstant;
 	pipelineDesc.fragment = &fragmentState;
 
-	// 设置混合状态
-	wgpu::BlendState blendState{};
-	blendState.color.srcFactor = wgpu::BlendFactor::SrcAlpha;
-	blendState.color.dstFactor = wgpu::BlendFactor::OneMinusSrcAlpha;
-	blendState.color.operation = wgpu::BlendOperation::Add;
-	blendState.alpha.srcFactor = wgpu::BlendFactor::Zero;
-	blendState.alpha.dstFactor = wgpu::BlendFactor::One;
-	blendState.alpha.operation = wgpu::BlendOperation::Add;
-	
-	// 颜色目标状态
+	// 颜色目标状态：主管线只画不透明物体，不混合（透明物体在单独的 OIT 通道中绘制）
 	wgpu::ColorTargetState colorTarget;
 	colorTarget.format = swapChainFormat;
-	colorTarget.blend = &blendState;
+	colorTarget.blend = nullptr;
 	colorTarget.writeMask = wgpu::ColorWriteMask::All; // 可以选择性地写入颜色通道
 	
 	// 我们的渲染通道只有一个输出颜色附件
@@ -235,7 +278,6 @@ void Application::InitializePipeline(){
 	wgpu::DepthStencilState depthStencilState = wgpu::Default;
 	depthStencilState.depthCompare = wgpu::CompareFunction::Less;
 	depthStencilState.depthWriteEnabled = true;
-	wgpu::TextureFormat depthTextureFormat = wgpu::TextureFormat::Depth24Plus;
 	depthStencilState.format = depthTextureFormat;
 	depthStencilState.stencilReadMask = 0;
 	depthStencilState.stencilWriteMask = 0;
@@ -252,16 +294,91 @@ void Application::InitializePipeline(){
 	pipelineDesc.multisample.alphaToCoverageEnabled = false;
 
 	// 创建绑定布局
-	wgpu::BindGroupLayoutEntry bindingLayout = wgpu::Default;
+	std::vector<wgpu::BindGroupLayoutEntry> bindingLayoutEntries(15, wgpu::Default);
+	wgpu::BindGroupLayoutEntry& bindingLayout = bindingLayoutEntries[0];
 	bindingLayout.binding = 0;
 	bindingLayout.visibility = wgpu::ShaderStage::Vertex | wgpu::ShaderStage::Fragment;
 	bindingLayout.buffer.type = wgpu::BufferBindingType::Uniform;
 	bindingLayout.buffer.minBindingSize = sizeof(Uniform);
 
+	// 实例数据
+	wgpu::BindGroupLayoutEntry& instanceBindingLayout = bindingLayoutEntries[1];
+	instanceBindingLayout.binding = 1;
+	instanceBindingLayout.visibility = wgpu::ShaderStage::Vertex;
+	instanceBindingLayout.buffer.type = wgpu::BufferBindingType::ReadOnlyStorage;
+	instanceBindingLayout.buffer.minBindingSize = sizeof(InstanceData);
+
+	// 漫反射贴图
+	wgpu::BindGroupLayoutEntry& textureBindingLayout = bindingLayoutEntries[2];
+	textureBindingLayout.binding = 2;
+	textureBindingLayout.visibility = wgpu::ShaderStage::Fragment;
+	textureBindingLayout.texture.sampleType = wgpu::TextureSampleType::Float;
+	textureBindingLayout.texture.viewDimension = wgpu::TextureViewDimension::_2D;
+
+	// 采样器
+	wgpu::BindGroupLayoutEntry& samplerBindingLayout = bindingLayoutEntries[3];
+	samplerBindingLayout.binding = 3;
+	samplerBindingLayout.visibility = wgpu::ShaderStage::Fragment;
+	samplerBindingLayout.sampler.type = wgpu::SamplerBindingType::Filtering;
+
+	// 虚拟纹理：间接纹理、物理页图集、参数、反馈位图
+	wgpu::BindGroupLayoutEntry& pageTableBindingLayout = bindingLayoutEntries[4];
+	pageTableBindingLayout.binding = 4;
+	pageTableBindingLayout.visibility = wgpu::ShaderStage::Fragment;
+	pageTableBindingLayout.texture.sampleType = wgpu::TextureSampleType::Uint;
+	pageTableBindingLayout.texture.viewDimension = wgpu::TextureViewDimension::_2D;
+
+	wgpu::BindGroupLayoutEntry& pageAtlasBindingLayout = bindingLayoutEntries[5];
+	pageAtlasBindingLayout.binding = 5;
+	pageAtlasBindingLayout.visibility = wgpu::ShaderStage::Fragment;
+	pageAtlasBindingLayout.texture.sampleType = wgpu::TextureSampleType::Float;
+	pageAtlasBindingLayout.texture.viewDimension = wgpu::TextureViewDimension::_2D;
+
+	wgpu::BindGroupLayoutEntry& virtualTextureBindingLayout = bindingLayoutEntries[6];
+	virtualTextureBindingLayout.binding = 6;
+	virtualTextureBindingLayout.visibility = wgpu::ShaderStage::Fragment;
+	virtualTextureBindingLayout.buffer.type = wgpu::BufferBindingType::Uniform;
+	virtualTextureBindingLayout.buffer.minBindingSize = sizeof(VirtualTextureUniform);
+
+	wgpu::BindGroupLayoutEntry& feedbackBindingLayout = bindingLayoutEntries[7];
+	feedbackBindingLayout.binding = 7;
+	feedbackBindingLayout.visibility = wgpu::ShaderStage::Fragment;
+	feedbackBindingLayout.buffer.type = wgpu::BufferBindingType::Storage;
+
+	// 分簇点光源：参数、光源、每簇的光源数与光源编号
+	wgpu::BindGroupLayoutEntry& clusterBindingLayout = bindingLayoutEntries[8];
+	clusterBindingLayout.binding = 8;
+	clusterBindingLayout.visibility = wgpu::ShaderStage::Fragment;
+	clusterBindingLayout.buffer.type = wgpu::BufferBindingType::Uniform;
+	clusterBindingLayout.buffer.minBindingSize = sizeof(LightClusterUniform);
+	for (uint32_t binding = 9; binding <= 11; ++binding) {
+		bindingLayoutEntries[binding].binding = binding;
+		bindingLayoutEntries[binding].visibility = wgpu::ShaderStage::Fragment;
+		bindingLayoutEntries[binding].buffer.type = wgpu::BufferBindingType::ReadOnlyStorage;
+	}
+
+	// 级联阴影：阴影贴图、比较采样器、参数
+	wgpu::BindGroupLayoutEntry& shadowMapBindingLayout = bindingLayoutEntries[12];
+	shadowMapBindingLayout.binding = 12;
+	shadowMapBindingLayout.visibility = wgpu::ShaderStage::Fragment;
+	shadowMapBindingLayout.texture.sampleType = wgpu::TextureSampleType::Depth;
+	shadowMapBindingLayout.texture.viewDimension = wgpu::TextureViewDimension::_2DArray;
+
+	wgpu::BindGroupLayoutEntry& shadowSamplerBindingLayout = bindingLayoutEntries[13];
+	shadowSamplerBindingLayout.binding = 13;
+	shadowSamplerBindingLayout.visibility = wgpu::ShaderStage::Fragment;
+	shadowSamplerBindingLayout.sampler.type = wgpu::SamplerBindingType::Comparison;
+
+	wgpu::BindGroupLayoutEntry& shadowBindingLayout = bindingLayoutEntries[14];
+	shadowBindingLayout.binding = 14;
+	shadowBindingLayout.visibility = wgpu::ShaderStage::Fragment;
+	shadowBindingLayout.buffer.type = wgpu::BufferBindingType::Uniform;
+	shadowBindingLayout.buffer.minBindingSize = sizeof(ShadowUniform);
+
 	// 创建一个绑定布局
 	wgpu::BindGroupLayoutDescriptor bindGroupLayoutDesc{};
-	bindGroupLayoutDesc.entryCount = 1;
-	bindGroupLayoutDesc.entries = &bindingLayout;
+	bindGroupLayoutDesc.entryCount = (uint32_t)bindingLayoutEntries.size();
+	bindGroupLayoutDesc.entries = bindingLayoutEntries.data();
 	wgpu::BindGroupLayout bindGroupLayout = device.createBindGroupLayout(bindGroupLayoutDesc);
 
 	// 创建管线布局
@@ -275,30 +392,46 @@ void Application::InitializePipeline(){
 	pipeline = device.createRenderPipeline(pipelineDesc);
 	LOG("Render pipeline %p\n", static_cast<void*>(&pipeline));
 
-	// 创建深度纹理
-	wgpu::TextureDescriptor depthTextureDesc;
-	depthTextureDesc.dimension = wgpu::TextureDimension::_2D;
-	depthTextureDesc.format = depthTextureFormat;
-	depthTextureDesc.mipLevelCount = 1;
-	depthTextureDesc.sampleCount = 1;
-	depthTextureDesc.size = {wgpuGLFWWindow.window_size.width, wgpuGLFWWindow.window_size.height, 1};
-	depthTextureDesc.usage = wgpu::TextureUsage::RenderAttachment;
-	depthTextureDesc.viewFormatCount = 1;
-	depthTextureDesc.viewFormats = (WGPUTextureFormat*)&depthTextureFormat;
-	depthTexture = device.createTexture(depthTextureDesc);
-	LOG("Depth texture %p\n", static_cast<void*>(&depthTexture));
-
-	// 创建深度纹理视图（由栅格化器生成）
-	wgpu::TextureViewDescriptor depthTextureViewDesc;
-	depthTextureViewDesc.aspect = wgpu::TextureAspect::DepthOnly;
-	depthTextureViewDesc.baseArrayLayer = 0;
-	depthTextureViewDesc.arrayLayerCount = 1;
-	depthTextureViewDesc.baseMipLevel = 0;
-	depthTextureViewDesc.mipLevelCount = 1;
-	depthTextureViewDesc.dimension = wgpu::TextureViewDimension::_2D;
-	depthTextureViewDesc.format = depthTextureFormat;
-	depthTextureView = depthTexture.createView(depthTextureViewDesc);
-	LOG("Depth texture view %p\n", static_cast<void*>(&depthTextureView));
+	// 深度预通道之后的主渲染通道：深度只比较不写入
+	depthStencilState.depthCompare = wgpu::CompareFunction::Equal;
+	depthStencilState.depthWriteEnabled = false;
+	depthEqualPipeline = device.createRenderPipeline(pipelineDesc);
+
+	// 透明物体：深度只测试不写入，输出到加权混合 OIT 的累积与透过率附件
+	std::vector<wgpu::ColorTargetState> transparentTargets(2);
+	transparencyRenderer.FillAccumulationTargets(transparentTargets);
+	fragmentState.entryPoint = "fs_transparent";
+	fragmentState.targetCount = static_cast<uint32_t>(transparentTargets.size());
+	fragmentState.targets = transparentTargets.data();
+	depthStencilState.depthCompare = wgpu::CompareFunction::Less;
+	depthStencilState.depthWriteEnabled = false;
+	transparentPipeline = device.createRenderPipeline(pipelineDesc);
+	checkNullPointerError(transparentPipeline, "transparent pipeline");
+
+	// 深度预通道：只读取位置流，没有片元着色器，与主管线共用绑定布局
+	wgpu::ShaderModule depthPrepassModule = loadShaderModule(std::filesystem::path(shaderCodeFilePath).parent_path() / "depth-prepass.wgsl", device);
+	wgpu::VertexAttribute positionAttrib;
+	positionAttrib.shaderLocation = 0;
+	positionAttrib.format = positionFormat;
+	positionAttrib.offset = 0;
+	wgpu::VertexBufferLayout positionBufferLayout = {};
+	positionBufferLayout.attributeCount = 1;
+	positionBufferLayout.attributes = &positionAttrib;
+	positionBufferLayout.arrayStride = positionStride;
+	positionBufferLayout.stepMode = wgpu::VertexStepMode::Vertex;
+	pipelineDesc.vertex.buffers = &positionBufferLayout;
+	pipelineDesc.vertex.module = depthPrepassModule;
+	pipelineDesc.vertex.constantCount = 0;
+	pipelineDesc.vertex.constants = nullptr;
+	pipelineDesc.fragment = nullptr;
+	depthStencilState.depthCompare = wgpu::CompareFunction::Less;
+	depthStencilState.depthWriteEnabled = true;
+	depthPrepassPipeline = device.createRenderPipeline(pipelineDesc);
+	checkNullPointerError(depthPrepassPipeline, "depth prepass pipeline");
+	depthPrepassModule.release();
+
+	// 与窗口尺寸相关的渲染目标按通道从池中申请
+	renderTargetPool.Initialize(device);
 
 	// 创建数据
 	std::vector<float> pointData;
@@ -306,28 +439,99 @@ void Application::InitializePipeline(){
 
 	// Load mesh data from OBJ file
 
-	bool success = loadGeometryFromObj(objFilePath, vertexData);
+	bool success = loadMeshFromObj(objFilePath, mesh);
 	if (!success) {
 		std::cerr << "Could not load geometry!" << '\n';
 		throw std::runtime_error("Could not load geometry!");
 	}
 
+	// 贴图在工作线程上解码，与下面的网格处理并行，创建 bind group 前再等待上传完成
+	textureManager.Initialize(device, queue, std::filesystem::path(shaderCodeFilePath).parent_path());
+	// 不用虚拟纹理时只创建 fs_main 绑定需要的占位资源，没有加载线程和反馈回读
+	if (useVirtualTexture) {
+		virtualTextures.Initialize(device, queue);
+		// 页加载完成时唤醒按需渲染模式下等待事件的主循环（glfwPostEmptyEvent 可以在任意线程调用）
+		virtualTextures.SetLoadNotifier([]() { glfwPostEmptyEvent(); });
+	} else {
+		virtualTextures.InitializePlaceholders(device, queue);
+	}
+	if (!mesh.diffuseTexturePath.empty()) {
+		if (useVirtualTexture) {
+			baseColorVirtualTexture = virtualTextures.Add(mesh.diffuseTexturePath);
+		} else {
+			baseColorTexture = textureManager.Load(mesh.diffuseTexturePath);
+		}
+	}
+
+	// 顶点缓存 / overdraw / 顶点读取优化
+	VertexCacheStats statsBefore;
+	VertexCacheStats statsAfter;
+	optimizeMesh(mesh, &statsBefore, &statsAfter);
+	LOG("Mesh optimized: ACMR %.3f -> %.3f, ATVR %.3f -> %.3f\n", statsBefore.acmr, statsAfter.acmr, statsBefore.atvr, statsAfter.atvr);
+
+	// 生成 LOD 链（追加在 mesh.indices 之后，共享顶点缓冲区）
+	meshLods = buildLodChain(mesh);
+	meshBounds = computeBoundingSphere(mesh.vertices);
+
+	// 最高精度的 LOD 切分成 meshlet，用于 GPU 剔除
+	MeshletMesh meshletMesh = buildMeshlets(mesh.vertices, mesh.indices.data() + meshLods[0].firstIndex, meshLods[0].indexCount);
+
 	// 创建顶点缓冲区
 	wgpu::BufferDescriptor bufferDesc;
-	bufferDesc.size = vertexData.size() * sizeof(VertexAttributes); // changed
 	bufferDesc.usage = wgpu::BufferUsage::CopyDst | wgpu::BufferUsage::Vertex;
 	bufferDesc.mappedAtCreation = false;
-	vertexBuffer = device.createBuffer(bufferDesc);
-	queue.writeBuffer(vertexBuffer, 0, vertexData.data(), bufferDesc.size); // changed
+	if (useCompactVertexFormat) {
+		QuantizedMesh quantizedMesh;
+		// 蒙皮后的位置可能超出绑定姿态的包围盒，量化范围相应放大
+		quantizeMesh(mesh, quantizedMesh, useSkinning ? skinnedBoundsScale : 1.0f);
+		LOG("Compact vertex format: %zu -> %zu bytes per vertex, max error: position %g, normal %.4f deg, color %.4f\n",
+			sizeof(VertexAttributes), sizeof(CompactVertexAttributes),
+			quantizedMesh.maxPositionError, quantizedMesh.maxNormalErrorDegrees, quantizedMesh.maxColorError);
+		uniforms.Set(&Uniform::positionOffset, glm::vec4(quantizedMesh.positionOffset, 0.0f));
+		uniforms.Set(&Uniform::positionScale, glm::vec4(quantizedMesh.positionScale, 1.0f));
+
+		vertexBufferSize = quantizedMesh.vertices.size() * sizeof(CompactVertexAttributes);
+		bufferDesc.size = vertexBufferSize;
+		vertexBuffer = device.createBuffer(bufferDesc);
+		queue.writeBuffer(vertexBuffer, 0, quantizedMesh.vertices.data(), vertexBufferSize);
+
+		// 只含位置的顶点流（与交错顶点中的位置逐位相同）
+		std::vector<std::array<int16_t, 4>> positions(quantizedMesh.vertices.size());
+		for (size_t i = 0; i < positions.size(); ++i) {
+			positions[i] = quantizedMesh.vertices[i].position;
+		}
+		positionBufferSize = positions.size() * positionStride;
+		bufferDesc.size = positionBufferSize;
+		positionBuffer = device.createBuffer(bufferDesc);
+		queue.writeBuffer(positionBuffer, 0, positions.data(), positionBufferSize);
+		if (useSkinning) {
+			InitializeSkinning(quantizedMesh.vertices.data(), positions.data());
+		}
+	} else {
+		vertexBufferSize = mesh.vertices.size() * sizeof(VertexAttributes);
+		bufferDesc.size = vertexBufferSize;
+		vertexBuffer = device.createBuffer(bufferDesc);
+		queue.writeBuffer(vertexBuffer, 0, mesh.vertices.data(), vertexBufferSize);
+
+		std::vector<glm::vec3> positions(mesh.vertices.size());
+		for (size_t i = 0; i < positions.size(); ++i) {
+			positions[i] = mesh.vertices[i].position;
+		}
+		positionBufferSize = positions.size() * positionStride;
+		bufferDesc.size = positionBufferSize;
+		positionBuffer = device.createBuffer(bufferDesc);
+		queue.writeBuffer(positionBuffer, 0, positions.data(), positionBufferSize);
+		if (useSkinning) {
+			InitializeSkinning(mesh.vertices.data(), positions.data());
+		}
+	}
 
-	// int indexCount = static_cast<int>(vertexData.size()); // changed
+	// 创建索引缓冲区（writeBuffer 要求大小为 4 的倍数，uint32 索引天然满足）
+	bufferDesc.size = mesh.indices.size() * sizeof(uint32_t);
+	bufferDesc.usage = wgpu::BufferUsage::CopyDst | wgpu::BufferUsage::Index;
+	indexBuffer = device.createBuffer(bufferDesc);
+	queue.writeBuffer(indexBuffer, 0, mesh.indices.data(), bufferDesc.size);
 	
-	// 创建uniform缓冲区
-	bufferDesc.size = sizeof(Uniform);
-	bufferDesc.usage = wgpu::BufferUsage::CopyDst | wgpu::BufferUsage::Uniform;
-	bufferDesc.mappedAtCreation = false;
-	uniformBuffer = device.createBuffer(bufferDesc);
-	checkNullPointerError(uniformBuffer, "uniformBuffer");
 	// 上传初始uniform数据
 	
 
@@ -343,53 +547,699 @@ void Application::InitializePipeline(){
 	glm::mat4x4 S = glm::scale(glm::mat4x4(1.0), glm::vec3(0.3f));
 	glm::mat4x4 T1 = glm::mat4x4(1.0);
 	glm::mat4x4 R1 = glm::rotate(glm::mat4x4(1.0), angle1, glm::vec3(0.0, 0.0, 1.0));
-	uniform.modelMatrix = R1 * T1 * S;
+	modelMatrix = R1 * T1 * S;
 
 	glm::mat4x4 R2 = glm::rotate(glm::mat4x4(1.0), -angle2, glm::vec3(1.0, 0.0, 0.0));
 	glm::mat4x4 T2 = glm::translate(glm::mat4x4(1.0), -focalPoint);
-	uniform.viewMatrix = T2 * R2;
+	viewMatrix = T2 * R2;
+
+	UpdateProjectionMatrix();
+
+	uniforms.Set(&Uniform::viewDepthRow, glm::vec4(viewMatrix[0][2], viewMatrix[1][2], viewMatrix[2][2], viewMatrix[3][2]));
+	uniforms.Set(&Uniform::time, 1.0f);
+	// alpha 为透明实例的不透明度
+	uniforms.Set(&Uniform::color, std::array<float, 4>{ 0.0f, 1.0f, 0.4f, transparentOpacity });
+	// 创建 uniform 缓冲区并上传初始数据
+	uniforms.Initialize(device, queue, "Uniform buffer");
+
+	// 实例数据依赖相机，放在视角矩阵之后生成
+	InitializeInstances();
+	bufferDesc.size = instances.size() * sizeof(InstanceData);
+	bufferDesc.usage = wgpu::BufferUsage::CopyDst | wgpu::BufferUsage::Storage;
+	bufferDesc.mappedAtCreation = false;
+	instanceBuffer = device.createBuffer(bufferDesc);
+	queue.writeBuffer(instanceBuffer, 0, instances.data(), bufferDesc.size);
+
+	if (useMeshletCulling) {
+		meshletCuller.Initialize(device, queue, std::filesystem::path(shaderCodeFilePath).parent_path() / "meshlet-cull.wgsl",
+			meshletMesh, instanceBuffer, instances.size() * sizeof(InstanceData));
+	}
+
+	shadowRenderer.Initialize(device, queue, std::filesystem::path(shaderCodeFilePath).parent_path() / "shadow.wgsl",
+		positionStride, positionFormat, uniforms.GetBuffer(), instanceBuffer, instances.size() * sizeof(InstanceData));
+
+	if (useOcclusionCulling && indirectFirstInstanceSupported) {
+		occlusionCuller.Initialize(device, queue, std::filesystem::path(shaderCodeFilePath).parent_path(), static_cast<uint32_t>(instances.size()));
+	} else if (useOcclusionCulling) {
+		LOG("Occlusion culling disabled: IndirectFirstInstance is not supported\n");
+	}
+
+	lightClusterer.Initialize(device, queue, std::filesystem::path(shaderCodeFilePath).parent_path() / "light-cluster.wgsl", pointLightCount);
+	InitializePointLights();
+
+	if (transparentColumnStride > 0) {
+		transparencyRenderer.Initialize(device, std::filesystem::path(shaderCodeFilePath).parent_path() / "oit-composite.wgsl", swapChainFormat);
+	}
+	gpuPrimitives.Initialize(device, queue, std::filesystem::path(shaderCodeFilePath).parent_path());
+
+	// GPU 粒子：从中心模型顶部喷出，落在模型的包围球和它下方的地面上（按模型半径缩放，一个半径相当于一米）
+	if (particleCount > 0) {
+		particleSystem.Initialize(device, queue, std::filesystem::path(shaderCodeFilePath).parent_path(), particleCount, swapChainFormat, depthTextureFormat);
+		float worldScale = glm::length(glm::vec3(modelMatrix[0]));
+		glm::vec3 modelCenter = glm::vec3(modelMatrix * glm::vec4(meshBounds.center, 1.0f));
+		float modelRadius = meshBounds.radius * worldScale;
+		ParticleEmitter emitter;
+		emitter.position = modelCenter + glm::vec3(0.0f, 0.0f, 1.1f * modelRadius);
+		emitter.direction = glm::vec3(0.0f, 0.0f, 1.0f);
+		emitter.gravity = glm::vec3(0.0f, 0.0f, -9.8f * modelRadius);
+		// 最高点约在发射点上方两个半径
+		emitter.speed = std::sqrt(4.0f * 9.8f) * modelRadius;
+		emitter.minLifetime = 2.0f;
+		emitter.maxLifetime = 4.0f;
+		emitter.size = 0.01f * modelRadius;
+		particleSystem.SetEmitter(emitter);
+		particleSystem.AddPlane(glm::vec3(0.0f, 0.0f, 1.0f), -(modelCenter.z - modelRadius));
+		particleSystem.AddSphere(modelCenter, 0.8f * modelRadius);
+	}
+
+	textureManager.WaitAll();
+
+	// Create a binding
+	std::vector<wgpu::BindGroupEntry> bindings(15);
+	bindings[0].binding = 0;
+	bindings[0].buffer = uniforms.GetBuffer();
+	bindings[0].offset = 0;
+	bindings[0].size = sizeof(Uniform);
+
+	bindings[1].binding = 1;
+	bindings[1].buffer = instanceBuffer;
+	bindings[1].offset = 0;
+	bindings[1].size = instances.size() * sizeof(InstanceData);
+
+	// 没有贴图时使用白色占位纹理
+	bindings[2].binding = 2;
+	bindings[2].textureView = textureManager.GetView(baseColorTexture);
+
+	bindings[3].binding = 3;
+	bindings[3].sampler = textureManager.GetSampler();
+
+	// 间接纹理要等源图解码完才知道尺寸
+	virtualTextures.WaitUntilOpened();
+	bindings[4].binding = 4;
+	bindings[4].textureView = virtualTextures.GetPageTableView(baseColorVirtualTexture);
+
+	bindings[5].binding = 5;
+	bindings[5].textureView = virtualTextures.GetAtlasView();
+
+	bindings[6].binding = 6;
+	bindings[6].buffer = virtualTextures.GetUniformBuffer(baseColorVirtualTexture);
+	bindings[6].offset = 0;
+	bindings[6].size = sizeof(VirtualTextureUniform);
+
+	bindings[7].binding = 7;
+	bindings[7].buffer = virtualTextures.GetFeedbackBuffer();
+	bindings[7].offset = 0;
+	bindings[7].size = virtualTextures.GetFeedbackBufferSize();
+
+	bindings[8].binding = 8;
+	bindings[8].buffer = lightClusterer.GetUniformBuffer();
+	bindings[8].offset = 0;
+	bindings[8].size = sizeof(LightClusterUniform);
+
+	bindings[9].binding = 9;
+	bindings[9].buffer = lightClusterer.GetLightBuffer();
+	bindings[9].offset = 0;
+	bindings[9].size = lightClusterer.GetLightBufferSize();
+
+	bindings[10].binding = 10;
+	bindings[10].buffer = lightClusterer.GetLightCountBuffer();
+	bindings[10].offset = 0;
+	bindings[10].size = lightClusterer.GetLightCountBufferSize();
+
+	bindings[11].binding = 11;
+	bindings[11].buffer = lightClusterer.GetLightIndexBuffer();
+	bindings[11].offset = 0;
+	bindings[11].size = lightClusterer.GetLightIndexBufferSize();
+
+	bindings[12].binding = 12;
+	bindings[12].textureView = shadowRenderer.GetShadowMapView();
+
+	bindings[13].binding = 13;
+	bindings[13].sampler = shadowRenderer.GetSampler();
+
+	bindings[14].binding = 14;
+	bindings[14].buffer = shadowRenderer.GetUniformBuffer();
+	bindings[14].offset = 0;
+	bindings[14].size = sizeof(ShadowUniform);
+
+	// A bind group contains one or multiple bindings
+	wgpu::BindGroupDescriptor bindGroupDesc;
+	bindGroupDesc.layout = bindGroupLayout;
+	bindGroupDesc.entryCount = bindGroupLayoutDesc.entryCount;
+	bindGroupDesc.entries = bindings.data();
+	bindGroup = device.createBindGroup(bindGroupDesc);
+
+	// 渲染队列中的状态编号
+	uint64_t indexBufferSize = mesh.indices.size() * sizeof(uint32_t);
+	mainPipelineId = renderQueue.RegisterPipeline(pipeline);
+	depthEqualPipelineId = renderQueue.RegisterPipeline(depthEqualPipeline);
+	depthPrepassPipelineId = renderQueue.RegisterPipeline(depthPrepassPipeline);
+	transparentPipelineId = renderQueue.RegisterPipeline(transparentPipeline);
+	sceneBindGroupId = renderQueue.RegisterBindGroup(bindGroup);
+	meshGeometryId = renderQueue.RegisterGeometry(vertexBuffer, vertexBufferSize, indexBuffer, indexBufferSize);
+	positionGeometryId = renderQueue.RegisterGeometry(positionBuffer, positionBufferSize, indexBuffer, indexBufferSize);
+	if (skinning.IsReady()) {
+		skinnedGeometryId = renderQueue.RegisterGeometry(skinning.GetVertexBuffer(), skinning.GetVertexBufferSize(), indexBuffer, indexBufferSize);
+		skinnedPositionGeometryId = renderQueue.RegisterGeometry(skinning.GetPositionBuffer(), skinning.GetPositionBufferSize(), indexBuffer, indexBufferSize);
+	}
+	if (meshletCuller.IsReady()) {
+		meshletGeometryId = renderQueue.RegisterGeometry(vertexBuffer, vertexBufferSize,
+			meshletCuller.GetCulledIndexBuffer(), meshletCuller.GetCulledIndexBufferSize());
+		meshletPositionGeometryId = renderQueue.RegisterGeometry(positionBuffer, positionBufferSize,
+			meshletCuller.GetCulledIndexBuffer(), meshletCuller.GetCulledIndexBufferSize());
+	}
+
+	BuildFrameGraph();
+}
+
+void Application::BuildFrameGraph() {
+	frameGraph.Clear();
+	backbufferResource = frameGraph.ImportTexture("Backbuffer");
+	// 深度缓冲区是临时资源，尺寸跟随交换链，由帧图在通道前后从池中申请和归还
+	RenderTargetDesc depthDesc;
+	depthDesc.format = depthTextureFormat;
+	depthDesc.usage = wgpu::TextureUsage::RenderAttachment;
+	if (occlusionCuller.IsReady()) {
+		// 前期绘制的深度用来生成 Hi-Z
+		depthDesc.usage |= wgpu::TextureUsage::TextureBinding;
+	}
+	FrameGraphResource depth = frameGraph.CreateTexture("Depth texture", depthDesc, true);
+	FrameGraphResource meshletDraws = frameGraph.ImportBuffer("Meshlet draws");
+	FrameGraphResource feedback = frameGraph.ImportBuffer("Virtual texture feedback");
+	FrameGraphResource lightClusters = frameGraph.ImportBuffer("Light clusters");
+	// 阴影贴图跨帧保留（静态投射物缓存），作为导入资源
+	FrameGraphResource shadowMap = frameGraph.ImportTexture("Shadow map");
+	// 蒙皮后的顶点，所有绘制带动画实例的通道共用
+	FrameGraphResource skinnedVertices = frameGraph.ImportBuffer("Skinned vertices");
+
+	// 蒙皮（计算通道），工作线程算好的蒙皮矩阵在这里上传
+	frameGraph.AddEncoderPass("Skinning",
+		[&](FrameGraph::PassBuilder& builder) {
+			builder.Write(skinnedVertices);
+		},
+		[this](wgpu::CommandEncoder& encoder) {
+			skinning.Skin(encoder);
+		});
+
+	// 级联阴影：静态投射物按需重画到缓存，每帧只叠加动态投射物
+	ShadowRenderer::DrawCasters drawShadowCasters = [this](wgpu::RenderPassEncoder& renderPass, ShadowRenderer::Casters casters) {
+		// 动态投射物（带动画的实例）读取蒙皮后的位置流
+		bool skinned = casters == ShadowRenderer::Casters::Dynamic && skinning.IsReady();
+		renderPass.setVertexBuffer(0, skinned ? skinning.GetPositionBuffer() : positionBuffer, 0, positionBufferSize);
+		renderPass.setIndexBuffer(indexBuffer, wgpu::IndexFormat::Uint32, 0, mesh.indices.size() * sizeof(uint32_t));
+		uint32_t drawnCount = static_cast<uint32_t>(frameInstanceLods.size());
+		uint32_t dynamicCount = std::min<uint32_t>(dynamicInstanceCount, drawnCount);
+		uint32_t begin = casters == ShadowRenderer::Casters::Dynamic ? 0 : dynamicCount;
+		uint32_t end = casters == ShadowRenderer::Casters::Dynamic ? dynamicCount : drawnCount;
+		for (uint32_t i = begin; i < end; ++i) {
+			const MeshLod& lod = meshLods[frameInstanceLods[i]];
+			renderPass.drawIndexed(lod.indexCount, 1, lod.firstIndex, 0, i);
+		}
+	};
+	frameGraph.AddEncoderPass("Shadow cascades",
+		[&](FrameGraph::PassBuilder& builder) {
+			builder.Read(skinnedVertices);
+			builder.Write(shadowMap);
+		},
+		[this, drawShadowCasters](wgpu::CommandEncoder& encoder) {
+			shadowRenderer.Update(projectionMatrix, viewMatrix, keyLightDirection, sceneBounds, cameraNear, shadowDistance);
+			shadowRenderer.Render(encoder, dynamicInstanceCount > 0, drawShadowCasters);
+		});
+
+	// 分簇光源剔除（计算通道），结果在主渲染通道的片元着色器中读取
+	frameGraph.AddEncoderPass("Light clusters",
+		[&](FrameGraph::PassBuilder& builder) {
+			builder.Write(lightClusters);
+		},
+		[this](wgpu::CommandEncoder& encoder) {
+			lightClusterer.AssignLights(encoder, projectionMatrix, viewMatrix,
+				wgpuGLFWWindow.window_size.width, wgpuGLFWWindow.window_size.height, clusterNear, clusterFar);
+		});
+
+	// meshlet 剔除（计算通道），结果在主渲染通道中间接绘制
+	frameGraph.AddEncoderPass("Meshlet cull",
+		[&](FrameGraph::PassBuilder& builder) {
+			builder.Write(meshletDraws);
+		},
+		[this](wgpu::CommandEncoder& encoder) {
+			if (!frameMeshletInstances.empty()) {
+				meshletCuller.Cull(encoder, frameCullParams, frameMeshletInstances.data(), static_cast<uint32_t>(frameMeshletInstances.size()), frameInstancesMoved);
+			}
+		});
+
+	// 遮挡剔除前期：视锥内且上一帧可见的实例
+	FrameGraphResource earlyDraws = frameGraph.ImportBuffer("Occlusion early draws");
+	if (occlusionCuller.IsReady()) {
+		frameGraph.AddEncoderPass("Occlusion cull (early)",
+			[&](FrameGraph::PassBuilder& builder) {
+				builder.Write(earlyDraws);
+			},
+			[this](wgpu::CommandEncoder& encoder) {
+				occlusionCuller.CullEarly(encoder, projectionMatrix, viewMatrix, cameraNear);
+			});
+	}
+
+	// 深度预通道：先只写深度，主渲染通道以 Equal 比较，每个像素只对最前面的片元执行光照
+	if (useDepthPrepass) {
+		frameGraph.AddRenderPass("Depth prepass",
+			[&](FrameGraph::PassBuilder& builder) {
+				builder.DepthAttachment(depth);
+				builder.Read(skinnedVertices);
+				builder.Read(meshletDraws);
+				builder.Read(earlyDraws);
+			},
+			[this](wgpu::RenderPassEncoder& renderPass) {
+				DrawInstances(renderPass, InstancePass::DepthPrepass);
+			});
+	}
+
+	frameGraph.AddRenderPass("Main pass",
+		[&](FrameGraph::PassBuilder& builder) {
+			builder.ColorAttachment(backbufferResource, wgpu::LoadOp::Clear, wgpu::Color{ 0.05, 0.05, 0.05, 1.0 });
+			builder.DepthAttachment(depth, useDepthPrepass ? wgpu::LoadOp::Load : wgpu::LoadOp::Clear);
+			builder.Read(skinnedVertices);
+			builder.Read(meshletDraws);
+			builder.Read(earlyDraws);
+			builder.Read(lightClusters);
+			builder.Read(shadowMap);
+			builder.Write(feedback);
+		},
+		[this](wgpu::RenderPassEncoder& renderPass) {
+			DrawInstances(renderPass, InstancePass::Main);
+			// 按 LOD 选择的结果统计，是 GPU 剔除（meshlet、遮挡）之前提交的三角形数，不是实际光栅化的数量
+			uint64_t drawnTriangles = 0;
+			for (uint32_t lod : frameInstanceLods) {
+				drawnTriangles += meshLods[lod].indexCount / 3;
+			}
+			if (drawnTriangles != lastDrawnTriangles) {
+				LOG("LOD: %llu triangles submitted before GPU culling (%llu at full resolution)\n", static_cast<unsigned long long>(drawnTriangles),
+					static_cast<unsigned long long>(frameInstanceLods.size() * (meshLods[0].indexCount / 3)));
+				lastDrawnTriangles = drawnTriangles;
+			}
+		});
+
+	if (occlusionCuller.IsReady()) {
+		// 由前期的深度生成 Hi-Z，测试所有视锥内的实例，补画新露出的实例
+		FrameGraphResource hiz = frameGraph.ImportTexture("Hi-Z pyramid");
+		FrameGraphResource lateDraws = frameGraph.ImportBuffer("Occlusion late draws");
+		frameGraph.AddEncoderPass("Hi-Z build",
+			[&](FrameGraph::PassBuilder& builder) {
+				builder.Read(depth);
+				builder.Write(hiz);
+			},
+			[this, depth](wgpu::CommandEncoder& encoder) {
+				occlusionCuller.BuildPyramid(encoder, frameGraph.GetTextureView(depth),
+					wgpuGLFWWindow.window_size.width, wgpuGLFWWindow.window_size.height);
+			});
+		frameGraph.AddEncoderPass("Occlusion cull (late)",
+			[&](FrameGraph::PassBuilder& builder) {
+				builder.Read(hiz);
+				builder.Write(lateDraws);
+			},
+			[this](wgpu::CommandEncoder& encoder) {
+				occlusionCuller.CullLate(encoder);
+			});
+		frameGraph.AddRenderPass("Main pass (late)",
+			[&](FrameGraph::PassBuilder& builder) {
+				builder.ColorAttachment(backbufferResource, wgpu::LoadOp::Load);
+				builder.DepthAttachment(depth, wgpu::LoadOp::Load);
+				builder.Read(skinnedVertices);
+				builder.Read(lateDraws);
+				builder.Read(lightClusters);
+				builder.Read(shadowMap);
+				builder.Write(feedback);
+			},
+			[this](wgpu::RenderPassEncoder& renderPass) {
+				DrawInstances(renderPass, InstancePass::Late);
+			});
+	}
+
+	// 透明物体：加权混合 OIT，深度只测试不写入，累积到两个临时附件后合成到交换链（--transparency 打开）
+	if (transparencyRenderer.IsReady()) {
+		FrameGraphResource accumulation = frameGraph.CreateTexture("OIT accumulation", TransparencyRenderer::AccumulationDesc(), true);
+		FrameGraphResource revealage = frameGraph.CreateTexture("OIT revealage", TransparencyRenderer::RevealageDesc(), true);
+		frameGraph.AddRenderPass("Transparent pass",
+			[&](FrameGraph::PassBuilder& builder) {
+				builder.ColorAttachment(accumulation, wgpu::LoadOp::Clear, wgpu::Color{ 0.0, 0.0, 0.0, 0.0 });
+				builder.ColorAttachment(revealage, wgpu::LoadOp::Clear, wgpu::Color{ 1.0, 1.0, 1.0, 1.0 });
+				builder.DepthAttachment(depth, wgpu::LoadOp::Load);
+				builder.Read(skinnedVertices);
+				builder.Read(lightClusters);
+				builder.Read(shadowMap);
+				builder.Write(feedback);
+			},
+			[this](wgpu::RenderPassEncoder& renderPass) {
+				DrawInstances(renderPass, InstancePass::Transparent);
+			});
+		frameGraph.AddRenderPass("Transparent composite",
+			[&](FrameGraph::PassBuilder& builder) {
+				builder.ColorAttachment(backbufferResource, wgpu::LoadOp::Load);
+				builder.Read(accumulation);
+				builder.Read(revealage);
+			},
+			[this, accumulation, revealage](wgpu::RenderPassEncoder& renderPass) {
+				transparencyRenderer.Composite(renderPass, frameGraph.GetTextureView(accumulation), frameGraph.GetTextureView(revealage));
+			});
+	}
+
+	// GPU 粒子：模拟在计算通道中完成，存活数直接作为间接绘制的实例数，叠加到交换链上
+	if (particleSystem.IsReady()) {
+		FrameGraphResource particles = frameGraph.ImportBuffer("Particles");
+		frameGraph.AddEncoderPass("Particle simulation",
+			[&](FrameGraph::PassBuilder& builder) {
+				builder.Write(particles);
+			},
+			[this](wgpu::CommandEncoder& encoder) {
+				particleSystem.Simulate(encoder, uniforms.Get().time);
+			});
+		frameGraph.AddRenderPass("Particles",
+			[&](FrameGraph::PassBuilder& builder) {
+				builder.ColorAttachment(backbufferResource, wgpu::LoadOp::Load);
+				builder.DepthAttachment(depth, wgpu::LoadOp::Load);
+				builder.Read(particles);
+			},
+			[this](wgpu::RenderPassEncoder& renderPass) {
+				particleSystem.Draw(renderPass, projectionMatrix, viewMatrix);
+			});
+	}
+
+	// 本帧的虚拟纹理反馈拷贝出来，几帧后在 CPU 上读到
+	if (useVirtualTexture) {
+		frameGraph.AddEncoderPass("Virtual texture feedback readback",
+			[&](FrameGraph::PassBuilder& builder) {
+				builder.Read(feedback);
+				builder.SideEffect();
+			},
+			[this](wgpu::CommandEncoder& encoder) {
+				virtualTextures.RecordFeedbackReadback(encoder);
+			});
+	}
+
+	frameGraph.Compile();
+}
+
+void Application::DrawInstances(wgpu::RenderPassEncoder& renderPass, InstancePass pass) {
+	// 选择使用的 pipeline：深度预通道只读位置流；预通道之后的主渲染通道深度以 Equal 比较且不写入；
+	// 后期补画的实例不在预通道中，按正常的深度测试绘制；透明实例只在透明通道中绘制
+	RenderDraw draw;
+	draw.bindGroup = sceneBindGroupId;
+	uint32_t geometry = meshGeometryId;
+	uint32_t skinnedGeometry = skinnedGeometryId;
+	uint32_t meshletGeometry = meshletGeometryId;
+	if (pass == InstancePass::DepthPrepass) {
+		draw.pipeline = depthPrepassPipelineId;
+		geometry = positionGeometryId;
+		skinnedGeometry = skinnedPositionGeometryId;
+		meshletGeometry = meshletPositionGeometryId;
+	} else if (pass == InstancePass::Transparent) {
+		draw.pipeline = transparentPipelineId;
+	} else {
+		draw.pipeline = pass == InstancePass::Main && useDepthPrepass ? depthEqualPipelineId : mainPipelineId;
+	}
+
+	renderQueue.Clear();
+	if (pass == InstancePass::Transparent) {
+		// 加权混合 OIT 与顺序无关，排序键中的深度只影响状态分组
+		for (uint32_t i = 0; i < frameInstanceLods.size(); ++i) {
+			if (!instanceTransparent[i]) {
+				continue;
+			}
+			draw.geometry = IsSkinned(i) ? skinnedGeometry : geometry;
+			const MeshLod& lod = meshLods[frameInstanceLods[i]];
+			draw.indexCount = lod.indexCount;
+			draw.firstIndex = lod.firstIndex;
+			draw.firstInstance = i;
+			renderQueue.Add(RenderLayer::Transparent, frameInstanceDepths[i], draw);
+		}
+		renderQueue.Sort();
+		renderQueue.Submit(renderPass);
+		return;
+	}
+
+	// 不参与 meshlet 剔除的不透明实例直接绘制（或按遮挡剔除的结果间接绘制），按深度从前到后排序
+	size_t culledCursor = 0;
+	for (uint32_t i = 0; i < frameInstanceLods.size(); ++i) {
+		if (culledCursor < frameMeshletInstances.size() && frameMeshletInstances[culledCursor] == i) {
+			++culledCursor;
+			continue;
+		}
+		if (instanceTransparent[i]) {
+			continue;
+		}
+		draw.geometry = IsSkinned(i) ? skinnedGeometry : geometry;
+		if (occlusionCuller.IsReady()) {
+			if (i >= occlusionCuller.GetInstanceCount()) {
+				continue;
+			}
+			draw.indirectBuffer = occlusionCuller.GetDrawArgsBuffer(pass == InstancePass::Late);
+			draw.indirectOffset = occlusionCuller.GetDrawArgsOffset(i);
+		} else {
+			const MeshLod& lod = meshLods[frameInstanceLods[i]];
+			draw.indexCount = lod.indexCount;
+			draw.firstIndex = lod.firstIndex;
+			draw.firstInstance = i;
+		}
+		renderQueue.Add(RenderLayer::Opaque, frameInstanceDepths[i], draw);
+	}
+	// meshlet 剔除后的实例使用剔除后的索引缓冲区，作为单独的几何参与排序
+	if (pass != InstancePass::Late) {
+		draw.geometry = meshletGeometry;
+		for (uint32_t slot = 0; slot < frameMeshletInstances.size(); ++slot) {
+			draw.indirectBuffer = meshletCuller.GetDrawArgsBuffer();
+			draw.indirectOffset = meshletCuller.GetDrawArgsOffset(slot);
+			renderQueue.Add(RenderLayer::Opaque, frameInstanceDepths[frameMeshletInstances[slot]], draw);
+		}
+	}
+	renderQueue.Sort();
+	renderQueue.Submit(renderPass);
+
+	if (pass == InstancePass::Main && renderQueue.GetStats() != lastRenderQueueStats) {
+		const RenderQueueStats& stats = renderQueue.GetStats();
+		LOG("Render queue: %u draws, %u pipeline / %u bind group / %u vertex+index buffer changes\n",
+			stats.drawCount, stats.pipelineChanges, stats.bindGroupChanges, stats.geometryChanges);
+		lastRenderQueueStats = stats;
+	}
+}
 
+void Application::CreateSwapChain() {
+	wgpu::SwapChainDescriptor swapChainDesc;
+	swapChainDesc.width = wgpuGLFWWindow.window_size.width;
+	swapChainDesc.height = wgpuGLFWWindow.window_size.height;
+	swapChainDesc.usage = wgpu::TextureUsage::RenderAttachment;
+	swapChainDesc.format = swapChainFormat;
+	swapChainDesc.presentMode = wgpu::PresentMode::Fifo;
+	swapChain = device.createSwapChain(surface, swapChainDesc);
+	LOG("Swapchain %p (%ux%u)\n", static_cast<void*>(&swapChain), swapChainDesc.width, swapChainDesc.height);
+}
+
+void Application::UpdateProjectionMatrix() {
 	float ratio = (float)wgpuGLFWWindow.window_size.width / (float)wgpuGLFWWindow.window_size.height;
 	float focalLength = 2.0;
-	float near = 0.01f;
-	float far = 100.0f;
+	float near = cameraNear;
+	float far = cameraFar;
 	float divider = 1 / (focalLength * (far - near));
-	uniform.projectionMatrix = transpose(glm::mat4x4(
+	projectionMatrix = transpose(glm::mat4x4(
 		1.0, 0.0, 0.0, 0.0,
 		0.0, ratio, 0.0, 0.0,
 		0.0, 0.0, far * divider, -far * near * divider,
 		0.0, 0.0, 1.0 / focalLength, 0.0
 	));
+}
 
-	uniform.time = 1.0f;
-	uniform.color = { 0.0f, 1.0f, 0.4f, 1.0f };
-	queue.writeBuffer(uniformBuffer, 0, &uniform, sizeof(Uniform));
+void Application::OnResize() {
+	// 只重建交换链，渲染目标每帧按新尺寸从池中申请，设备、管线和其他资源保持不变
+	swapChain.release();
+	CreateSwapChain();
 
-	// Create a binding
-	wgpu::BindGroupEntry binding{};
-	binding.binding = 0;
-	binding.buffer = uniformBuffer;
-	binding.offset = 0;
-	binding.size = sizeof(Uniform);
+	// 实例的 MVP 在下一帧按新的投影矩阵重新组合
+	UpdateProjectionMatrix();
+}
 
-	// A bind group contains one or multiple bindings
-	wgpu::BindGroupDescriptor bindGroupDesc;
-	bindGroupDesc.layout = bindGroupLayout;
-	bindGroupDesc.entryCount = bindGroupLayoutDesc.entryCount;
-	bindGroupDesc.entries = &binding;
-	bindGroup = device.createBindGroup(bindGroupDesc);
+void Application::InitializeInstances() {
+	instanceTransforms.resize(1 + static_cast<size_t>(farFieldRows) * farFieldColumns);
+	instanceTransparent.clear();
+	// 中心的模型
+	instanceTransforms.set(0, glm::vec3(0.0f), glm::quat(1.0f, 0.0f, 0.0f, 0.0f), glm::vec3(1.0f));
+	instanceTransparent.push_back(0);
+
+	// 相机在世界空间中的位置与朝向（视图空间 +z 朝前）
+	glm::mat4x4 invView = glm::inverse(viewMatrix);
+	glm::vec3 right = glm::normalize(glm::vec3(invView[0]));
+	glm::vec3 up = glm::normalize(glm::vec3(invView[1]));
+	glm::vec3 forward = glm::normalize(glm::vec3(invView[2]));
+	glm::vec3 eye = glm::vec3(invView[3]);
+	float focusDistance = glm::length(eye);
+
+	// 沿视线方向逐行后退，每行横向展开到视野宽度的 80%
+	// 远景实例是静态的（编号不小于 dynamicInstanceCount），静止时的姿态（均匀缩放 + 旋转）直接作为摆放的旋转和缩放
+	float staticScale = glm::length(glm::vec3(modelMatrix[0]));
+	glm::quat staticRotation = glm::quat_cast(glm::mat3x3(modelMatrix) / staticScale);
+	const float rowSpacing = 1.5f;
+	size_t index = 1;
+	for (uint32_t row = 1; row <= farFieldRows; ++row) {
+		float distance = focusDistance + rowSpacing * static_cast<float>(row);
+		for (uint32_t column = 0; column < farFieldColumns; ++column) {
+			float u = farFieldColumns > 1 ? static_cast<float>(column) / static_cast<float>(farFieldColumns - 1) - 0.5f : 0.0f;
+			glm::vec3 position = eye + forward * distance + right * (u * 0.8f * distance) - up * (0.15f * distance);
+			instanceTransforms.set(index++, position, staticRotation, glm::vec3(staticScale));
+			// 每隔几列一个透明的实例，在 OIT 通道中绘制
+			instanceTransparent.push_back(transparentColumnStride > 0 && column % transparentColumnStride == transparentColumnStride - 1);
+		}
+	}
+
+	instances.assign(instanceTransforms.size(), InstanceData{});
+	instanceTransformsDirty = true;
+	UpdateInstanceTransforms();
+
+	// 场景包围球：包含所有实例中心的球，加上模型的半径
+	float worldScale = glm::length(glm::vec3(modelMatrix[0]));
+	glm::vec3 boundsMin(std::numeric_limits<float>::max());
+	glm::vec3 boundsMax(-std::numeric_limits<float>::max());
+	for (const InstanceData& instance : instances) {
+		glm::vec3 center = glm::vec3(instance.modelMatrix[3]);
+		boundsMin = glm::min(boundsMin, center);
+		boundsMax = glm::max(boundsMax, center);
+	}
+	sceneBounds.center = 0.5f * (boundsMin + boundsMax);
+	sceneBounds.radius = 0.5f * glm::length(boundsMax - boundsMin) + (glm::length(meshBounds.center) + meshBounds.radius) * worldScale;
+	LOG("Instances: %zu (%u dynamic, %zu transparent, transforms composed with %s)\n", instances.size(), std::min<uint32_t>(dynamicInstanceCount, static_cast<uint32_t>(instances.size())),
+		static_cast<size_t>(std::count(instanceTransparent.begin(), instanceTransparent.end(), 1)), transformBatchPath());
+}
+
+uint32_t Application::UpdateInstanceTransforms() {
+	glm::mat4x4 viewProjection = projectionMatrix * viewMatrix;
+	bool recomposeAll = instanceTransformsDirty || viewProjection != instanceViewProjection;
+	if (recomposeAll) {
+		// 摆放矩阵、MVP 和法向量矩阵由 SoA 的平移/旋转/缩放批量组合，直接写进实例数据
+		TransformOutput output;
+		output.models = &instances.data()->modelMatrix;
+		output.modelViewProjections = &instances.data()->modelViewProjectionMatrix;
+		output.normalMatrices = instances.data()->normalMatrix.data();
+		output.stride = sizeof(InstanceData);
+		composeTransforms(instanceTransforms, viewProjection, output);
+		instanceViewProjection = viewProjection;
+		instanceTransformsDirty = false;
+	}
+	// 带模型动画的实例：摆放矩阵作用在模型动画矩阵之后，动画暂停且相机不动时不用更新
+	bool animated = modelMatrix != instanceModelMatrix;
+	if (!recomposeAll && !animated) {
+		return 0;
+	}
+	uint32_t dynamicCount = std::min<uint32_t>(dynamicInstanceCount, static_cast<uint32_t>(instances.size()));
+	for (uint32_t i = 0; i < dynamicCount; ++i) {
+		InstanceData& instance = instances[i];
+		instance.modelMatrix = instanceTransforms.matrix(i) * modelMatrix;
+		instance.modelViewProjectionMatrix = viewProjection * instance.modelMatrix;
+		instance.normalMatrix = packNormalMatrix(instance.modelMatrix);
+	}
+	instanceModelMatrix = modelMatrix;
+	return recomposeAll ? static_cast<uint32_t>(instances.size()) : dynamicCount;
+}
+
+void Application::InitializeSkinning(const void* vertexData, const void* positionData) {
+	// 没有带骨骼的资源：沿网格 z 轴（上方向）从底到顶生成一串关节，按顶点的高度分配权重
+	glm::vec3 boundsMin(std::numeric_limits<float>::max());
+	glm::vec3 boundsMax(std::numeric_limits<float>::lowest());
+	for (const VertexAttributes& vertex : mesh.vertices) {
+		boundsMin = glm::min(boundsMin, vertex.position);
+		boundsMax = glm::max(boundsMax, vertex.position);
+	}
+	glm::vec3 center = (boundsMin + boundsMax) * 0.5f;
+	Skeleton skeleton = createChainSkeleton(glm::vec3(center.x, center.y, boundsMin.z), glm::vec3(center.x, center.y, boundsMax.z), skinningJointCount);
+	std::vector<SkinVertex> skin = computeChainSkinWeights(mesh.vertices, skeleton);
+
+	// 整条链最多弯曲/扭转约 20 度，蒙皮后的网格留在放大 skinnedBoundsScale 倍的包围范围内
+	float jointAngle = glm::radians(20.0f) / static_cast<float>(skinningJointCount);
+	std::vector<AnimationClip> clips;
+	clips.push_back(createChainClip(skeleton, glm::vec3(1.0f, 0.0f, 0.0f), jointAngle, 0.0f, 2.0f));
+	clips.push_back(createChainClip(skeleton, glm::vec3(0.0f, 1.0f, 0.0f), 0.5f * jointAngle, jointAngle, 3.0f));
+
+	SkinnedVertexLayout layout;
+	layout.compact = useCompactVertexFormat;
+	layout.vertexStride = static_cast<uint32_t>(useCompactVertexFormat ? sizeof(CompactVertexAttributes) : sizeof(VertexAttributes));
+	layout.positionStride = static_cast<uint32_t>(positionStride);
+	layout.positionOffset = glm::vec3(uniforms.Get().positionOffset);
+	layout.positionScale = glm::vec3(uniforms.Get().positionScale);
+	skinning.Initialize(device, queue, std::filesystem::path(shaderCodeFilePath).parent_path(), mesh.vertices, std::move(skeleton), std::move(clips), skin,
+		vertexData, vertexBufferSize, positionData, positionBufferSize, layout);
+}
+
+void Application::InitializePointLights() {
+	if (instances.empty()) {
+		return;
+	}
+	// 实例阵列的包围盒（模型半径按世界缩放计入）
+	float worldScale = glm::length(glm::vec3(modelMatrix[0]));
+	glm::vec3 boundsMin(std::numeric_limits<float>::max());
+	glm::vec3 boundsMax(-std::numeric_limits<float>::max());
+	for (const InstanceData& instance : instances) {
+		glm::vec3 center = glm::vec3(instance.modelMatrix * glm::vec4(meshBounds.center, 1.0f));
+		boundsMin = glm::min(boundsMin, center - meshBounds.radius * worldScale);
+		boundsMax = glm::max(boundsMax, center + meshBounds.radius * worldScale);
+	}
+	glm::vec3 extent = glm::max(boundsMax - boundsMin, glm::vec3(1e-3f));
+	// 每个光源平均占据的体积的边长，半径取它的倍数，光源越多半径越小
+	float spacing = std::cbrt(extent.x * extent.y * extent.z / static_cast<float>(std::max(pointLightCount, 1u)));
+	float radius = 1.5f * spacing;
+
+	std::mt19937 random(7);
+	std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+	pointLights.resize(pointLightCount);
+	pointLightOrbits.resize(pointLightCount);
+	for (uint32_t i = 0; i < pointLightCount; ++i) {
+		glm::vec3 center = boundsMin + extent * glm::vec3(unit(random), unit(random), unit(random));
+		float angularSpeed = (unit(random) - 0.5f) * 2.0f;
+		pointLightOrbits[i] = glm::vec4(center, angularSpeed);
+		PointLight& light = pointLights[i];
+		light.radius = radius;
+		// 色相均匀分布的饱和色
+		float hue = unit(random) * 6.0f;
+		light.color = glm::clamp(glm::vec3(std::abs(hue - 3.0f) - 1.0f, 2.0f - std::abs(hue - 2.0f), 2.0f - std::abs(hue - 4.0f)), 0.0f, 1.0f);
+		light.intensity = 0.5f;
+	}
+	pointLightOrbitRadius = 0.5f * spacing;
+	LOG("Point lights: %u, radius %.3f\n", pointLightCount, radius);
+}
+
+void Application::UpdatePointLights(float time) {
+	for (size_t i = 0; i < pointLights.size(); ++i) {
+		const glm::vec4& orbit = pointLightOrbits[i];
+		float angle = time * orbit.w + static_cast<float>(i);
+		pointLights[i].position = glm::vec3(orbit) + pointLightOrbitRadius * glm::vec3(std::cos(angle), std::sin(angle), 0.0f);
+	}
+	lightClusterer.SetLights(pointLights.data(), std::min(activePointLightCount, static_cast<uint32_t>(pointLights.size())));
 }
 
 void Application::Terminate() {
 	// Move all the release/destroy/terminate calls here
 	vertexBuffer.destroy();
 	vertexBuffer.release();
-
-	depthTextureView.release();
-	depthTexture.destroy();
-	depthTexture.release();
+	positionBuffer.destroy();
+	positionBuffer.release();
+	indexBuffer.destroy();
+	indexBuffer.release();
+	instanceBuffer.destroy();
+	instanceBuffer.release();
+	uniforms.Terminate();
+	renderQueue.Reset();
+	meshletCuller.Terminate();
+	occlusionCuller.Terminate();
+	shadowRenderer.Terminate();
+	lightClusterer.Terminate();
+	transparencyRenderer.Terminate();
+	gpuPrimitives.Terminate();
+	particleSystem.Terminate();
+	skinning.Terminate();
+	textureManager.Terminate();
+	virtualTextures.Terminate();
+
+	frameGraph.Clear();
+	renderTargetPool.Terminate();
 
 	pipeline.release();
+	depthEqualPipeline.release();
+	depthPrepassPipeline.release();
+	transparentPipeline.release();
 	shaderModule.release();
 	swapChain.release();
 	surface.unconfigure();
@@ -400,31 +1250,42 @@ void Application::Terminate() {
 	wgpuGLFWWindow.Terminate();
 }
 
-void Application::MainLoop() {
-	glfwPollEvents();
-	// LOG("Main loop begin\n");
-
-	// 更新 uniform buffer
-	uniform.time = static_cast<float>(glfwGetTime()); // glfwGetTime returns a double
-	// 仅更新 uniformBuffer 的第一个 float
-	queue.writeBuffer(uniformBuffer, offsetof(Uniform, time), &uniform.time, sizeof(Uniform::time));
-
-	// 更新视角矩阵
-	float angle1 = uniform.time;
-	glm::mat4x4 R1 = glm::rotate(glm::mat4x4(1.0), angle1, glm::vec3(0.0, 0.0, 1.0));
-	glm::mat4x4 T1 = glm::mat4x4(1.0);
-	glm::mat4x4 S = glm::scale(glm::mat4x4(1.0), glm::vec3(0.3f));
-	uniform.modelMatrix = R1 * T1 * S;
-	queue.writeBuffer(uniformBuffer, offsetof(Uniform, modelMatrix), &uniform.modelMatrix, sizeof(Uniform::modelMatrix));
-
-	// std::cout << uniform << "\n";
-  // 获取 view
-  wgpu::TextureView nextTexture = swapChain.getCurrentTextureView();
-	checkNullPointerError(nextTexture, "nextTexture");
-  if(!nextTexture) {
-    throw std::runtime_error("Failed to get next surface texture view");
-    return;
-  }
+void Application::RenderFrame(wgpu::TextureView target) {
+	// 动画时钟，暂停时停在当前时刻
+	double now = glfwGetTime();
+	if (!animationPaused) {
+		animationTime += now - animationClock;
+	}
+	animationClock = now;
+	float time = static_cast<float>(animationTime);
+	// 只修改 CPU 端的 uniform，帧末统一上传
+	bool animated = time != uniforms.Get().time;
+	uniforms.Set(&Uniform::time, time);
+
+	if (animated) {
+		// 骨骼动画的姿态在工作线程上计算，与下面准备本帧的工作并行，蒙皮通道中再等待结果
+		skinning.BeginUpdate(time, 0.5f + 0.5f * std::sin(0.5f * time));
+
+		// 更新模型动画矩阵
+		float angle1 = time;
+		glm::mat4x4 R1 = glm::rotate(glm::mat4x4(1.0), angle1, glm::vec3(0.0, 0.0, 1.0));
+		glm::mat4x4 T1 = glm::mat4x4(1.0);
+		glm::mat4x4 S = glm::scale(glm::mat4x4(1.0), glm::vec3(0.3f));
+		modelMatrix = R1 * T1 * S;
+
+		// 动态点光源
+		UpdatePointLights(time);
+	}
+	// 带模型动画的实例在动画时重新组合，相机变化时全部重新组合，只上传变化的部分
+	uint32_t changedInstanceCount = UpdateInstanceTransforms();
+	if (changedInstanceCount > 0) {
+		queue.writeBuffer(instanceBuffer, 0, instances.data(), changedInstanceCount * sizeof(InstanceData));
+	}
+	frameInstancesMoved = changedInstanceCount > 0;
+	// 画面变化后虚拟纹理的反馈重新轮换一遍，静止的画面不再修改反馈参数
+	if (animated || frameInstancesMoved) {
+		virtualTextures.RestartFeedbackSweep();
+	}
 
   // 创建 command encoder
   wgpu::CommandEncoderDescriptor encoderDesc = {};
@@ -433,65 +1294,89 @@ void Application::MainLoop() {
 	checkNullPointerError(encoder, "commandencoder");
 	// LOG("Command encoder\n");
 
-  // 创建 render pass 描述符
-  wgpu::RenderPassDescriptor renderPassDesc = {};
-
-  // 渲染管道描述符的 attachment 描述了通道的目标纹理
-  wgpu::RenderPassColorAttachment colorAttachment = {};
-  colorAttachment.view = nextTexture;
-  colorAttachment.resolveTarget = nullptr;
-  colorAttachment.loadOp = wgpu::LoadOp::Clear;
-  colorAttachment.storeOp = wgpu::StoreOp::Store;
-  colorAttachment.clearValue = wgpu::Color{ 0.05, 0.05, 0.05, 1.0 };
-#ifndef WEBGPU_BACKEND_WGPU
-	colorAttachment.depthSlice = WGPU_DEPTH_SLICE_UNDEFINED;
-#endif // NOT WEBGPU_BACKEND_WGPU
-  renderPassDesc.colorAttachmentCount = 1;
-  renderPassDesc.colorAttachments = &colorAttachment;
-	// LOG("RenderPassDescriptor\n");
-
-	// 创建深度缓冲区
-	wgpu::RenderPassDepthStencilAttachment depthStencilAttachment;
-	depthStencilAttachment.view = depthTextureView;
-	depthStencilAttachment.depthClearValue = 1.0f;
-	depthStencilAttachment.depthLoadOp = wgpu::LoadOp::Clear;
-	depthStencilAttachment.depthStoreOp = wgpu::StoreOp::Store;
-	depthStencilAttachment.depthReadOnly = false;
-	depthStencilAttachment.stencilClearValue = 0;
-#ifdef WEBGPU_BACKEND_WGPU
-	depthStencilAttachment.stencilLoadOp = LoadOp::Clear;
-	depthStencilAttachment.stencilStoreOp = StoreOp::Store;
-#else
-	depthStencilAttachment.stencilLoadOp = wgpu::LoadOp::Undefined;
-	depthStencilAttachment.stencilStoreOp = wgpu::StoreOp::Undefined;
-#endif
-	depthStencilAttachment.stencilReadOnly = true;
-	// LOG("DepthStencilAttachment");
-
-  renderPassDesc.depthStencilAttachment = &depthStencilAttachment;
-
-
-	renderPassDesc.timestampWrites = 0;
-  renderPassDesc.timestampWrites = nullptr;
-
-  // 创建 render pass
-  wgpu::RenderPassEncoder renderPass = encoder.beginRenderPass(renderPassDesc);
-	checkNullPointerError(renderPass, "renderPass");
-  
-	// 选择使用的 pipeline
-	renderPass.setPipeline(pipeline);
-	// 设置 vertex buffer
-	renderPass.setVertexBuffer(0, vertexBuffer, 0, vertexData.size() * sizeof(VertexAttributes)); 
-	// 设置 binding group
-	renderPass.setBindGroup(0, bindGroup, 0, nullptr);
+	// 虚拟纹理：处理回读的反馈，上传新加载的页
+	// 有新页上传说明画面缺过页，反馈每帧只覆盖部分像素，连续画够一轮才能请求到剩下缺的页
+	if (virtualTextures.Update(frameIndex)) {
+		invalidatedFrames = std::max(invalidatedFrames, VirtualTextureSystem::kFeedbackPhases);
+	}
 
-	// Draw 1 instance of a 3-vertices shape
-	renderPass.draw(static_cast<int>(vertexData.size()), 1, 0, 0);
+	// 每个实例按投影到屏幕上的误差选择 LOD
+	glm::vec3 eye = glm::vec3(glm::inverse(viewMatrix)[3]);
+	float worldScale = glm::length(glm::vec3(modelMatrix[0]));
+	float pixelsPerUnit = 0.5f * static_cast<float>(wgpuGLFWWindow.window_size.height)
+		* projectionMatrix[1][1] / std::abs(projectionMatrix[2][3]);
+	// 只绘制前 instanceDrawLimit 个实例
+	uint32_t drawnInstanceCount = std::min<uint32_t>(instanceDrawLimit, static_cast<uint32_t>(instances.size()));
+	std::pmr::vector<uint32_t> instanceLods(drawnInstanceCount, &frameArena);
+	std::pmr::vector<float> instanceDepths(drawnInstanceCount, &frameArena);
+	// 使用最高精度 LOD 的实例交给 meshlet 剔除（没有 IndirectFirstInstance 特性时只能处理 0 号实例），
+	// 蒙皮的实例形状每帧变化，meshlet 的包围球和法线锥不再适用，不参与
+	std::pmr::vector<uint32_t> meshletCulledInstances(&frameArena);
+	uint32_t meshletOverflow = 0;
+	for (uint32_t i = 0; i < drawnInstanceCount; ++i) {
+		glm::vec3 center = glm::vec3(instances[i].modelMatrix * glm::vec4(meshBounds.center, 1.0f));
+		float distance = glm::length(center - eye) - meshBounds.radius * worldScale;
+		instanceDepths[i] = (viewMatrix * glm::vec4(center, 1.0f)).z / cameraFar;
+		instanceLods[i] = static_cast<uint32_t>(selectLod(meshLods, distance, worldScale, pixelsPerUnit, lodPixelThreshold));
+		if (instanceLods[i] == 0 && !instanceTransparent[i] && !IsSkinned(i) && meshletCuller.IsReady() && (i == 0 || indirectFirstInstanceSupported)) {
+			if (meshletCulledInstances.size() < MeshletCuller::kMaxInstances) {
+				meshletCulledInstances.push_back(i);
+			} else {
+				++meshletOverflow;
+			}
+		}
+	}
+	// 超出 meshlet 剔除槽位的实例按普通实例绘制（不做 meshlet 剔除），数量变化时输出
+	if (meshletOverflow != lastMeshletOverflow) {
+		LOG("Meshlet culling: %u instances over the %u-slot cap drawn without meshlet culling\n", meshletOverflow, MeshletCuller::kMaxInstances);
+		lastMeshletOverflow = meshletOverflow;
+	}
 
-	renderPass.end();
-	renderPass.release();
+	// meshlet 剔除的参数
+	frameCullParams.frustumPlanes = extractFrustumPlanes(projectionMatrix * viewMatrix);
+	frameCullParams.cameraPosition = glm::vec4(eye, 1.0f);
+	frameInstanceLods = instanceLods;
+	frameMeshletInstances = meshletCulledInstances;
+	frameInstanceDepths = instanceDepths;
+
+	// 遮挡剔除的实例：世界空间包围球和选中 LOD 的绘制参数，交给 meshlet 剔除的实例和透明实例不参与
+	if (occlusionCuller.IsReady()) {
+		std::pmr::vector<OcclusionInstance> occlusionInstances(drawnInstanceCount, &frameArena);
+		size_t culledCursor = 0;
+		for (uint32_t i = 0; i < drawnInstanceCount; ++i) {
+			const glm::mat4x4& model = instances[i].modelMatrix;
+			float scale = std::max({ glm::length(glm::vec3(model[0])), glm::length(glm::vec3(model[1])), glm::length(glm::vec3(model[2])) });
+			// 蒙皮的实例可能超出绑定姿态的包围球
+			if (IsSkinned(i)) {
+				scale *= skinnedBoundsScale;
+			}
+			const MeshLod& lod = meshLods[instanceLods[i]];
+			OcclusionInstance& occlusionInstance = occlusionInstances[i];
+			occlusionInstance.sphere = glm::vec4(glm::vec3(model * glm::vec4(meshBounds.center, 1.0f)), meshBounds.radius * scale);
+			occlusionInstance.indexCount = lod.indexCount;
+			occlusionInstance.instanceCount = 1;
+			occlusionInstance.firstIndex = lod.firstIndex;
+			occlusionInstance.firstInstance = i;
+			if (culledCursor < meshletCulledInstances.size() && meshletCulledInstances[culledCursor] == i) {
+				occlusionInstance.instanceCount = 0;
+				++culledCursor;
+			}
+			// 透明实例不遮挡其他物体，在透明通道中直接绘制
+			if (instanceTransparent[i]) {
+				occlusionInstance.instanceCount = 0;
+			}
+		}
+		occlusionCuller.SetInstances(occlusionInstances.data(), static_cast<uint32_t>(occlusionInstances.size()));
+	}
 
-	nextTexture.release();
+	// 按编译好的顺序录制整帧：剔除、分簇光源、阴影、主渲染通道（遮挡剔除时分前后两期）、透明通道与合成、反馈回读
+	frameGraph.SetImportedTexture(backbufferResource, target);
+	frameGraph.SetBackbufferSize(wgpuGLFWWindow.window_size.width, wgpuGLFWWindow.window_size.height);
+	frameGraph.Execute(encoder, renderTargetPool);
+	frameGraph.SetImportedTexture(backbufferResource, nullptr);
+	frameInstanceLods = {};
+	frameMeshletInstances = {};
+	frameInstanceDepths = {};
 
   // 执行 encoder 并且提交
   wgpu::CommandBufferDescriptor cmdBufferDesacriptor = {};
@@ -502,9 +1387,96 @@ void Application::MainLoop() {
 	checkNullPointerError(command, "command");
   encoder.release(); // <--  释放 encoder
 
+	// 本帧修改过的 uniform 字段合并后上传（在提交之前，本帧的命令读到新值）
+	// 统计本帧所有的 writeBuffer/writeTexture（各子系统只在内容变化时上传），静止的帧应该为 0
+	uint32_t uploads = uniforms.Flush() + (changedInstanceCount > 0 ? 1u : 0u)
+		+ lightClusterer.TakeUploadCount() + meshletCuller.TakeUploadCount() + occlusionCuller.TakeUploadCount()
+		+ shadowRenderer.TakeUploadCount() + particleSystem.TakeUploadCount() + skinning.TakeUploadCount()
+		+ virtualTextures.TakeUploadCount();
+	if (uploads != lastFrameUploads) {
+		LOG("Frame %llu uploads: %u\n", static_cast<unsigned long long>(frameIndex), uploads);
+		lastFrameUploads = uploads;
+	}
+
 	// LOG("Submitting command...\n");
-	queue.submit(command);
+	queue.submit(1, &command);
 	command.release();
+	virtualTextures.OnSubmitted();
+	occlusionCuller.OnSubmitted();
+	gpuPrimitives.OnSubmitted();
+}
+
+void Application::Invalidate() {
+	// 只重绘一帧；这一帧的反馈发现缺页时，加载和上传期间继续渲染（见 IsFrameNeeded 和 RenderFrame）
+	invalidatedFrames = std::max(invalidatedFrames, 1u);
+}
+
+bool Application::IsFrameNeeded() {
+	return invalidatedFrames > 0 || !animationPaused || virtualTextures.HasPendingUploads();
+}
+
+void Application::MainLoop() {
+#ifdef ALLOC_COUNTER_ENABLED
+	uint64_t heapAllocationsBegin = getHeapAllocationCount();
+#endif // ALLOC_COUNTER_ENABLED
+
+#ifndef __EMSCRIPTEN__
+	if (wgpuGLFWWindow.isMinimized() || (onDemandRendering && !IsFrameNeeded())) {
+		// 最小化（任何模式）或按需渲染下没有要画的内容：阻塞到有事件（还原、重绘、缩放、页加载完成）或超时
+		glfwWaitEventsTimeout(virtualTextures.HasReadbackInFlight() ? kReadbackPollInterval : kIdleWaitTimeout);
+		// 不渲染时也推进设备，完成上一帧反馈的回读，缺页交给加载线程
+#if defined(WEBGPU_BACKEND_DAWN)
+		device.tick();
+#elif defined(WEBGPU_BACKEND_WGPU)
+		device.poll(false);
+#endif
+		virtualTextures.PollFeedback();
+	} else {
+		glfwPollEvents();
+	}
+#else
+	glfwPollEvents();
+#endif // NOT __EMSCRIPTEN__
+	// LOG("Main loop begin\n");
+	if (wgpuGLFWWindow.pollInvalidated()) {
+		Invalidate();
+	}
+
+	// 最小化时没有可以绘制的交换链
+	if (wgpuGLFWWindow.isMinimized()) {
+		return;
+	}
+	if (wgpuGLFWWindow.pollResize()) {
+		OnResize();
+		Invalidate();
+	}
+
+	// 按需渲染：画面没有变化时不渲染也不呈现，交换链中保持上一次的画面
+	if (onDemandRendering && !IsFrameNeeded()) {
+		if (!idle) {
+			LOG("Idle after frame %llu\n", static_cast<unsigned long long>(frameIndex));
+			idle = true;
+		}
+		return;
+	}
+	if (idle) {
+		LOG("Rendering resumed at frame %llu\n", static_cast<unsigned long long>(frameIndex));
+		idle = false;
+	}
+	invalidatedFrames = invalidatedFrames > 0 ? invalidatedFrames - 1 : 0;
+
+	// std::cout << uniforms.Get() << "\n";
+  // 获取 view
+  wgpu::TextureView nextTexture = swapChain.getCurrentTextureView();
+	checkNullPointerError(nextTexture, "nextTexture");
+  if(!nextTexture) {
+    throw std::runtime_error("Failed to get next surface texture view");
+    return;
+  }
+
+	RenderFrame(nextTexture);
+	nextTexture.release();
+
 	// LOG("Command submitted.\n");
 	swapChain.present();
 	// At the end of the frame
@@ -519,10 +1491,119 @@ void Application::MainLoop() {
 	device.poll(false);
 #endif
 
+	// 帧结束，回收本帧的临时分配
+	frameArena.reset();
+	renderTargetPool.EndFrame();
+
+#ifdef ALLOC_COUNTER_ENABLED
+	// 统计本帧的堆分配次数，只在数值变化时输出
+	uint64_t heapAllocations = getHeapAllocationCount() - heapAllocationsBegin;
+	if (heapAllocations != lastFrameHeapAllocations) {
+		LOG("Frame %llu heap allocations: %llu (arena capacity %zu bytes)\n",
+			static_cast<unsigned long long>(frameIndex), static_cast<unsigned long long>(heapAllocations), frameArena.capacity());
+		lastFrameHeapAllocations = heapAllocations;
+	}
+#endif // ALLOC_COUNTER_ENABLED
+	++frameIndex;
+
 	// LOG("Main loop end\n");
 }
 
 
+void Application::SetDepthPrepass(bool enabled) {
+	useDepthPrepass = enabled;
+	if (pipeline) {
+		BuildFrameGraph();
+	}
+	Invalidate();
+}
+
+void Application::WaitForGpu() {
+	bool done = false;
+	auto callback = queue.onSubmittedWorkDone([&done](wgpu::QueueWorkDoneStatus) { done = true; });
+	while (!done) {
+#if defined(WEBGPU_BACKEND_DAWN)
+		device.tick();
+#elif defined(WEBGPU_BACKEND_WGPU)
+		device.poll(false);
+#endif
+	}
+}
+
+void Application::RunDepthPrepassBenchmark() {
+	constexpr uint32_t kWarmupFrames = 10;
+	constexpr uint32_t kMeasuredFrames = 60;
+
+	// 离屏渲染目标，格式与交换链相同
+	RenderTargetDesc targetDesc;
+	targetDesc.format = swapChainFormat;
+	targetDesc.width = wgpuGLFWWindow.window_size.width;
+	targetDesc.height = wgpuGLFWWindow.window_size.height;
+	RenderTarget target = renderTargetPool.Acquire(targetDesc, "Depth prepass benchmark target");
+
+	// 连续提交 frameCount 帧后等待 GPU 执行完，返回平均每帧的毫秒数（GPU 是瓶颈时约等于 GPU 帧时间）
+	auto renderFrames = [&](uint32_t frameCount) {
+		auto begin = std::chrono::steady_clock::now();
+		for (uint32_t frame = 0; frame < frameCount; ++frame) {
+			glfwPollEvents();
+			RenderFrame(target.view);
+#if defined(WEBGPU_BACKEND_DAWN)
+			device.tick();
+#elif defined(WEBGPU_BACKEND_WGPU)
+			device.poll(false);
+#endif
+			frameArena.reset();
+			renderTargetPool.EndFrame();
+			++frameIndex;
+		}
+		WaitForGpu();
+		std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - begin;
+		return elapsed.count() / frameCount;
+	};
+
+	// 深度复杂度：沿视线方向绘制的远景行数；片元开销：参与光照的点光源数
+	std::vector<uint32_t> rowCounts;
+	for (uint32_t rows : { 1u, farFieldRows / 4, farFieldRows / 2, farFieldRows }) {
+		if (rows > 0 && std::find(rowCounts.begin(), rowCounts.end(), rows) == rowCounts.end()) {
+			rowCounts.push_back(rows);
+		}
+	}
+	std::vector<uint32_t> lightCounts;
+	for (uint32_t lights : { 0u, pointLightCount / 16, pointLightCount / 4, pointLightCount }) {
+		if (std::find(lightCounts.begin(), lightCounts.end(), lights) == lightCounts.end()) {
+			lightCounts.push_back(lights);
+		}
+	}
+
+	bool depthPrepassWasEnabled = useDepthPrepass;
+	LOG("Depth prepass benchmark: %ux%u, %u frames per configuration, occlusion culling %s\n",
+		targetDesc.width, targetDesc.height, kMeasuredFrames, occlusionCuller.IsReady() ? "on" : "off");
+	LOG("  rows  lights  no prepass     prepass\n");
+	for (uint32_t rows : rowCounts) {
+		instanceDrawLimit = 1 + rows * farFieldColumns;
+		shadowRenderer.InvalidateStaticCache();
+		for (uint32_t lights : lightCounts) {
+			activePointLightCount = lights;
+			UpdatePointLights(uniforms.Get().time);
+			std::array<double, 2> frameTimes = {};
+			for (uint32_t mode = 0; mode < 2; ++mode) {
+				SetDepthPrepass(mode == 1);
+				renderFrames(kWarmupFrames);
+				frameTimes[mode] = renderFrames(kMeasuredFrames);
+			}
+			LOG("  %4u  %6u  %7.3f ms  %7.3f ms  (%+.1f%%)\n", rows, lights, frameTimes[0], frameTimes[1],
+				100.0 * (frameTimes[1] - frameTimes[0]) / frameTimes[0]);
+		}
+	}
+
+	instanceDrawLimit = UINT32_MAX;
+	activePointLightCount = UINT32_MAX;
+	UpdatePointLights(uniforms.Get().time);
+	shadowRenderer.InvalidateStaticCache();
+	SetDepthPrepass(depthPrepassWasEnabled);
+	renderTargetPool.Release(target);
+}
+
 bool Application::IsRunning() {
 	return !glfwWindowShouldClose(wgpuGLFWWindow.window);
 }
@@ -3,8 +3,28 @@
 #include "../utils/global.h"
 #include "../utils/data-structure.h"
 #include "../utils/utils.h"
+#include "../utils/frame-arena.h"
+#include "../utils/alloc-counter.h"
+#include "../utils/mesh-optimizer.h"
+#include "../utils/vertex-quantization.h"
+#include "../utils/mesh-simplifier.h"
+#include "../utils/transform-batch.h"
 
 #include "glfw-window.h"
+#include "meshlet-culler.h"
+#include "occlusion-culler.h"
+#include "texture-manager.h"
+#include "render-target-pool.h"
+#include "frame-graph.h"
+#include "light-clusterer.h"
+#include "shadow-renderer.h"
+#include "virtual-texture.h"
+#include "render-queue.h"
+#include "transparency-renderer.h"
+#include "gpu-primitives.h"
+#include "particle-system.h"
+#include "skinning.h"
+#include "uniform-buffer.h"
 
 
 namespace webgpu {
@@ -44,6 +64,62 @@ public:
 		*/
 	bool IsRunning();
 
+	/**
+		* @brief 设置场景中的动态点光源数量（在 Initialize 之前调用），默认 0，只有两个方向光
+		*/
+	void SetPointLightCount(uint32_t count) { pointLightCount = count; }
+
+	/**
+		* @brief 设置 GPU 粒子数上限（在 Initialize 之前调用），默认 0，即关闭
+		*/
+	void SetParticleCount(uint32_t count) { particleCount = count; }
+
+	/**
+		* @brief 在中心模型后方摆放 rows 行 columns 列的远景实例阵列（在 Initialize 之前调用），0 行表示只绘制中心的模型
+		*/
+	void SetFarField(uint32_t rows, uint32_t columns) { farFieldRows = rows; farFieldColumns = columns; }
+
+	/**
+		* @brief 远景阵列中每隔 columnStride 列一个透明实例，用加权混合 OIT 绘制（在 Initialize 之前调用），0 表示关闭
+		*/
+	void SetTransparentColumnStride(uint32_t columnStride) { transparentColumnStride = columnStride; }
+
+	/**
+		* @brief 开关中心模型的骨骼动画（沿模型竖轴生成的关节链，在 Initialize 之前调用），默认关闭
+		*/
+	void SetSkinning(bool enabled) { useSkinning = enabled; }
+
+	/**
+		* @brief 漫反射贴图是否按页流式加载（虚拟纹理，在 Initialize 之前调用），默认关闭，直接采样纹理管理器加载的贴图
+		*/
+	void SetVirtualTexture(bool enabled) { useVirtualTexture = enabled; }
+
+	/**
+		* @brief 开关深度预通道，Initialize 之后调用会重建帧图
+		*/
+	void SetDepthPrepass(bool enabled);
+
+	/**
+		* @brief 暂停/继续模型动画、骨骼动画和点光源的运动，暂停且相机不动时每帧不上传 uniform 和实例数据
+		*/
+	void SetAnimationPaused(bool paused) { animationPaused = paused; Invalidate(); }
+
+	/**
+		* @brief 按需渲染：画面没有失效（窗口重绘或缩放、动画、新加载的虚拟纹理页）时阻塞等待事件，不渲染也不呈现
+		*/
+	void SetOnDemandRendering(bool enabled) { onDemandRendering = enabled; Invalidate(); }
+
+	/**
+		* @brief 标记画面失效，按需渲染模式下重绘一帧
+		*/
+	void Invalidate();
+
+	/**
+		* @brief 深度预通道基准测试：按深度复杂度（绘制的远景行数）和片元开销（点光源数）
+		* 分别测量关闭/开启预通道时的帧时间，离屏渲染，不受垂直同步限制
+		*/
+	void RunDepthPrepassBenchmark();
+
 private:
 	/**
 		* @brief 获取下一个可用的纹理视图
@@ -60,6 +136,82 @@ private:
 		*/
 	void InitializePipeline();
 
+	/**
+		* @brief 按当前窗口尺寸创建交换链
+		*/
+	void CreateSwapChain();
+
+	/**
+		* @brief 按窗口宽高比更新投影矩阵
+		*/
+	void UpdateProjectionMatrix();
+
+	/**
+		* @brief 窗口缩放：重建交换链，更新投影矩阵
+		*/
+	void OnResize();
+
+	/**
+		* @brief 声明每帧的通道和资源：蒙皮、剔除、分簇光源、阴影、主渲染通道（遮挡剔除时分前后两期）、透明通道与合成、虚拟纹理反馈回读
+		*/
+	void BuildFrameGraph();
+
+	// 绘制实例的通道：深度预通道、主渲染通道、遮挡剔除的后期（只补画前期没画而现在可见的实例）、透明通道（只画透明实例）
+	enum class InstancePass { DepthPrepass, Main, Late, Transparent };
+
+	/**
+		* @brief 设置管线和缓冲区，绘制本帧的实例（meshlet 剔除的实例在前两种通道中绘制）
+		*/
+	void DrawInstances(wgpu::RenderPassEncoder& renderPass, InstancePass pass);
+
+	/**
+		* @brief 本轮主循环是否需要渲染：画面失效、动画在播放或有等待上传的虚拟纹理页
+		*/
+	bool IsFrameNeeded();
+
+	/**
+		* @brief 录制并提交一帧，画到 target 上
+		*/
+	void RenderFrame(wgpu::TextureView target);
+
+	/**
+		* @brief 等待已提交的命令在 GPU 上执行完
+		*/
+	void WaitForGpu();
+
+	/**
+		* @brief 生成实例：中心一个模型，加上沿视线方向排列的远景阵列
+		*/
+	void InitializeInstances();
+
+	/**
+		* @brief 组合实例的模型矩阵、MVP 和法向量矩阵：视图投影或摆放变化时批量重新组合全部实例，否则只更新带模型动画的实例
+		* @return 需要上传的实例数（从 0 号实例开始）
+		*/
+	uint32_t UpdateInstanceTransforms();
+
+	/**
+		* @brief 沿网格 z 轴生成一串关节并自动计算权重，创建摆动、扭转两个片段，交给蒙皮系统
+		* @param vertexData 顶点缓冲区的初始数据（与当前顶点格式一致）
+		* @param positionData 位置流的初始数据
+		*/
+	void InitializeSkinning(const void* vertexData, const void* positionData);
+
+	/**
+		* @brief 实例是否使用蒙皮后的顶点（带模型动画的实例）
+		*/
+	bool IsSkinned(uint32_t instance) const { return skinning.IsReady() && instance < dynamicInstanceCount; }
+
+	/**
+		* @brief 在实例阵列的包围盒内随机生成点光源，半径随数量缩放使每簇的光源数大致不变
+		*/
+	void InitializePointLights();
+
+	/**
+		* @brief 点光源绕各自的中心转动，上传到分簇光源的缓冲区
+		*/
+	void UpdatePointLights(float time);
+
 	/**
 		* @brief 读取着色器文件
  		*/
@@ -94,18 +246,175 @@ private:
 	wgpu::SwapChain swapChain = nullptr;
 	// 顶点缓冲区
 	wgpu::Buffer vertexBuffer = nullptr;
+	// 顶点缓冲区大小（字节）
+	uint64_t vertexBufferSize = 0;
+	// 只含位置的顶点流，深度预通道和阴影只读取它
+	wgpu::Buffer positionBuffer = nullptr;
+	uint64_t positionBufferSize = 0;
+	uint64_t positionStride = 0;
+	wgpu::VertexFormat positionFormat = wgpu::VertexFormat::Float32x3;
+	// 深度预通道：只写深度的管线，以及之后以 Equal 比较、不写深度的主管线
+	wgpu::RenderPipeline depthPrepassPipeline = nullptr;
+	wgpu::RenderPipeline depthEqualPipeline = nullptr;
+	bool useDepthPrepass = false;
+	// 透明实例的管线：深度只测试不写入，输出到 OIT 的累积与透过率附件
+	wgpu::RenderPipeline transparentPipeline = nullptr;
+	// 是否使用紧凑顶点格式（CompactVertexAttributes）
+	bool useCompactVertexFormat = true;
 	// 索引缓冲区
-	std::vector<VertexAttributes> vertexData;
-	// 深度纹理
-	wgpu::Texture depthTexture = nullptr;
-	// 深度纹理视图
-	wgpu::TextureView depthTextureView = nullptr;
-	// uniform
-	Uniform uniform = {};
-	// uniform buffer
-	wgpu::Buffer uniformBuffer = nullptr;
+	wgpu::Buffer indexBuffer = nullptr;
+	// 网格数据（顶点 + 索引，索引中依次存放各级 LOD）
+	Mesh mesh;
+	// LOD 链
+	std::vector<MeshLod> meshLods;
+	// 网格包围球（网格空间）
+	BoundingSphere meshBounds;
+	// 允许的最大屏幕空间误差（像素）
+	float lodPixelThreshold = 1.0f;
+	// 实例的摆放（平移/旋转/缩放，SoA），批量组合成 instances 中的矩阵
+	TransformBatch instanceTransforms;
+	// 实例数据
+	std::vector<InstanceData> instances;
+	// 上次组合实例变换时的视图投影矩阵，相机不动时静态实例的 MVP 不用重算
+	glm::mat4x4 instanceViewProjection = glm::mat4x4(0.0f);
+	// 摆放变化后置位，下次全部重新组合
+	bool instanceTransformsDirty = true;
+	// 上次组合带动画实例时的模型动画矩阵
+	glm::mat4x4 instanceModelMatrix = glm::mat4x4(0.0f);
+	// 只绘制前 N 个实例（基准测试用来改变深度复杂度）
+	uint32_t instanceDrawLimit = UINT32_MAX;
+	// 实例 storage buffer
+	wgpu::Buffer instanceBuffer = nullptr;
+	// 远景实例阵列（沿视线方向排列），默认 0 行，只绘制中心的一个模型
+	uint32_t farFieldRows = 0;
+	uint32_t farFieldColumns = 8;
+	// meshlet 剔除
+	MeshletCuller meshletCuller;
+	bool useMeshletCulling = true;
+	// 设备是否启用了 IndirectFirstInstance 特性
+	bool indirectFirstInstanceSupported = false;
+	// Hi-Z 遮挡剔除（按实例间接绘制，需要 IndirectFirstInstance 特性）
+	OcclusionCuller occlusionCuller;
+	bool useOcclusionCulling = true;
+	// 每个实例是否透明（不写深度，不参与遮挡剔除和 meshlet 剔除，在 OIT 通道中绘制）
+	std::vector<uint8_t> instanceTransparent;
+	// 远景阵列中每隔几列一个透明实例，默认 0，没有透明实例，也不创建 OIT 通道
+	uint32_t transparentColumnStride = 0;
+	// 透明实例的不透明度
+	float transparentOpacity = 0.4f;
+	// 加权混合的顺序无关透明
+	TransparencyRenderer transparencyRenderer;
+	// GPU 并行原语（前缀和、归约、流压缩、基数排序）
+	GpuPrimitives gpuPrimitives;
+	// GPU 粒子：中心模型上方的喷泉，默认 0，不创建粒子系统和它的通道
+	ParticleSystem particleSystem;
+	uint32_t particleCount = 0;
+	// 带模型动画的实例数（排在最前），其余实例是静态的阴影投射物
+	uint32_t dynamicInstanceCount = 1;
+	// 骨骼动画：带模型动画的实例使用蒙皮后的顶点，默认关闭（蒙皮的实例不参与 meshlet 剔除）
+	SkinningSystem skinning;
+	bool useSkinning = false;
+	uint32_t skinningJointCount = 8;
+	// 蒙皮后的网格相对绑定姿态的包围范围放大倍数（紧凑格式的量化范围、遮挡剔除的包围球）
+	float skinnedBoundsScale = 2.0f;
+	// 所有实例的包围球（世界空间）
+	BoundingSphere sceneBounds;
+	// 主光源的级联阴影
+	ShadowRenderer shadowRenderer;
+	// 指向主光源的方向
+	glm::vec3 keyLightDirection = glm::vec3(0.5f, -0.9f, 0.1f);
+	// 阴影覆盖到的视图空间深度
+	float shadowDistance = 30.0f;
+	// 相机的近/远平面
+	float cameraNear = 0.01f;
+	float cameraFar = 100.0f;
+	// 分簇点光源
+	LightClusterer lightClusterer;
+	uint32_t pointLightCount = 0;
+	// 参与光照的点光源数（基准测试用来改变片元开销），默认全部
+	uint32_t activePointLightCount = UINT32_MAX;
+	std::vector<PointLight> pointLights;
+	// 每个点光源转动的中心（xyz）与角速度（w）
+	std::vector<glm::vec4> pointLightOrbits;
+	// 点光源转动的半径
+	float pointLightOrbitRadius = 0.0f;
+	// 深度切片的范围（视图空间）
+	float clusterNear = 0.05f;
+	float clusterFar = 100.0f;
+	// 纹理管理器
+	TextureManager textureManager;
+	// 网格的漫反射贴图
+	TextureHandle baseColorTexture = kInvalidTexture;
+	// 虚拟纹理（按页流式加载的漫反射贴图）
+	VirtualTextureSystem virtualTextures;
+	VirtualTextureHandle baseColorVirtualTexture = kInvalidVirtualTexture;
+	// 默认关闭，虚拟纹理系统只提供占位的绑定资源
+	bool useVirtualTexture = false;
+	// 渲染队列：实例的绘制按管线、绑定组、几何和深度排序，只在状态变化时设置状态
+	RenderQueue renderQueue;
+	uint32_t mainPipelineId = 0;
+	uint32_t depthEqualPipelineId = 0;
+	uint32_t depthPrepassPipelineId = 0;
+	uint32_t transparentPipelineId = 0;
+	uint32_t sceneBindGroupId = 0;
+	// 完整顶点/位置流与原索引缓冲区、meshlet 剔除后的索引缓冲区的组合
+	uint32_t meshGeometryId = 0;
+	uint32_t positionGeometryId = 0;
+	uint32_t meshletGeometryId = 0;
+	uint32_t meshletPositionGeometryId = 0;
+	// 蒙皮后的顶点/位置流与原索引缓冲区的组合
+	uint32_t skinnedGeometryId = 0;
+	uint32_t skinnedPositionGeometryId = 0;
+	// 上一次主渲染通道的状态切换统计，变化时输出日志
+	RenderQueueStats lastRenderQueueStats;
+	// 上一帧 GPU 剔除前提交的三角形数，变化时输出日志
+	uint64_t lastDrawnTriangles = 0;
+	// 上一帧超出 meshlet 剔除槽位的实例数
+	uint32_t lastMeshletOverflow = 0;
+	// 与窗口尺寸相关的渲染目标池
+	RenderTargetPool renderTargetPool;
+	// 深度纹理格式
+	wgpu::TextureFormat depthTextureFormat = wgpu::TextureFormat::Depth24Plus;
+	// 帧图，初始化时声明并编译一次
+	FrameGraph frameGraph;
+	FrameGraphResource backbufferResource = kInvalidFrameGraphResource;
+	// 本帧的 LOD 选择与参与 meshlet 剔除的实例，在执行帧图前设置，供通道回调读取
+	std::span<const uint32_t> frameInstanceLods;
+	std::span<const uint32_t> frameMeshletInstances;
+	// 本帧每个实例包围球中心的视图空间深度（除以远平面），作为渲染队列排序键中的深度
+	std::span<const float> frameInstanceDepths;
+	MeshletCullUniform frameCullParams;
+	// 本帧是否上传了变化的实例变换（实例没动时 meshlet 剔除沿用上一次的结果）
+	bool frameInstancesMoved = false;
+	// 相机矩阵与模型动画矩阵，在 CPU 上组合进每个实例的 MVP
+	glm::mat4x4 projectionMatrix = glm::mat4x4(1.0f);
+	glm::mat4x4 viewMatrix = glm::mat4x4(1.0f);
+	glm::mat4x4 modelMatrix = glm::mat4x4(1.0f);
+	// uniform 及其缓冲区，按字段跟踪修改，每帧末尾合并上传
+	UniformBuffer<Uniform> uniforms{ kUniformLayout };
+	// 动画时钟（秒），暂停时不前进
+	bool animationPaused = false;
+	double animationTime = 0.0;
+	double animationClock = 0.0;
+	// 上一帧所有缓冲区和纹理的上传次数，变化时输出日志
+	uint32_t lastFrameUploads = UINT32_MAX;
+	// 按需渲染
+	bool onDemandRendering = false;
+	// 还需要重绘的帧数，第一帧总是要画
+	uint32_t invalidatedFrames = 1;
+	// 是否处于空闲（没有渲染），状态变化时输出日志
+	bool idle = false;
+	// 空闲时等待事件的超时（秒）；反馈回读还没完成时缩短，以便推进设备完成映射
+	static constexpr double kIdleWaitTimeout = 0.5;
+	static constexpr double kReadbackPollInterval = 0.005;
 	// bind group
 	wgpu::BindGroup bindGroup = nullptr;
+	// 帧级分配器，每帧的临时容器从这里分配，帧结束时重置
+	FrameArena frameArena{ 64 * 1024 };
+	// 帧计数
+	uint64_t frameIndex = 0;
+	// 上一帧的堆分配次数，变化时输出日志
+	uint64_t lastFrameHeapAllocations = UINT64_MAX;
 	// 着色器代码
 	std::string shaderCodeFilePath = "C:/Users/Sy200/Desktop/learn-WebGPU/src/shader/base.wgsl";
 	// ojb 地址
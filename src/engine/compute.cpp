@@ -0,0 +1,212 @@
+#include "compute.h"
+
+#include <algorithm>
+
+namespace webgpu {
+
+ComputeBinding ComputeBinding::Uniform(uint64_t minBindingSize) {
+	ComputeBinding binding;
+	binding.type = Type::Uniform;
+	binding.minBindingSize = minBindingSize;
+	return binding;
+}
+
+ComputeBinding ComputeBinding::ReadOnlyStorage() {
+	ComputeBinding binding;
+	binding.type = Type::ReadOnlyStorage;
+	return binding;
+}
+
+ComputeBinding ComputeBinding::Storage() {
+	ComputeBinding binding;
+	binding.type = Type::Storage;
+	return binding;
+}
+
+ComputeBinding ComputeBinding::Texture(wgpu::TextureSampleType sampleType) {
+	ComputeBinding binding;
+	binding.type = Type::Texture;
+	binding.sampleType = sampleType;
+	return binding;
+}
+
+ComputeBinding ComputeBinding::StorageTexture(wgpu::TextureFormat format) {
+	ComputeBinding binding;
+	binding.type = Type::StorageTexture;
+	binding.storageFormat = format;
+	return binding;
+}
+
+ComputeResource ComputeResource::Buffer(wgpu::Buffer buffer, uint64_t size, uint64_t offset) {
+	ComputeResource resource;
+	resource.buffer = buffer;
+	resource.size = size;
+	resource.offset = offset;
+	return resource;
+}
+
+ComputeResource ComputeResource::Texture(wgpu::TextureView view) {
+	ComputeResource resource;
+	resource.textureView = view;
+	return resource;
+}
+
+void ComputeKernel::Initialize(wgpu::Device device, const ComputeKernelDesc& desc) {
+	this->device = device;
+	bindingCount = static_cast<uint32_t>(desc.bindings.size());
+
+	wgpu::SupportedLimits limits;
+	device.getLimits(&limits);
+	maxWorkgroupsPerDimension = std::max(limits.limits.maxComputeWorkgroupsPerDimension, 1u);
+	workgroupSize = desc.workgroupSize;
+	if (desc.overridableWorkgroupSize) {
+		workgroupSize.x = std::max(1u, std::min({ workgroupSize.x, limits.limits.maxComputeWorkgroupSizeX,
+			limits.limits.maxComputeInvocationsPerWorkgroup / std::max(workgroupSize.y * workgroupSize.z, 1u) }));
+	}
+
+	// 绑定布局
+	std::vector<wgpu::BindGroupLayoutEntry> layoutEntries(desc.bindings.size(), wgpu::Default);
+	for (uint32_t i = 0; i < bindingCount; ++i) {
+		const ComputeBinding& binding = desc.bindings[i];
+		wgpu::BindGroupLayoutEntry& entry = layoutEntries[i];
+		entry.binding = i;
+		entry.visibility = wgpu::ShaderStage::Compute;
+		switch (binding.type) {
+		case ComputeBinding::Type::Uniform:
+			entry.buffer.type = wgpu::BufferBindingType::Uniform;
+			entry.buffer.minBindingSize = binding.minBindingSize;
+			break;
+		case ComputeBinding::Type::ReadOnlyStorage:
+			entry.buffer.type = wgpu::BufferBindingType::ReadOnlyStorage;
+			break;
+		case ComputeBinding::Type::Storage:
+			entry.buffer.type = wgpu::BufferBindingType::Storage;
+			break;
+		case ComputeBinding::Type::Texture:
+			entry.texture.sampleType = binding.sampleType;
+			entry.texture.viewDimension = binding.viewDimension;
+			break;
+		case ComputeBinding::Type::StorageTexture:
+			entry.storageTexture.access = wgpu::StorageTextureAccess::WriteOnly;
+			entry.storageTexture.format = binding.storageFormat;
+			entry.storageTexture.viewDimension = binding.viewDimension;
+			break;
+		}
+	}
+	wgpu::BindGroupLayoutDescriptor bindGroupLayoutDesc{};
+	bindGroupLayoutDesc.entryCount = (uint32_t)layoutEntries.size();
+	bindGroupLayoutDesc.entries = layoutEntries.data();
+	bindGroupLayout = device.createBindGroupLayout(bindGroupLayoutDesc);
+
+	wgpu::PipelineLayoutDescriptor layoutDesc{};
+	layoutDesc.bindGroupLayoutCount = 1;
+	layoutDesc.bindGroupLayouts = (WGPUBindGroupLayout*)&bindGroupLayout;
+	wgpu::PipelineLayout layout = device.createPipelineLayout(layoutDesc);
+
+	wgpu::ConstantEntry workgroupConstant = wgpu::Default;
+	workgroupConstant.key = "workgroupSize";
+	workgroupConstant.value = static_cast<double>(workgroupSize.x);
+
+	wgpu::ComputePipelineDescriptor pipelineDesc{};
+	pipelineDesc.label = desc.label;
+	pipelineDesc.layout = layout;
+	pipelineDesc.compute.module = desc.module;
+	pipelineDesc.compute.entryPoint = desc.entryPoint;
+	pipelineDesc.compute.constantCount = desc.overridableWorkgroupSize ? 1 : 0;
+	pipelineDesc.compute.constants = desc.overridableWorkgroupSize ? &workgroupConstant : nullptr;
+	pipeline = device.createComputePipeline(pipelineDesc);
+	layout.release();
+	if (!pipeline) {
+		LOG("Failed to create compute pipeline %s\n", desc.label);
+		throw std::runtime_error(std::string("Failed to create compute pipeline ") + desc.label);
+	}
+}
+
+wgpu::BindGroup ComputeKernel::CreateBindGroup(std::span<const ComputeResource> resources) const {
+	std::vector<wgpu::BindGroupEntry> bindings(bindingCount);
+	for (uint32_t i = 0; i < bindingCount && i < resources.size(); ++i) {
+		bindings[i].binding = i;
+		if (resources[i].textureView) {
+			bindings[i].textureView = resources[i].textureView;
+		} else {
+			bindings[i].buffer = resources[i].buffer;
+			bindings[i].offset = resources[i].offset;
+			bindings[i].size = resources[i].size;
+		}
+	}
+	wgpu::BindGroupDescriptor bindGroupDesc;
+	bindGroupDesc.layout = bindGroupLayout;
+	bindGroupDesc.entryCount = (uint32_t)bindings.size();
+	bindGroupDesc.entries = bindings.data();
+	return device.createBindGroup(bindGroupDesc);
+}
+
+void ComputeKernel::Terminate() {
+	if (!pipeline) {
+		return;
+	}
+	bindGroupLayout.release();
+	bindGroupLayout = nullptr;
+	pipeline.release();
+	pipeline = nullptr;
+}
+
+ComputePass::ComputePass(wgpu::CommandEncoder& encoder, const char* label) {
+	wgpu::ComputePassDescriptor computePassDesc = {};
+	computePassDesc.label = label;
+	pass = encoder.beginComputePass(computePassDesc);
+}
+
+ComputePass::~ComputePass() {
+	End();
+}
+
+void ComputePass::End() {
+	if (pass) {
+		pass.end();
+		pass.release();
+		pass = nullptr;
+	}
+}
+
+void ComputePass::Bind(const ComputeKernel& kernel, wgpu::BindGroup bindGroup) {
+	WGPUComputePipeline pipeline = kernel.GetPipeline();
+	if (pipeline != currentPipeline) {
+		pass.setPipeline(kernel.GetPipeline());
+		currentPipeline = pipeline;
+		// 管线变化后重新设置绑定组（不同内核的布局不兼容）
+		currentBindGroup = nullptr;
+	}
+	if (static_cast<WGPUBindGroup>(bindGroup) != currentBindGroup) {
+		pass.setBindGroup(0, bindGroup, 0, nullptr);
+		currentBindGroup = bindGroup;
+	}
+}
+
+void ComputePass::Dispatch(const ComputeKernel& kernel, wgpu::BindGroup bindGroup, uint32_t groupsX, uint32_t groupsY, uint32_t groupsZ) {
+	if (groupsX == 0 || groupsY == 0 || groupsZ == 0) {
+		return;
+	}
+	Bind(kernel, bindGroup);
+	pass.dispatchWorkgroups(groupsX, groupsY, groupsZ);
+}
+
+void ComputePass::DispatchThreads(const ComputeKernel& kernel, wgpu::BindGroup bindGroup, uint32_t threadsX, uint32_t threadsY, uint32_t threadsZ) {
+	const glm::uvec3& size = kernel.GetWorkgroupSize();
+	uint32_t groupsX = workgroupCount(threadsX, size.x);
+	uint32_t groupsY = workgroupCount(threadsY, size.y);
+	uint32_t groupsZ = workgroupCount(threadsZ, size.z);
+	uint32_t maxGroups = kernel.GetMaxWorkgroupsPerDimension();
+	if (groupsX > maxGroups && groupsY == 1 && groupsZ == 1) {
+		groupsY = workgroupCount(groupsX, maxGroups);
+		groupsX = workgroupCount(groupsX, groupsY);
+	}
+	Dispatch(kernel, bindGroup, groupsX, groupsY, groupsZ);
+}
+
+void ComputePass::DispatchIndirect(const ComputeKernel& kernel, wgpu::BindGroup bindGroup, wgpu::Buffer indirectBuffer, uint64_t indirectOffset) {
+	Bind(kernel, bindGroup);
+	pass.dispatchWorkgroupsIndirect(indirectBuffer, indirectOffset);
+}
+
+}
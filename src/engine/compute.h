@@ -0,0 +1,152 @@
+#pragma once
+
+#include "../utils/global.h"
+
+namespace webgpu {
+
+/**
+ * 计算管线中一个绑定的类型（绑定号按声明顺序从 0 开始）
+ */
+struct ComputeBinding {
+	enum class Type { Uniform, ReadOnlyStorage, Storage, Texture, StorageTexture };
+
+	Type type = Type::Storage;
+	// Uniform 的最小绑定大小，0 表示不检查
+	uint64_t minBindingSize = 0;
+	// Texture 的采样类型
+	wgpu::TextureSampleType sampleType = wgpu::TextureSampleType::UnfilterableFloat;
+	// StorageTexture 的格式（只写）
+	wgpu::TextureFormat storageFormat = wgpu::TextureFormat::Undefined;
+	wgpu::TextureViewDimension viewDimension = wgpu::TextureViewDimension::_2D;
+
+	static ComputeBinding Uniform(uint64_t minBindingSize);
+	static ComputeBinding ReadOnlyStorage();
+	static ComputeBinding Storage();
+	static ComputeBinding Texture(wgpu::TextureSampleType sampleType);
+	static ComputeBinding StorageTexture(wgpu::TextureFormat format);
+};
+
+/**
+ * 创建绑定组时一个绑定对应的资源：缓冲区的一段，或纹理视图
+ */
+struct ComputeResource {
+	wgpu::Buffer buffer = nullptr;
+	uint64_t offset = 0;
+	uint64_t size = 0;
+	wgpu::TextureView textureView = nullptr;
+
+	static ComputeResource Buffer(wgpu::Buffer buffer, uint64_t size, uint64_t offset = 0);
+	static ComputeResource Texture(wgpu::TextureView view);
+};
+
+/**
+ * 计算内核的描述
+ */
+struct ComputeKernelDesc {
+	const char* label = "Compute kernel";
+	wgpu::ShaderModule module = nullptr;
+	const char* entryPoint = "cs_main";
+	std::vector<ComputeBinding> bindings;
+	// 着色器中 @workgroup_size 的值
+	glm::uvec3 workgroupSize = glm::uvec3(64u, 1u, 1u);
+	// 为 true 时着色器用 override 常量 workgroupSize 声明 x 方向的大小，
+	// 实际大小取 workgroupSize.x 与设备的 maxComputeWorkgroupSizeX、maxComputeInvocationsPerWorkgroup 中较小的一个
+	bool overridableWorkgroupSize = false;
+};
+
+/**
+ * 计算内核：一个计算管线和它的绑定布局（只使用第 0 组）
+ */
+class ComputeKernel {
+public:
+	/**
+	 * @brief 创建绑定布局和计算管线，失败时抛出异常
+	 */
+	void Initialize(wgpu::Device device, const ComputeKernelDesc& desc);
+
+	/**
+	 * @brief 按声明的绑定顺序创建绑定组，由调用方释放
+	 */
+	wgpu::BindGroup CreateBindGroup(std::span<const ComputeResource> resources) const;
+
+	/**
+	 * @brief 一个工作组的线程数（可覆盖时已按设备限制截断）
+	 */
+	const glm::uvec3& GetWorkgroupSize() const { return workgroupSize; }
+
+	/**
+	 * @brief 设备每个维度允许的最大工作组数
+	 */
+	uint32_t GetMaxWorkgroupsPerDimension() const { return maxWorkgroupsPerDimension; }
+
+	wgpu::ComputePipeline GetPipeline() const { return pipeline; }
+
+	/**
+	 * @brief 销毁
+	 */
+	void Terminate();
+
+	/**
+	 * @brief 是否已初始化
+	 */
+	bool IsReady() const { return pipeline != nullptr; }
+
+private:
+	wgpu::Device device = nullptr;
+	wgpu::ComputePipeline pipeline = nullptr;
+	wgpu::BindGroupLayout bindGroupLayout = nullptr;
+	uint32_t bindingCount = 0;
+	glm::uvec3 workgroupSize = glm::uvec3(1u);
+	uint32_t maxWorkgroupsPerDimension = 65535;
+};
+
+/**
+ * @brief 覆盖 count 个元素需要的工作组数（向上取整）
+ */
+inline uint32_t workgroupCount(uint32_t count, uint32_t workgroupSize) {
+	return (count + workgroupSize - 1) / workgroupSize;
+}
+
+/**
+ * 一个计算通道，在同一个 encoder 中连续录制多次分发
+ * WebGPU 在同一计算通道内相邻两次分发之间自动同步存储资源的读写，前一次的输出可以直接作为后一次的输入。
+ * 相同的管线和绑定组不重复设置；析构时结束通道。
+ */
+class ComputePass {
+public:
+	ComputePass(wgpu::CommandEncoder& encoder, const char* label);
+	~ComputePass();
+
+	ComputePass(const ComputePass&) = delete;
+	ComputePass& operator=(const ComputePass&) = delete;
+
+	/**
+	 * @brief 按工作组数分发
+	 */
+	void Dispatch(const ComputeKernel& kernel, wgpu::BindGroup bindGroup, uint32_t groupsX, uint32_t groupsY = 1, uint32_t groupsZ = 1);
+
+	/**
+	 * @brief 按线程总数分发（每个维度向上取整到工作组）
+	 * 一维时超过 maxComputeWorkgroupsPerDimension 的部分折叠到 y 方向，着色器用 num_workgroups 还原线性编号
+	 */
+	void DispatchThreads(const ComputeKernel& kernel, wgpu::BindGroup bindGroup, uint32_t threadsX, uint32_t threadsY = 1, uint32_t threadsZ = 1);
+
+	/**
+	 * @brief 间接分发，工作组数从缓冲区读取
+	 */
+	void DispatchIndirect(const ComputeKernel& kernel, wgpu::BindGroup bindGroup, wgpu::Buffer indirectBuffer, uint64_t indirectOffset = 0);
+
+	/**
+	 * @brief 提前结束通道
+	 */
+	void End();
+
+private:
+	void Bind(const ComputeKernel& kernel, wgpu::BindGroup bindGroup);
+
+	wgpu::ComputePassEncoder pass = nullptr;
+	WGPUComputePipeline currentPipeline = nullptr;
+	WGPUBindGroup currentBindGroup = nullptr;
+};
+
+}
@@ -0,0 +1,507 @@
+#include "frame-graph.h"
+
+#include <algorithm>
+
+namespace webgpu {
+
+namespace {
+
+template <typename T>
+void pushUnique(std::vector<T>& values, T value) {
+	if (std::find(values.begin(), values.end(), value) == values.end()) {
+		values.push_back(value);
+	}
+}
+
+template <typename T>
+bool contains(const std::vector<T>& values, T value) {
+	return std::find(values.begin(), values.end(), value) != values.end();
+}
+
+}
+
+void FrameGraph::PassBuilder::Read(FrameGraphResource resource) {
+	if (resource >= graph.resources.size()) {
+		throw std::runtime_error("Frame graph: invalid resource read by pass " + graph.passes[pass].name);
+	}
+	pushUnique(graph.passes[pass].reads, resource);
+	pushUnique(graph.resources[resource].readers, pass);
+}
+
+void FrameGraph::PassBuilder::Write(FrameGraphResource resource) {
+	if (resource >= graph.resources.size()) {
+		throw std::runtime_error("Frame graph: invalid resource written by pass " + graph.passes[pass].name);
+	}
+	pushUnique(graph.passes[pass].writes, resource);
+	pushUnique(graph.resources[resource].writers, pass);
+}
+
+void FrameGraph::PassBuilder::ColorAttachment(FrameGraphResource resource, wgpu::LoadOp loadOp, wgpu::Color clearValue) {
+	Pass& target = graph.passes[pass];
+	if (target.type != PassType::Render || target.colorAttachments.size() >= kMaxColorAttachments) {
+		throw std::runtime_error("Frame graph: too many color attachments in pass " + target.name);
+	}
+	Attachment attachment;
+	attachment.resource = resource;
+	attachment.loadOp = loadOp;
+	attachment.clearValue = clearValue;
+	target.colorAttachments.push_back(attachment);
+	if (loadOp == wgpu::LoadOp::Load) {
+		Read(resource);
+	}
+	Write(resource);
+}
+
+void FrameGraph::PassBuilder::DepthAttachment(FrameGraphResource resource, wgpu::LoadOp loadOp, float clearValue) {
+	Pass& target = graph.passes[pass];
+	if (target.type != PassType::Render) {
+		throw std::runtime_error("Frame graph: depth attachment in non-render pass " + target.name);
+	}
+	target.depthAttachment.resource = resource;
+	target.depthAttachment.loadOp = loadOp;
+	target.depthAttachment.depthClearValue = clearValue;
+	if (loadOp == wgpu::LoadOp::Load) {
+		Read(resource);
+	}
+	Write(resource);
+}
+
+void FrameGraph::PassBuilder::SideEffect() {
+	graph.passes[pass].sideEffect = true;
+}
+
+FrameGraphResource FrameGraph::ImportTexture(const char* name) {
+	Resource resource;
+	resource.name = name;
+	resource.type = ResourceType::Texture;
+	resource.imported = true;
+	resources.push_back(std::move(resource));
+	compiled = false;
+	return static_cast<FrameGraphResource>(resources.size() - 1);
+}
+
+FrameGraphResource FrameGraph::ImportBuffer(const char* name) {
+	Resource resource;
+	resource.name = name;
+	resource.type = ResourceType::Buffer;
+	resource.imported = true;
+	resources.push_back(std::move(resource));
+	compiled = false;
+	return static_cast<FrameGraphResource>(resources.size() - 1);
+}
+
+FrameGraphResource FrameGraph::CreateTexture(const char* name, const RenderTargetDesc& desc, bool matchBackbuffer) {
+	Resource resource;
+	resource.name = name;
+	resource.type = ResourceType::Texture;
+	resource.desc = desc;
+	resource.matchBackbuffer = matchBackbuffer;
+	resources.push_back(std::move(resource));
+	compiled = false;
+	return static_cast<FrameGraphResource>(resources.size() - 1);
+}
+
+uint32_t FrameGraph::AddPass(const char* name, PassType type) {
+	Pass pass;
+	pass.name = name;
+	pass.type = type;
+	passes.push_back(std::move(pass));
+	compiled = false;
+	return static_cast<uint32_t>(passes.size() - 1);
+}
+
+void FrameGraph::AddRenderPass(const char* name, const std::function<void(PassBuilder&)>& setup, RenderExecute execute) {
+	uint32_t index = AddPass(name, PassType::Render);
+	PassBuilder builder(*this, index);
+	setup(builder);
+	if (passes[index].colorAttachments.empty() && passes[index].depthAttachment.resource == kInvalidFrameGraphResource) {
+		throw std::runtime_error("Frame graph: render pass " + passes[index].name + " has no attachment");
+	}
+	passes[index].renderExecute = std::move(execute);
+}
+
+void FrameGraph::AddEncoderPass(const char* name, const std::function<void(PassBuilder&)>& setup, EncoderExecute execute) {
+	uint32_t index = AddPass(name, PassType::Encoder);
+	PassBuilder builder(*this, index);
+	setup(builder);
+	passes[index].encoderExecute = std::move(execute);
+}
+
+void FrameGraph::CullPasses() {
+	// 引用计数：通道的计数为它写的资源数，资源的计数为读取它的通道数。
+	// 从没有读者的资源出发，把只写这些资源的通道剔除，再递减被剔除通道读取的资源，直到不再变化
+	for (Pass& pass : passes) {
+		pass.culled = false;
+		pass.refCount = static_cast<uint32_t>(pass.writes.size());
+	}
+	// 读改写同一资源（如 LoadOp::Load 的附件）的通道不算作该资源的读者，否则它永远不会被剔除
+	for (Resource& resource : resources) {
+		resource.refCount = 0;
+		for (uint32_t reader : resource.readers) {
+			resource.refCount += contains(resource.writers, reader) ? 0 : 1;
+		}
+	}
+	auto keep = [this](const Pass& pass) {
+		if (pass.sideEffect) {
+			return true;
+		}
+		for (FrameGraphResource resource : pass.writes) {
+			if (resources[resource].imported) {
+				return true;
+			}
+		}
+		return false;
+	};
+
+	std::vector<FrameGraphResource> unreferenced;
+	auto cull = [&](Pass& pass) {
+		pass.culled = true;
+		for (FrameGraphResource resource : pass.reads) {
+			if (contains(pass.writes, resource)) {
+				continue;
+			}
+			if (resources[resource].refCount > 0 && --resources[resource].refCount == 0) {
+				unreferenced.push_back(resource);
+			}
+		}
+	};
+	for (Pass& pass : passes) {
+		if (pass.refCount == 0 && !keep(pass)) {
+			cull(pass);
+		}
+	}
+	for (FrameGraphResource resource = 0; resource < resources.size(); ++resource) {
+		if (resources[resource].refCount == 0) {
+			unreferenced.push_back(resource);
+		}
+	}
+	while (!unreferenced.empty()) {
+		FrameGraphResource resource = unreferenced.back();
+		unreferenced.pop_back();
+		for (uint32_t writer : resources[resource].writers) {
+			Pass& pass = passes[writer];
+			if (pass.culled || keep(pass)) {
+				continue;
+			}
+			if (pass.refCount > 0 && --pass.refCount == 0) {
+				cull(pass);
+			}
+		}
+	}
+
+	// 读改写的通道不计入引用，保留下来的这类通道要把在它之前写同一资源的通道（及其输入）找回来，
+	// 例如深度预通道之后以 LoadOp::Load 使用深度的主渲染通道
+	for (bool restored = true; restored;) {
+		restored = false;
+		for (uint32_t index = 0; index < passes.size(); ++index) {
+			if (passes[index].culled) {
+				continue;
+			}
+			for (FrameGraphResource resource : passes[index].reads) {
+				for (uint32_t writer : resources[resource].writers) {
+					if (writer < index && passes[writer].culled) {
+						passes[writer].culled = false;
+						restored = true;
+					}
+				}
+			}
+		}
+	}
+}
+
+std::vector<uint32_t> FrameGraph::SortPasses() const {
+	// 依赖边：同一资源的写入按声明顺序串起来；只读的通道排在它之前声明的最后一次写入之后、下一次写入之前，
+	// 在所有写入之前声明的只读通道排在所有写入之后
+	std::vector<std::vector<uint32_t>> successors(passes.size());
+	std::vector<uint32_t> inDegree(passes.size(), 0);
+	auto addEdge = [&](uint32_t from, uint32_t to) {
+		if (from != to && !contains(successors[from], to)) {
+			successors[from].push_back(to);
+			++inDegree[to];
+		}
+	};
+	for (const Resource& resource : resources) {
+		uint32_t previousWriter = ~0u;
+		for (uint32_t writer : resource.writers) {
+			if (passes[writer].culled) {
+				continue;
+			}
+			if (previousWriter != ~0u) {
+				addEdge(previousWriter, writer);
+			}
+			previousWriter = writer;
+		}
+		for (uint32_t reader : resource.readers) {
+			if (passes[reader].culled || contains(resource.writers, reader)) {
+				continue;
+			}
+			uint32_t writerBefore = ~0u;
+			uint32_t writerAfter = ~0u;
+			for (uint32_t writer : resource.writers) {
+				if (passes[writer].culled) {
+					continue;
+				}
+				if (writer < reader) {
+					writerBefore = writer;
+				} else if (writerAfter == ~0u) {
+					writerAfter = writer;
+				}
+			}
+			if (writerBefore == ~0u) {
+				for (uint32_t writer : resource.writers) {
+					if (!passes[writer].culled) {
+						addEdge(writer, reader);
+					}
+				}
+				continue;
+			}
+			addEdge(writerBefore, reader);
+			if (writerAfter != ~0u) {
+				addEdge(reader, writerAfter);
+			}
+		}
+	}
+
+	// Kahn 排序，每次取就绪通道中声明最早的，没有依赖约束的通道保持声明顺序
+	std::vector<uint32_t> order;
+	std::vector<bool> emitted(passes.size(), false);
+	uint32_t liveCount = 0;
+	for (const Pass& pass : passes) {
+		liveCount += pass.culled ? 0 : 1;
+	}
+	while (order.size() < liveCount) {
+		uint32_t next = ~0u;
+		for (uint32_t index = 0; index < passes.size(); ++index) {
+			if (!passes[index].culled && !emitted[index] && inDegree[index] == 0) {
+				next = index;
+				break;
+			}
+		}
+		if (next == ~0u) {
+			throw std::runtime_error("Frame graph: dependency cycle between passes");
+		}
+		emitted[next] = true;
+		order.push_back(next);
+		for (uint32_t successor : successors[next]) {
+			--inDegree[successor];
+		}
+	}
+	return order;
+}
+
+bool FrameGraph::CanMerge(const Pass& previous, const Pass& next) const {
+	if (previous.type != PassType::Render || next.type != PassType::Render) {
+		return false;
+	}
+	if (previous.colorAttachments.size() != next.colorAttachments.size()
+		|| previous.depthAttachment.resource != next.depthAttachment.resource) {
+		return false;
+	}
+	for (size_t i = 0; i < previous.colorAttachments.size(); ++i) {
+		if (previous.colorAttachments[i].resource != next.colorAttachments[i].resource
+			|| next.colorAttachments[i].loadOp != wgpu::LoadOp::Load) {
+			return false;
+		}
+	}
+	if (next.depthAttachment.resource != kInvalidFrameGraphResource && next.depthAttachment.loadOp != wgpu::LoadOp::Load) {
+		return false;
+	}
+	// 后一个通道不能以纹理方式读取附件，也不能读取前一个通道写的其他资源（同一 wgpu 通道内没有屏障）
+	auto isAttachment = [&](FrameGraphResource resource) {
+		if (resource == next.depthAttachment.resource) {
+			return true;
+		}
+		for (const Attachment& attachment : next.colorAttachments) {
+			if (attachment.resource == resource) {
+				return true;
+			}
+		}
+		return false;
+	};
+	for (FrameGraphResource resource : next.reads) {
+		if (!isAttachment(resource) && contains(previous.writes, resource)) {
+			return false;
+		}
+	}
+	return true;
+}
+
+void FrameGraph::Compile() {
+	CullPasses();
+	std::vector<uint32_t> order = SortPasses();
+
+	// 合并相邻的兼容渲染通道
+	groups.clear();
+	for (uint32_t index : order) {
+		if (!groups.empty() && CanMerge(passes[groups.back().passes.back()], passes[index])) {
+			groups.back().passes.push_back(index);
+		} else {
+			PassGroup group;
+			group.passes.push_back(index);
+			groups.push_back(std::move(group));
+		}
+	}
+
+	// 临时纹理的生命周期（以通道组为单位）
+	for (Resource& resource : resources) {
+		resource.firstGroup = ~0u;
+		resource.lastGroup = 0;
+	}
+	for (uint32_t groupIndex = 0; groupIndex < groups.size(); ++groupIndex) {
+		for (uint32_t passIndex : groups[groupIndex].passes) {
+			const Pass& pass = passes[passIndex];
+			for (const std::vector<FrameGraphResource>* used : { &pass.reads, &pass.writes }) {
+				for (FrameGraphResource resource : *used) {
+					Resource& target = resources[resource];
+					target.firstGroup = std::min(target.firstGroup, groupIndex);
+					target.lastGroup = std::max(target.lastGroup, groupIndex);
+				}
+			}
+		}
+	}
+	for (FrameGraphResource resource = 0; resource < resources.size(); ++resource) {
+		const Resource& target = resources[resource];
+		if (target.imported || target.type != ResourceType::Texture || target.firstGroup == ~0u) {
+			continue;
+		}
+		groups[target.firstGroup].acquires.push_back(resource);
+		groups[target.lastGroup].releases.push_back(resource);
+	}
+
+	// 合并后的通道以最后一个通道的附件决定是否保存：之后不再使用的临时附件直接丢弃
+	for (uint32_t groupIndex = 0; groupIndex < groups.size(); ++groupIndex) {
+		Pass& last = passes[groups[groupIndex].passes.back()];
+		if (last.type != PassType::Render) {
+			continue;
+		}
+		auto storeOp = [&](FrameGraphResource resource) {
+			const Resource& target = resources[resource];
+			return !target.imported && target.lastGroup == groupIndex ? wgpu::StoreOp::Discard : wgpu::StoreOp::Store;
+		};
+		for (Attachment& attachment : last.colorAttachments) {
+			attachment.storeOp = storeOp(attachment.resource);
+		}
+		if (last.depthAttachment.resource != kInvalidFrameGraphResource) {
+			last.depthAttachment.storeOp = storeOp(last.depthAttachment.resource);
+		}
+	}
+
+	uint32_t culledCount = 0;
+	for (const Pass& pass : passes) {
+		if (pass.culled) {
+			LOG("Frame graph: culled pass %s\n", pass.name.c_str());
+			++culledCount;
+		}
+	}
+	for (const PassGroup& group : groups) {
+		std::string names;
+		for (uint32_t passIndex : group.passes) {
+			names += (names.empty() ? "" : " + ") + passes[passIndex].name;
+		}
+		LOG("Frame graph: %s\n", names.c_str());
+	}
+	LOG("Frame graph: %zu passes, %u culled, %zu recorded after merging\n", passes.size(), culledCount, groups.size());
+	compiled = true;
+}
+
+void FrameGraph::SetImportedTexture(FrameGraphResource resource, wgpu::TextureView view) {
+	resources[resource].view = view;
+}
+
+void FrameGraph::SetBackbufferSize(uint32_t width, uint32_t height) {
+	backbufferWidth = width;
+	backbufferHeight = height;
+}
+
+void FrameGraph::Execute(wgpu::CommandEncoder& encoder, RenderTargetPool& pool) {
+	if (!compiled) {
+		Compile();
+	}
+	for (const PassGroup& group : groups) {
+		for (FrameGraphResource resource : group.acquires) {
+			Resource& target = resources[resource];
+			RenderTargetDesc desc = target.desc;
+			if (target.matchBackbuffer) {
+				desc.width = backbufferWidth;
+				desc.height = backbufferHeight;
+			}
+			target.target = pool.Acquire(desc, target.name.c_str());
+			target.view = target.target.view;
+		}
+
+		const Pass& first = passes[group.passes.front()];
+		if (first.type == PassType::Render) {
+			// 合并的通道按第一个通道的 LoadOp 开始，按最后一个通道的 StoreOp 结束
+			const Pass& last = passes[group.passes.back()];
+			std::array<wgpu::RenderPassColorAttachment, kMaxColorAttachments> colorAttachments;
+			for (size_t i = 0; i < first.colorAttachments.size(); ++i) {
+				wgpu::RenderPassColorAttachment& colorAttachment = colorAttachments[i];
+				colorAttachment.view = resources[first.colorAttachments[i].resource].view;
+				colorAttachment.resolveTarget = nullptr;
+				colorAttachment.loadOp = first.colorAttachments[i].loadOp;
+				colorAttachment.storeOp = last.colorAttachments[i].storeOp;
+				colorAttachment.clearValue = first.colorAttachments[i].clearValue;
+#ifndef WEBGPU_BACKEND_WGPU
+				colorAttachment.depthSlice = WGPU_DEPTH_SLICE_UNDEFINED;
+#endif // NOT WEBGPU_BACKEND_WGPU
+			}
+
+			wgpu::RenderPassDescriptor renderPassDesc = {};
+			renderPassDesc.label = first.name.c_str();
+			renderPassDesc.colorAttachmentCount = first.colorAttachments.size();
+			renderPassDesc.colorAttachments = colorAttachments.data();
+			renderPassDesc.timestampWrites = nullptr;
+
+			wgpu::RenderPassDepthStencilAttachment depthStencilAttachment;
+			if (first.depthAttachment.resource != kInvalidFrameGraphResource) {
+				depthStencilAttachment.view = resources[first.depthAttachment.resource].view;
+				depthStencilAttachment.depthClearValue = first.depthAttachment.depthClearValue;
+				depthStencilAttachment.depthLoadOp = first.depthAttachment.loadOp;
+				depthStencilAttachment.depthStoreOp = last.depthAttachment.storeOp;
+				depthStencilAttachment.depthReadOnly = false;
+				depthStencilAttachment.stencilClearValue = 0;
+#ifdef WEBGPU_BACKEND_WGPU
+				depthStencilAttachment.stencilLoadOp = wgpu::LoadOp::Clear;
+				depthStencilAttachment.stencilStoreOp = wgpu::StoreOp::Store;
+#else
+				depthStencilAttachment.stencilLoadOp = wgpu::LoadOp::Undefined;
+				depthStencilAttachment.stencilStoreOp = wgpu::StoreOp::Undefined;
+#endif
+				depthStencilAttachment.stencilReadOnly = true;
+				renderPassDesc.depthStencilAttachment = &depthStencilAttachment;
+			} else {
+				renderPassDesc.depthStencilAttachment = nullptr;
+			}
+
+			wgpu::RenderPassEncoder renderPass = encoder.beginRenderPass(renderPassDesc);
+			checkNullPointerError(renderPass, "renderPass");
+			for (uint32_t passIndex : group.passes) {
+				passes[passIndex].renderExecute(renderPass);
+			}
+			renderPass.end();
+			renderPass.release();
+		} else {
+			first.encoderExecute(encoder);
+		}
+
+		for (FrameGraphResource resource : group.releases) {
+			Resource& target = resources[resource];
+			pool.Release(target.target);
+			target.target = {};
+			target.view = nullptr;
+		}
+	}
+}
+
+wgpu::TextureView FrameGraph::GetTextureView(FrameGraphResource resource) const {
+	return resources[resource].view;
+}
+
+void FrameGraph::Clear() {
+	resources.clear();
+	passes.clear();
+	groups.clear();
+	compiled = false;
+}
+
+}
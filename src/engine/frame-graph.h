@@ -0,0 +1,176 @@
+#pragma once
+
+#include "../utils/global.h"
+#include "render-target-pool.h"
+
+#include <functional>
+#include <string>
+
+namespace webgpu {
+
+// 帧图中的资源句柄
+using FrameGraphResource = uint32_t;
+constexpr FrameGraphResource kInvalidFrameGraphResource = ~0u;
+
+/**
+ * 帧图
+ * 初始化时声明资源和通道：每个通道声明它读写的资源和附件，Compile 时
+ *   1. 剔除输出没有被任何人使用的通道（写导入资源或标记了副作用的通道保留）；
+ *   2. 按依赖关系排序（同一资源的写入按声明顺序进行，只读的通道读到它之前声明的最后一次写入，
+ *      之前没有写入时读到最终结果），有环时抛异常；
+ *   3. 计算临时纹理的首次/最后使用位置，执行时按此从渲染目标池申请和归还，生命周期不重叠的纹理共享同一张；
+ *      最后一次使用是作为附件写入的临时纹理用 StoreOp::Discard；
+ *   4. 把附件相同、后者 LoadOp::Load 且不采样前者附件的相邻渲染通道合并成一个 wgpu 渲染通道。
+ * 结构不变时只需编译一次，每帧只更新导入的纹理视图后 Execute，执行过程不分配堆内存。
+ */
+class FrameGraph {
+public:
+	static constexpr uint32_t kMaxColorAttachments = 4;
+
+	using RenderExecute = std::function<void(wgpu::RenderPassEncoder&)>;
+	using EncoderExecute = std::function<void(wgpu::CommandEncoder&)>;
+
+	/**
+	 * 通道声明
+	 */
+	class PassBuilder {
+	public:
+		/**
+		 * @brief 以纹理/缓冲区绑定的方式读取
+		 */
+		void Read(FrameGraphResource resource);
+
+		/**
+		 * @brief 写入（存储纹理/缓冲区、拷贝目标等）
+		 */
+		void Write(FrameGraphResource resource);
+
+		/**
+		 * @brief 颜色附件（只用于渲染通道），LoadOp::Load 时同时算作读取
+		 */
+		void ColorAttachment(FrameGraphResource resource, wgpu::LoadOp loadOp = wgpu::LoadOp::Clear, wgpu::Color clearValue = { 0.0, 0.0, 0.0, 1.0 });
+
+		/**
+		 * @brief 深度附件（只用于渲染通道）
+		 */
+		void DepthAttachment(FrameGraphResource resource, wgpu::LoadOp loadOp = wgpu::LoadOp::Clear, float clearValue = 1.0f);
+
+		/**
+		 * @brief 通道有图外可见的效果（如回读），不会被剔除
+		 */
+		void SideEffect();
+
+	private:
+		friend class FrameGraph;
+		PassBuilder(FrameGraph& graph, uint32_t pass) : graph(graph), pass(pass) {}
+		FrameGraph& graph;
+		uint32_t pass;
+	};
+
+	/**
+	 * @brief 导入外部纹理（如交换链），每帧用 SetImportedTexture 设置视图
+	 */
+	FrameGraphResource ImportTexture(const char* name);
+
+	/**
+	 * @brief 导入外部缓冲区，只用于表达依赖
+	 */
+	FrameGraphResource ImportBuffer(const char* name);
+
+	/**
+	 * @brief 创建临时纹理，由帧图在第一次使用前申请、最后一次使用后归还
+	 * @param matchBackbuffer 为 true 时宽高取 SetBackbufferSize 设置的尺寸
+	 */
+	FrameGraphResource CreateTexture(const char* name, const RenderTargetDesc& desc, bool matchBackbuffer = false);
+
+	void AddRenderPass(const char* name, const std::function<void(PassBuilder&)>& setup, RenderExecute execute);
+	void AddEncoderPass(const char* name, const std::function<void(PassBuilder&)>& setup, EncoderExecute execute);
+
+	/**
+	 * @brief 剔除、排序、计算生命周期、合并通道
+	 */
+	void Compile();
+
+	void SetImportedTexture(FrameGraphResource resource, wgpu::TextureView view);
+	void SetBackbufferSize(uint32_t width, uint32_t height);
+
+	/**
+	 * @brief 按编译结果录制整帧
+	 */
+	void Execute(wgpu::CommandEncoder& encoder, RenderTargetPool& pool);
+
+	/**
+	 * @brief 资源当前的纹理视图（临时纹理只在其生命周期内的通道中有效）
+	 */
+	wgpu::TextureView GetTextureView(FrameGraphResource resource) const;
+
+	/**
+	 * @brief 清空所有声明
+	 */
+	void Clear();
+
+private:
+	enum class ResourceType { Texture, Buffer };
+	enum class PassType { Render, Encoder };
+
+	struct Resource {
+		std::string name;
+		ResourceType type = ResourceType::Texture;
+		bool imported = false;
+		RenderTargetDesc desc;
+		bool matchBackbuffer = false;
+		// 本帧的纹理与视图
+		RenderTarget target;
+		wgpu::TextureView view = nullptr;
+		// 读写它的通道（声明序号）
+		std::vector<uint32_t> readers;
+		std::vector<uint32_t> writers;
+		uint32_t refCount = 0;
+		// 编译后首次/最后使用所在的通道组
+		uint32_t firstGroup = ~0u;
+		uint32_t lastGroup = 0;
+	};
+
+	struct Attachment {
+		FrameGraphResource resource = kInvalidFrameGraphResource;
+		wgpu::LoadOp loadOp = wgpu::LoadOp::Clear;
+		wgpu::StoreOp storeOp = wgpu::StoreOp::Store;
+		wgpu::Color clearValue = { 0.0, 0.0, 0.0, 1.0 };
+		float depthClearValue = 1.0f;
+	};
+
+	struct Pass {
+		std::string name;
+		PassType type = PassType::Render;
+		std::vector<FrameGraphResource> reads;
+		std::vector<FrameGraphResource> writes;
+		std::vector<Attachment> colorAttachments;
+		Attachment depthAttachment;
+		bool sideEffect = false;
+		RenderExecute renderExecute;
+		EncoderExecute encoderExecute;
+		uint32_t refCount = 0;
+		bool culled = false;
+	};
+
+	// 编译后的执行单元：一个 wgpu 渲染通道（可能由多个声明的通道合并）或一个编码器通道
+	struct PassGroup {
+		std::vector<uint32_t> passes;
+		std::vector<FrameGraphResource> acquires;
+		std::vector<FrameGraphResource> releases;
+	};
+
+	uint32_t AddPass(const char* name, PassType type);
+	void CullPasses();
+	std::vector<uint32_t> SortPasses() const;
+	bool CanMerge(const Pass& previous, const Pass& next) const;
+
+	std::vector<Resource> resources;
+	std::vector<Pass> passes;
+	std::vector<PassGroup> groups;
+	uint32_t backbufferWidth = 1;
+	uint32_t backbufferHeight = 1;
+	bool compiled = false;
+};
+
+}
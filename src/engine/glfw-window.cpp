@@ -2,14 +2,59 @@
 #include "GLFW/glfw3.h"
 #include "src/utils/global.h"
 
+#include <algorithm>
+
 namespace webgpu {
 
 bool WGPUGLFWWindow::initWindow(window_size_t window_size) {
   glfwInit();
   glfwWindowHint(GLFW_CLIENT_API, GLFW_NO_API);
-  glfwWindowHint(GLFW_RESIZABLE, GLFW_FALSE);
+  glfwWindowHint(GLFW_RESIZABLE, GLFW_TRUE);
   window = glfwCreateWindow(window_size.width, window_size.height, "WebGPU", nullptr, nullptr);
-  return checkNullPointerError(window, "GLFW window");
+  if (!checkNullPointerError(window, "GLFW window")) {
+    return false;
+  }
+  // 高 DPI 屏幕上 framebuffer 与窗口尺寸不同，交换链按 framebuffer 尺寸创建
+  int width = 0;
+  int height = 0;
+  glfwGetFramebufferSize(window, &width, &height);
+  this->window_size = { static_cast<uint32_t>(width), static_cast<uint32_t>(height) };
+  glfwSetWindowUserPointer(window, this);
+  glfwSetFramebufferSizeCallback(window, &WGPUGLFWWindow::onFramebufferResize);
+  // 目前没有处理键盘和鼠标输入，它们不改变画面，只有窗口要求重绘（被遮挡后露出等）时失效
+  glfwSetWindowRefreshCallback(window, &WGPUGLFWWindow::onWindowRefresh);
+  return true;
+}
+
+void WGPUGLFWWindow::onWindowRefresh(GLFWwindow* window) {
+  auto* self = static_cast<WGPUGLFWWindow*>(glfwGetWindowUserPointer(window));
+  if (self) {
+    self->invalidated = true;
+  }
+}
+
+void WGPUGLFWWindow::onFramebufferResize(GLFWwindow* window, int width, int height) {
+  auto* self = static_cast<WGPUGLFWWindow*>(glfwGetWindowUserPointer(window));
+  if (self) {
+    self->window_size = { static_cast<uint32_t>(std::max(width, 0)), static_cast<uint32_t>(std::max(height, 0)) };
+    self->resized = true;
+  }
+}
+
+bool WGPUGLFWWindow::pollResize() {
+  bool value = resized;
+  resized = false;
+  return value;
+}
+
+bool WGPUGLFWWindow::pollInvalidated() {
+  bool value = invalidated;
+  invalidated = false;
+  return value;
+}
+
+bool WGPUGLFWWindow::isMinimized() const {
+  return window_size.width == 0 || window_size.height == 0;
 }
 WGPUGLFWWindow::WGPUGLFWWindow(){
   if(!initWindow(window_size)) {
@@ -20,7 +65,7 @@ WGPUGLFWWindow::WGPUGLFWWindow(){
 }
 
 WGPUGLFWWindow::WGPUGLFWWindow(window_size_t window_size) {
-  window_size = window_size;
+  this->window_size = window_size;
   if(!initWindow(window_size)) {
     throw std::runtime_error("Failed to create GLFW window");
   } else {
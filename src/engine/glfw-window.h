@@ -27,6 +27,21 @@ class WGPUGLFWWindow {
    */
   GLFWwindow* getWGPUGLFWWindow();
 
+  /**
+   * @brief 自上次调用以来 framebuffer 尺寸是否变化过（读取后清除标记）
+   */
+  bool pollResize();
+
+  /**
+   * @brief 自上次调用以来窗口是否要求重绘（读取后清除标记）
+   */
+  bool pollInvalidated();
+
+  /**
+   * @brief 窗口是否最小化（framebuffer 尺寸为 0）
+   */
+  bool isMinimized() const;
+
   /**
    * @brief 销毁窗口
    */
@@ -35,7 +50,7 @@ class WGPUGLFWWindow {
   ~WGPUGLFWWindow();
 
 public:
-  // 窗口大小
+  // framebuffer 大小，随窗口缩放更新
   window_size_t window_size = { 800, 600 };
   // GLFW 窗口
 	GLFWwindow* window = nullptr;
@@ -43,6 +58,14 @@ private:
 
   bool initWindow(window_size_t window_size);
 
+  // GLFW framebuffer 尺寸回调
+  static void onFramebufferResize(GLFWwindow* window, int width, int height);
+  // GLFW 窗口重绘回调，只记录画面需要更新
+  static void onWindowRefresh(GLFWwindow* window);
+
+  bool resized = false;
+  bool invalidated = false;
+
 };
 
 }
\ No newline at end of file
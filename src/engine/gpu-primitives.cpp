@@ -0,0 +1,547 @@
+#include "gpu-primitives.h"
+#include "../utils/utils.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <functional>
+#include <numeric>
+#include <random>
+
+namespace webgpu {
+
+namespace {
+
+// 着色器中的工作组大小与每块的元素数
+constexpr uint32_t kWorkgroupSize = 256;
+constexpr uint32_t kScanTileSize = 1024;
+constexpr uint32_t kReduceTileSize = 1024;
+constexpr uint32_t kSortTileSize = 256;
+constexpr uint32_t kRadixBits = 4;
+constexpr uint32_t kRadix = 1u << kRadixBits;
+// 参数槽位间隔（minUniformBufferOffsetAlignment 的上限）
+constexpr uint64_t kUniformStride = 256;
+constexpr uint64_t kParamsSize = 4 * sizeof(uint32_t);
+
+ComputeKernelDesc kernelDesc(const char* label, wgpu::ShaderModule module, const char* entryPoint, std::vector<ComputeBinding> bindings) {
+	ComputeKernelDesc desc;
+	desc.label = label;
+	desc.module = module;
+	desc.entryPoint = entryPoint;
+	desc.bindings = std::move(bindings);
+	desc.workgroupSize = glm::uvec3(kWorkgroupSize, 1u, 1u);
+	return desc;
+}
+
+uint64_t wordSize(uint32_t count) {
+	return static_cast<uint64_t>(std::max(count, 1u)) * sizeof(uint32_t);
+}
+
+}
+
+void GpuPrimitives::Initialize(wgpu::Device device, wgpu::Queue queue, const std::filesystem::path& shaderDirectory) {
+	this->device = device;
+	this->queue = queue;
+
+	LOG("Creating GPU primitive pipelines...\n");
+	wgpu::ShaderModule scanModule = loadShaderModule(shaderDirectory / "scan.wgsl", device);
+	wgpu::ShaderModule reduceModule = loadShaderModule(shaderDirectory / "reduce.wgsl", device);
+	wgpu::ShaderModule compactModule = loadShaderModule(shaderDirectory / "compact.wgsl", device);
+	wgpu::ShaderModule sortModule = loadShaderModule(shaderDirectory / "radix-sort.wgsl", device);
+	if (!scanModule || !reduceModule || !compactModule || !sortModule) {
+		LOG("Failed to load GPU primitive shaders from %s\n", shaderDirectory.string().c_str());
+		throw std::runtime_error("Failed to load GPU primitive shaders");
+	}
+
+	const ComputeBinding params = ComputeBinding::Uniform(kParamsSize);
+	const ComputeBinding read = ComputeBinding::ReadOnlyStorage();
+	const ComputeBinding write = ComputeBinding::Storage();
+	clearKernel.Initialize(device, kernelDesc("Clear pipeline", scanModule, "cs_clear", { params, write }));
+	scanKernel.Initialize(device, kernelDesc("Scan pipeline", scanModule, "cs_scan", { params, read, write, write }));
+	reduceInitKernel.Initialize(device, kernelDesc("Reduce init pipeline", reduceModule, "cs_reduce_init", { params, read, write }));
+	reduceKernel.Initialize(device, kernelDesc("Reduce pipeline", reduceModule, "cs_reduce", { params, read, write }));
+	compactKernel.Initialize(device, kernelDesc("Compact pipeline", compactModule, "cs_scatter", { params, read, read, read, write, write }));
+	histogramKernel.Initialize(device, kernelDesc("Radix histogram pipeline", sortModule, "cs_histogram", { params, read, write }));
+	sortScatterKernel.Initialize(device, kernelDesc("Radix scatter pipeline", sortModule, "cs_scatter", { params, read, read, read, write, write }));
+	scanModule.release();
+	reduceModule.release();
+	compactModule.release();
+	sortModule.release();
+
+	wgpu::BufferDescriptor bufferDesc;
+	bufferDesc.label = "GPU primitive params";
+	bufferDesc.size = kMaxUniformSlots * kUniformStride;
+	bufferDesc.usage = wgpu::BufferUsage::Uniform | wgpu::BufferUsage::CopyDst;
+	bufferDesc.mappedAtCreation = false;
+	uniformBuffer = device.createBuffer(bufferDesc);
+}
+
+void GpuPrimitives::ExclusiveScan(wgpu::CommandEncoder& encoder, wgpu::Buffer input, wgpu::Buffer output, uint32_t count) {
+	if (count == 0) {
+		return;
+	}
+	ComputePass computePass(encoder, "Scan pass");
+	RecordScan(computePass, input, output, count, false);
+}
+
+void GpuPrimitives::Reduce(wgpu::CommandEncoder& encoder, wgpu::Buffer input, uint32_t count, ReduceOp op, wgpu::Buffer result, uint32_t resultIndex) {
+	Params params;
+	params.count = count;
+	params.mode = static_cast<uint32_t>(op);
+	params.index = resultIndex;
+	ComputeResource resources[] = {
+		AllocateParams(params),
+		ComputeResource::Buffer(input, wordSize(count)),
+		ComputeResource::Buffer(result, wordSize(resultIndex + 1)),
+	};
+
+	// 先写入单位元，再由每个工作组原子合并（元素数为 0 时结果就是单位元）
+	ComputePass computePass(encoder, "Reduce pass");
+	computePass.Dispatch(reduceInitKernel, CreateBindGroup(reduceInitKernel, resources), 1);
+	computePass.DispatchThreads(reduceKernel, CreateBindGroup(reduceKernel, resources), workgroupCount(count, kReduceTileSize) * kWorkgroupSize);
+}
+
+void GpuPrimitives::Compact(wgpu::CommandEncoder& encoder, wgpu::Buffer values, wgpu::Buffer flags, uint32_t count,
+	wgpu::Buffer output, wgpu::Buffer countBuffer, uint32_t countIndex) {
+	if (count == 0) {
+		encoder.clearBuffer(countBuffer, countIndex * sizeof(uint32_t), sizeof(uint32_t));
+		return;
+	}
+	EnsureScratch(offsetBuffer, offsetCapacity, wordSize(count), "Compact offsets");
+
+	Params params;
+	params.count = count;
+	params.index = countIndex;
+	ComputeResource resources[] = {
+		AllocateParams(params),
+		ComputeResource::Buffer(values, wordSize(count)),
+		ComputeResource::Buffer(flags, wordSize(count)),
+		ComputeResource::Buffer(offsetBuffer, wordSize(count)),
+		ComputeResource::Buffer(output, wordSize(count)),
+		ComputeResource::Buffer(countBuffer, wordSize(countIndex + 1)),
+	};
+
+	// 谓词的前缀和就是每个保留元素的输出位置
+	ComputePass computePass(encoder, "Compact pass");
+	RecordScan(computePass, flags, offsetBuffer, count, true);
+	computePass.DispatchThreads(compactKernel, CreateBindGroup(compactKernel, resources), count);
+}
+
+void GpuPrimitives::SortPairs(wgpu::CommandEncoder& encoder, wgpu::Buffer keys, wgpu::Buffer values, uint32_t count, uint32_t keyBits) {
+	if (count <= 1) {
+		return;
+	}
+	// 每 8 位两遍，遍数为偶数，结果最后回到 keys/values
+	uint32_t passCount = (std::clamp(keyBits, 1u, 32u) + 7) / 8 * 2;
+	uint32_t blockCount = workgroupCount(count, kSortTileSize);
+	uint32_t histogramCount = blockCount * kRadix;
+	EnsureScratch(keyScratchBuffer, keyScratchCapacity, wordSize(count), "Radix sort keys");
+	EnsureScratch(valueScratchBuffer, valueScratchCapacity, wordSize(count), "Radix sort values");
+	EnsureScratch(histogramBuffer, histogramCapacity, wordSize(histogramCount), "Radix sort histogram");
+	EnsureScratch(histogramOffsetBuffer, histogramOffsetCapacity, wordSize(histogramCount), "Radix sort offsets");
+
+	wgpu::Buffer keyBuffers[] = { keys, keyScratchBuffer };
+	wgpu::Buffer valueBuffers[] = { values, valueScratchBuffer };
+	ComputePass computePass(encoder, "Radix sort pass");
+	for (uint32_t pass = 0; pass < passCount; ++pass) {
+		uint32_t source = pass & 1;
+		Params params;
+		params.count = count;
+		params.blockCount = blockCount;
+		params.mode = pass * kRadixBits;
+		ComputeResource passParams = AllocateParams(params);
+
+		ComputeResource histogramResources[] = {
+			passParams,
+			ComputeResource::Buffer(keyBuffers[source], wordSize(count)),
+			ComputeResource::Buffer(histogramBuffer, wordSize(histogramCount)),
+		};
+		computePass.DispatchThreads(histogramKernel, CreateBindGroup(histogramKernel, histogramResources), blockCount * kWorkgroupSize);
+
+		RecordScan(computePass, histogramBuffer, histogramOffsetBuffer, histogramCount, false);
+
+		ComputeResource scatterResources[] = {
+			passParams,
+			ComputeResource::Buffer(keyBuffers[source], wordSize(count)),
+			ComputeResource::Buffer(valueBuffers[source], wordSize(count)),
+			ComputeResource::Buffer(histogramOffsetBuffer, wordSize(histogramCount)),
+			ComputeResource::Buffer(keyBuffers[1 - source], wordSize(count)),
+			ComputeResource::Buffer(valueBuffers[1 - source], wordSize(count)),
+		};
+		computePass.DispatchThreads(sortScatterKernel, CreateBindGroup(sortScatterKernel, scatterResources), blockCount * kWorkgroupSize);
+	}
+}
+
+void GpuPrimitives::OnSubmitted() {
+	usedUniformSlots = 0;
+	for (wgpu::BindGroup& bindGroup : pendingBindGroups) {
+		bindGroup.release();
+	}
+	pendingBindGroups.clear();
+}
+
+void GpuPrimitives::Terminate() {
+	if (!IsReady()) {
+		return;
+	}
+	OnSubmitted();
+	for (wgpu::Buffer* buffer : { &uniformBuffer, &tileStateBuffer, &offsetBuffer, &keyScratchBuffer, &valueScratchBuffer, &histogramBuffer, &histogramOffsetBuffer }) {
+		if (*buffer) {
+			buffer->destroy();
+			buffer->release();
+			*buffer = nullptr;
+		}
+	}
+	tileStateCapacity = offsetCapacity = keyScratchCapacity = valueScratchCapacity = histogramCapacity = histogramOffsetCapacity = 0;
+	for (ComputeKernel* kernel : { &clearKernel, &scanKernel, &reduceInitKernel, &reduceKernel, &compactKernel, &histogramKernel, &sortScatterKernel }) {
+		kernel->Terminate();
+	}
+}
+
+ComputeResource GpuPrimitives::AllocateParams(const Params& params) {
+	if (usedUniformSlots >= kMaxUniformSlots) {
+		LOG("GPU primitives: more than %u dispatches in one submission\n", kMaxUniformSlots);
+		throw std::runtime_error("GPU primitives: out of uniform slots, call OnSubmitted after each submission");
+	}
+	uint64_t offset = usedUniformSlots++ * kUniformStride;
+	queue.writeBuffer(uniformBuffer, offset, &params, sizeof(Params));
+	return ComputeResource::Buffer(uniformBuffer, kParamsSize, offset);
+}
+
+wgpu::BindGroup GpuPrimitives::CreateBindGroup(const ComputeKernel& kernel, std::span<const ComputeResource> resources) {
+	pendingBindGroups.push_back(kernel.CreateBindGroup(resources));
+	return pendingBindGroups.back();
+}
+
+void GpuPrimitives::EnsureScratch(wgpu::Buffer& buffer, uint64_t& capacity, uint64_t size, const char* label) {
+	if (size <= capacity) {
+		return;
+	}
+	// 已录制的命令仍持有旧缓冲区的引用，这里只释放不销毁
+	if (buffer) {
+		buffer.release();
+	}
+	capacity = std::max(size, capacity * 2);
+	wgpu::BufferDescriptor bufferDesc;
+	bufferDesc.label = label;
+	bufferDesc.size = capacity;
+	bufferDesc.usage = wgpu::BufferUsage::Storage | wgpu::BufferUsage::CopyDst;
+	bufferDesc.mappedAtCreation = false;
+	buffer = device.createBuffer(bufferDesc);
+}
+
+void GpuPrimitives::RecordScan(ComputePass& computePass, wgpu::Buffer input, wgpu::Buffer output, uint32_t count, bool predicate) {
+	uint32_t blockCount = workgroupCount(count, kScanTileSize);
+	EnsureScratch(tileStateBuffer, tileStateCapacity, wordSize(blockCount + 1), "Scan tile states");
+
+	// 块号计数器和每块的状态清零
+	Params clearParams;
+	clearParams.count = blockCount + 1;
+	ComputeResource clearResources[] = {
+		AllocateParams(clearParams),
+		ComputeResource::Buffer(tileStateBuffer, wordSize(blockCount + 1)),
+	};
+	computePass.DispatchThreads(clearKernel, CreateBindGroup(clearKernel, clearResources), blockCount + 1);
+
+	Params scanParams;
+	scanParams.count = count;
+	scanParams.blockCount = blockCount;
+	scanParams.mode = predicate ? 1 : 0;
+	ComputeResource scanResources[] = {
+		AllocateParams(scanParams),
+		ComputeResource::Buffer(input, wordSize(count)),
+		ComputeResource::Buffer(output, wordSize(count)),
+		ComputeResource::Buffer(tileStateBuffer, wordSize(blockCount + 1)),
+	};
+	computePass.DispatchThreads(scanKernel, CreateBindGroup(scanKernel, scanResources), blockCount * kWorkgroupSize);
+}
+
+std::vector<uint32_t> exclusiveScanReference(std::span<const uint32_t> input) {
+	std::vector<uint32_t> output(input.size());
+	std::exclusive_scan(input.begin(), input.end(), output.begin(), 0u);
+	return output;
+}
+
+uint32_t reduceReference(std::span<const uint32_t> input, ReduceOp op) {
+	switch (op) {
+	case ReduceOp::Sum:
+		return std::accumulate(input.begin(), input.end(), 0u);
+	case ReduceOp::Min:
+		return input.empty() ? 0xFFFFFFFFu : *std::min_element(input.begin(), input.end());
+	case ReduceOp::Max:
+		return input.empty() ? 0u : *std::max_element(input.begin(), input.end());
+	}
+	return 0;
+}
+
+std::vector<uint32_t> compactReference(std::span<const uint32_t> values, std::span<const uint32_t> flags) {
+	std::vector<uint32_t> output;
+	for (size_t i = 0; i < values.size() && i < flags.size(); ++i) {
+		if (flags[i] != 0) {
+			output.push_back(values[i]);
+		}
+	}
+	return output;
+}
+
+void sortPairsReference(std::span<uint32_t> keys, std::span<uint32_t> values, uint32_t keyBits) {
+	std::vector<std::pair<uint32_t, uint32_t>> pairs(keys.size());
+	for (size_t i = 0; i < keys.size(); ++i) {
+		pairs[i] = { keys[i], values[i] };
+	}
+	uint32_t mask = keyBits >= 32 ? 0xFFFFFFFFu : (1u << keyBits) - 1;
+	std::stable_sort(pairs.begin(), pairs.end(), [mask](const auto& a, const auto& b) { return (a.first & mask) < (b.first & mask); });
+	for (size_t i = 0; i < keys.size(); ++i) {
+		keys[i] = pairs[i].first;
+		values[i] = pairs[i].second;
+	}
+}
+
+namespace {
+
+void tickDevice(wgpu::Device& device) {
+#if defined(WEBGPU_BACKEND_DAWN)
+	device.tick();
+#elif defined(WEBGPU_BACKEND_WGPU)
+	device.poll(false);
+#endif
+}
+
+void waitForQueue(wgpu::Device& device, wgpu::Queue& queue) {
+	bool done = false;
+	auto callback = queue.onSubmittedWorkDone([&done](wgpu::QueueWorkDoneStatus) { done = true; });
+	while (!done) {
+		tickDevice(device);
+	}
+}
+
+wgpu::Buffer createStorageBuffer(wgpu::Device& device, const char* label, uint32_t count) {
+	wgpu::BufferDescriptor bufferDesc;
+	bufferDesc.label = label;
+	bufferDesc.size = wordSize(count);
+	bufferDesc.usage = wgpu::BufferUsage::Storage | wgpu::BufferUsage::CopySrc | wgpu::BufferUsage::CopyDst;
+	bufferDesc.mappedAtCreation = false;
+	return device.createBuffer(bufferDesc);
+}
+
+/**
+ * 把缓冲区的前 count 个 uint32 读回 CPU（同步等待）
+ */
+std::vector<uint32_t> readBuffer(wgpu::Device& device, wgpu::Queue& queue, wgpu::Buffer buffer, uint32_t count) {
+	wgpu::BufferDescriptor bufferDesc;
+	bufferDesc.label = "GPU primitive readback";
+	bufferDesc.size = wordSize(count);
+	bufferDesc.usage = wgpu::BufferUsage::MapRead | wgpu::BufferUsage::CopyDst;
+	bufferDesc.mappedAtCreation = false;
+	wgpu::Buffer readback = device.createBuffer(bufferDesc);
+
+	wgpu::CommandEncoderDescriptor encoderDesc = {};
+	encoderDesc.label = "Readback encoder";
+	wgpu::CommandEncoder encoder = device.createCommandEncoder(encoderDesc);
+	encoder.copyBufferToBuffer(buffer, 0, readback, 0, bufferDesc.size);
+	wgpu::CommandBufferDescriptor cmdBufferDescriptor = {};
+	cmdBufferDescriptor.label = "Readback commands";
+	wgpu::CommandBuffer command = encoder.finish(cmdBufferDescriptor);
+	encoder.release();
+	queue.submit(1, &command);
+	command.release();
+
+	bool done = false;
+	bool mapped = false;
+	auto callback = readback.mapAsync(wgpu::MapMode::Read, 0, bufferDesc.size, [&](wgpu::BufferMapAsyncStatus status) {
+		mapped = status == wgpu::BufferMapAsyncStatus::Success;
+		done = true;
+	});
+	while (!done) {
+		tickDevice(device);
+	}
+	std::vector<uint32_t> result(count);
+	if (mapped) {
+		const uint32_t* words = static_cast<const uint32_t*>(readback.getConstMappedRange(0, bufferDesc.size));
+		std::copy(words, words + count, result.begin());
+		readback.unmap();
+	}
+	readback.destroy();
+	readback.release();
+	return result;
+}
+
+}
+
+bool reportGpuPrimitivesBenchmark(const std::filesystem::path& shaderDirectory, uint32_t elementCount, bool forceFallbackAdapter) {
+	constexpr uint32_t kIterations = 20;
+
+	wgpu::InstanceDescriptor instanceDesc = {};
+	wgpu::Instance instance = wgpu::createInstance(instanceDesc);
+	wgpu::RequestAdapterOptions adapterOpts = {};
+	adapterOpts.forceFallbackAdapter = forceFallbackAdapter;
+	wgpu::Adapter adapter = instance.requestAdapter(adapterOpts);
+	if (!adapter) {
+		printf("No %s adapter available\n", forceFallbackAdapter ? "software" : "GPU");
+		return false;
+	}
+	wgpu::AdapterProperties properties = {};
+	adapter.getProperties(&properties);
+
+	wgpu::SupportedLimits supportedLimits;
+	adapter.getLimits(&supportedLimits);
+	// 每个缓冲区都要能整个绑定为存储缓冲区
+	uint64_t maxElements = std::min(supportedLimits.limits.maxStorageBufferBindingSize, supportedLimits.limits.maxBufferSize) / sizeof(uint32_t);
+	elementCount = static_cast<uint32_t>(std::clamp<uint64_t>(elementCount, 1, maxElements));
+	wgpu::RequiredLimits requiredLimits = wgpu::Default;
+	requiredLimits.limits.maxStorageBufferBindingSize = wordSize(elementCount);
+	requiredLimits.limits.maxBufferSize = std::max<uint64_t>(wordSize(elementCount) * 2, GpuPrimitives::kMaxUniformSlots * kUniformStride);
+	requiredLimits.limits.minStorageBufferOffsetAlignment = supportedLimits.limits.minStorageBufferOffsetAlignment;
+	requiredLimits.limits.minUniformBufferOffsetAlignment = supportedLimits.limits.minUniformBufferOffsetAlignment;
+
+	wgpu::DeviceDescriptor deviceDesc = {};
+	deviceDesc.label = "GPU primitives benchmark device";
+	deviceDesc.requiredLimits = &requiredLimits;
+	deviceDesc.defaultQueue.label = "The default queue";
+	wgpu::Device device = adapter.requestDevice(deviceDesc);
+	if (!device) {
+		printf("Failed to create a device\n");
+		return false;
+	}
+	auto errorCallback = device.setUncapturedErrorCallback([](wgpu::ErrorType type, char const* message) {
+		std::cout << "Uncaptured device error: type " << type;
+		if (message) std::cout << " (" << message << ")";
+		std::cout << '\n';
+	});
+	wgpu::Queue queue = device.getQueue();
+
+	GpuPrimitives primitives;
+	try {
+		primitives.Initialize(device, queue, shaderDirectory);
+	} catch (const std::runtime_error& e) {
+		printf("%s\n", e.what());
+		return false;
+	}
+
+	// 随机数据：前缀和的元素较小（总和不超过 2^30），约一半的元素保留
+	std::mt19937 random(42);
+	std::vector<uint32_t> small(elementCount);
+	std::vector<uint32_t> words(elementCount);
+	std::vector<uint32_t> flags(elementCount);
+	std::vector<uint32_t> indices(elementCount);
+	for (uint32_t i = 0; i < elementCount; ++i) {
+		small[i] = random() % 16;
+		words[i] = random();
+		flags[i] = random() % 2;
+		indices[i] = i;
+	}
+
+	wgpu::Buffer smallBuffer = createStorageBuffer(device, "Benchmark small values", elementCount);
+	wgpu::Buffer wordBuffer = createStorageBuffer(device, "Benchmark words", elementCount);
+	wgpu::Buffer flagBuffer = createStorageBuffer(device, "Benchmark flags", elementCount);
+	wgpu::Buffer indexBuffer = createStorageBuffer(device, "Benchmark indices", elementCount);
+	wgpu::Buffer keyBuffer = createStorageBuffer(device, "Benchmark keys", elementCount);
+	wgpu::Buffer valueBuffer = createStorageBuffer(device, "Benchmark values", elementCount);
+	wgpu::Buffer outputBuffer = createStorageBuffer(device, "Benchmark output", elementCount);
+	wgpu::Buffer resultBuffer = createStorageBuffer(device, "Benchmark results", 4);
+	queue.writeBuffer(smallBuffer, 0, small.data(), wordSize(elementCount));
+	queue.writeBuffer(wordBuffer, 0, words.data(), wordSize(elementCount));
+	queue.writeBuffer(flagBuffer, 0, flags.data(), wordSize(elementCount));
+	queue.writeBuffer(indexBuffer, 0, indices.data(), wordSize(elementCount));
+
+	// 录制一次操作，提交后回收参数槽位
+	auto submit = [&](const std::function<void(wgpu::CommandEncoder&)>& record) {
+		wgpu::CommandEncoderDescriptor encoderDesc = {};
+		encoderDesc.label = "Benchmark encoder";
+		wgpu::CommandEncoder encoder = device.createCommandEncoder(encoderDesc);
+		record(encoder);
+		wgpu::CommandBufferDescriptor cmdBufferDescriptor = {};
+		cmdBufferDescriptor.label = "Benchmark commands";
+		wgpu::CommandBuffer command = encoder.finish(cmdBufferDescriptor);
+		encoder.release();
+		queue.submit(1, &command);
+		command.release();
+		primitives.OnSubmitted();
+	};
+	// 连续提交 kIterations 次后等待 GPU 执行完，返回每秒处理的元素数
+	auto measure = [&](const std::function<void(wgpu::CommandEncoder&)>& record) {
+		submit(record);
+		waitForQueue(device, queue);
+		auto begin = std::chrono::steady_clock::now();
+		for (uint32_t i = 0; i < kIterations; ++i) {
+			submit(record);
+		}
+		waitForQueue(device, queue);
+		std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - begin;
+		return static_cast<double>(elementCount) * kIterations / elapsed.count();
+	};
+	auto resetPairs = [&](wgpu::CommandEncoder& encoder) {
+		encoder.copyBufferToBuffer(wordBuffer, 0, keyBuffer, 0, wordSize(elementCount));
+		encoder.copyBufferToBuffer(indexBuffer, 0, valueBuffer, 0, wordSize(elementCount));
+	};
+
+	printf("GPU primitives: %u elements on %s (%s adapter)\n", elementCount, properties.name ? properties.name : "unknown",
+		forceFallbackAdapter ? "software" : "default");
+	printf("%-20s %8s %16s\n", "primitive", "valid", "elements/s");
+	bool allValid = true;
+
+	// 前缀和
+	submit([&](wgpu::CommandEncoder& encoder) { primitives.ExclusiveScan(encoder, smallBuffer, outputBuffer, elementCount); });
+	bool scanValid = readBuffer(device, queue, outputBuffer, elementCount) == exclusiveScanReference(small);
+	double scanRate = measure([&](wgpu::CommandEncoder& encoder) { primitives.ExclusiveScan(encoder, smallBuffer, outputBuffer, elementCount); });
+	printf("%-20s %8s %16.3e\n", "exclusive scan", scanValid ? "yes" : "NO", scanRate);
+	allValid = allValid && scanValid;
+
+	// 归约：三种运算各写一个结果
+	submit([&](wgpu::CommandEncoder& encoder) {
+		for (ReduceOp op : { ReduceOp::Sum, ReduceOp::Min, ReduceOp::Max }) {
+			primitives.Reduce(encoder, wordBuffer, elementCount, op, resultBuffer, static_cast<uint32_t>(op));
+		}
+	});
+	std::vector<uint32_t> reduced = readBuffer(device, queue, resultBuffer, 3);
+	bool reduceValid = reduced[0] == reduceReference(words, ReduceOp::Sum) && reduced[1] == reduceReference(words, ReduceOp::Min)
+		&& reduced[2] == reduceReference(words, ReduceOp::Max);
+	double reduceRate = measure([&](wgpu::CommandEncoder& encoder) { primitives.Reduce(encoder, wordBuffer, elementCount, ReduceOp::Sum, resultBuffer); });
+	printf("%-20s %8s %16.3e\n", "reduce", reduceValid ? "yes" : "NO", reduceRate);
+	allValid = allValid && reduceValid;
+
+	// 流压缩
+	submit([&](wgpu::CommandEncoder& encoder) { primitives.Compact(encoder, wordBuffer, flagBuffer, elementCount, outputBuffer, resultBuffer); });
+	std::vector<uint32_t> expected = compactReference(words, flags);
+	uint32_t compactedCount = readBuffer(device, queue, resultBuffer, 1)[0];
+	std::vector<uint32_t> compacted = readBuffer(device, queue, outputBuffer, elementCount);
+	compacted.resize(std::min<size_t>(compactedCount, compacted.size()));
+	bool compactValid = compactedCount == expected.size() && compacted == expected;
+	double compactRate = measure([&](wgpu::CommandEncoder& encoder) { primitives.Compact(encoder, wordBuffer, flagBuffer, elementCount, outputBuffer, resultBuffer); });
+	printf("%-20s %8s %16.3e\n", "stream compaction", compactValid ? "yes" : "NO", compactRate);
+	allValid = allValid && compactValid;
+
+	// 键值对排序：按全部 32 位和只按低 16 位，每次排序前从原始数据恢复（计入耗时）
+	for (uint32_t keyBits : { 32u, 16u }) {
+		std::vector<uint32_t> referenceKeys = words;
+		std::vector<uint32_t> referenceValues = indices;
+		sortPairsReference(referenceKeys, referenceValues, keyBits);
+		submit([&](wgpu::CommandEncoder& encoder) {
+			resetPairs(encoder);
+			primitives.SortPairs(encoder, keyBuffer, valueBuffer, elementCount, keyBits);
+		});
+		bool sortValid = readBuffer(device, queue, keyBuffer, elementCount) == referenceKeys
+			&& readBuffer(device, queue, valueBuffer, elementCount) == referenceValues;
+		double sortRate = measure([&](wgpu::CommandEncoder& encoder) {
+			resetPairs(encoder);
+			primitives.SortPairs(encoder, keyBuffer, valueBuffer, elementCount, keyBits);
+		});
+		char name[32];
+		snprintf(name, sizeof(name), "radix sort (%u-bit)", keyBits);
+		printf("%-20s %8s %16.3e\n", name, sortValid ? "yes" : "NO", sortRate);
+		allValid = allValid && sortValid;
+	}
+
+	primitives.Terminate();
+	for (wgpu::Buffer* buffer : { &smallBuffer, &wordBuffer, &flagBuffer, &indexBuffer, &keyBuffer, &valueBuffer, &outputBuffer, &resultBuffer }) {
+		buffer->destroy();
+		buffer->release();
+	}
+	queue.release();
+	device.release();
+	adapter.release();
+	instance.release();
+	return allValid;
+}
+
+}
@@ -0,0 +1,131 @@
+#pragma once
+
+#include "../utils/global.h"
+#include "compute.h"
+
+namespace webgpu {
+
+/**
+ * 归约运算
+ */
+enum class ReduceOp : uint32_t { Sum, Min, Max };
+
+/**
+ * 通用的 GPU 并行原语：前缀和、归约、流压缩、键值对基数排序，元素都是 uint32
+ * 每个操作录制到调用方的 encoder 中，输入输出都是调用方的存储缓冲区（需要 Storage 用途），
+ * 内部的临时缓冲区按需增长。每次调用占用一个 uniform 槽位（排序每遍一个），
+ * 提交后调用 OnSubmitted 回收槽位和本次提交使用的绑定组。
+ */
+class GpuPrimitives {
+public:
+	// 一次提交最多可用的 uniform 槽位数
+	static constexpr uint32_t kMaxUniformSlots = 256;
+
+	/**
+	 * @brief 创建计算内核
+	 * @param shaderDirectory scan.wgsl、reduce.wgsl、compact.wgsl、radix-sort.wgsl 所在目录
+	 */
+	void Initialize(wgpu::Device device, wgpu::Queue queue, const std::filesystem::path& shaderDirectory);
+
+	/**
+	 * @brief 排他前缀和：output[i] = input[0] + ... + input[i - 1]
+	 * 单遍 decoupled look-back 实现，总和必须小于 2^30；input 与 output 不能是同一个缓冲区
+	 */
+	void ExclusiveScan(wgpu::CommandEncoder& encoder, wgpu::Buffer input, wgpu::Buffer output, uint32_t count);
+
+	/**
+	 * @brief 归约，结果写入 result[resultIndex]（求和按 2^32 取模）
+	 */
+	void Reduce(wgpu::CommandEncoder& encoder, wgpu::Buffer input, uint32_t count, ReduceOp op, wgpu::Buffer result, uint32_t resultIndex = 0);
+
+	/**
+	 * @brief 流压缩：按顺序保留 flags[i] 非 0 的 values[i]，写到 output 的开头，保留的个数写入 countBuffer[countIndex]
+	 */
+	void Compact(wgpu::CommandEncoder& encoder, wgpu::Buffer values, wgpu::Buffer flags, uint32_t count,
+		wgpu::Buffer output, wgpu::Buffer countBuffer, uint32_t countIndex = 0);
+
+	/**
+	 * @brief 键值对原地排序（按键升序、稳定），只比较键的低 keyBits 位（向上取整到 8 位）
+	 */
+	void SortPairs(wgpu::CommandEncoder& encoder, wgpu::Buffer keys, wgpu::Buffer values, uint32_t count, uint32_t keyBits = 32);
+
+	/**
+	 * @brief 提交后调用，回收 uniform 槽位和绑定组
+	 */
+	void OnSubmitted();
+
+	/**
+	 * @brief 销毁
+	 */
+	void Terminate();
+
+	/**
+	 * @brief 是否已初始化
+	 */
+	bool IsReady() const { return scanKernel.IsReady(); }
+
+private:
+	// 与各着色器中的参数结构布局一致
+	struct Params {
+		uint32_t count = 0;
+		uint32_t blockCount = 0;
+		uint32_t mode = 0;
+		uint32_t index = 0;
+	};
+
+	ComputeResource AllocateParams(const Params& params);
+	wgpu::BindGroup CreateBindGroup(const ComputeKernel& kernel, std::span<const ComputeResource> resources);
+	void EnsureScratch(wgpu::Buffer& buffer, uint64_t& capacity, uint64_t size, const char* label);
+	void RecordScan(ComputePass& computePass, wgpu::Buffer input, wgpu::Buffer output, uint32_t count, bool predicate);
+
+	wgpu::Device device = nullptr;
+	wgpu::Queue queue = nullptr;
+
+	ComputeKernel clearKernel;
+	ComputeKernel scanKernel;
+	ComputeKernel reduceInitKernel;
+	ComputeKernel reduceKernel;
+	ComputeKernel compactKernel;
+	ComputeKernel histogramKernel;
+	ComputeKernel sortScatterKernel;
+
+	// 参数槽位，按 256 字节对齐
+	wgpu::Buffer uniformBuffer = nullptr;
+	uint32_t usedUniformSlots = 0;
+	// 本次提交中创建的绑定组
+	std::vector<wgpu::BindGroup> pendingBindGroups;
+
+	// 前缀和的块状态
+	wgpu::Buffer tileStateBuffer = nullptr;
+	uint64_t tileStateCapacity = 0;
+	// 流压缩的偏移
+	wgpu::Buffer offsetBuffer = nullptr;
+	uint64_t offsetCapacity = 0;
+	// 排序的乒乓缓冲区和每块每个数位的计数、偏移
+	wgpu::Buffer keyScratchBuffer = nullptr;
+	uint64_t keyScratchCapacity = 0;
+	wgpu::Buffer valueScratchBuffer = nullptr;
+	uint64_t valueScratchCapacity = 0;
+	wgpu::Buffer histogramBuffer = nullptr;
+	uint64_t histogramCapacity = 0;
+	wgpu::Buffer histogramOffsetBuffer = nullptr;
+	uint64_t histogramOffsetCapacity = 0;
+};
+
+/**
+ * @brief CPU 上的参考实现，用于校验 GPU 结果
+ */
+std::vector<uint32_t> exclusiveScanReference(std::span<const uint32_t> input);
+uint32_t reduceReference(std::span<const uint32_t> input, ReduceOp op);
+std::vector<uint32_t> compactReference(std::span<const uint32_t> values, std::span<const uint32_t> flags);
+void sortPairsReference(std::span<uint32_t> keys, std::span<uint32_t> values, uint32_t keyBits = 32);
+
+/**
+ * @brief 并行原语的校验与基准测试：创建独立的设备（不需要窗口），
+ * 对 elementCount 个随机元素运行每个原语，与 CPU 参考实现比较，输出每秒处理的元素数
+ * @param forceFallbackAdapter 为 true 时请求软件适配器
+ * @return 所有原语的结果都与 CPU 参考实现一致；没有适配器、设备或着色器创建失败时为 false
+ */
+bool reportGpuPrimitivesBenchmark(const std::filesystem::path& shaderDirectory, uint32_t elementCount, bool forceFallbackAdapter);
+
+}
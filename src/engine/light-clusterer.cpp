@@ -0,0 +1,107 @@
+#include "light-clusterer.h"
+#include "../utils/utils.h"
+
+namespace webgpu {
+
+namespace {
+
+// 与 light-cluster.wgsl 中的 WORKGROUP_SIZE 一致
+constexpr uint32_t kWorkgroupSize = 64;
+
+}
+
+void LightClusterer::Initialize(wgpu::Device device, wgpu::Queue queue, const std::filesystem::path& shaderPath, uint32_t maxLights) {
+	this->queue = queue;
+	this->maxLights = std::max(maxLights, 1u);
+
+	LOG("Creating light cluster pipeline...\n");
+	wgpu::ShaderModule shaderModule = loadShaderModule(shaderPath, device);
+
+	// 参数、光源、每簇的光源数与光源编号
+	ComputeKernelDesc kernelDesc;
+	kernelDesc.label = "Light cluster pipeline";
+	kernelDesc.module = shaderModule;
+	kernelDesc.bindings = { ComputeBinding::Uniform(sizeof(LightClusterUniform)), ComputeBinding::ReadOnlyStorage(),
+		ComputeBinding::Storage(), ComputeBinding::Storage() };
+	kernelDesc.workgroupSize = glm::uvec3(kWorkgroupSize, 1u, 1u);
+	kernel.Initialize(device, kernelDesc);
+
+	// 缓冲区
+	wgpu::BufferDescriptor bufferDesc;
+	bufferDesc.mappedAtCreation = false;
+
+	bufferDesc.size = sizeof(LightClusterUniform);
+	bufferDesc.usage = wgpu::BufferUsage::CopyDst | wgpu::BufferUsage::Uniform;
+	uniformBuffer = device.createBuffer(bufferDesc);
+
+	bufferDesc.size = GetLightBufferSize();
+	bufferDesc.usage = wgpu::BufferUsage::CopyDst | wgpu::BufferUsage::Storage;
+	lightBuffer = device.createBuffer(bufferDesc);
+
+	bufferDesc.size = GetLightCountBufferSize();
+	bufferDesc.usage = wgpu::BufferUsage::Storage;
+	lightCountBuffer = device.createBuffer(bufferDesc);
+
+	bufferDesc.size = GetLightIndexBufferSize();
+	lightIndexBuffer = device.createBuffer(bufferDesc);
+
+	// 绑定组
+	ComputeResource resources[] = {
+		ComputeResource::Buffer(uniformBuffer, sizeof(LightClusterUniform)),
+		ComputeResource::Buffer(lightBuffer, GetLightBufferSize()),
+		ComputeResource::Buffer(lightCountBuffer, GetLightCountBufferSize()),
+		ComputeResource::Buffer(lightIndexBuffer, GetLightIndexBufferSize()),
+	};
+	bindGroup = kernel.CreateBindGroup(resources);
+
+	shaderModule.release();
+
+	LOG("Light clusters: %ux%ux%u, up to %u lights (%u per cluster)\n", kGridX, kGridY, kGridZ, this->maxLights, kMaxLightsPerCluster);
+}
+
+void LightClusterer::SetLights(const PointLight* lights, uint32_t count) {
+	lightCount = std::min(count, maxLights);
+	if (lightCount > 0 && lightCache.Write(queue, lightBuffer, 0, lights, lightCount * sizeof(PointLight)) > 0) {
+		lightsChanged = true;
+		++uploadCount;
+	}
+}
+
+void LightClusterer::AssignLights(wgpu::CommandEncoder& encoder, const glm::mat4x4& projectionMatrix, const glm::mat4x4& viewMatrix,
+	uint32_t width, uint32_t height, float zNear, float zFar) {
+	uniform.inverseProjection = glm::inverse(projectionMatrix);
+	uniform.viewMatrix = viewMatrix;
+	uniform.gridSize = glm::uvec4(kGridX, kGridY, kGridZ, lightCount);
+	uniform.screenSize = glm::vec2(static_cast<float>(width), static_cast<float>(height));
+	uniform.zNear = zNear;
+	uniform.zFar = zFar;
+	uint32_t written = uniformCache.Write(queue, uniformBuffer, 0, &uniform, sizeof(LightClusterUniform));
+	uploadCount += written;
+	// 每簇的列表只由这里写入，光源和参数都没变时上一次的结果仍然有效
+	if (written == 0 && !lightsChanged) {
+		return;
+	}
+	lightsChanged = false;
+
+	// 没有光源时也要执行，把每簇的光源数清零
+	ComputePass computePass(encoder, "Light cluster pass");
+	computePass.DispatchThreads(kernel, bindGroup, kClusterCount);
+}
+
+void LightClusterer::Terminate() {
+	if (!kernel.IsReady()) {
+		return;
+	}
+	for (wgpu::Buffer* buffer : { &uniformBuffer, &lightBuffer, &lightCountBuffer, &lightIndexBuffer }) {
+		buffer->destroy();
+		buffer->release();
+		*buffer = nullptr;
+	}
+	bindGroup.release();
+	kernel.Terminate();
+	lightCache.Reset();
+	uniformCache.Reset();
+	lightsChanged = true;
+}
+
+}
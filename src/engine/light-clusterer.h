@@ -0,0 +1,113 @@
+#pragma once
+
+#include "../utils/global.h"
+#include "compute.h"
+#include "uniform-buffer.h"
+
+namespace webgpu {
+
+/**
+ * 点光源，布局与 base.wgsl / light-cluster.wgsl 中的 PointLight 一致
+ */
+struct PointLight {
+	glm::vec3 position = glm::vec3(0.0f);
+	// 影响半径，之外的贡献为 0
+	float radius = 1.0f;
+	glm::vec3 color = glm::vec3(1.0f);
+	float intensity = 1.0f;
+};
+
+static_assert(sizeof(PointLight) == 32);
+
+/**
+ * 分簇参数，布局与着色器中的 ClusterUniforms 一致
+ */
+struct LightClusterUniform {
+	glm::mat4x4 inverseProjection = glm::mat4x4(1.0f);
+	glm::mat4x4 viewMatrix = glm::mat4x4(1.0f);
+	// x、y、z 方向的簇数，w 为光源数
+	glm::uvec4 gridSize = glm::uvec4(0u);
+	glm::vec2 screenSize = glm::vec2(1.0f);
+	// 深度方向按指数划分的范围（视图空间）
+	float zNear = 0.1f;
+	float zFar = 100.0f;
+};
+
+static_assert(sizeof(LightClusterUniform) % 16 == 0);
+
+/**
+ * 分簇光源剔除（clustered forward）
+ * 视锥按屏幕分块和指数深度切片划分成 kGridX * kGridY * kGridZ 个簇，
+ * 计算通道对每个簇的视图空间包围盒测试所有点光源，把相交的光源编号写入该簇的列表（每簇最多 kMaxLightsPerCluster 个），
+ * 片元着色器只遍历自己所在簇的光源，每像素的开销与场景中的光源总数无关。
+ */
+class LightClusterer {
+public:
+	static constexpr uint32_t kGridX = 16;
+	static constexpr uint32_t kGridY = 9;
+	static constexpr uint32_t kGridZ = 24;
+	static constexpr uint32_t kClusterCount = kGridX * kGridY * kGridZ;
+	// 与 light-cluster.wgsl / base.wgsl 中的 MAX_LIGHTS_PER_CLUSTER 一致
+	static constexpr uint32_t kMaxLightsPerCluster = 128;
+
+	/**
+	 * @brief 创建计算管线和缓冲区
+	 * @param shaderPath light-cluster.wgsl 路径
+	 * @param maxLights 光源缓冲区的容量
+	 */
+	void Initialize(wgpu::Device device, wgpu::Queue queue, const std::filesystem::path& shaderPath, uint32_t maxLights);
+
+	/**
+	 * @brief 上传本帧的光源（超过容量的部分丢弃），与上次相同时不上传
+	 */
+	void SetLights(const PointLight* lights, uint32_t count);
+
+	/**
+	 * @brief 录制分簇计算通道
+	 * @param projectionMatrix / viewMatrix 本帧的相机矩阵
+	 * @param width / height 渲染目标尺寸
+	 * @param zNear / zFar 深度切片的范围，之外的片元归入首/尾切片
+	 * 光源和分簇参数都没变时沿用上一次的分簇结果，不上传也不分发
+	 */
+	void AssignLights(wgpu::CommandEncoder& encoder, const glm::mat4x4& projectionMatrix, const glm::mat4x4& viewMatrix,
+		uint32_t width, uint32_t height, float zNear, float zFar);
+
+	/**
+	 * @brief 自上次调用以来每帧的 writeBuffer 次数，读取后清零
+	 */
+	uint32_t TakeUploadCount() { return std::exchange(uploadCount, 0u); }
+
+	/**
+	 * @brief 销毁
+	 */
+	void Terminate();
+
+	// 片元着色器绑定的缓冲区
+	wgpu::Buffer GetUniformBuffer() const { return uniformBuffer; }
+	wgpu::Buffer GetLightBuffer() const { return lightBuffer; }
+	uint64_t GetLightBufferSize() const { return static_cast<uint64_t>(maxLights) * sizeof(PointLight); }
+	wgpu::Buffer GetLightCountBuffer() const { return lightCountBuffer; }
+	uint64_t GetLightCountBufferSize() const { return kClusterCount * sizeof(uint32_t); }
+	wgpu::Buffer GetLightIndexBuffer() const { return lightIndexBuffer; }
+	uint64_t GetLightIndexBufferSize() const { return static_cast<uint64_t>(kClusterCount) * kMaxLightsPerCluster * sizeof(uint32_t); }
+
+private:
+	wgpu::Queue queue = nullptr;
+	ComputeKernel kernel;
+	wgpu::BindGroup bindGroup = nullptr;
+	wgpu::Buffer uniformBuffer = nullptr;
+	wgpu::Buffer lightBuffer = nullptr;
+	// 每簇的光源数与光源编号列表（每簇固定 kMaxLightsPerCluster 个槽位）
+	wgpu::Buffer lightCountBuffer = nullptr;
+	wgpu::Buffer lightIndexBuffer = nullptr;
+	uint32_t maxLights = 0;
+	uint32_t lightCount = 0;
+	LightClusterUniform uniform;
+	BufferWriteCache lightCache;
+	BufferWriteCache uniformCache;
+	// 上次分簇之后光源是否重新上传过
+	bool lightsChanged = true;
+	uint32_t uploadCount = 0;
+};
+
+}
@@ -0,0 +1,134 @@
+#include "meshlet-culler.h"
+#include "../utils/utils.h"
+
+namespace webgpu {
+
+namespace {
+
+// drawIndexedIndirect 参数
+struct DrawIndexedIndirectArgs {
+	uint32_t indexCount;
+	uint32_t instanceCount;
+	uint32_t firstIndex;
+	int32_t baseVertex;
+	uint32_t firstInstance;
+};
+
+static_assert(sizeof(DrawIndexedIndirectArgs) == 20);
+
+// 与 meshlet-cull.wgsl 中的 WORKGROUP_SIZE 一致
+constexpr uint32_t kWorkgroupSize = 64;
+
+}
+
+void MeshletCuller::Initialize(wgpu::Device device, wgpu::Queue queue, const std::filesystem::path& shaderPath,
+	const MeshletMesh& meshletMesh, wgpu::Buffer instanceBuffer, uint64_t instanceBufferSize) {
+	this->queue = queue;
+	meshletCount = static_cast<uint32_t>(meshletMesh.meshlets.size());
+	indexCapacity = static_cast<uint32_t>(meshletMesh.indices.size());
+
+	LOG("Creating meshlet cull pipeline...\n");
+	wgpu::ShaderModule shaderModule = loadShaderModule(shaderPath, device);
+
+	// 参数、meshlet、meshlet 索引、实例、参与剔除的实例编号、压缩后的索引、间接绘制参数
+	ComputeKernelDesc kernelDesc;
+	kernelDesc.label = "Meshlet cull pipeline";
+	kernelDesc.module = shaderModule;
+	kernelDesc.bindings = { ComputeBinding::Uniform(sizeof(MeshletCullUniform)), ComputeBinding::ReadOnlyStorage(), ComputeBinding::ReadOnlyStorage(),
+		ComputeBinding::ReadOnlyStorage(), ComputeBinding::ReadOnlyStorage(), ComputeBinding::Storage(), ComputeBinding::Storage() };
+	kernelDesc.workgroupSize = glm::uvec3(kWorkgroupSize, 1u, 1u);
+	kernel.Initialize(device, kernelDesc);
+
+	// 缓冲区
+	wgpu::BufferDescriptor bufferDesc;
+	bufferDesc.mappedAtCreation = false;
+
+	bufferDesc.size = sizeof(MeshletCullUniform);
+	bufferDesc.usage = wgpu::BufferUsage::CopyDst | wgpu::BufferUsage::Uniform;
+	uniformBuffer = device.createBuffer(bufferDesc);
+
+	bufferDesc.size = meshletMesh.meshlets.size() * sizeof(Meshlet);
+	bufferDesc.usage = wgpu::BufferUsage::CopyDst | wgpu::BufferUsage::Storage;
+	meshletBuffer = device.createBuffer(bufferDesc);
+	queue.writeBuffer(meshletBuffer, 0, meshletMesh.meshlets.data(), bufferDesc.size);
+
+	bufferDesc.size = meshletMesh.indices.size() * sizeof(uint32_t);
+	meshletIndexBuffer = device.createBuffer(bufferDesc);
+	queue.writeBuffer(meshletIndexBuffer, 0, meshletMesh.indices.data(), bufferDesc.size);
+
+	bufferDesc.size = kMaxInstances * sizeof(uint32_t);
+	cullInstanceBuffer = device.createBuffer(bufferDesc);
+
+	bufferDesc.size = static_cast<uint64_t>(kMaxInstances) * indexCapacity * sizeof(uint32_t);
+	bufferDesc.usage = wgpu::BufferUsage::Storage | wgpu::BufferUsage::Index;
+	culledIndexBuffer = device.createBuffer(bufferDesc);
+
+	bufferDesc.size = kMaxInstances * sizeof(DrawIndexedIndirectArgs);
+	bufferDesc.usage = wgpu::BufferUsage::CopyDst | wgpu::BufferUsage::Storage | wgpu::BufferUsage::Indirect;
+	drawArgsBuffer = device.createBuffer(bufferDesc);
+
+	// 绑定组
+	ComputeResource resources[] = {
+		ComputeResource::Buffer(uniformBuffer, sizeof(MeshletCullUniform)),
+		ComputeResource::Buffer(meshletBuffer, meshletMesh.meshlets.size() * sizeof(Meshlet)),
+		ComputeResource::Buffer(meshletIndexBuffer, meshletMesh.indices.size() * sizeof(uint32_t)),
+		ComputeResource::Buffer(instanceBuffer, instanceBufferSize),
+		ComputeResource::Buffer(cullInstanceBuffer, kMaxInstances * sizeof(uint32_t)),
+		ComputeResource::Buffer(culledIndexBuffer, GetCulledIndexBufferSize()),
+		ComputeResource::Buffer(drawArgsBuffer, kMaxInstances * sizeof(DrawIndexedIndirectArgs)),
+	};
+	bindGroup = kernel.CreateBindGroup(resources);
+
+	shaderModule.release();
+}
+
+void MeshletCuller::Cull(wgpu::CommandEncoder& encoder, MeshletCullUniform params, const uint32_t* instanceIds, uint32_t count, bool instancesMoved) {
+	count = std::min(count, kMaxInstances);
+	if (count == 0) {
+		return;
+	}
+
+	params.meshletCount = meshletCount;
+	params.indexCapacity = indexCapacity;
+	uint32_t written = uniformCache.Write(queue, uniformBuffer, 0, &params, sizeof(MeshletCullUniform))
+		+ instanceIdCache.Write(queue, cullInstanceBuffer, 0, instanceIds, count * sizeof(uint32_t));
+	uploadCount += written;
+	// 输入都没变：压缩后的索引和间接绘制参数只由这里写入，上一次的结果仍然有效
+	if (written == 0 && !instancesMoved) {
+		return;
+	}
+
+	// 重置间接绘制参数，indexCount 由计算着色器原子累加
+	std::array<DrawIndexedIndirectArgs, kMaxInstances> args;
+	for (uint32_t slot = 0; slot < count; ++slot) {
+		args[slot] = { 0, 1, slot * indexCapacity, 0, instanceIds[slot] };
+	}
+	queue.writeBuffer(drawArgsBuffer, 0, args.data(), count * sizeof(DrawIndexedIndirectArgs));
+	++uploadCount;
+
+	// 每个工作组处理一个 (meshlet, 实例)
+	ComputePass computePass(encoder, "Meshlet cull pass");
+	computePass.Dispatch(kernel, bindGroup, meshletCount, count);
+}
+
+void MeshletCuller::Draw(wgpu::RenderPassEncoder& renderPass, uint32_t slot) {
+	renderPass.setIndexBuffer(culledIndexBuffer, wgpu::IndexFormat::Uint32, 0, static_cast<uint64_t>(kMaxInstances) * indexCapacity * sizeof(uint32_t));
+	renderPass.drawIndexedIndirect(drawArgsBuffer, slot * sizeof(DrawIndexedIndirectArgs));
+}
+
+void MeshletCuller::Terminate() {
+	if (!kernel.IsReady()) {
+		return;
+	}
+	for (wgpu::Buffer* buffer : { &uniformBuffer, &meshletBuffer, &meshletIndexBuffer, &cullInstanceBuffer, &culledIndexBuffer, &drawArgsBuffer }) {
+		buffer->destroy();
+		buffer->release();
+		*buffer = nullptr;
+	}
+	bindGroup.release();
+	kernel.Terminate();
+	uniformCache.Reset();
+	instanceIdCache.Reset();
+}
+
+}
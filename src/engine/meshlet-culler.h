@@ -0,0 +1,106 @@
+#pragma once
+
+#include "../utils/global.h"
+#include "../utils/data-structure.h"
+#include "../utils/meshlet.h"
+#include "../utils/frustum.h"
+#include "compute.h"
+#include "uniform-buffer.h"
+
+namespace webgpu {
+
+/**
+ * meshlet 剔除参数，布局与 meshlet-cull.wgsl 中的 CullUniforms 一致
+ */
+struct MeshletCullUniform {
+	FrustumPlanes frustumPlanes = {};
+	glm::vec4 cameraPosition = glm::vec4(0.0f);
+	uint32_t meshletCount = 0;
+	uint32_t indexCapacity = 0;
+	uint32_t _pad[2] = {};
+};
+
+static_assert(sizeof(MeshletCullUniform) % 16 == 0);
+
+/**
+ * GPU meshlet 剔除
+ * 计算通道对每个 (meshlet, 实例) 做视锥和法线锥测试，把可见三角形压缩进一个索引缓冲区，
+ * 每个实例对应一个槽位和一组 drawIndexedIndirect 参数
+ */
+class MeshletCuller {
+public:
+	// 每帧最多参与 meshlet 剔除的实例数
+	static constexpr uint32_t kMaxInstances = 16;
+
+	/**
+	 * @brief 创建计算管线和缓冲区
+	 * @param shaderPath meshlet-cull.wgsl 路径
+	 * @param meshletMesh 切分好的 meshlet
+	 * @param instanceBuffer 实例 storage buffer
+	 * @param instanceBufferSize 实例 buffer 大小
+	 */
+	void Initialize(wgpu::Device device, wgpu::Queue queue, const std::filesystem::path& shaderPath,
+		const MeshletMesh& meshletMesh, wgpu::Buffer instanceBuffer, uint64_t instanceBufferSize);
+
+	/**
+	 * @brief 录制剔除计算通道
+	 * @param params 视锥、相机与模型矩阵（meshletCount/indexCapacity 由内部填写）
+	 * @param instanceIds 参与剔除的实例编号，第 i 个占用槽位 i
+	 * @param count 实例数，不超过 kMaxInstances
+	 * @param instancesMoved 实例的模型矩阵是否变化；参数、实例编号和模型矩阵都没变时沿用上一次的剔除结果，不上传也不分发
+	 */
+	void Cull(wgpu::CommandEncoder& encoder, MeshletCullUniform params, const uint32_t* instanceIds, uint32_t count, bool instancesMoved);
+
+	/**
+	 * @brief 绘制某个槽位的剔除结果（会替换当前的索引缓冲区）
+	 */
+	void Draw(wgpu::RenderPassEncoder& renderPass, uint32_t slot);
+
+	/**
+	 * @brief 压缩后的索引缓冲区及其大小（交给渲染队列时使用）
+	 */
+	wgpu::Buffer GetCulledIndexBuffer() const { return culledIndexBuffer; }
+	uint64_t GetCulledIndexBufferSize() const { return static_cast<uint64_t>(kMaxInstances) * indexCapacity * sizeof(uint32_t); }
+
+	/**
+	 * @brief 间接绘制参数缓冲区，以及某个槽位的参数偏移
+	 */
+	wgpu::Buffer GetDrawArgsBuffer() const { return drawArgsBuffer; }
+	uint64_t GetDrawArgsOffset(uint32_t slot) const { return slot * 5 * sizeof(uint32_t); }
+
+	/**
+	 * @brief 自上次调用以来每帧的 writeBuffer 次数，读取后清零
+	 */
+	uint32_t TakeUploadCount() { return std::exchange(uploadCount, 0u); }
+
+	/**
+	 * @brief 销毁
+	 */
+	void Terminate();
+
+	/**
+	 * @brief 是否已初始化
+	 */
+	bool IsReady() const { return kernel.IsReady(); }
+
+private:
+	wgpu::Queue queue = nullptr;
+	ComputeKernel kernel;
+	wgpu::BindGroup bindGroup = nullptr;
+	wgpu::Buffer uniformBuffer = nullptr;
+	wgpu::Buffer meshletBuffer = nullptr;
+	wgpu::Buffer meshletIndexBuffer = nullptr;
+	wgpu::Buffer cullInstanceBuffer = nullptr;
+	// 压缩后的索引，kMaxInstances 个槽位，每个 indexCapacity 个索引
+	wgpu::Buffer culledIndexBuffer = nullptr;
+	// drawIndexedIndirect 参数，每个槽位 5 个 uint32
+	wgpu::Buffer drawArgsBuffer = nullptr;
+	uint32_t meshletCount = 0;
+	uint32_t indexCapacity = 0;
+	// 上一次写入的剔除参数和实例编号
+	BufferWriteCache uniformCache;
+	BufferWriteCache instanceIdCache;
+	uint32_t uploadCount = 0;
+};
+
+}
@@ -0,0 +1,304 @@
+#include "occlusion-culler.h"
+#include "../utils/utils.h"
+
+#include <algorithm>
+#include <bit>
+
+namespace webgpu {
+
+namespace {
+
+// drawIndexedIndirect 参数
+struct DrawIndexedIndirectArgs {
+	uint32_t indexCount;
+	uint32_t instanceCount;
+	uint32_t firstIndex;
+	int32_t baseVertex;
+	uint32_t firstInstance;
+};
+
+static_assert(sizeof(DrawIndexedIndirectArgs) == 20);
+
+// occlusion-cull.wgsl 中 workgroupSize 的默认值（可按设备限制覆盖），hiz.wgsl 中的工作组大小
+constexpr uint32_t kCullWorkgroupSize = 64;
+constexpr uint32_t kHiZWorkgroupSize = 8;
+// 两个阶段的 uniform 槽位间隔（minUniformBufferOffsetAlignment 的上限）
+constexpr uint64_t kUniformStride = 256;
+constexpr uint64_t kStatsSize = 4 * sizeof(uint32_t);
+
+static_assert(sizeof(OcclusionCullUniform) <= kUniformStride);
+
+}
+
+void OcclusionCuller::Initialize(wgpu::Device device, wgpu::Queue queue, const std::filesystem::path& shaderDirectory, uint32_t maxInstances) {
+	this->device = device;
+	this->queue = queue;
+	this->maxInstances = std::max(maxInstances, 1u);
+
+	LOG("Creating occlusion cull pipelines...\n");
+	wgpu::ShaderModule cullModule = loadShaderModule(shaderDirectory / "occlusion-cull.wgsl", device);
+	wgpu::ShaderModule hizModule = loadShaderModule(shaderDirectory / "hiz.wgsl", device);
+
+	// 剔除：参数、实例、可见性、间接绘制参数、统计、Hi-Z
+	ComputeKernelDesc kernelDesc;
+	kernelDesc.label = "Occlusion cull pipeline";
+	kernelDesc.module = cullModule;
+	kernelDesc.bindings = { ComputeBinding::Uniform(sizeof(OcclusionCullUniform)), ComputeBinding::ReadOnlyStorage(), ComputeBinding::Storage(),
+		ComputeBinding::Storage(), ComputeBinding::Storage(), ComputeBinding::Texture(wgpu::TextureSampleType::UnfilterableFloat) };
+	kernelDesc.workgroupSize = glm::uvec3(kCullWorkgroupSize, 1u, 1u);
+	kernelDesc.overridableWorkgroupSize = true;
+	cullKernel.Initialize(device, kernelDesc);
+
+	// Hi-Z：深度或上一级作为输入，下一级作为存储纹理输出
+	kernelDesc.module = hizModule;
+	kernelDesc.workgroupSize = glm::uvec3(kHiZWorkgroupSize, kHiZWorkgroupSize, 1u);
+	kernelDesc.overridableWorkgroupSize = false;
+	kernelDesc.label = "Hi-Z copy pipeline";
+	kernelDesc.entryPoint = "cs_copy";
+	kernelDesc.bindings = { ComputeBinding::Texture(wgpu::TextureSampleType::Depth), ComputeBinding::StorageTexture(wgpu::TextureFormat::R32Float) };
+	copyKernel.Initialize(device, kernelDesc);
+	kernelDesc.label = "Hi-Z reduce pipeline";
+	kernelDesc.entryPoint = "cs_reduce";
+	kernelDesc.bindings[0] = ComputeBinding::Texture(wgpu::TextureSampleType::UnfilterableFloat);
+	reduceKernel.Initialize(device, kernelDesc);
+
+	cullModule.release();
+	hizModule.release();
+
+	// 缓冲区
+	wgpu::BufferDescriptor bufferDesc;
+	bufferDesc.mappedAtCreation = false;
+
+	bufferDesc.size = 2 * kUniformStride;
+	bufferDesc.usage = wgpu::BufferUsage::CopyDst | wgpu::BufferUsage::Uniform;
+	uniformBuffer = device.createBuffer(bufferDesc);
+
+	bufferDesc.size = static_cast<uint64_t>(this->maxInstances) * sizeof(OcclusionInstance);
+	bufferDesc.usage = wgpu::BufferUsage::CopyDst | wgpu::BufferUsage::Storage;
+	instanceBuffer = device.createBuffer(bufferDesc);
+
+	// 第一帧所有实例都视为不可见，由后期测试后补画
+	bufferDesc.size = static_cast<uint64_t>(this->maxInstances) * sizeof(uint32_t);
+	bufferDesc.usage = wgpu::BufferUsage::CopyDst | wgpu::BufferUsage::Storage;
+	visibilityBuffer = device.createBuffer(bufferDesc);
+	std::vector<uint32_t> zeros(this->maxInstances, 0u);
+	queue.writeBuffer(visibilityBuffer, 0, zeros.data(), bufferDesc.size);
+
+	bufferDesc.size = static_cast<uint64_t>(this->maxInstances) * sizeof(DrawIndexedIndirectArgs);
+	bufferDesc.usage = wgpu::BufferUsage::Storage | wgpu::BufferUsage::Indirect;
+	for (uint32_t phase = 0; phase < 2; ++phase) {
+		drawArgsBuffers.push_back(device.createBuffer(bufferDesc));
+	}
+
+	bufferDesc.size = kStatsSize;
+	bufferDesc.usage = wgpu::BufferUsage::CopyDst | wgpu::BufferUsage::CopySrc | wgpu::BufferUsage::Storage;
+	statsBuffer = device.createBuffer(bufferDesc);
+	bufferDesc.usage = wgpu::BufferUsage::CopyDst | wgpu::BufferUsage::MapRead;
+	statsReadbackBuffer = device.createBuffer(bufferDesc);
+	statsState = ReadbackState::Idle;
+
+	// 先用 1x1 的金字塔占位，第一次 BuildPyramid 时按深度缓冲区的尺寸重建
+	CreatePyramid(1, 1);
+
+	LOG("Occlusion culling: two-phase Hi-Z, up to %u instances\n", this->maxInstances);
+}
+
+void OcclusionCuller::SetInstances(const OcclusionInstance* instances, uint32_t count) {
+	instanceCount = std::min(count, maxInstances);
+	if (instanceCount > 0) {
+		uploadCount += instanceCache.Write(queue, instanceBuffer, 0, instances, instanceCount * sizeof(OcclusionInstance));
+	}
+}
+
+void OcclusionCuller::CullEarly(wgpu::CommandEncoder& encoder, const glm::mat4x4& projectionMatrix, const glm::mat4x4& viewMatrix, float cameraNear) {
+	uniform.viewMatrix = viewMatrix;
+	uniform.projectionMatrix = projectionMatrix;
+	uniform.frustumPlanes = extractFrustumPlanes(projectionMatrix * viewMatrix);
+	uniform.camera.x = cameraNear;
+	encoder.clearBuffer(statsBuffer, 0, kStatsSize);
+	DispatchCull(encoder, 0, "Occlusion cull pass (early)");
+}
+
+void OcclusionCuller::BuildPyramid(wgpu::CommandEncoder& encoder, wgpu::TextureView depthView, uint32_t width, uint32_t height) {
+	if (width != pyramidWidth || height != pyramidHeight) {
+		CreatePyramid(width, height);
+	}
+	if (!copyBindGroup || copySourceView != static_cast<WGPUTextureView>(depthView)) {
+		if (copyBindGroup) {
+			copyBindGroup.release();
+		}
+		ComputeResource resources[] = { ComputeResource::Texture(depthView), ComputeResource::Texture(pyramidMipViews[0]) };
+		copyBindGroup = copyKernel.CreateBindGroup(resources);
+		copySourceView = depthView;
+	}
+
+	ComputePass computePass(encoder, "Hi-Z pass");
+	computePass.DispatchThreads(copyKernel, copyBindGroup, width, height);
+	// 每级一次分发，同一计算通道内上一级写完才会被读取
+	for (uint32_t level = 1; level < pyramidLevels; ++level) {
+		uint32_t levelWidth = std::max(width >> level, 1u);
+		uint32_t levelHeight = std::max(height >> level, 1u);
+		computePass.DispatchThreads(reduceKernel, reduceBindGroups[level - 1], levelWidth, levelHeight);
+	}
+}
+
+void OcclusionCuller::CullLate(wgpu::CommandEncoder& encoder) {
+	DispatchCull(encoder, 1, "Occlusion cull pass (late)");
+	if (statsState == ReadbackState::Idle) {
+		encoder.copyBufferToBuffer(statsBuffer, 0, statsReadbackBuffer, 0, kStatsSize);
+		statsState = ReadbackState::Copied;
+	}
+}
+
+void OcclusionCuller::Draw(wgpu::RenderPassEncoder& renderPass, uint32_t instance, bool late) {
+	if (instance < instanceCount) {
+		renderPass.drawIndexedIndirect(drawArgsBuffers[late ? 1 : 0], instance * sizeof(DrawIndexedIndirectArgs));
+	}
+}
+
+void OcclusionCuller::OnSubmitted() {
+	if (statsState == ReadbackState::Mapped) {
+		const uint32_t* stats = static_cast<const uint32_t*>(statsReadbackBuffer.getConstMappedRange(0, kStatsSize));
+		std::array<uint32_t, 3> current = { stats[0], stats[1], stats[2] };
+		statsReadbackBuffer.unmap();
+		statsState = ReadbackState::Idle;
+		if (current != lastStats) {
+			LOG("Occlusion culling: %u drawn early, %u drawn late, %u occluded of %u instances\n",
+				current[0], current[1], current[2], instanceCount);
+			lastStats = current;
+		}
+	}
+	if (statsState == ReadbackState::Copied) {
+		statsState = ReadbackState::Mapping;
+		// 回调在 device.tick() 中触发
+		statsCallback = statsReadbackBuffer.mapAsync(wgpu::MapMode::Read, 0, kStatsSize, [this](wgpu::BufferMapAsyncStatus status) {
+			statsState = status == wgpu::BufferMapAsyncStatus::Success ? ReadbackState::Mapped : ReadbackState::Idle;
+		});
+	}
+}
+
+void OcclusionCuller::DispatchCull(wgpu::CommandEncoder& encoder, uint32_t phase, const char* label) {
+	uniform.params = glm::uvec4(instanceCount, phase, pyramidWidth, pyramidHeight);
+	uniform.camera.y = static_cast<float>(pyramidLevels);
+	uploadCount += uniformCaches[phase].Write(queue, uniformBuffer, phase * kUniformStride, &uniform, sizeof(OcclusionCullUniform));
+	if (instanceCount == 0) {
+		return;
+	}
+
+	ComputePass computePass(encoder, label);
+	computePass.DispatchThreads(cullKernel, cullBindGroups[phase], instanceCount);
+}
+
+void OcclusionCuller::CreatePyramid(uint32_t width, uint32_t height) {
+	DestroyPyramid();
+	pyramidWidth = std::max(width, 1u);
+	pyramidHeight = std::max(height, 1u);
+	pyramidLevels = static_cast<uint32_t>(std::bit_width(std::max(pyramidWidth, pyramidHeight)));
+
+	wgpu::TextureDescriptor textureDesc;
+	textureDesc.label = "Hi-Z pyramid";
+	textureDesc.dimension = wgpu::TextureDimension::_2D;
+	textureDesc.format = wgpu::TextureFormat::R32Float;
+	textureDesc.mipLevelCount = pyramidLevels;
+	textureDesc.sampleCount = 1;
+	textureDesc.size = { pyramidWidth, pyramidHeight, 1 };
+	textureDesc.usage = wgpu::TextureUsage::TextureBinding | wgpu::TextureUsage::StorageBinding;
+	textureDesc.viewFormatCount = 0;
+	textureDesc.viewFormats = nullptr;
+	pyramid = device.createTexture(textureDesc);
+
+	wgpu::TextureViewDescriptor viewDesc;
+	viewDesc.aspect = wgpu::TextureAspect::All;
+	viewDesc.baseArrayLayer = 0;
+	viewDesc.arrayLayerCount = 1;
+	viewDesc.dimension = wgpu::TextureViewDimension::_2D;
+	viewDesc.format = wgpu::TextureFormat::R32Float;
+	viewDesc.baseMipLevel = 0;
+	viewDesc.mipLevelCount = pyramidLevels;
+	pyramidView = pyramid.createView(viewDesc);
+	viewDesc.mipLevelCount = 1;
+	for (uint32_t level = 0; level < pyramidLevels; ++level) {
+		viewDesc.baseMipLevel = level;
+		pyramidMipViews.push_back(pyramid.createView(viewDesc));
+	}
+	for (uint32_t level = 0; level + 1 < pyramidLevels; ++level) {
+		ComputeResource resources[] = { ComputeResource::Texture(pyramidMipViews[level]), ComputeResource::Texture(pyramidMipViews[level + 1]) };
+		reduceBindGroups.push_back(reduceKernel.CreateBindGroup(resources));
+	}
+	CreateCullBindGroups();
+}
+
+void OcclusionCuller::DestroyPyramid() {
+	// 本帧可能已经录制了引用旧金字塔的命令，只释放引用，不立即 destroy
+	for (wgpu::BindGroup& bindGroup : reduceBindGroups) {
+		bindGroup.release();
+	}
+	reduceBindGroups.clear();
+	for (wgpu::BindGroup& bindGroup : cullBindGroups) {
+		bindGroup.release();
+	}
+	cullBindGroups.clear();
+	if (copyBindGroup) {
+		copyBindGroup.release();
+		copyBindGroup = nullptr;
+		copySourceView = nullptr;
+	}
+	for (wgpu::TextureView& view : pyramidMipViews) {
+		view.release();
+	}
+	pyramidMipViews.clear();
+	if (pyramid) {
+		pyramidView.release();
+		pyramidView = nullptr;
+		pyramid.release();
+		pyramid = nullptr;
+	}
+}
+
+void OcclusionCuller::CreateCullBindGroups() {
+	for (uint32_t phase = 0; phase < 2; ++phase) {
+		ComputeResource resources[] = {
+			ComputeResource::Buffer(uniformBuffer, sizeof(OcclusionCullUniform), phase * kUniformStride),
+			ComputeResource::Buffer(instanceBuffer, static_cast<uint64_t>(maxInstances) * sizeof(OcclusionInstance)),
+			ComputeResource::Buffer(visibilityBuffer, static_cast<uint64_t>(maxInstances) * sizeof(uint32_t)),
+			ComputeResource::Buffer(drawArgsBuffers[phase], static_cast<uint64_t>(maxInstances) * sizeof(DrawIndexedIndirectArgs)),
+			ComputeResource::Buffer(statsBuffer, kStatsSize),
+			ComputeResource::Texture(pyramidView),
+		};
+		cullBindGroups.push_back(cullKernel.CreateBindGroup(resources));
+	}
+}
+
+void OcclusionCuller::Terminate() {
+	if (!cullKernel.IsReady()) {
+		return;
+	}
+	if (statsState == ReadbackState::Mapped) {
+		statsReadbackBuffer.unmap();
+	}
+	statsCallback.reset();
+	statsState = ReadbackState::Idle;
+	if (pyramid) {
+		pyramid.destroy();
+	}
+	DestroyPyramid();
+	for (wgpu::Buffer& buffer : drawArgsBuffers) {
+		buffer.destroy();
+		buffer.release();
+	}
+	drawArgsBuffers.clear();
+	for (wgpu::Buffer* buffer : { &uniformBuffer, &instanceBuffer, &visibilityBuffer, &statsBuffer, &statsReadbackBuffer }) {
+		buffer->destroy();
+		buffer->release();
+		*buffer = nullptr;
+	}
+	copyKernel.Terminate();
+	reduceKernel.Terminate();
+	cullKernel.Terminate();
+	instanceCache.Reset();
+	for (BufferWriteCache& cache : uniformCaches) {
+		cache.Reset();
+	}
+}
+
+}
@@ -0,0 +1,166 @@
+#pragma once
+
+#include "../utils/global.h"
+#include "../utils/frustum.h"
+#include "compute.h"
+#include "uniform-buffer.h"
+
+namespace webgpu {
+
+/**
+ * 参与遮挡剔除的实例：世界空间包围球和它的绘制参数，布局与 occlusion-cull.wgsl 中的 CullInstance 一致
+ * instanceCount 为 0 的实例不参与（例如已经交给 meshlet 剔除的实例）
+ */
+struct OcclusionInstance {
+	glm::vec4 sphere = glm::vec4(0.0f);
+	uint32_t indexCount = 0;
+	uint32_t instanceCount = 0;
+	uint32_t firstIndex = 0;
+	int32_t baseVertex = 0;
+	uint32_t firstInstance = 0;
+	uint32_t _pad[3] = {};
+};
+
+static_assert(sizeof(OcclusionInstance) == 48);
+
+/**
+ * 遮挡剔除参数，布局与 occlusion-cull.wgsl 中的 CullUniforms 一致
+ */
+struct OcclusionCullUniform {
+	glm::mat4x4 viewMatrix = glm::mat4x4(1.0f);
+	glm::mat4x4 projectionMatrix = glm::mat4x4(1.0f);
+	FrustumPlanes frustumPlanes = {};
+	// x 为实例数，y 为阶段（0 前期，1 后期），zw 为 Hi-Z 第 0 级的尺寸
+	glm::uvec4 params = glm::uvec4(0u);
+	// x 为相机近平面，y 为 Hi-Z 的级数
+	glm::vec4 camera = glm::vec4(0.0f);
+};
+
+static_assert(sizeof(OcclusionCullUniform) % 16 == 0);
+
+/**
+ * 基于 Hi-Z 的两阶段遮挡剔除
+ * 前期：视锥内且上一帧可见的实例直接绘制；
+ * 然后由前期的深度生成 Hi-Z 金字塔（每级取 2x2 的最大深度）；
+ * 后期：所有视锥内的实例用包围球的屏幕矩形测试 Hi-Z，更新可见性，上一帧不可见而这一帧可见的实例补画。
+ * 被遮挡的物体不会因为上一帧的结果而突然消失（补画在同一帧），新露出的物体也不会晚一帧出现。
+ * 每个实例对应一组 drawIndexedIndirect 参数，需要 IndirectFirstInstance 特性。
+ */
+class OcclusionCuller {
+public:
+	/**
+	 * @brief 创建计算管线和缓冲区
+	 * @param shaderDirectory occlusion-cull.wgsl 与 hiz.wgsl 所在目录
+	 * @param maxInstances 实例数上限
+	 */
+	void Initialize(wgpu::Device device, wgpu::Queue queue, const std::filesystem::path& shaderDirectory, uint32_t maxInstances);
+
+	/**
+	 * @brief 上传本帧的实例包围球和绘制参数（超过上限的部分丢弃），与上次相同时不上传
+	 */
+	void SetInstances(const OcclusionInstance* instances, uint32_t count);
+
+	/**
+	 * @brief 录制前期剔除：视锥内且上一帧可见的实例写入前期的间接绘制参数
+	 */
+	void CullEarly(wgpu::CommandEncoder& encoder, const glm::mat4x4& projectionMatrix, const glm::mat4x4& viewMatrix, float cameraNear);
+
+	/**
+	 * @brief 由前期绘制的深度生成 Hi-Z 金字塔，尺寸变化时重建
+	 * @param depthView 深度缓冲区（需要 TextureBinding 用途）
+	 */
+	void BuildPyramid(wgpu::CommandEncoder& encoder, wgpu::TextureView depthView, uint32_t width, uint32_t height);
+
+	/**
+	 * @brief 录制后期剔除：测试 Hi-Z，更新可见性，写入补画的间接绘制参数
+	 */
+	void CullLate(wgpu::CommandEncoder& encoder);
+
+	/**
+	 * @brief 间接绘制某个实例在前期或后期的剔除结果
+	 */
+	void Draw(wgpu::RenderPassEncoder& renderPass, uint32_t instance, bool late);
+
+	/**
+	 * @brief 前期或后期的间接绘制参数缓冲区，以及某个实例的参数偏移（交给渲染队列时使用）
+	 */
+	wgpu::Buffer GetDrawArgsBuffer(bool late) const { return drawArgsBuffers[late ? 1 : 0]; }
+	uint64_t GetDrawArgsOffset(uint32_t instance) const { return instance * 5 * sizeof(uint32_t); }
+
+	/**
+	 * @brief 本帧参与剔除的实例数
+	 */
+	uint32_t GetInstanceCount() const { return instanceCount; }
+
+	/**
+	 * @brief 提交后调用，映射统计数据的回读缓冲区
+	 */
+	void OnSubmitted();
+
+	/**
+	 * @brief 自上次调用以来每帧的 writeBuffer 次数，读取后清零
+	 */
+	uint32_t TakeUploadCount() { return std::exchange(uploadCount, 0u); }
+
+	/**
+	 * @brief 销毁
+	 */
+	void Terminate();
+
+	/**
+	 * @brief 是否已初始化
+	 */
+	bool IsReady() const { return cullKernel.IsReady(); }
+
+private:
+	enum class ReadbackState { Idle, Copied, Mapping, Mapped };
+
+	void CreatePyramid(uint32_t width, uint32_t height);
+	void DestroyPyramid();
+	void CreateCullBindGroups();
+	void DispatchCull(wgpu::CommandEncoder& encoder, uint32_t phase, const char* label);
+
+	wgpu::Device device = nullptr;
+	wgpu::Queue queue = nullptr;
+	uint32_t maxInstances = 0;
+	uint32_t instanceCount = 0;
+	OcclusionCullUniform uniform;
+	// 上一次写入的实例和两个阶段的参数，相机不动时不再上传（剔除仍然每帧执行，结果取决于本帧的深度）
+	BufferWriteCache instanceCache;
+	std::array<BufferWriteCache, 2> uniformCaches;
+	uint32_t uploadCount = 0;
+
+	// 剔除：前期和后期各一个绑定组（uniform 槽位和输出的绘制参数不同）
+	ComputeKernel cullKernel;
+	std::vector<wgpu::BindGroup> cullBindGroups;
+	// 两个阶段的参数，按 256 字节对齐
+	wgpu::Buffer uniformBuffer = nullptr;
+	wgpu::Buffer instanceBuffer = nullptr;
+	// 每个实例在上一帧是否可见
+	wgpu::Buffer visibilityBuffer = nullptr;
+	// 前期与后期的 drawIndexedIndirect 参数，每个实例 5 个 uint32
+	std::vector<wgpu::Buffer> drawArgsBuffers;
+	// 统计：前期绘制数、后期补画数、被遮挡数
+	wgpu::Buffer statsBuffer = nullptr;
+	wgpu::Buffer statsReadbackBuffer = nullptr;
+	ReadbackState statsState = ReadbackState::Idle;
+	std::unique_ptr<wgpu::BufferMapCallback> statsCallback;
+	std::array<uint32_t, 3> lastStats = {};
+
+	// Hi-Z：第 0 级由深度拷贝而来，之后每级取上一级 2x2 的最大值
+	ComputeKernel copyKernel;
+	ComputeKernel reduceKernel;
+	wgpu::Texture pyramid = nullptr;
+	wgpu::TextureView pyramidView = nullptr;
+	std::vector<wgpu::TextureView> pyramidMipViews;
+	// reduceBindGroups[i] 从第 i 级生成第 i + 1 级
+	std::vector<wgpu::BindGroup> reduceBindGroups;
+	// 深度缓冲区来自渲染目标池，视图不变时复用拷贝用的绑定组
+	wgpu::BindGroup copyBindGroup = nullptr;
+	WGPUTextureView copySourceView = nullptr;
+	uint32_t pyramidWidth = 0;
+	uint32_t pyramidHeight = 0;
+	uint32_t pyramidLevels = 0;
+};
+
+}
@@ -0,0 +1,294 @@
+#include "particle-system.h"
+#include "../utils/utils.h"
+
+#include <algorithm>
+#include <numeric>
+
+namespace webgpu {
+
+namespace {
+
+// 与 particles.wgsl 一致
+struct GpuParticle {
+	glm::vec3 position;
+	float age;
+	glm::vec3 velocity;
+	float lifetime;
+};
+
+static_assert(sizeof(GpuParticle) == 32);
+
+constexpr uint32_t kWorkgroupSize = 64;
+constexpr uint64_t kCounterSize = 4 * sizeof(uint32_t);
+constexpr uint64_t kIndirectSize = 12 * sizeof(uint32_t);
+// 发射、模拟的分发参数和绘制参数在间接参数缓冲区中的偏移
+constexpr uint64_t kEmitArgsOffset = 0;
+constexpr uint64_t kSimulateArgsOffset = 3 * sizeof(uint32_t);
+constexpr uint64_t kDrawArgsOffset = 8 * sizeof(uint32_t);
+// 时间步长上限，避免卡顿后一步积分穿过碰撞体
+constexpr float kMaxTimeStep = 1.0f / 30.0f;
+
+}
+
+void ParticleSystem::Initialize(wgpu::Device device, wgpu::Queue queue, const std::filesystem::path& shaderDirectory, uint32_t maxParticles,
+	wgpu::TextureFormat colorFormat, wgpu::TextureFormat depthFormat) {
+	this->device = device;
+	this->queue = queue;
+
+	// 粒子缓冲区要能整个绑定为存储缓冲区
+	wgpu::SupportedLimits limits;
+	device.getLimits(&limits);
+	uint64_t maxBinding = std::min(limits.limits.maxStorageBufferBindingSize, limits.limits.maxBufferSize);
+	this->maxParticles = static_cast<uint32_t>(std::clamp<uint64_t>(maxParticles, 1, maxBinding / sizeof(GpuParticle)));
+
+	LOG("Creating particle pipelines...\n");
+	wgpu::ShaderModule simulationModule = loadShaderModule(shaderDirectory / "particles.wgsl", device);
+	wgpu::ShaderModule renderModule = loadShaderModule(shaderDirectory / "particle-render.wgsl", device);
+	checkNullPointerError(simulationModule, "particle simulation shader");
+	checkNullPointerError(renderModule, "particle render shader");
+
+	// 缓冲区
+	auto createBuffer = [&](const char* label, uint64_t size, auto usage) {
+		wgpu::BufferDescriptor bufferDesc;
+		bufferDesc.label = label;
+		bufferDesc.size = size;
+		bufferDesc.usage = usage;
+		bufferDesc.mappedAtCreation = false;
+		return device.createBuffer(bufferDesc);
+	};
+	uint64_t listSize = static_cast<uint64_t>(this->maxParticles) * sizeof(uint32_t);
+	simulationBuffer = createBuffer("Particle simulation uniforms", sizeof(ParticleSimulationUniform), wgpu::BufferUsage::Uniform | wgpu::BufferUsage::CopyDst);
+	particleBuffer = createBuffer("Particles", static_cast<uint64_t>(this->maxParticles) * sizeof(GpuParticle), wgpu::BufferUsage::Storage);
+	deadListBuffer = createBuffer("Particle dead list", listSize, wgpu::BufferUsage::Storage | wgpu::BufferUsage::CopyDst);
+	aliveListBuffer = createBuffer("Particle alive lists", 2 * listSize, wgpu::BufferUsage::Storage);
+	counterBuffer = createBuffer("Particle counters", kCounterSize, wgpu::BufferUsage::Storage | wgpu::BufferUsage::CopyDst);
+	indirectBuffer = createBuffer("Particle indirect args", kIndirectSize, wgpu::BufferUsage::Storage | wgpu::BufferUsage::Indirect);
+	renderUniformBuffer = createBuffer("Particle render uniforms", sizeof(ParticleRenderUniform), wgpu::BufferUsage::Uniform | wgpu::BufferUsage::CopyDst);
+
+	// 初始所有粒子都在死亡列表中
+	std::vector<uint32_t> deadList(this->maxParticles);
+	std::iota(deadList.begin(), deadList.end(), 0u);
+	queue.writeBuffer(deadListBuffer, 0, deadList.data(), listSize);
+	std::array<uint32_t, 4> counters = { 0, 0, this->maxParticles, 0 };
+	queue.writeBuffer(counterBuffer, 0, counters.data(), kCounterSize);
+
+	// 模拟内核：四个内核共用同一组绑定，发射和模拟不绑定间接参数缓冲区
+	std::vector<ComputeBinding> bindings = {
+		ComputeBinding::Uniform(sizeof(ParticleSimulationUniform)),
+		ComputeBinding::Storage(),
+		ComputeBinding::Storage(),
+		ComputeBinding::Storage(),
+		ComputeBinding::Storage(),
+		ComputeBinding::Storage(),
+	};
+	std::vector<ComputeResource> resources = {
+		ComputeResource::Buffer(simulationBuffer, sizeof(ParticleSimulationUniform)),
+		ComputeResource::Buffer(particleBuffer, static_cast<uint64_t>(this->maxParticles) * sizeof(GpuParticle)),
+		ComputeResource::Buffer(deadListBuffer, listSize),
+		ComputeResource::Buffer(aliveListBuffer, 2 * listSize),
+		ComputeResource::Buffer(counterBuffer, kCounterSize),
+		ComputeResource::Buffer(indirectBuffer, kIndirectSize),
+	};
+	auto initializeKernel = [&](ComputeKernel& kernel, wgpu::BindGroup& bindGroup, const char* label, const char* entryPoint, bool indirectArgs) {
+		ComputeKernelDesc kernelDesc;
+		kernelDesc.label = label;
+		kernelDesc.module = simulationModule;
+		kernelDesc.entryPoint = entryPoint;
+		kernelDesc.bindings.assign(bindings.begin(), bindings.end() - (indirectArgs ? 0 : 1));
+		kernelDesc.workgroupSize = glm::uvec3(indirectArgs ? 1u : kWorkgroupSize, 1u, 1u);
+		kernel.Initialize(device, kernelDesc);
+		bindGroup = kernel.CreateBindGroup(std::span<const ComputeResource>(resources.data(), kernelDesc.bindings.size()));
+	};
+	initializeKernel(beginKernel, beginBindGroup, "Particle begin pipeline", "cs_begin", true);
+	initializeKernel(emitKernel, emitBindGroup, "Particle emit pipeline", "cs_emit", false);
+	initializeKernel(simulateKernel, simulateBindGroup, "Particle simulate pipeline", "cs_simulate", false);
+	initializeKernel(finishKernel, finishBindGroup, "Particle finish pipeline", "cs_finish", true);
+
+	// 绘制管线的绑定布局：参数、粒子、存活列表
+	std::vector<wgpu::BindGroupLayoutEntry> layoutEntries(3, wgpu::Default);
+	layoutEntries[0].binding = 0;
+	layoutEntries[0].visibility = wgpu::ShaderStage::Vertex;
+	layoutEntries[0].buffer.type = wgpu::BufferBindingType::Uniform;
+	layoutEntries[0].buffer.minBindingSize = sizeof(ParticleRenderUniform);
+	for (uint32_t binding = 1; binding < 3; ++binding) {
+		layoutEntries[binding].binding = binding;
+		layoutEntries[binding].visibility = wgpu::ShaderStage::Vertex;
+		layoutEntries[binding].buffer.type = wgpu::BufferBindingType::ReadOnlyStorage;
+	}
+	wgpu::BindGroupLayoutDescriptor bindGroupLayoutDesc{};
+	bindGroupLayoutDesc.entryCount = (uint32_t)layoutEntries.size();
+	bindGroupLayoutDesc.entries = layoutEntries.data();
+	renderBindGroupLayout = device.createBindGroupLayout(bindGroupLayoutDesc);
+
+	wgpu::PipelineLayoutDescriptor layoutDesc{};
+	layoutDesc.bindGroupLayoutCount = 1;
+	layoutDesc.bindGroupLayouts = (WGPUBindGroupLayout*)&renderBindGroupLayout;
+	wgpu::PipelineLayout layout = device.createPipelineLayout(layoutDesc);
+
+	// 预乘颜色叠加混合，目标的 alpha 不变
+	wgpu::BlendState blendState{};
+	blendState.color.srcFactor = wgpu::BlendFactor::One;
+	blendState.color.dstFactor = wgpu::BlendFactor::One;
+	blendState.color.operation = wgpu::BlendOperation::Add;
+	blendState.alpha.srcFactor = wgpu::BlendFactor::Zero;
+	blendState.alpha.dstFactor = wgpu::BlendFactor::One;
+	blendState.alpha.operation = wgpu::BlendOperation::Add;
+	wgpu::ColorTargetState colorTarget;
+	colorTarget.format = colorFormat;
+	colorTarget.blend = &blendState;
+	colorTarget.writeMask = wgpu::ColorWriteMask::All;
+
+	wgpu::FragmentState fragmentState;
+	fragmentState.module = renderModule;
+	fragmentState.entryPoint = "fs_main";
+	fragmentState.constantCount = 0;
+	fragmentState.constants = nullptr;
+	fragmentState.targetCount = 1;
+	fragmentState.targets = &colorTarget;
+
+	// 深度只测试不写入，粒子之间不互相遮挡
+	wgpu::DepthStencilState depthStencilState = wgpu::Default;
+	depthStencilState.depthCompare = wgpu::CompareFunction::Less;
+	depthStencilState.depthWriteEnabled = false;
+	depthStencilState.format = depthFormat;
+	depthStencilState.stencilReadMask = 0;
+	depthStencilState.stencilWriteMask = 0;
+
+	// 公告板的顶点由 vertex_index 和 instance_index 生成
+	wgpu::RenderPipelineDescriptor pipelineDesc = {};
+	pipelineDesc.label = "Particle render pipeline";
+	pipelineDesc.layout = layout;
+	pipelineDesc.vertex.module = renderModule;
+	pipelineDesc.vertex.entryPoint = "vs_main";
+	pipelineDesc.vertex.constantCount = 0;
+	pipelineDesc.vertex.constants = nullptr;
+	pipelineDesc.vertex.bufferCount = 0;
+	pipelineDesc.vertex.buffers = nullptr;
+	pipelineDesc.primitive.topology = wgpu::PrimitiveTopology::TriangleList;
+	pipelineDesc.primitive.stripIndexFormat = wgpu::IndexFormat::Undefined;
+	pipelineDesc.primitive.frontFace = wgpu::FrontFace::CCW;
+	pipelineDesc.primitive.cullMode = wgpu::CullMode::None;
+	pipelineDesc.fragment = &fragmentState;
+	pipelineDesc.depthStencil = &depthStencilState;
+	pipelineDesc.multisample.count = 1;
+	pipelineDesc.multisample.mask = ~0u;
+	pipelineDesc.multisample.alphaToCoverageEnabled = false;
+	renderPipeline = device.createRenderPipeline(pipelineDesc);
+	checkNullPointerError(renderPipeline, "particle render pipeline");
+	layout.release();
+
+	std::vector<wgpu::BindGroupEntry> renderBindings(3);
+	renderBindings[0].binding = 0;
+	renderBindings[0].buffer = renderUniformBuffer;
+	renderBindings[0].offset = 0;
+	renderBindings[0].size = sizeof(ParticleRenderUniform);
+	renderBindings[1].binding = 1;
+	renderBindings[1].buffer = particleBuffer;
+	renderBindings[1].offset = 0;
+	renderBindings[1].size = static_cast<uint64_t>(this->maxParticles) * sizeof(GpuParticle);
+	renderBindings[2].binding = 2;
+	renderBindings[2].buffer = aliveListBuffer;
+	renderBindings[2].offset = 0;
+	renderBindings[2].size = 2 * listSize;
+	wgpu::BindGroupDescriptor bindGroupDesc;
+	bindGroupDesc.layout = renderBindGroupLayout;
+	bindGroupDesc.entryCount = (uint32_t)renderBindings.size();
+	bindGroupDesc.entries = renderBindings.data();
+	renderBindGroup = device.createBindGroup(bindGroupDesc);
+
+	simulationModule.release();
+	renderModule.release();
+
+	LOG("Particles: up to %u, %.1f MB of storage\n", this->maxParticles,
+		static_cast<double>(this->maxParticles) * (sizeof(GpuParticle) + 3 * sizeof(uint32_t)) / (1024.0 * 1024.0));
+}
+
+void ParticleSystem::ClearColliders() {
+	simulation.colliders = glm::uvec4(0u);
+}
+
+void ParticleSystem::AddPlane(const glm::vec3& normal, float offset) {
+	if (simulation.colliders.x < kMaxPlanes) {
+		glm::vec3 n = glm::normalize(normal);
+		simulation.planes[simulation.colliders.x++] = glm::vec4(n, offset);
+	}
+}
+
+void ParticleSystem::AddSphere(const glm::vec3& center, float radius) {
+	if (simulation.colliders.y < kMaxSpheres) {
+		simulation.spheres[simulation.colliders.y++] = glm::vec4(center, radius);
+	}
+}
+
+void ParticleSystem::Simulate(wgpu::CommandEncoder& encoder, float time) {
+	// 时间步长为 0 时粒子不动也不发射，上一次模拟的存活列表和绘制参数仍然有效
+	if (lastTime >= 0.0f && time == lastTime) {
+		return;
+	}
+	float dt = lastTime < 0.0f ? 0.0f : std::clamp(time - lastTime, 0.0f, kMaxTimeStep);
+	lastTime = time;
+
+	// 不指定发射速率时，按平均寿命发射，稳定后粒子池保持满
+	float averageLifetime = std::max(0.5f * (emitter.minLifetime + emitter.maxLifetime), 1e-3f);
+	float rate = emitter.rate > 0.0f ? emitter.rate : static_cast<float>(maxParticles) / averageLifetime;
+	emitAccumulator = std::min(emitAccumulator + rate * dt, static_cast<float>(maxParticles));
+	uint32_t emitCount = static_cast<uint32_t>(emitAccumulator);
+	emitAccumulator -= static_cast<float>(emitCount);
+
+	simulation.emitterPosition = glm::vec4(emitter.position, std::cos(emitter.spreadAngle));
+	simulation.emitterDirection = glm::vec4(emitter.direction, emitter.speed);
+	simulation.gravity = glm::vec4(emitter.gravity, dt);
+	simulation.lifetime = glm::vec4(emitter.minLifetime, emitter.maxLifetime, emitter.drag, emitter.restitution);
+	simulation.params = glm::uvec4(maxParticles, emitCount, frameIndex++, inputList);
+	queue.writeBuffer(simulationBuffer, 0, &simulation, sizeof(ParticleSimulationUniform));
+	++uploadCount;
+
+	// 每次分发之间由计算通道自动同步，发射和模拟的线程数在上一次分发中才确定
+	ComputePass computePass(encoder, "Particle simulation pass");
+	computePass.Dispatch(beginKernel, beginBindGroup, 1);
+	computePass.DispatchIndirect(emitKernel, emitBindGroup, indirectBuffer, kEmitArgsOffset);
+	computePass.DispatchIndirect(simulateKernel, simulateBindGroup, indirectBuffer, kSimulateArgsOffset);
+	computePass.Dispatch(finishKernel, finishBindGroup, 1);
+	inputList = 1 - inputList;
+}
+
+void ParticleSystem::Draw(wgpu::RenderPassEncoder& renderPass, const glm::mat4x4& projectionMatrix, const glm::mat4x4& viewMatrix) {
+	glm::mat4x4 invView = glm::inverse(viewMatrix);
+	ParticleRenderUniform render;
+	render.viewProjection = projectionMatrix * viewMatrix;
+	render.cameraRight = glm::vec4(glm::normalize(glm::vec3(invView[0])), emitter.size);
+	render.cameraUp = glm::vec4(glm::normalize(glm::vec3(invView[1])), 0.0f);
+	render.color = emitter.color;
+	// 模拟之后输入列表已经交换，本帧的输出列表就是下一帧的输入列表
+	render.params = glm::uvec4(inputList * maxParticles, 0u, 0u, 0u);
+	uploadCount += renderUniformCache.Write(queue, renderUniformBuffer, 0, &render, sizeof(ParticleRenderUniform));
+
+	renderPass.setPipeline(renderPipeline);
+	renderPass.setBindGroup(0, renderBindGroup, 0, nullptr);
+	renderPass.drawIndirect(indirectBuffer, kDrawArgsOffset);
+}
+
+void ParticleSystem::Terminate() {
+	if (!renderPipeline) {
+		return;
+	}
+	for (wgpu::BindGroup* bindGroup : { &beginBindGroup, &emitBindGroup, &simulateBindGroup, &finishBindGroup, &renderBindGroup }) {
+		bindGroup->release();
+		*bindGroup = nullptr;
+	}
+	for (ComputeKernel* kernel : { &beginKernel, &emitKernel, &simulateKernel, &finishKernel }) {
+		kernel->Terminate();
+	}
+	for (wgpu::Buffer* buffer : { &simulationBuffer, &particleBuffer, &deadListBuffer, &aliveListBuffer, &counterBuffer, &indirectBuffer, &renderUniformBuffer }) {
+		buffer->destroy();
+		buffer->release();
+		*buffer = nullptr;
+	}
+	renderBindGroupLayout.release();
+	renderBindGroupLayout = nullptr;
+	renderPipeline.release();
+	renderPipeline = nullptr;
+	renderUniformCache.Reset();
+}
+
+}
@@ -0,0 +1,159 @@
+#pragma once
+
+#include "../utils/global.h"
+#include "compute.h"
+#include "uniform-buffer.h"
+
+namespace webgpu {
+
+/**
+ * 粒子发射器
+ */
+struct ParticleEmitter {
+	glm::vec3 position = glm::vec3(0.0f);
+	glm::vec3 direction = glm::vec3(0.0f, 0.0f, 1.0f);
+	// 发射锥的半角（弧度）
+	float spreadAngle = 0.3f;
+	float speed = 1.0f;
+	float minLifetime = 1.0f;
+	float maxLifetime = 2.0f;
+	// 每秒发射数，0 表示按平均寿命保持粒子池满
+	float rate = 0.0f;
+	glm::vec3 gravity = glm::vec3(0.0f, 0.0f, -9.8f);
+	// 空气阻力（每秒损失的速度比例）
+	float drag = 0.1f;
+	// 碰撞的弹性系数
+	float restitution = 0.4f;
+	// 公告板的半径与颜色（叠加混合）
+	float size = 0.005f;
+	glm::vec4 color = glm::vec4(1.0f, 0.6f, 0.2f, 0.6f);
+};
+
+/**
+ * 粒子模拟参数，布局与 particles.wgsl 中的 SimulationUniforms 一致
+ */
+struct ParticleSimulationUniform {
+	glm::vec4 emitterPosition = glm::vec4(0.0f);
+	glm::vec4 emitterDirection = glm::vec4(0.0f);
+	glm::vec4 gravity = glm::vec4(0.0f);
+	glm::vec4 lifetime = glm::vec4(0.0f);
+	std::array<glm::vec4, 4> planes = {};
+	std::array<glm::vec4, 4> spheres = {};
+	glm::uvec4 params = glm::uvec4(0u);
+	glm::uvec4 colliders = glm::uvec4(0u);
+};
+
+static_assert(sizeof(ParticleSimulationUniform) % 16 == 0);
+
+/**
+ * 粒子绘制参数，布局与 particle-render.wgsl 中的 RenderUniforms 一致
+ */
+struct ParticleRenderUniform {
+	glm::mat4x4 viewProjection = glm::mat4x4(1.0f);
+	glm::vec4 cameraRight = glm::vec4(0.0f);
+	glm::vec4 cameraUp = glm::vec4(0.0f);
+	glm::vec4 color = glm::vec4(0.0f);
+	glm::uvec4 params = glm::uvec4(0u);
+};
+
+static_assert(sizeof(ParticleRenderUniform) % 16 == 0);
+
+/**
+ * GPU 粒子系统：粒子状态、死亡列表和存活列表只存在于存储缓冲区
+ * 每帧在一个计算通道中依次发射、积分、碰撞（平面和球体 SDF）、回收寿命结束的粒子，
+ * 存活粒子数直接写入间接绘制参数，以实例化的公告板绘制，全程不回读到 CPU。
+ */
+class ParticleSystem {
+public:
+	static constexpr uint32_t kMaxPlanes = 4;
+	static constexpr uint32_t kMaxSpheres = 4;
+
+	/**
+	 * @brief 创建缓冲区和管线，所有粒子初始都在死亡列表中
+	 * @param shaderDirectory particles.wgsl 与 particle-render.wgsl 所在目录
+	 * @param maxParticles 粒子数上限（按设备的存储缓冲区大小限制截断）
+	 */
+	void Initialize(wgpu::Device device, wgpu::Queue queue, const std::filesystem::path& shaderDirectory, uint32_t maxParticles,
+		wgpu::TextureFormat colorFormat, wgpu::TextureFormat depthFormat);
+
+	void SetEmitter(const ParticleEmitter& emitter) { this->emitter = emitter; }
+
+	/**
+	 * @brief 碰撞体：平面 dot(n, p) + d = 0（法向指向允许的一侧），球体（粒子不能进入），超过上限的忽略
+	 */
+	void ClearColliders();
+	void AddPlane(const glm::vec3& normal, float offset);
+	void AddSphere(const glm::vec3& center, float radius);
+
+	/**
+	 * @brief 录制本帧的模拟，time 为当前时间（秒），两帧的间隔作为时间步长
+	 * 时间没有前进（动画暂停）时不模拟也不上传，粒子保持上一帧的状态
+	 */
+	void Simulate(wgpu::CommandEncoder& encoder, float time);
+
+	/**
+	 * @brief 间接绘制本帧存活的粒子
+	 */
+	void Draw(wgpu::RenderPassEncoder& renderPass, const glm::mat4x4& projectionMatrix, const glm::mat4x4& viewMatrix);
+
+	uint32_t GetMaxParticles() const { return maxParticles; }
+
+	/**
+	 * @brief 自上次调用以来每帧的 writeBuffer 次数，读取后清零
+	 */
+	uint32_t TakeUploadCount() { return std::exchange(uploadCount, 0u); }
+
+	/**
+	 * @brief 销毁
+	 */
+	void Terminate();
+
+	/**
+	 * @brief 是否已初始化
+	 */
+	bool IsReady() const { return renderPipeline != nullptr; }
+
+private:
+	wgpu::Device device = nullptr;
+	wgpu::Queue queue = nullptr;
+	uint32_t maxParticles = 0;
+	ParticleEmitter emitter;
+	ParticleSimulationUniform simulation;
+
+	// 输入存活列表的编号，每帧交换
+	uint32_t inputList = 0;
+	uint32_t frameIndex = 0;
+	float lastTime = -1.0f;
+	// 不足一个的发射数累积到下一帧
+	float emitAccumulator = 0.0f;
+	// 上一次写入的绘制参数，相机不动时不再上传
+	BufferWriteCache renderUniformCache;
+	uint32_t uploadCount = 0;
+
+	ComputeKernel beginKernel;
+	ComputeKernel emitKernel;
+	ComputeKernel simulateKernel;
+	ComputeKernel finishKernel;
+	// cs_begin/cs_finish 写间接参数；发射和模拟以间接参数分发，它们的绑定组不能包含间接参数缓冲区
+	wgpu::BindGroup beginBindGroup = nullptr;
+	wgpu::BindGroup emitBindGroup = nullptr;
+	wgpu::BindGroup simulateBindGroup = nullptr;
+	wgpu::BindGroup finishBindGroup = nullptr;
+
+	wgpu::Buffer simulationBuffer = nullptr;
+	wgpu::Buffer particleBuffer = nullptr;
+	wgpu::Buffer deadListBuffer = nullptr;
+	// 两个存活列表首尾相接
+	wgpu::Buffer aliveListBuffer = nullptr;
+	// 两个存活列表的长度、死亡粒子数、本帧发射数
+	wgpu::Buffer counterBuffer = nullptr;
+	// 发射与模拟的分发参数、drawIndirect 参数
+	wgpu::Buffer indirectBuffer = nullptr;
+
+	wgpu::RenderPipeline renderPipeline = nullptr;
+	wgpu::BindGroupLayout renderBindGroupLayout = nullptr;
+	wgpu::BindGroup renderBindGroup = nullptr;
+	wgpu::Buffer renderUniformBuffer = nullptr;
+};
+
+}
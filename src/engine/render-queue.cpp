@@ -0,0 +1,219 @@
+#include "render-queue.h"
+#include "../utils/radix-sort.h"
+
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <random>
+
+namespace webgpu {
+
+namespace {
+
+constexpr uint64_t kDepthMax = (1ull << kSortKeyDepthBits) - 1;
+
+uint64_t quantizeDepth(float depth) {
+	return static_cast<uint64_t>(std::clamp(depth, 0.0f, 1.0f) * static_cast<float>(kDepthMax) + 0.5f);
+}
+
+uint32_t checkedId(size_t size, uint32_t bits, const char* kind) {
+	if (size >= (1ull << bits)) {
+		LOG("Render queue: too many %s (limit %u)\n", kind, 1u << bits);
+		throw std::runtime_error(std::string("Render queue: too many ") + kind);
+	}
+	return static_cast<uint32_t>(size);
+}
+
+}
+
+uint64_t makeRenderSortKey(RenderLayer layer, uint32_t pipeline, uint32_t bindGroup, uint32_t geometry, float depth) {
+	assert(pipeline < (1u << kSortKeyPipelineBits) && bindGroup < (1u << kSortKeyBindGroupBits) && geometry < (1u << kSortKeyGeometryBits));
+	uint64_t key = static_cast<uint64_t>(layer) << 56;
+	// 管线、绑定组、几何拼在一起，共 28 位
+	uint64_t state = (static_cast<uint64_t>(pipeline) << (kSortKeyBindGroupBits + kSortKeyGeometryBits))
+		| (static_cast<uint64_t>(bindGroup) << kSortKeyGeometryBits)
+		| geometry;
+	uint64_t quantized = quantizeDepth(depth);
+	if (layer == RenderLayer::Transparent) {
+		// 远的在前
+		key |= (kDepthMax - quantized) << 32;
+		key |= state << 4;
+	} else {
+		key |= state << 28;
+		key |= quantized << 4;
+	}
+	return key;
+}
+
+RenderQueueStats countRenderStateChanges(std::span<const RenderDraw> draws, std::span<const uint32_t> order) {
+	RenderQueueStats result;
+	const RenderDraw* previous = nullptr;
+	for (size_t i = 0; i < draws.size(); ++i) {
+		const RenderDraw& draw = draws[order.empty() ? i : order[i]];
+		result.pipelineChanges += !previous || previous->pipeline != draw.pipeline;
+		result.bindGroupChanges += !previous || previous->bindGroup != draw.bindGroup;
+		result.geometryChanges += !previous || previous->geometry != draw.geometry;
+		previous = &draw;
+	}
+	result.drawCount = static_cast<uint32_t>(draws.size());
+	return result;
+}
+
+uint32_t RenderQueue::RegisterPipeline(wgpu::RenderPipeline pipeline) {
+	uint32_t id = checkedId(pipelines.size(), kSortKeyPipelineBits, "pipelines");
+	pipelines.push_back(pipeline);
+	return id;
+}
+
+uint32_t RenderQueue::RegisterBindGroup(wgpu::BindGroup bindGroup) {
+	uint32_t id = checkedId(bindGroups.size(), kSortKeyBindGroupBits, "bind groups");
+	bindGroups.push_back(bindGroup);
+	return id;
+}
+
+uint32_t RenderQueue::RegisterGeometry(wgpu::Buffer vertexBuffer, uint64_t vertexBufferSize, wgpu::Buffer indexBuffer, uint64_t indexBufferSize) {
+	uint32_t id = checkedId(geometries.size(), kSortKeyGeometryBits, "geometries");
+	Geometry geometry;
+	geometry.vertexBuffer = vertexBuffer;
+	geometry.vertexBufferSize = vertexBufferSize;
+	geometry.indexBuffer = indexBuffer;
+	geometry.indexBufferSize = indexBufferSize;
+	geometries.push_back(geometry);
+	return id;
+}
+
+void RenderQueue::Clear() {
+	draws.clear();
+	keys.clear();
+	order.clear();
+}
+
+void RenderQueue::Add(RenderLayer layer, float depth, const RenderDraw& draw) {
+	keys.push_back(makeRenderSortKey(layer, draw.pipeline, draw.bindGroup, draw.geometry, depth));
+	order.push_back(static_cast<uint32_t>(draws.size()));
+	draws.push_back(draw);
+}
+
+void RenderQueue::Sort() {
+	if (keyScratch.size() < keys.size()) {
+		keyScratch.resize(keys.size());
+		orderScratch.resize(keys.size());
+	}
+	radixSort(keys, order, keyScratch, orderScratch);
+}
+
+void RenderQueue::Submit(wgpu::RenderPassEncoder& renderPass) {
+	stats = {};
+	stats.drawCount = static_cast<uint32_t>(draws.size());
+	uint32_t currentPipeline = UINT32_MAX;
+	uint32_t currentBindGroup = UINT32_MAX;
+	uint32_t currentGeometry = UINT32_MAX;
+	for (uint32_t index : order) {
+		const RenderDraw& draw = draws[index];
+		if (draw.pipeline != currentPipeline) {
+			renderPass.setPipeline(pipelines[draw.pipeline]);
+			currentPipeline = draw.pipeline;
+			++stats.pipelineChanges;
+		}
+		if (draw.bindGroup != currentBindGroup) {
+			renderPass.setBindGroup(0, bindGroups[draw.bindGroup], 0, nullptr);
+			currentBindGroup = draw.bindGroup;
+			++stats.bindGroupChanges;
+		}
+		if (draw.geometry != currentGeometry) {
+			const Geometry& geometry = geometries[draw.geometry];
+			renderPass.setVertexBuffer(0, geometry.vertexBuffer, 0, geometry.vertexBufferSize);
+			renderPass.setIndexBuffer(geometry.indexBuffer, wgpu::IndexFormat::Uint32, 0, geometry.indexBufferSize);
+			currentGeometry = draw.geometry;
+			++stats.geometryChanges;
+		}
+		if (draw.indirectBuffer) {
+			renderPass.drawIndexedIndirect(wgpu::Buffer(draw.indirectBuffer), draw.indirectOffset);
+		} else {
+			renderPass.drawIndexed(draw.indexCount, 1, draw.firstIndex, 0, draw.firstInstance);
+		}
+	}
+}
+
+void RenderQueue::Reset() {
+	Clear();
+	pipelines.clear();
+	bindGroups.clear();
+	geometries.clear();
+}
+
+void reportRenderQueueBenchmark(uint32_t drawCount, uint32_t frameCount) {
+	// 模拟的场景：32 个管线、1024 个材质、64 个网格，约 1/8 的绘制是透明的
+	constexpr uint32_t kPipelines = 32;
+	constexpr uint32_t kMaterials = 1024;
+	constexpr uint32_t kGeometries = 64;
+	std::mt19937 random(42);
+	std::vector<RenderDraw> draws(drawCount);
+	std::vector<RenderLayer> layers(drawCount);
+	std::vector<float> depths(drawCount);
+	for (uint32_t i = 0; i < drawCount; ++i) {
+		draws[i].pipeline = random() % kPipelines;
+		draws[i].bindGroup = random() % kMaterials;
+		draws[i].geometry = random() % kGeometries;
+		layers[i] = random() % 8 == 0 ? RenderLayer::Transparent : RenderLayer::Opaque;
+		depths[i] = std::uniform_real_distribution<float>(0.0f, 1.0f)(random);
+	}
+
+	std::vector<uint64_t> keys(drawCount);
+	std::vector<uint32_t> order(drawCount);
+	std::vector<uint64_t> keyScratch(drawCount);
+	std::vector<uint32_t> orderScratch(drawCount);
+	std::vector<std::pair<uint64_t, uint32_t>> pairs(drawCount);
+	std::uniform_real_distribution<float> jitter(-0.01f, 0.01f);
+	using Clock = std::chrono::steady_clock;
+	double buildSeconds = 0.0;
+	double radixSeconds = 0.0;
+	double stdSortSeconds = 0.0;
+	bool consistent = true;
+	for (uint32_t frame = 0; frame < frameCount; ++frame) {
+		// 物体和相机在动，深度每帧都变
+		for (float& depth : depths) {
+			depth = std::clamp(depth + jitter(random), 0.0f, 1.0f);
+		}
+
+		auto start = Clock::now();
+		for (uint32_t i = 0; i < drawCount; ++i) {
+			keys[i] = makeRenderSortKey(layers[i], draws[i].pipeline, draws[i].bindGroup, draws[i].geometry, depths[i]);
+			order[i] = i;
+		}
+		auto built = Clock::now();
+		for (uint32_t i = 0; i < drawCount; ++i) {
+			pairs[i] = { keys[i], i };
+		}
+		auto radixStart = Clock::now();
+		radixSort(keys, order, keyScratch, orderScratch);
+		auto radixSorted = Clock::now();
+
+		auto stdStart = Clock::now();
+		std::stable_sort(pairs.begin(), pairs.end(), [](const auto& a, const auto& b) { return a.first < b.first; });
+		auto stdSorted = Clock::now();
+
+		buildSeconds += std::chrono::duration<double>(built - start).count();
+		radixSeconds += std::chrono::duration<double>(radixSorted - radixStart).count();
+		stdSortSeconds += std::chrono::duration<double>(stdSorted - stdStart).count();
+		for (uint32_t i = 0; i < drawCount && consistent; ++i) {
+			consistent = pairs[i].second == order[i];
+		}
+	}
+
+	RenderQueueStats unsorted = countRenderStateChanges(draws);
+	RenderQueueStats sorted = countRenderStateChanges(draws, order);
+	double frames = static_cast<double>(std::max(frameCount, 1u));
+	printf("Render queue sort: %u draws, %u frames\n", drawCount, frameCount);
+	printf("%-24s %12s\n", "step", "ms/frame");
+	printf("%-24s %12.3f\n", "pack keys", buildSeconds * 1000.0 / frames);
+	printf("%-24s %12.3f\n", "radix sort", radixSeconds * 1000.0 / frames);
+	printf("%-24s %12.3f\n", "std::stable_sort", stdSortSeconds * 1000.0 / frames);
+	printf("%-24s %12s\n", "same order", consistent ? "yes" : "NO");
+	printf("%-24s %12s %12s\n", "state changes", "submitted", "sorted");
+	printf("%-24s %12u %12u\n", "setPipeline", unsorted.pipelineChanges, sorted.pipelineChanges);
+	printf("%-24s %12u %12u\n", "setBindGroup", unsorted.bindGroupChanges, sorted.bindGroupChanges);
+	printf("%-24s %12u %12u\n", "vertex/index buffers", unsorted.geometryChanges, sorted.geometryChanges);
+}
+
+}
@@ -0,0 +1,134 @@
+#pragma once
+
+#include "../utils/global.h"
+
+namespace webgpu {
+
+/**
+ * 同一渲染通道内的分组，排序键的最高 8 位，不透明物体先于透明物体绘制
+ */
+enum class RenderLayer : uint8_t {
+	Opaque = 0,
+	Transparent = 1,
+};
+
+// 排序键各字段的位数
+constexpr uint32_t kSortKeyPipelineBits = 8;
+constexpr uint32_t kSortKeyBindGroupBits = 12;
+constexpr uint32_t kSortKeyGeometryBits = 8;
+constexpr uint32_t kSortKeyDepthBits = 24;
+
+/**
+ * @brief 打包 64 位排序键
+ * 不透明：层 | 管线 | 绑定组 | 几何 | 深度（从前到后），先按状态分组以减少切换，同状态内由近到远以利用 early-Z；
+ * 透明：层 | 反转的深度（从后到前） | 管线 | 绑定组 | 几何，混合的正确性优先于状态切换
+ * @param depth 归一化到 [0, 1] 的视图空间深度，超出范围时截断
+ */
+uint64_t makeRenderSortKey(RenderLayer layer, uint32_t pipeline, uint32_t bindGroup, uint32_t geometry, float depth);
+
+/**
+ * 一次绘制，管线、绑定组和几何是在渲染队列中注册时得到的编号
+ */
+struct RenderDraw {
+	uint32_t pipeline = 0;
+	uint32_t bindGroup = 0;
+	uint32_t geometry = 0;
+	uint32_t indexCount = 0;
+	uint32_t firstIndex = 0;
+	uint32_t firstInstance = 0;
+	// 不为空时改为 drawIndexedIndirect，参数从这里读取
+	WGPUBuffer indirectBuffer = nullptr;
+	uint64_t indirectOffset = 0;
+};
+
+/**
+ * 一次提交中的状态切换统计
+ */
+struct RenderQueueStats {
+	uint32_t drawCount = 0;
+	uint32_t pipelineChanges = 0;
+	uint32_t bindGroupChanges = 0;
+	uint32_t geometryChanges = 0;
+
+	bool operator==(const RenderQueueStats&) const = default;
+};
+
+/**
+ * @brief 按提交顺序统计状态切换次数（与 RenderQueue::Submit 的判断一致）
+ * @param order 绘制顺序，为空时按 draws 的原始顺序
+ */
+RenderQueueStats countRenderStateChanges(std::span<const RenderDraw> draws, std::span<const uint32_t> order = {});
+
+/**
+ * 渲染队列
+ * 每次绘制打包成一个 64 位排序键，基数排序后按顺序提交，
+ * 只有管线、绑定组或顶点/索引缓冲区真正变化时才调用 setPipeline/setBindGroup/setVertexBuffer/setIndexBuffer。
+ * 内部容器在 Clear 时保留容量，稳定后每帧不再分配内存。
+ */
+class RenderQueue {
+public:
+	/**
+	 * @brief 注册管线/绑定组/几何（顶点缓冲区 + 32 位索引缓冲区），返回在排序键中使用的编号
+	 */
+	uint32_t RegisterPipeline(wgpu::RenderPipeline pipeline);
+	uint32_t RegisterBindGroup(wgpu::BindGroup bindGroup);
+	uint32_t RegisterGeometry(wgpu::Buffer vertexBuffer, uint64_t vertexBufferSize, wgpu::Buffer indexBuffer, uint64_t indexBufferSize);
+
+	/**
+	 * @brief 清空本次的绘制（注册的状态保留）
+	 */
+	void Clear();
+
+	/**
+	 * @brief 加入一次绘制
+	 * @param depth 归一化到 [0, 1] 的视图空间深度
+	 */
+	void Add(RenderLayer layer, float depth, const RenderDraw& draw);
+
+	/**
+	 * @brief 按排序键排序
+	 */
+	void Sort();
+
+	/**
+	 * @brief 按排序后的顺序录制绘制命令，跳过多余的状态设置
+	 */
+	void Submit(wgpu::RenderPassEncoder& renderPass);
+
+	/**
+	 * @brief 上一次 Submit 的统计
+	 */
+	const RenderQueueStats& GetStats() const { return stats; }
+
+	/**
+	 * @brief 清空注册的状态和绘制
+	 */
+	void Reset();
+
+private:
+	struct Geometry {
+		wgpu::Buffer vertexBuffer = nullptr;
+		uint64_t vertexBufferSize = 0;
+		wgpu::Buffer indexBuffer = nullptr;
+		uint64_t indexBufferSize = 0;
+	};
+
+	std::vector<wgpu::RenderPipeline> pipelines;
+	std::vector<wgpu::BindGroup> bindGroups;
+	std::vector<Geometry> geometries;
+	std::vector<RenderDraw> draws;
+	// 排序键与对应的绘制编号，以及基数排序的临时空间
+	std::vector<uint64_t> keys;
+	std::vector<uint32_t> order;
+	std::vector<uint64_t> keyScratch;
+	std::vector<uint32_t> orderScratch;
+	RenderQueueStats stats;
+};
+
+/**
+ * @brief 排序基准测试：每帧随机移动 drawCount 个绘制的深度，重新打包并排序，
+ * 输出基数排序与 std::sort 的耗时，以及排序前后的状态切换次数，不创建窗口
+ */
+void reportRenderQueueBenchmark(uint32_t drawCount, uint32_t frameCount = 100);
+
+}
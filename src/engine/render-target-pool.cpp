@@ -0,0 +1,156 @@
+#include "render-target-pool.h"
+
+#include <algorithm>
+
+namespace webgpu {
+
+namespace {
+
+uint32_t bytesPerPixel(wgpu::TextureFormat format) {
+	switch (format) {
+	case wgpu::TextureFormat::R8Unorm:
+		return 1;
+	case wgpu::TextureFormat::RG8Unorm:
+	case wgpu::TextureFormat::R16Float:
+	case wgpu::TextureFormat::Depth16Unorm:
+		return 2;
+	case wgpu::TextureFormat::RGBA16Float:
+	case wgpu::TextureFormat::RG32Float:
+		return 8;
+	case wgpu::TextureFormat::RGBA32Float:
+		return 16;
+	case wgpu::TextureFormat::Depth32FloatStencil8:
+		return 5;
+	default:
+		// RGBA8、BGRA8、R32Float、Depth24Plus、Depth32Float 等
+		return 4;
+	}
+}
+
+}
+
+uint64_t renderTargetByteSize(const RenderTargetDesc& desc) {
+	uint64_t bytes = 0;
+	for (uint32_t level = 0; level < desc.mipLevelCount; ++level) {
+		bytes += static_cast<uint64_t>(std::max(1u, desc.width >> level)) * std::max(1u, desc.height >> level);
+	}
+	return bytes * bytesPerPixel(desc.format) * desc.sampleCount;
+}
+
+void RenderTargetPool::Initialize(wgpu::Device device, uint32_t maxIdleFrames) {
+	this->device = device;
+	this->maxIdleFrames = maxIdleFrames;
+}
+
+RenderTarget RenderTargetPool::Acquire(const RenderTargetDesc& desc, const char* label) {
+	uint64_t bytes = renderTargetByteSize(desc);
+	frameRequestedBytes += bytes;
+	frameInUseBytes += bytes;
+	framePeakBytes = std::max(framePeakBytes, frameInUseBytes);
+	++frameAcquireCount;
+
+	// 优先完全匹配，其次是用途为超集的纹理
+	Entry* match = nullptr;
+	for (Entry& entry : entries) {
+		if (entry.inUse) {
+			continue;
+		}
+		RenderTargetDesc candidate = entry.desc;
+		candidate.usage = desc.usage;
+		if (!(candidate == desc) || (entry.desc.usage & desc.usage) != desc.usage) {
+			continue;
+		}
+		if (!match || entry.desc.usage == desc.usage) {
+			match = &entry;
+		}
+		if (entry.desc.usage == desc.usage) {
+			break;
+		}
+	}
+	if (match) {
+		match->inUse = true;
+		return match->target;
+	}
+
+	wgpu::TextureDescriptor textureDesc;
+	textureDesc.label = label;
+	textureDesc.dimension = wgpu::TextureDimension::_2D;
+	textureDesc.format = desc.format;
+	textureDesc.mipLevelCount = desc.mipLevelCount;
+	textureDesc.sampleCount = desc.sampleCount;
+	textureDesc.size = { desc.width, desc.height, 1 };
+	textureDesc.usage = desc.usage;
+	textureDesc.viewFormatCount = 0;
+	textureDesc.viewFormats = nullptr;
+
+	Entry entry;
+	entry.desc = desc;
+	entry.target.texture = device.createTexture(textureDesc);
+	checkNullPointerError(entry.target.texture, "render target");
+	wgpu::TextureViewDescriptor viewDesc;
+	viewDesc.aspect = wgpu::TextureAspect::All;
+	viewDesc.baseArrayLayer = 0;
+	viewDesc.arrayLayerCount = 1;
+	viewDesc.baseMipLevel = 0;
+	viewDesc.mipLevelCount = desc.mipLevelCount;
+	viewDesc.dimension = wgpu::TextureViewDimension::_2D;
+	viewDesc.format = desc.format;
+	entry.target.view = entry.target.texture.createView(viewDesc);
+	entry.inUse = true;
+	entries.push_back(entry);
+	++allocationCount;
+	residentBytes += bytes;
+	LOG("Render target pool: new %ux%u target (%zu pooled)\n", desc.width, desc.height, entries.size());
+	return entry.target;
+}
+
+void RenderTargetPool::Release(const RenderTarget& target) {
+	for (Entry& entry : entries) {
+		if (entry.target.texture == target.texture && entry.inUse) {
+			entry.inUse = false;
+			entry.releasedFrame = frameIndex;
+			frameInUseBytes -= std::min(frameInUseBytes, renderTargetByteSize(entry.desc));
+			return;
+		}
+	}
+}
+
+void RenderTargetPool::EndFrame() {
+	// 本帧申请的总量与峰值，两者之差就是复用省下的显存
+	if (frameAcquireCount > 0 && (frameRequestedBytes != lastRequestedBytes || framePeakBytes != lastPeakBytes)) {
+		LOG("Render targets: %u acquires, %.2f MB requested, %.2f MB peak in use, %.2f MB resident\n", frameAcquireCount,
+			frameRequestedBytes / (1024.0 * 1024.0), framePeakBytes / (1024.0 * 1024.0), residentBytes / (1024.0 * 1024.0));
+		lastRequestedBytes = frameRequestedBytes;
+		lastPeakBytes = framePeakBytes;
+	}
+	// 跨帧持有的目标（如深度缓冲区）计入下一帧的使用量
+	frameRequestedBytes = frameInUseBytes;
+	framePeakBytes = frameInUseBytes;
+	frameAcquireCount = 0;
+
+	++frameIndex;
+	auto expired = [this](const Entry& entry) { return !entry.inUse && entry.releasedFrame + maxIdleFrames < frameIndex; };
+	for (Entry& entry : entries) {
+		if (expired(entry)) {
+			Destroy(entry);
+		}
+	}
+	entries.erase(std::remove_if(entries.begin(), entries.end(), [](const Entry& entry) { return !entry.target.texture; }), entries.end());
+}
+
+void RenderTargetPool::Destroy(Entry& entry) {
+	residentBytes -= std::min(residentBytes, renderTargetByteSize(entry.desc));
+	entry.target.view.release();
+	entry.target.texture.destroy();
+	entry.target.texture.release();
+	entry.target = {};
+}
+
+void RenderTargetPool::Terminate() {
+	for (Entry& entry : entries) {
+		Destroy(entry);
+	}
+	entries.clear();
+}
+
+}
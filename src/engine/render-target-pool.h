@@ -0,0 +1,104 @@
+#pragma once
+
+#include "../utils/global.h"
+
+namespace webgpu {
+
+/**
+ * 渲染目标的描述，相同描述的纹理可以互相替换
+ */
+struct RenderTargetDesc {
+	wgpu::TextureFormat format = wgpu::TextureFormat::Undefined;
+	uint32_t width = 0;
+	uint32_t height = 0;
+	WGPUTextureUsageFlags usage = wgpu::TextureUsage::RenderAttachment;
+	uint32_t sampleCount = 1;
+	uint32_t mipLevelCount = 1;
+
+	bool operator==(const RenderTargetDesc& other) const {
+		return format == other.format && width == other.width && height == other.height && usage == other.usage
+			&& sampleCount == other.sampleCount && mipLevelCount == other.mipLevelCount;
+	}
+};
+
+/**
+ * 池中的一个渲染目标，view 为包含全部 mip 的默认视图，由池持有
+ */
+struct RenderTarget {
+	wgpu::Texture texture = nullptr;
+	wgpu::TextureView view = nullptr;
+};
+
+/**
+ * @brief 描述对应纹理的显存大小（字节，含全部 mip 和采样）
+ */
+uint64_t renderTargetByteSize(const RenderTargetDesc& desc);
+
+/**
+ * 渲染目标池
+ * 与窗口尺寸相关的附件（深度缓冲区、后处理的中间结果等）从这里申请，按通道的生命周期使用：
+ * 通道开始前 Acquire，最后一个读取它的通道录制完后 Release。
+ * 同一帧内生命周期不重叠的目标会拿到同一张纹理（WebGPU 没有显式的内存别名，复用纹理对象即共享显存，
+ * 同一队列上的先后读写由 WebGPU 自动同步），用途是申请用途超集的纹理也可以复用。
+ * 归还的纹理不立即销毁，闲置超过 maxIdleFrames 帧后才销毁，拖动窗口边框来回缩放时可以复用之前尺寸的纹理。
+ */
+class RenderTargetPool {
+public:
+	/**
+	 * @param maxIdleFrames 归还后保留的帧数
+	 */
+	void Initialize(wgpu::Device device, uint32_t maxIdleFrames = 120);
+
+	/**
+	 * @brief 取一个匹配描述的空闲纹理，没有时新建
+	 */
+	RenderTarget Acquire(const RenderTargetDesc& desc, const char* label = nullptr);
+
+	/**
+	 * @brief 归还纹理，之后不能再使用它和它的默认视图
+	 */
+	void Release(const RenderTarget& target);
+
+	/**
+	 * @brief 每帧结束时调用，销毁闲置过久的纹理
+	 */
+	void EndFrame();
+
+	/**
+	 * @brief 销毁所有纹理
+	 */
+	void Terminate();
+
+	// 池中纹理数（含使用中的）与累计新建次数
+	size_t GetTextureCount() const { return entries.size(); }
+	uint64_t GetAllocationCount() const { return allocationCount; }
+	// 池中纹理实际占用的显存
+	uint64_t GetResidentBytes() const { return residentBytes; }
+
+private:
+	struct Entry {
+		RenderTargetDesc desc;
+		RenderTarget target;
+		bool inUse = false;
+		uint64_t releasedFrame = 0;
+	};
+
+	void Destroy(Entry& entry);
+
+	wgpu::Device device = nullptr;
+	uint32_t maxIdleFrames = 0;
+	std::vector<Entry> entries;
+	uint64_t frameIndex = 0;
+	uint64_t allocationCount = 0;
+	uint64_t residentBytes = 0;
+	// 本帧各次申请的大小之和（不复用时需要的显存）与同时使用中的峰值
+	uint64_t frameRequestedBytes = 0;
+	uint64_t frameInUseBytes = 0;
+	uint64_t framePeakBytes = 0;
+	uint32_t frameAcquireCount = 0;
+	// 上一次输出的统计，变化时才输出
+	uint64_t lastRequestedBytes = 0;
+	uint64_t lastPeakBytes = 0;
+};
+
+}
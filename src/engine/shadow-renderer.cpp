@@ -0,0 +1,359 @@
+#include "shadow-renderer.h"
+#include "../utils/utils.h"
+
+#include <cmath>
+
+namespace webgpu {
+
+namespace {
+
+const wgpu::TextureFormat kShadowFormat = wgpu::TextureFormat::Depth32Float;
+
+// 级联矩阵在 uniform buffer 中的步长（minUniformBufferOffsetAlignment 的上限）
+constexpr uint64_t kCascadeUniformStride = 256;
+
+// 对数与均匀划分的混合比例
+constexpr float kSplitLambda = 0.75f;
+
+wgpu::TextureView createLayerView(wgpu::Texture texture, uint32_t layer) {
+	wgpu::TextureViewDescriptor viewDesc;
+	viewDesc.aspect = wgpu::TextureAspect::All;
+	viewDesc.baseArrayLayer = layer;
+	viewDesc.arrayLayerCount = 1;
+	viewDesc.baseMipLevel = 0;
+	viewDesc.mipLevelCount = 1;
+	viewDesc.dimension = wgpu::TextureViewDimension::_2D;
+	viewDesc.format = kShadowFormat;
+	return texture.createView(viewDesc);
+}
+
+}
+
+void ShadowRenderer::Initialize(wgpu::Device device, wgpu::Queue queue, const std::filesystem::path& shaderPath,
+	uint64_t vertexStride, wgpu::VertexFormat positionFormat, wgpu::Buffer uniformBuffer,
+	wgpu::Buffer instanceBuffer, uint64_t instanceBufferSize, uint32_t resolution) {
+	this->queue = queue;
+	this->resolution = resolution;
+
+	LOG("Creating shadow pipeline...\n");
+	wgpu::ShaderModule shaderModule = loadShaderModule(shaderPath, device);
+
+	// 绑定布局：全局 uniform、实例、级联矩阵（动态偏移）
+	std::vector<wgpu::BindGroupLayoutEntry> layoutEntries(3, wgpu::Default);
+	layoutEntries[0].binding = 0;
+	layoutEntries[0].visibility = wgpu::ShaderStage::Vertex;
+	layoutEntries[0].buffer.type = wgpu::BufferBindingType::Uniform;
+	layoutEntries[0].buffer.minBindingSize = sizeof(Uniform);
+	layoutEntries[1].binding = 1;
+	layoutEntries[1].visibility = wgpu::ShaderStage::Vertex;
+	layoutEntries[1].buffer.type = wgpu::BufferBindingType::ReadOnlyStorage;
+	layoutEntries[1].buffer.minBindingSize = sizeof(InstanceData);
+	layoutEntries[2].binding = 2;
+	layoutEntries[2].visibility = wgpu::ShaderStage::Vertex;
+	layoutEntries[2].buffer.type = wgpu::BufferBindingType::Uniform;
+	layoutEntries[2].buffer.hasDynamicOffset = true;
+	layoutEntries[2].buffer.minBindingSize = sizeof(glm::mat4x4);
+	wgpu::BindGroupLayoutDescriptor bindGroupLayoutDesc{};
+	bindGroupLayoutDesc.entryCount = (uint32_t)layoutEntries.size();
+	bindGroupLayoutDesc.entries = layoutEntries.data();
+	wgpu::BindGroupLayout bindGroupLayout = device.createBindGroupLayout(bindGroupLayoutDesc);
+
+	wgpu::PipelineLayoutDescriptor layoutDesc{};
+	layoutDesc.bindGroupLayoutCount = 1;
+	layoutDesc.bindGroupLayouts = (WGPUBindGroupLayout*)&bindGroupLayout;
+	wgpu::PipelineLayout layout = device.createPipelineLayout(layoutDesc);
+
+	// 只读取位置属性，步长与主管线的顶点缓冲区相同
+	wgpu::VertexAttribute positionAttrib;
+	positionAttrib.shaderLocation = 0;
+	positionAttrib.format = positionFormat;
+	positionAttrib.offset = 0;
+	wgpu::VertexBufferLayout vertexBufferLayout = {};
+	vertexBufferLayout.attributeCount = 1;
+	vertexBufferLayout.attributes = &positionAttrib;
+	vertexBufferLayout.arrayStride = vertexStride;
+	vertexBufferLayout.stepMode = wgpu::VertexStepMode::Vertex;
+
+	wgpu::RenderPipelineDescriptor pipelineDesc = {};
+	pipelineDesc.layout = layout;
+	pipelineDesc.vertex.module = shaderModule;
+	pipelineDesc.vertex.entryPoint = "vs_main";
+	pipelineDesc.vertex.constantCount = 0;
+	pipelineDesc.vertex.constants = nullptr;
+	pipelineDesc.vertex.bufferCount = 1;
+	pipelineDesc.vertex.buffers = &vertexBufferLayout;
+	pipelineDesc.primitive.topology = wgpu::PrimitiveTopology::TriangleList;
+	pipelineDesc.primitive.stripIndexFormat = wgpu::IndexFormat::Undefined;
+	pipelineDesc.primitive.frontFace = wgpu::FrontFace::CCW;
+	pipelineDesc.primitive.cullMode = wgpu::CullMode::None;
+	// 只写深度，没有片元着色器
+	pipelineDesc.fragment = nullptr;
+
+	// 斜率偏移抑制阴影痤疮
+	wgpu::DepthStencilState depthStencilState = wgpu::Default;
+	depthStencilState.depthCompare = wgpu::CompareFunction::Less;
+	depthStencilState.depthWriteEnabled = true;
+	depthStencilState.format = kShadowFormat;
+	depthStencilState.stencilReadMask = 0;
+	depthStencilState.stencilWriteMask = 0;
+	depthStencilState.depthBias = 2;
+	depthStencilState.depthBiasSlopeScale = 2.0f;
+	depthStencilState.depthBiasClamp = 0.0f;
+	pipelineDesc.depthStencil = &depthStencilState;
+	pipelineDesc.multisample.count = 1;
+	pipelineDesc.multisample.mask = ~0u;
+	pipelineDesc.multisample.alphaToCoverageEnabled = false;
+	pipeline = device.createRenderPipeline(pipelineDesc);
+	checkNullPointerError(pipeline, "shadow pipeline");
+
+	// 缓冲区
+	wgpu::BufferDescriptor bufferDesc;
+	bufferDesc.mappedAtCreation = false;
+	bufferDesc.size = kCascadeUniformStride * kCascadeCount;
+	bufferDesc.usage = wgpu::BufferUsage::CopyDst | wgpu::BufferUsage::Uniform;
+	cascadeUniformBuffer = device.createBuffer(bufferDesc);
+	bufferDesc.size = sizeof(ShadowUniform);
+	shadowUniformBuffer = device.createBuffer(bufferDesc);
+
+	std::vector<wgpu::BindGroupEntry> bindings(3);
+	bindings[0].binding = 0;
+	bindings[0].buffer = uniformBuffer;
+	bindings[0].offset = 0;
+	bindings[0].size = sizeof(Uniform);
+	bindings[1].binding = 1;
+	bindings[1].buffer = instanceBuffer;
+	bindings[1].offset = 0;
+	bindings[1].size = instanceBufferSize;
+	bindings[2].binding = 2;
+	bindings[2].buffer = cascadeUniformBuffer;
+	bindings[2].offset = 0;
+	bindings[2].size = sizeof(glm::mat4x4);
+	wgpu::BindGroupDescriptor bindGroupDesc;
+	bindGroupDesc.layout = bindGroupLayout;
+	bindGroupDesc.entryCount = (uint32_t)bindings.size();
+	bindGroupDesc.entries = bindings.data();
+	bindGroup = device.createBindGroup(bindGroupDesc);
+
+	// 阴影贴图（片元着色器采样）与静态投射物缓存（只作为拷贝源）
+	wgpu::TextureDescriptor textureDesc;
+	textureDesc.dimension = wgpu::TextureDimension::_2D;
+	textureDesc.format = kShadowFormat;
+	textureDesc.mipLevelCount = 1;
+	textureDesc.sampleCount = 1;
+	textureDesc.size = { resolution, resolution, kCascadeCount };
+	textureDesc.viewFormatCount = 0;
+	textureDesc.viewFormats = nullptr;
+	textureDesc.label = "Shadow map";
+	textureDesc.usage = wgpu::TextureUsage::RenderAttachment | wgpu::TextureUsage::TextureBinding | wgpu::TextureUsage::CopyDst;
+	shadowMap = device.createTexture(textureDesc);
+	checkNullPointerError(shadowMap, "shadow map");
+	textureDesc.label = "Static shadow cache";
+	textureDesc.usage = wgpu::TextureUsage::RenderAttachment | wgpu::TextureUsage::CopySrc;
+	staticCache = device.createTexture(textureDesc);
+	checkNullPointerError(staticCache, "static shadow cache");
+
+	wgpu::TextureViewDescriptor viewDesc;
+	viewDesc.aspect = wgpu::TextureAspect::All;
+	viewDesc.baseArrayLayer = 0;
+	viewDesc.arrayLayerCount = kCascadeCount;
+	viewDesc.baseMipLevel = 0;
+	viewDesc.mipLevelCount = 1;
+	viewDesc.dimension = wgpu::TextureViewDimension::_2DArray;
+	viewDesc.format = kShadowFormat;
+	shadowMapView = shadowMap.createView(viewDesc);
+	for (uint32_t cascade = 0; cascade < kCascadeCount; ++cascade) {
+		shadowLayerViews.push_back(createLayerView(shadowMap, cascade));
+		staticLayerViews.push_back(createLayerView(staticCache, cascade));
+	}
+
+	// 比较采样器，配合 textureSampleCompareLevel 做硬件 2x2 PCF
+	wgpu::SamplerDescriptor samplerDesc;
+	samplerDesc.addressModeU = wgpu::AddressMode::ClampToEdge;
+	samplerDesc.addressModeV = wgpu::AddressMode::ClampToEdge;
+	samplerDesc.addressModeW = wgpu::AddressMode::ClampToEdge;
+	samplerDesc.magFilter = wgpu::FilterMode::Linear;
+	samplerDesc.minFilter = wgpu::FilterMode::Linear;
+	samplerDesc.mipmapFilter = wgpu::MipmapFilterMode::Nearest;
+	samplerDesc.lodMinClamp = 0.0f;
+	samplerDesc.lodMaxClamp = 1.0f;
+	samplerDesc.compare = wgpu::CompareFunction::Less;
+	samplerDesc.maxAnisotropy = 1;
+	comparisonSampler = device.createSampler(samplerDesc);
+
+	layout.release();
+	bindGroupLayout.release();
+	shaderModule.release();
+
+	InvalidateStaticCache();
+	LOG("Shadow map: %u cascades of %ux%u\n", kCascadeCount, resolution, resolution);
+}
+
+void ShadowRenderer::Update(const glm::mat4x4& projectionMatrix, const glm::mat4x4& viewMatrix, const glm::vec3& lightDirection,
+	const BoundingSphere& sceneBounds, float cameraNear, float shadowDistance) {
+	glm::mat4x4 inverseProjection = glm::inverse(projectionMatrix);
+	glm::mat4x4 inverseView = glm::inverse(viewMatrix);
+	// NDC 中一点对应的视图空间射线，缩放到深度 1 处
+	auto viewRay = [&](float x, float y) {
+		glm::vec4 p = inverseProjection * glm::vec4(x, y, 0.5f, 1.0f);
+		glm::vec3 v = glm::vec3(p) / p.w;
+		return v / v.z;
+	};
+	const std::array<glm::vec3, 4> rays = { viewRay(-1.0f, -1.0f), viewRay(1.0f, -1.0f), viewRay(-1.0f, 1.0f), viewRay(1.0f, 1.0f) };
+
+	glm::vec3 towardLight = glm::normalize(lightDirection);
+	glm::vec3 up = std::abs(towardLight.y) > 0.99f ? glm::vec3(1.0f, 0.0f, 0.0f) : glm::vec3(0.0f, 1.0f, 0.0f);
+	glm::mat4x4 lightView = glm::lookAtRH(glm::vec3(0.0f), -towardLight, up);
+	glm::vec3 sceneCenter = glm::vec3(lightView * glm::vec4(sceneBounds.center, 1.0f));
+
+	float splitNear = cameraNear;
+	for (uint32_t cascade = 0; cascade < kCascadeCount; ++cascade) {
+		// 对数划分与均匀划分的混合
+		float t = static_cast<float>(cascade + 1) / static_cast<float>(kCascadeCount);
+		float logSplit = cameraNear * std::pow(shadowDistance / cameraNear, t);
+		float uniformSplit = cameraNear + (shadowDistance - cameraNear) * t;
+		float splitFar = kSplitLambda * logSplit + (1.0f - kSplitLambda) * uniformSplit;
+
+		// 这一段视锥的 8 个角点的包围球，球的大小与相机朝向无关，旋转相机时投影范围不变
+		std::array<glm::vec3, 8> corners;
+		glm::vec3 center(0.0f);
+		for (uint32_t i = 0; i < 4; ++i) {
+			corners[i] = glm::vec3(inverseView * glm::vec4(rays[i] * splitNear, 1.0f));
+			corners[i + 4] = glm::vec3(inverseView * glm::vec4(rays[i] * splitFar, 1.0f));
+		}
+		for (const glm::vec3& corner : corners) {
+			center += corner / 8.0f;
+		}
+		float radius = 0.0f;
+		for (const glm::vec3& corner : corners) {
+			radius = std::max(radius, glm::length(corner - center));
+		}
+		radius = std::ceil(radius * 16.0f) / 16.0f;
+
+		// 光源空间中把中心对齐到纹素
+		float texelSize = 2.0f * radius / static_cast<float>(resolution);
+		glm::vec3 lightCenter = glm::vec3(lightView * glm::vec4(center, 1.0f));
+		lightCenter.x = std::floor(lightCenter.x / texelSize) * texelSize;
+		lightCenter.y = std::floor(lightCenter.y / texelSize) * texelSize;
+		// 深度范围包含整个场景，级联之外的投射物也能投下阴影
+		float zMax = std::max(lightCenter.z + radius, sceneCenter.z + sceneBounds.radius);
+		float zMin = std::min(lightCenter.z - radius, sceneCenter.z - sceneBounds.radius);
+		glm::mat4x4 lightProjection = glm::orthoRH_ZO(lightCenter.x - radius, lightCenter.x + radius,
+			lightCenter.y - radius, lightCenter.y + radius, -zMax, -zMin);
+		glm::mat4x4 lightViewProjection = lightProjection * lightView;
+
+		if (lightViewProjection != uniform.lightViewProjection[cascade]) {
+			uniform.lightViewProjection[cascade] = lightViewProjection;
+			staticValid[cascade] = false;
+			queue.writeBuffer(cascadeUniformBuffer, cascade * kCascadeUniformStride, &lightViewProjection, sizeof(glm::mat4x4));
+			++uploadCount;
+		}
+		uniform.cascadeSplits[cascade] = splitFar;
+		uniform.cascadeTexelSize[cascade] = texelSize;
+		splitNear = splitFar;
+	}
+	uniform.lightDirection = glm::vec4(lightDirection, static_cast<float>(kCascadeCount));
+	uniform.params = glm::vec4(1.0f / static_cast<float>(resolution), 0.0005f, 0.0f, 0.0f);
+	uploadCount += uniformCache.Write(queue, shadowUniformBuffer, 0, &uniform, sizeof(ShadowUniform));
+}
+
+void ShadowRenderer::BeginCascadePass(wgpu::CommandEncoder& encoder, wgpu::TextureView view, wgpu::LoadOp loadOp, uint32_t cascade,
+	Casters casters, const DrawCasters& drawCasters) {
+	wgpu::RenderPassDepthStencilAttachment depthStencilAttachment;
+	depthStencilAttachment.view = view;
+	depthStencilAttachment.depthClearValue = 1.0f;
+	depthStencilAttachment.depthLoadOp = loadOp;
+	depthStencilAttachment.depthStoreOp = wgpu::StoreOp::Store;
+	depthStencilAttachment.depthReadOnly = false;
+	depthStencilAttachment.stencilClearValue = 0;
+#ifdef WEBGPU_BACKEND_WGPU
+	depthStencilAttachment.stencilLoadOp = wgpu::LoadOp::Clear;
+	depthStencilAttachment.stencilStoreOp = wgpu::StoreOp::Store;
+#else
+	depthStencilAttachment.stencilLoadOp = wgpu::LoadOp::Undefined;
+	depthStencilAttachment.stencilStoreOp = wgpu::StoreOp::Undefined;
+#endif
+	depthStencilAttachment.stencilReadOnly = true;
+
+	wgpu::RenderPassDescriptor renderPassDesc = {};
+	renderPassDesc.label = casters == Casters::Static ? "Static shadow pass" : "Dynamic shadow pass";
+	renderPassDesc.colorAttachmentCount = 0;
+	renderPassDesc.colorAttachments = nullptr;
+	renderPassDesc.depthStencilAttachment = &depthStencilAttachment;
+	renderPassDesc.timestampWrites = nullptr;
+
+	wgpu::RenderPassEncoder renderPass = encoder.beginRenderPass(renderPassDesc);
+	checkNullPointerError(renderPass, "shadow renderPass");
+	renderPass.setPipeline(pipeline);
+	uint32_t offset = static_cast<uint32_t>(cascade * kCascadeUniformStride);
+	renderPass.setBindGroup(0, bindGroup, 1, &offset);
+	drawCasters(renderPass, casters);
+	renderPass.end();
+	renderPass.release();
+}
+
+void ShadowRenderer::Render(wgpu::CommandEncoder& encoder, bool hasDynamicCasters, const DrawCasters& drawCasters) {
+	for (uint32_t cascade = 0; cascade < kCascadeCount; ++cascade) {
+		if (!staticValid[cascade]) {
+			BeginCascadePass(encoder, staticLayerViews[cascade], wgpu::LoadOp::Clear, cascade, Casters::Static, drawCasters);
+			staticValid[cascade] = true;
+			layerMatchesCache[cascade] = false;
+			++staticRenderCount;
+			LOG("Shadow: static casters re-rendered for cascade %u (%llu times in total)\n", cascade,
+				static_cast<unsigned long long>(staticRenderCount));
+		}
+		// 阴影贴图这一层已经是缓存的内容，且没有动态投射物要叠加
+		if (layerMatchesCache[cascade] && !hasDynamicCasters) {
+			continue;
+		}
+
+		wgpu::ImageCopyTexture source = wgpu::Default;
+		source.texture = staticCache;
+		source.origin = { 0, 0, cascade };
+		source.aspect = wgpu::TextureAspect::All;
+		wgpu::ImageCopyTexture destination = wgpu::Default;
+		destination.texture = shadowMap;
+		destination.origin = { 0, 0, cascade };
+		destination.aspect = wgpu::TextureAspect::All;
+		encoder.copyTextureToTexture(source, destination, { resolution, resolution, 1 });
+		layerMatchesCache[cascade] = true;
+
+		if (hasDynamicCasters) {
+			BeginCascadePass(encoder, shadowLayerViews[cascade], wgpu::LoadOp::Load, cascade, Casters::Dynamic, drawCasters);
+			layerMatchesCache[cascade] = false;
+		}
+	}
+}
+
+void ShadowRenderer::InvalidateStaticCache() {
+	staticValid.fill(false);
+}
+
+void ShadowRenderer::Terminate() {
+	if (!pipeline) {
+		return;
+	}
+	for (wgpu::TextureView& view : shadowLayerViews) {
+		view.release();
+	}
+	for (wgpu::TextureView& view : staticLayerViews) {
+		view.release();
+	}
+	shadowLayerViews.clear();
+	staticLayerViews.clear();
+	shadowMapView.release();
+	shadowMap.destroy();
+	shadowMap.release();
+	staticCache.destroy();
+	staticCache.release();
+	comparisonSampler.release();
+	cascadeUniformBuffer.destroy();
+	cascadeUniformBuffer.release();
+	shadowUniformBuffer.destroy();
+	shadowUniformBuffer.release();
+	bindGroup.release();
+	pipeline.release();
+	pipeline = nullptr;
+	uniformCache.Reset();
+}
+
+}
@@ -0,0 +1,117 @@
+#pragma once
+
+#include "../utils/global.h"
+#include "../utils/mesh-simplifier.h"
+#include "uniform-buffer.h"
+
+#include <functional>
+
+namespace webgpu {
+
+/**
+ * 阴影参数，布局与 base.wgsl 中的 ShadowUniforms 一致
+ */
+struct ShadowUniform {
+	std::array<glm::mat4x4, 4> lightViewProjection = {};
+	// 每级级联覆盖到的视图空间深度
+	glm::vec4 cascadeSplits = glm::vec4(0.0f);
+	// 每级级联一个纹素在世界空间中的大小（用于沿法线偏移）
+	glm::vec4 cascadeTexelSize = glm::vec4(0.0f);
+	// xyz 指向光源（与 fs_main 中的方向光相同，未归一化），w 为级联数
+	glm::vec4 lightDirection = glm::vec4(0.0f);
+	// x 为阴影贴图纹素的 uv 大小，y 为深度偏移
+	glm::vec4 params = glm::vec4(0.0f);
+};
+
+static_assert(sizeof(ShadowUniform) % 16 == 0);
+
+/**
+ * 级联阴影（方向光）
+ * 相机视锥按深度切成 kCascadeCount 级，每级用包住该段视锥的正交投影渲染一层深度（只有顶点着色器的管线变体）。
+ * 静态投射物单独渲染到一份缓存里，只有级联矩阵变化（光源方向、相机、窗口尺寸）或调用 InvalidateStaticCache 时才重画；
+ * 每帧只把缓存拷贝到阴影贴图再叠加动态投射物。级联中心对齐到纹素，相机平移时阴影不抖动。
+ */
+class ShadowRenderer {
+public:
+	static constexpr uint32_t kCascadeCount = 3;
+
+	// 投射物的种类，由 Render 的回调决定画哪些实例
+	enum class Casters { Static, Dynamic };
+	using DrawCasters = std::function<void(wgpu::RenderPassEncoder&, Casters)>;
+
+	/**
+	 * @brief 创建只有深度的管线、阴影贴图和缓存
+	 * @param shaderPath shadow.wgsl 路径
+	 * @param vertexStride / positionFormat 顶点缓冲区的步长与位置属性格式（只读取位置）
+	 * @param uniformBuffer 全局 uniform（模型动画矩阵、反量化参数、动态实例数）
+	 * @param instanceBuffer 实例 storage buffer
+	 * @param resolution 每级级联的分辨率
+	 */
+	void Initialize(wgpu::Device device, wgpu::Queue queue, const std::filesystem::path& shaderPath,
+		uint64_t vertexStride, wgpu::VertexFormat positionFormat, wgpu::Buffer uniformBuffer,
+		wgpu::Buffer instanceBuffer, uint64_t instanceBufferSize, uint32_t resolution = 2048);
+
+	/**
+	 * @brief 按相机拟合级联，级联矩阵变化的层标记为需要重画静态缓存
+	 * @param lightDirection 指向光源的方向
+	 * @param sceneBounds 所有投射物的包围球（世界空间），决定正交投影的深度范围
+	 * @param shadowDistance 阴影覆盖到的视图空间深度
+	 */
+	void Update(const glm::mat4x4& projectionMatrix, const glm::mat4x4& viewMatrix, const glm::vec3& lightDirection,
+		const BoundingSphere& sceneBounds, float cameraNear, float shadowDistance);
+
+	/**
+	 * @brief 录制阴影：按需重画静态缓存，拷贝到阴影贴图，再叠加动态投射物
+	 * @param hasDynamicCasters 没有动态投射物时缓存没变就什么都不录制
+	 * @param drawCasters 在已设置好管线和级联的通道中绘制指定种类的投射物
+	 */
+	void Render(wgpu::CommandEncoder& encoder, bool hasDynamicCasters, const DrawCasters& drawCasters);
+
+	/**
+	 * @brief 静态几何体变化后调用，下一帧重画所有级联的静态缓存
+	 */
+	void InvalidateStaticCache();
+
+	wgpu::TextureView GetShadowMapView() const { return shadowMapView; }
+	wgpu::Sampler GetSampler() const { return comparisonSampler; }
+	wgpu::Buffer GetUniformBuffer() const { return shadowUniformBuffer; }
+
+	/**
+	 * @brief 自上次调用以来每帧的 writeBuffer 次数，读取后清零
+	 */
+	uint32_t TakeUploadCount() { return std::exchange(uploadCount, 0u); }
+
+	/**
+	 * @brief 销毁
+	 */
+	void Terminate();
+
+private:
+	void BeginCascadePass(wgpu::CommandEncoder& encoder, wgpu::TextureView view, wgpu::LoadOp loadOp, uint32_t cascade,
+		Casters casters, const DrawCasters& drawCasters);
+
+	wgpu::Queue queue = nullptr;
+	wgpu::RenderPipeline pipeline = nullptr;
+	wgpu::BindGroup bindGroup = nullptr;
+	uint32_t resolution = 0;
+	// 每级级联的光源矩阵，按 256 字节对齐，以动态偏移绑定
+	wgpu::Buffer cascadeUniformBuffer = nullptr;
+	wgpu::Buffer shadowUniformBuffer = nullptr;
+	ShadowUniform uniform;
+	// 上一次写入的阴影参数，相机和光源不动时不再上传
+	BufferWriteCache uniformCache;
+	uint32_t uploadCount = 0;
+	// 采样用的阴影贴图与静态投射物的缓存，都是 kCascadeCount 层
+	wgpu::Texture shadowMap = nullptr;
+	wgpu::TextureView shadowMapView = nullptr;
+	std::vector<wgpu::TextureView> shadowLayerViews;
+	wgpu::Texture staticCache = nullptr;
+	std::vector<wgpu::TextureView> staticLayerViews;
+	wgpu::Sampler comparisonSampler = nullptr;
+	// 静态缓存是否有效、阴影贴图的该层是否与缓存一致（没有叠加动态投射物）
+	std::array<bool, kCascadeCount> staticValid = {};
+	std::array<bool, kCascadeCount> layerMatchesCache = {};
+	uint64_t staticRenderCount = 0;
+};
+
+}
@@ -0,0 +1,175 @@
+#include "skinning.h"
+#include "../utils/utils.h"
+
+#include <algorithm>
+
+namespace webgpu {
+
+namespace {
+
+constexpr uint32_t kWorkgroupSize = 256;
+
+}
+
+void SkinningSystem::Initialize(wgpu::Device device, wgpu::Queue queue, const std::filesystem::path& shaderDirectory,
+	std::span<const VertexAttributes> vertices, Skeleton skeleton, std::vector<AnimationClip> clips, std::span<const SkinVertex> skin,
+	const void* vertexData, uint64_t vertexDataSize, const void* positionData, uint64_t positionDataSize, const SkinnedVertexLayout& layout) {
+	if (clips.empty() || skin.size() != vertices.size()) {
+		throw std::runtime_error("Skinning needs at least one clip and skin data for every vertex");
+	}
+	this->device = device;
+	this->queue = queue;
+	this->skeleton = std::move(skeleton);
+	this->clips = std::move(clips);
+	vertexCount = static_cast<uint32_t>(vertices.size());
+	jointMatrices.assign(this->skeleton.jointCount(), glm::mat4x4(1.0f));
+
+	LOG("Creating skinning pipeline...\n");
+	wgpu::ShaderModule shaderModule = loadShaderModule(shaderDirectory / "skinning.wgsl", device);
+	checkNullPointerError(shaderModule, "skinning shader");
+
+	// 参数、绑定姿态、蒙皮数据、蒙皮矩阵、输出的交错顶点、输出的位置流
+	ComputeKernelDesc kernelDesc;
+	kernelDesc.label = "Skinning pipeline";
+	kernelDesc.module = shaderModule;
+	kernelDesc.bindings = { ComputeBinding::Uniform(sizeof(SkinningUniform)), ComputeBinding::ReadOnlyStorage(), ComputeBinding::ReadOnlyStorage(),
+		ComputeBinding::ReadOnlyStorage(), ComputeBinding::Storage(), ComputeBinding::Storage() };
+	kernelDesc.workgroupSize = glm::uvec3(kWorkgroupSize, 1u, 1u);
+	kernelDesc.overridableWorkgroupSize = true;
+	kernel.Initialize(device, kernelDesc);
+	shaderModule.release();
+
+	auto createBuffer = [&](const char* label, uint64_t size, auto usage) {
+		wgpu::BufferDescriptor bufferDesc;
+		bufferDesc.label = label;
+		bufferDesc.size = size;
+		bufferDesc.usage = usage;
+		bufferDesc.mappedAtCreation = false;
+		return device.createBuffer(bufferDesc);
+	};
+	uint64_t bindPoseSize = static_cast<uint64_t>(vertexCount) * 2 * sizeof(glm::vec4);
+	uint64_t skinSize = static_cast<uint64_t>(vertexCount) * sizeof(SkinVertex);
+	uint64_t jointSize = jointMatrices.size() * sizeof(glm::mat4x4);
+	vertexBufferSize = vertexDataSize;
+	positionBufferSize = positionDataSize;
+	uniformBuffer = createBuffer("Skinning uniforms", sizeof(SkinningUniform), wgpu::BufferUsage::Uniform | wgpu::BufferUsage::CopyDst);
+	bindPoseBuffer = createBuffer("Skinning bind pose", bindPoseSize, wgpu::BufferUsage::Storage | wgpu::BufferUsage::CopyDst);
+	skinBuffer = createBuffer("Skinning weights", skinSize, wgpu::BufferUsage::Storage | wgpu::BufferUsage::CopyDst);
+	jointBuffer = createBuffer("Skinning joint matrices", jointSize, wgpu::BufferUsage::Storage | wgpu::BufferUsage::CopyDst);
+	vertexBuffer = createBuffer("Skinned vertices", vertexBufferSize,
+		wgpu::BufferUsage::Vertex | wgpu::BufferUsage::Storage | wgpu::BufferUsage::CopyDst);
+	positionBuffer = createBuffer("Skinned positions", positionBufferSize,
+		wgpu::BufferUsage::Vertex | wgpu::BufferUsage::Storage | wgpu::BufferUsage::CopyDst);
+
+	SkinningUniform uniform;
+	uniform.params = glm::uvec4(vertexCount, layout.compact ? 1u : 0u, layout.vertexStride / sizeof(uint32_t), layout.positionStride / sizeof(uint32_t));
+	uniform.positionOffset = glm::vec4(layout.positionOffset, 0.0f);
+	uniform.positionScale = glm::vec4(layout.positionScale, 1.0f);
+	queue.writeBuffer(uniformBuffer, 0, &uniform, sizeof(SkinningUniform));
+
+	std::vector<glm::vec4> bindPose(2 * static_cast<size_t>(vertexCount));
+	for (size_t i = 0; i < vertices.size(); ++i) {
+		bindPose[2 * i] = glm::vec4(vertices[i].position, 1.0f);
+		bindPose[2 * i + 1] = glm::vec4(vertices[i].normal, 0.0f);
+	}
+	queue.writeBuffer(bindPoseBuffer, 0, bindPose.data(), bindPoseSize);
+	queue.writeBuffer(skinBuffer, 0, skin.data(), skinSize);
+	queue.writeBuffer(jointBuffer, 0, jointMatrices.data(), jointSize);
+	// 颜色和纹理坐标不参与蒙皮，输出缓冲区以原始顶点初始化
+	queue.writeBuffer(vertexBuffer, 0, vertexData, vertexBufferSize);
+	queue.writeBuffer(positionBuffer, 0, positionData, positionBufferSize);
+
+	std::array<ComputeResource, 6> resources = {
+		ComputeResource::Buffer(uniformBuffer, sizeof(SkinningUniform)),
+		ComputeResource::Buffer(bindPoseBuffer, bindPoseSize),
+		ComputeResource::Buffer(skinBuffer, skinSize),
+		ComputeResource::Buffer(jointBuffer, jointSize),
+		ComputeResource::Buffer(vertexBuffer, vertexBufferSize),
+		ComputeResource::Buffer(positionBuffer, positionBufferSize),
+	};
+	bindGroup = kernel.CreateBindGroup(resources);
+
+	stopping = false;
+	hasJob = false;
+	updateRequested = false;
+	worker = std::thread(&SkinningSystem::WorkerLoop, this);
+	LOG("Skinning: %u vertices, %zu joints, %zu clips\n", vertexCount, this->skeleton.jointCount(), this->clips.size());
+}
+
+void SkinningSystem::BeginUpdate(float time, float blendWeight) {
+	if (!IsReady()) {
+		return;
+	}
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		jobTime = time;
+		jobBlendWeight = std::clamp(blendWeight, 0.0f, 1.0f);
+		hasJob = true;
+	}
+	jobAvailable.notify_one();
+	updateRequested = true;
+}
+
+void SkinningSystem::Skin(wgpu::CommandEncoder& encoder) {
+	if (!IsReady() || !updateRequested) {
+		return;
+	}
+	updateRequested = false;
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		jobDone.wait(lock, [this] { return !hasJob; });
+	}
+	queue.writeBuffer(jointBuffer, 0, jointMatrices.data(), jointMatrices.size() * sizeof(glm::mat4x4));
+	++uploadCount;
+
+	ComputePass computePass(encoder, "Skinning pass");
+	computePass.DispatchThreads(kernel, bindGroup, vertexCount);
+}
+
+void SkinningSystem::WorkerLoop() {
+	std::unique_lock<std::mutex> lock(mutex);
+	while (true) {
+		jobAvailable.wait(lock, [this] { return stopping || hasJob; });
+		if (stopping) {
+			return;
+		}
+		float time = jobTime;
+		float blendWeight = jobBlendWeight;
+		lock.unlock();
+
+		// 姿态和矩阵的容器在第一次之后不再分配
+		sampleClip(clips[0], time, basePose);
+		if (clips.size() > 1 && blendWeight > 0.0f) {
+			sampleClip(clips[1], time, blendPose);
+			blendPoses(basePose, blendPose, blendWeight, basePose);
+		}
+		computeSkinningMatrices(skeleton, basePose, jointMatrices);
+
+		lock.lock();
+		hasJob = false;
+		jobDone.notify_all();
+	}
+}
+
+void SkinningSystem::Terminate() {
+	if (!IsReady()) {
+		return;
+	}
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		stopping = true;
+	}
+	jobAvailable.notify_all();
+	worker.join();
+
+	bindGroup.release();
+	bindGroup = nullptr;
+	kernel.Terminate();
+	for (wgpu::Buffer* buffer : { &uniformBuffer, &bindPoseBuffer, &skinBuffer, &jointBuffer, &vertexBuffer, &positionBuffer }) {
+		buffer->destroy();
+		buffer->release();
+		*buffer = nullptr;
+	}
+}
+
+}
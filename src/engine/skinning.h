@@ -0,0 +1,128 @@
+#pragma once
+
+#include "../utils/global.h"
+#include "../utils/animation.h"
+#include "compute.h"
+
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+namespace webgpu {
+
+/**
+ * 蒙皮输出的顶点布局，与渲染管线读取的顶点缓冲区一致
+ */
+struct SkinnedVertexLayout {
+	// 为 true 时是 CompactVertexAttributes，位置按 positionOffset/positionScale 量化
+	bool compact = true;
+	uint32_t vertexStride = sizeof(CompactVertexAttributes);
+	uint32_t positionStride = 4 * sizeof(int16_t);
+	glm::vec3 positionOffset = glm::vec3(0.0f);
+	glm::vec3 positionScale = glm::vec3(1.0f);
+};
+
+/**
+ * 蒙皮参数，布局与 skinning.wgsl 中的 SkinningUniforms 一致
+ */
+struct SkinningUniform {
+	glm::uvec4 params = glm::uvec4(0u);
+	glm::vec4 positionOffset = glm::vec4(0.0f);
+	glm::vec4 positionScale = glm::vec4(1.0f);
+};
+
+static_assert(sizeof(SkinningUniform) % 16 == 0);
+
+/**
+ * 骨骼动画与 GPU 蒙皮：
+ * 片段采样、姿态混合和蒙皮矩阵在工作线程上计算（与主线程准备本帧的其他工作并行），
+ * 蒙皮在计算通道中完成，结果写入共享的顶点缓冲区和位置流，主渲染通道、深度预通道和阴影都直接读取，每帧只蒙皮一次。
+ */
+class SkinningSystem {
+public:
+	/**
+	 * @brief 上传绑定姿态和蒙皮数据，创建输出缓冲区（以 vertexData/positionData 初始化，不被蒙皮覆盖的属性保持原样），启动工作线程
+	 * @param vertices 绑定姿态的网格顶点
+	 * @param clips 第一个片段为基础动画，第二个（可选）按 BeginUpdate 的权重混合上去
+	 * @param vertexData 与 layout 一致的交错顶点数据
+	 * @param positionData 与 layout 一致的位置流数据
+	 */
+	void Initialize(wgpu::Device device, wgpu::Queue queue, const std::filesystem::path& shaderDirectory,
+		std::span<const VertexAttributes> vertices, Skeleton skeleton, std::vector<AnimationClip> clips, std::span<const SkinVertex> skin,
+		const void* vertexData, uint64_t vertexDataSize, const void* positionData, uint64_t positionDataSize, const SkinnedVertexLayout& layout);
+
+	/**
+	 * @brief 在工作线程上计算 time 时刻的姿态，blendWeight 为第二个片段的权重
+	 */
+	void BeginUpdate(float time, float blendWeight);
+
+	/**
+	 * @brief 等待姿态计算完成，上传蒙皮矩阵并录制蒙皮（本帧没有调用 BeginUpdate 时不重复蒙皮）
+	 */
+	void Skin(wgpu::CommandEncoder& encoder);
+
+	wgpu::Buffer GetVertexBuffer() const { return vertexBuffer; }
+	uint64_t GetVertexBufferSize() const { return vertexBufferSize; }
+	wgpu::Buffer GetPositionBuffer() const { return positionBuffer; }
+	uint64_t GetPositionBufferSize() const { return positionBufferSize; }
+
+	/**
+	 * @brief 自上次调用以来每帧的 writeBuffer 次数，读取后清零
+	 */
+	uint32_t TakeUploadCount() { return std::exchange(uploadCount, 0u); }
+
+	/**
+	 * @brief 销毁，停止工作线程
+	 */
+	void Terminate();
+
+	/**
+	 * @brief 是否已初始化
+	 */
+	bool IsReady() const { return kernel.IsReady(); }
+
+private:
+	/**
+	 * @brief 工作线程：等待任务，采样、混合并计算蒙皮矩阵
+	 */
+	void WorkerLoop();
+
+	wgpu::Device device = nullptr;
+	wgpu::Queue queue = nullptr;
+	uint32_t vertexCount = 0;
+
+	Skeleton skeleton;
+	std::vector<AnimationClip> clips;
+	// 工作线程使用的姿态和输出的蒙皮矩阵，任务完成前主线程不读取
+	JointPoses basePose;
+	JointPoses blendPose;
+	std::vector<glm::mat4x4> jointMatrices;
+
+	// 工作线程共享的状态，由 mutex 保护
+	std::thread worker;
+	std::mutex mutex;
+	std::condition_variable jobAvailable;
+	std::condition_variable jobDone;
+	bool hasJob = false;
+	bool stopping = false;
+	float jobTime = 0.0f;
+	float jobBlendWeight = 0.0f;
+	// 本帧是否已经提交了姿态任务（只由主线程访问）
+	bool updateRequested = false;
+	uint32_t uploadCount = 0;
+
+	ComputeKernel kernel;
+	wgpu::BindGroup bindGroup = nullptr;
+	wgpu::Buffer uniformBuffer = nullptr;
+	// 每个顶点的绑定姿态位置和法向量（各一个 vec4）
+	wgpu::Buffer bindPoseBuffer = nullptr;
+	wgpu::Buffer skinBuffer = nullptr;
+	wgpu::Buffer jointBuffer = nullptr;
+	// 蒙皮后的交错顶点和位置流，同时作为顶点缓冲区和存储缓冲区
+	wgpu::Buffer vertexBuffer = nullptr;
+	uint64_t vertexBufferSize = 0;
+	wgpu::Buffer positionBuffer = nullptr;
+	uint64_t positionBufferSize = 0;
+};
+
+}
@@ -0,0 +1,417 @@
+#include "texture-manager.h"
+#include "../utils/utils.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace webgpu {
+
+namespace {
+
+const wgpu::TextureFormat kTextureFormat = wgpu::TextureFormat::RGBA8Unorm;
+
+uint32_t mipLevelCountFor(uint32_t width, uint32_t height) {
+	uint32_t levels = 1;
+	while ((std::max(width, height) >> levels) > 0) {
+		++levels;
+	}
+	return levels;
+}
+
+wgpu::TextureFormat textureFormatFor(TextureCodecFormat format) {
+	switch (format) {
+	case TextureCodecFormat::BC7: return wgpu::TextureFormat::BC7RGBAUnorm;
+	case TextureCodecFormat::ETC2: return wgpu::TextureFormat::ETC2RGBA8Unorm;
+	default: return kTextureFormat;
+	}
+}
+
+wgpu::TextureView createMipView(wgpu::Texture texture, uint32_t mipLevel, uint32_t mipLevelCount, wgpu::TextureFormat format = kTextureFormat) {
+	wgpu::TextureViewDescriptor viewDesc;
+	viewDesc.aspect = wgpu::TextureAspect::All;
+	viewDesc.baseArrayLayer = 0;
+	viewDesc.arrayLayerCount = 1;
+	viewDesc.baseMipLevel = mipLevel;
+	viewDesc.mipLevelCount = mipLevelCount;
+	viewDesc.dimension = wgpu::TextureViewDimension::_2D;
+	viewDesc.format = format;
+	return texture.createView(viewDesc);
+}
+
+}
+
+void TextureManager::Initialize(wgpu::Device device, wgpu::Queue queue, const std::filesystem::path& shaderDirectory, uint32_t workerCount) {
+	this->device = device;
+	this->queue = queue;
+
+	// mipmap 生成管线
+	LOG("Creating mipmap pipeline...\n");
+	wgpu::ShaderModule shaderModule = loadShaderModule(shaderDirectory / "mipmap.wgsl", device);
+
+	// 上一级作为输入，下一级作为存储纹理输出，与 mipmap.wgsl 的 8x8 工作组一致
+	ComputeKernelDesc kernelDesc;
+	kernelDesc.label = "Mipmap pipeline";
+	kernelDesc.module = shaderModule;
+	kernelDesc.bindings = { ComputeBinding::Texture(wgpu::TextureSampleType::Float), ComputeBinding::StorageTexture(kTextureFormat) };
+	kernelDesc.workgroupSize = glm::uvec3(8u, 8u, 1u);
+	mipmapKernel.Initialize(device, kernelDesc);
+	shaderModule.release();
+
+	// 三线性过滤，重复寻址
+	wgpu::SamplerDescriptor samplerDesc;
+	samplerDesc.addressModeU = wgpu::AddressMode::Repeat;
+	samplerDesc.addressModeV = wgpu::AddressMode::Repeat;
+	samplerDesc.addressModeW = wgpu::AddressMode::Repeat;
+	samplerDesc.magFilter = wgpu::FilterMode::Linear;
+	samplerDesc.minFilter = wgpu::FilterMode::Linear;
+	samplerDesc.mipmapFilter = wgpu::MipmapFilterMode::Linear;
+	samplerDesc.lodMinClamp = 0.0f;
+	samplerDesc.lodMaxClamp = 32.0f;
+	samplerDesc.compare = wgpu::CompareFunction::Undefined;
+	samplerDesc.maxAnisotropy = 1;
+	sampler = device.createSampler(samplerDesc);
+
+	// 1x1 白色占位纹理
+	wgpu::TextureDescriptor textureDesc;
+	textureDesc.dimension = wgpu::TextureDimension::_2D;
+	textureDesc.format = kTextureFormat;
+	textureDesc.mipLevelCount = 1;
+	textureDesc.sampleCount = 1;
+	textureDesc.size = { 1, 1, 1 };
+	textureDesc.usage = wgpu::TextureUsage::TextureBinding | wgpu::TextureUsage::CopyDst;
+	textureDesc.viewFormatCount = 0;
+	textureDesc.viewFormats = nullptr;
+	placeholderTexture = device.createTexture(textureDesc);
+	placeholderView = createMipView(placeholderTexture, 0, 1);
+	const uint8_t white[4] = { 255, 255, 255, 255 };
+	wgpu::ImageCopyTexture destination;
+	destination.texture = placeholderTexture;
+	destination.mipLevel = 0;
+	destination.origin = { 0, 0, 0 };
+	destination.aspect = wgpu::TextureAspect::All;
+	wgpu::TextureDataLayout source;
+	source.offset = 0;
+	source.bytesPerRow = 4;
+	source.rowsPerImage = 1;
+	queue.writeTexture(destination, white, sizeof(white), source, { 1, 1, 1 });
+
+	// 块压缩格式，必须在设备创建时请求了对应特性
+	compressedFormats.clear();
+	if (device.hasFeature(wgpu::FeatureName::TextureCompressionBC)) {
+		compressedFormats.push_back(TextureCodecFormat::BC7);
+	}
+	if (device.hasFeature(wgpu::FeatureName::TextureCompressionETC2)) {
+		compressedFormats.push_back(TextureCodecFormat::ETC2);
+	}
+	LOG("Texture manager: compressed formats:%s%s%s\n",
+		compressedFormats.empty() ? " none (baked textures are transcoded to RGBA8, .wtex has no ASTC payload)" : "",
+		device.hasFeature(wgpu::FeatureName::TextureCompressionBC) ? " BC7" : "",
+		device.hasFeature(wgpu::FeatureName::TextureCompressionETC2) ? " ETC2" : "");
+
+	// 工作线程
+#ifdef __EMSCRIPTEN__
+	// 浏览器里默认没有线程，Load 中同步解码
+	workerCount = 0;
+#else
+	if (workerCount == 0) {
+		workerCount = std::clamp(std::thread::hardware_concurrency() / 2, 1u, 4u);
+	}
+#endif
+	stopping = false;
+	for (uint32_t i = 0; i < workerCount; ++i) {
+		workers.emplace_back(&TextureManager::WorkerLoop, this);
+	}
+	LOG("Texture manager: %u decode worker(s)\n", workerCount);
+}
+
+TextureHandle TextureManager::Load(const std::filesystem::path& path) {
+	std::error_code ec;
+	std::filesystem::path canonical = std::filesystem::weakly_canonical(path, ec);
+	std::string key = (ec ? path.lexically_normal() : canonical).generic_string();
+
+	auto it = handlesByPath.find(key);
+	if (it != handlesByPath.end()) {
+		return it->second;
+	}
+
+	TextureHandle handle = static_cast<TextureHandle>(textures.size());
+	textures.push_back({ path });
+	handlesByPath.emplace(key, handle);
+	++pendingCount;
+
+	if (workers.empty()) {
+		DecodeResult result;
+		result.handle = handle;
+		Decode(path, result);
+		results.push_back(std::move(result));
+	} else {
+		std::lock_guard<std::mutex> lock(mutex);
+		jobs.emplace_back(handle, path);
+		jobAvailable.notify_one();
+	}
+	return handle;
+}
+
+void TextureManager::WorkerLoop() {
+	for (;;) {
+		std::pair<TextureHandle, std::filesystem::path> job;
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			jobAvailable.wait(lock, [this]() { return stopping || !jobs.empty(); });
+			if (stopping) {
+				return;
+			}
+			job = std::move(jobs.front());
+			jobs.pop_front();
+		}
+
+		DecodeResult result;
+		result.handle = job.first;
+		Decode(job.second, result);
+
+		std::lock_guard<std::mutex> lock(mutex);
+		results.push_back(std::move(result));
+		resultAvailable.notify_all();
+	}
+}
+
+void TextureManager::Decode(const std::filesystem::path& path, DecodeResult& result) const {
+	std::filesystem::path bakedPath = bakedTexturePath(path);
+	if (std::filesystem::exists(bakedPath) && loadBakedTexture(bakedPath, compressedFormats, result.texture)) {
+		result.success = true;
+		return;
+	}
+	Image image;
+	result.success = decodeImage(path, image);
+	result.texture.format = TextureCodecFormat::RGBA8;
+	result.texture.mips.clear();
+	if (result.success) {
+		result.texture.mips.push_back({ image.width, image.height, std::move(image.pixels) });
+	}
+}
+
+uint32_t TextureManager::Update() {
+	std::vector<DecodeResult> finished;
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		finished.swap(results);
+	}
+	if (finished.empty()) {
+		return 0;
+	}
+
+	wgpu::CommandEncoderDescriptor encoderDesc = {};
+	encoderDesc.label = "Texture upload encoder";
+	wgpu::CommandEncoder encoder = device.createCommandEncoder(encoderDesc);
+	std::vector<wgpu::Buffer> stagingBuffers;
+
+	uint32_t readyCount = 0;
+	for (DecodeResult& result : finished) {
+		--pendingCount;
+		TextureEntry& entry = textures[result.handle];
+		if (!result.success) {
+			LOG("Texture %s failed to load, using placeholder\n", entry.path.string().c_str());
+			continue;
+		}
+		Upload(encoder, entry, result.texture, stagingBuffers);
+		++readyCount;
+	}
+
+	wgpu::CommandBufferDescriptor cmdBufferDescriptor = {};
+	cmdBufferDescriptor.label = "Texture upload commands";
+	wgpu::CommandBuffer command = encoder.finish(cmdBufferDescriptor);
+	encoder.release();
+	queue.submit(1, &command);
+	command.release();
+
+	// 提交之后即可释放，实际销毁由设备在 GPU 用完后进行
+	for (wgpu::Buffer& buffer : stagingBuffers) {
+		buffer.release();
+	}
+	return readyCount;
+}
+
+void TextureManager::Upload(wgpu::CommandEncoder& encoder, TextureEntry& entry, const BakedTexture& texture, std::vector<wgpu::Buffer>& stagingBuffers) {
+	const TextureMip& base = texture.mips[0];
+	bool compressed = texture.format != TextureCodecFormat::RGBA8;
+	// 只有一级时由 GPU 生成其余 mip（需要存储纹理用途，块压缩格式不支持）
+	bool generateMips = texture.mips.size() == 1;
+	uint32_t mipLevelCount = generateMips ? mipLevelCountFor(base.width, base.height) : static_cast<uint32_t>(texture.mips.size());
+	wgpu::TextureFormat format = textureFormatFor(texture.format);
+
+	wgpu::TextureDescriptor textureDesc;
+	textureDesc.dimension = wgpu::TextureDimension::_2D;
+	textureDesc.format = format;
+	textureDesc.mipLevelCount = mipLevelCount;
+	textureDesc.sampleCount = 1;
+	textureDesc.size = { base.width, base.height, 1 };
+	textureDesc.usage = wgpu::TextureUsage::TextureBinding | wgpu::TextureUsage::CopyDst;
+	if (generateMips) {
+		textureDesc.usage |= wgpu::TextureUsage::StorageBinding;
+	}
+	textureDesc.viewFormatCount = 0;
+	textureDesc.viewFormats = nullptr;
+	entry.texture = device.createTexture(textureDesc);
+
+	// 块压缩时按 4x4 块为一“行”；staging buffer 的行距需要 256 字节对齐，每级 mip 的起点也按 256 对齐
+	struct MipLayout {
+		uint64_t offset;
+		uint32_t rowBytes;
+		uint32_t bytesPerRow;
+		uint32_t rows;
+	};
+	std::vector<MipLayout> layouts;
+	uint64_t stagingSize = 0;
+	uint64_t memory = 0;
+	for (const TextureMip& mip : texture.mips) {
+		MipLayout layout;
+		layout.offset = stagingSize;
+		layout.rowBytes = compressed ? blockCount(mip.width) * 16 : mip.width * 4;
+		layout.bytesPerRow = (layout.rowBytes + 255) & ~255u;
+		layout.rows = compressed ? blockCount(mip.height) : mip.height;
+		stagingSize += (static_cast<uint64_t>(layout.bytesPerRow) * layout.rows + 255) & ~uint64_t(255);
+		memory += static_cast<uint64_t>(layout.rowBytes) * layout.rows;
+		layouts.push_back(layout);
+	}
+	if (generateMips) {
+		// GPU 生成的各级约为第 0 级的 1/3
+		memory += memory / 3;
+	}
+
+	wgpu::BufferDescriptor bufferDesc;
+	bufferDesc.size = stagingSize;
+	bufferDesc.usage = wgpu::BufferUsage::MapWrite | wgpu::BufferUsage::CopySrc;
+	bufferDesc.mappedAtCreation = true;
+	wgpu::Buffer staging = device.createBuffer(bufferDesc);
+	uint8_t* mapped = static_cast<uint8_t*>(staging.getMappedRange(0, bufferDesc.size));
+	for (size_t level = 0; level < texture.mips.size(); ++level) {
+		const MipLayout& layout = layouts[level];
+		for (uint32_t row = 0; row < layout.rows; ++row) {
+			std::memcpy(mapped + layout.offset + static_cast<size_t>(row) * layout.bytesPerRow,
+				texture.mips[level].data.data() + static_cast<size_t>(row) * layout.rowBytes, layout.rowBytes);
+		}
+	}
+	staging.unmap();
+	stagingBuffers.push_back(staging);
+
+	for (size_t level = 0; level < texture.mips.size(); ++level) {
+		const TextureMip& mip = texture.mips[level];
+		wgpu::ImageCopyBuffer source;
+		source.buffer = staging;
+		source.layout.offset = layouts[level].offset;
+		source.layout.bytesPerRow = layouts[level].bytesPerRow;
+		source.layout.rowsPerImage = layouts[level].rows;
+		wgpu::ImageCopyTexture destination;
+		destination.texture = entry.texture;
+		destination.mipLevel = static_cast<uint32_t>(level);
+		destination.origin = { 0, 0, 0 };
+		destination.aspect = wgpu::TextureAspect::All;
+		// 块压缩纹理的拷贝范围必须是整块（小于 4 的 mip 按物理尺寸拷贝）
+		wgpu::Extent3D copySize = compressed
+			? wgpu::Extent3D(blockCount(mip.width) * 4, blockCount(mip.height) * 4, 1)
+			: wgpu::Extent3D(mip.width, mip.height, 1);
+		encoder.copyBufferToTexture(source, destination, copySize);
+	}
+
+	if (generateMips) {
+		GenerateMipmaps(encoder, entry, base.width, base.height, mipLevelCount);
+	}
+
+	entry.view = createMipView(entry.texture, 0, mipLevelCount, format);
+	entry.ready = true;
+	textureMemory += memory;
+	LOG("Texture %s: %ux%u %s, %u mip levels, %.1f KB (total %.1f KB)\n", entry.path.string().c_str(), base.width, base.height,
+		textureCodecFormatName(texture.format), mipLevelCount, memory / 1024.0, textureMemory / 1024.0);
+}
+
+void TextureManager::GenerateMipmaps(wgpu::CommandEncoder& encoder, TextureEntry& entry, uint32_t width, uint32_t height, uint32_t mipLevelCount) {
+	if (mipLevelCount <= 1) {
+		return;
+	}
+
+	// 每一级一个只含单个 mip 的视图
+	std::vector<wgpu::TextureView> mipViews(mipLevelCount, nullptr);
+	for (uint32_t level = 0; level < mipLevelCount; ++level) {
+		mipViews[level] = createMipView(entry.texture, level, 1);
+	}
+
+	ComputePass computePass(encoder, "Mipmap generation pass");
+
+	std::vector<wgpu::BindGroup> bindGroups;
+	for (uint32_t level = 1; level < mipLevelCount; ++level) {
+		ComputeResource resources[] = { ComputeResource::Texture(mipViews[level - 1]), ComputeResource::Texture(mipViews[level]) };
+		wgpu::BindGroup bindGroup = mipmapKernel.CreateBindGroup(resources);
+		bindGroups.push_back(bindGroup);
+
+		// 同一个计算通道内相邻两次分发对同一子资源的读写由 WebGPU 自动同步
+		uint32_t levelWidth = std::max(1u, width >> level);
+		uint32_t levelHeight = std::max(1u, height >> level);
+		computePass.DispatchThreads(mipmapKernel, bindGroup, levelWidth, levelHeight);
+	}
+	computePass.End();
+
+	for (wgpu::BindGroup& bindGroup : bindGroups) {
+		bindGroup.release();
+	}
+	for (wgpu::TextureView& view : mipViews) {
+		view.release();
+	}
+}
+
+void TextureManager::WaitAll() {
+	while (pendingCount > 0) {
+		if (!workers.empty()) {
+			std::unique_lock<std::mutex> lock(mutex);
+			resultAvailable.wait(lock, [this]() { return !results.empty(); });
+		}
+		Update();
+	}
+}
+
+bool TextureManager::IsReady(TextureHandle handle) const {
+	return handle < textures.size() && textures[handle].ready;
+}
+
+wgpu::TextureView TextureManager::GetView(TextureHandle handle) const {
+	return IsReady(handle) ? textures[handle].view : placeholderView;
+}
+
+void TextureManager::Terminate() {
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		stopping = true;
+		jobs.clear();
+	}
+	jobAvailable.notify_all();
+	for (std::thread& worker : workers) {
+		worker.join();
+	}
+	workers.clear();
+	results.clear();
+	pendingCount = 0;
+
+	for (TextureEntry& entry : textures) {
+		if (entry.texture) {
+			entry.view.release();
+			entry.texture.destroy();
+			entry.texture.release();
+		}
+	}
+	textures.clear();
+	handlesByPath.clear();
+	textureMemory = 0;
+
+	if (placeholderTexture) {
+		placeholderView.release();
+		placeholderTexture.destroy();
+		placeholderTexture.release();
+		placeholderTexture = nullptr;
+	}
+	if (sampler) {
+		sampler.release();
+		sampler = nullptr;
+	}
+	mipmapKernel.Terminate();
+}
+
+}
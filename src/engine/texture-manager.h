@@ -0,0 +1,118 @@
+#pragma once
+
+#include "../utils/global.h"
+#include "../utils/texture-baker.h"
+#include "compute.h"
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+
+namespace webgpu {
+
+// 纹理句柄，同一路径的多次加载返回同一个句柄
+using TextureHandle = uint32_t;
+constexpr TextureHandle kInvalidTexture = ~0u;
+
+/**
+ * 纹理管理器
+ * 图像在工作线程上解码，主线程经 staging buffer 上传到 GPU，mipmap 由计算着色器逐级生成。
+ * 源图旁边有烘焙好的 .wtex 时优先使用，按设备特性选择 BC7 > ETC2 > RGBA8（CPU 转码），mip 链直接上传。
+ * 纹理按规范化后的路径去重，多个材质可以共享同一个句柄。
+ * 解码完成前（或失败时）GetView 返回 1x1 的白色占位纹理。
+ */
+class TextureManager {
+public:
+	/**
+	 * @brief 创建 mipmap 管线、采样器和占位纹理，启动工作线程
+	 * @param shaderDirectory mipmap.wgsl 所在目录
+	 * @param workerCount 工作线程数，0 表示按硬件线程数自动选择
+	 */
+	void Initialize(wgpu::Device device, wgpu::Queue queue, const std::filesystem::path& shaderDirectory, uint32_t workerCount = 0);
+
+	/**
+	 * @brief 异步加载纹理（立即返回）
+	 */
+	TextureHandle Load(const std::filesystem::path& path);
+
+	/**
+	 * @brief 上传已经解码完成的纹理并生成 mipmap，每帧在主线程调用
+	 * @return 本次变为可用的纹理数
+	 */
+	uint32_t Update();
+
+	/**
+	 * @brief 阻塞直到所有已提交的加载都完成上传
+	 */
+	void WaitAll();
+
+	/**
+	 * @brief 纹理是否已上传
+	 */
+	bool IsReady(TextureHandle handle) const;
+
+	/**
+	 * @brief 纹理视图（包含全部 mip），未就绪时为占位纹理
+	 */
+	wgpu::TextureView GetView(TextureHandle handle) const;
+
+	/**
+	 * @brief 所有纹理共用的三线性重复采样器
+	 */
+	wgpu::Sampler GetSampler() const { return sampler; }
+
+	/**
+	 * @brief 停止工作线程并销毁所有纹理
+	 */
+	void Terminate();
+
+private:
+	struct TextureEntry {
+		std::filesystem::path path;
+		wgpu::Texture texture = nullptr;
+		wgpu::TextureView view = nullptr;
+		bool ready = false;
+	};
+
+	struct DecodeResult {
+		TextureHandle handle = kInvalidTexture;
+		bool success = false;
+		// 源图解码时只有一级 mip，其余由 GPU 生成
+		BakedTexture texture;
+	};
+
+	void WorkerLoop();
+	void Decode(const std::filesystem::path& path, DecodeResult& result) const;
+	void Upload(wgpu::CommandEncoder& encoder, TextureEntry& entry, const BakedTexture& texture, std::vector<wgpu::Buffer>& stagingBuffers);
+	void GenerateMipmaps(wgpu::CommandEncoder& encoder, TextureEntry& entry, uint32_t width, uint32_t height, uint32_t mipLevelCount);
+
+	wgpu::Device device = nullptr;
+	wgpu::Queue queue = nullptr;
+	ComputeKernel mipmapKernel;
+	wgpu::Sampler sampler = nullptr;
+	wgpu::Texture placeholderTexture = nullptr;
+	wgpu::TextureView placeholderView = nullptr;
+	// 设备支持的块压缩格式，按优先级排列
+	std::vector<TextureCodecFormat> compressedFormats;
+	// 已上传纹理占用的显存（字节）
+	uint64_t textureMemory = 0;
+
+	std::vector<TextureEntry> textures;
+	std::unordered_map<std::string, TextureHandle> handlesByPath;
+
+	// 工作线程共享的状态，由 mutex 保护
+	std::vector<std::thread> workers;
+	std::mutex mutex;
+	std::condition_variable jobAvailable;
+	std::condition_variable resultAvailable;
+	std::deque<std::pair<TextureHandle, std::filesystem::path>> jobs;
+	std::vector<DecodeResult> results;
+	bool stopping = false;
+	// 已提交但还没上传的加载数，只在主线程访问
+	uint32_t pendingCount = 0;
+};
+
+}
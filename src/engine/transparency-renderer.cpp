@@ -0,0 +1,152 @@
+#include "transparency-renderer.h"
+#include "../utils/utils.h"
+
+namespace webgpu {
+
+RenderTargetDesc TransparencyRenderer::AccumulationDesc() {
+	RenderTargetDesc desc;
+	desc.format = wgpu::TextureFormat::RGBA16Float;
+	desc.usage = wgpu::TextureUsage::RenderAttachment | wgpu::TextureUsage::TextureBinding;
+	return desc;
+}
+
+RenderTargetDesc TransparencyRenderer::RevealageDesc() {
+	RenderTargetDesc desc;
+	desc.format = wgpu::TextureFormat::R8Unorm;
+	desc.usage = wgpu::TextureUsage::RenderAttachment | wgpu::TextureUsage::TextureBinding;
+	return desc;
+}
+
+void TransparencyRenderer::FillAccumulationTargets(std::span<wgpu::ColorTargetState> targets) {
+	// ColorTargetState 只保存混合状态的指针，混合状态放在成员里
+	accumulationBlend.color.srcFactor = wgpu::BlendFactor::One;
+	accumulationBlend.color.dstFactor = wgpu::BlendFactor::One;
+	accumulationBlend.color.operation = wgpu::BlendOperation::Add;
+	accumulationBlend.alpha.srcFactor = wgpu::BlendFactor::One;
+	accumulationBlend.alpha.dstFactor = wgpu::BlendFactor::One;
+	accumulationBlend.alpha.operation = wgpu::BlendOperation::Add;
+	revealageBlend.color.srcFactor = wgpu::BlendFactor::Zero;
+	revealageBlend.color.dstFactor = wgpu::BlendFactor::OneMinusSrc;
+	revealageBlend.color.operation = wgpu::BlendOperation::Add;
+	revealageBlend.alpha.srcFactor = wgpu::BlendFactor::Zero;
+	revealageBlend.alpha.dstFactor = wgpu::BlendFactor::OneMinusSrc;
+	revealageBlend.alpha.operation = wgpu::BlendOperation::Add;
+
+	targets[0].format = AccumulationDesc().format;
+	targets[0].blend = &accumulationBlend;
+	targets[0].writeMask = wgpu::ColorWriteMask::All;
+	targets[1].format = RevealageDesc().format;
+	targets[1].blend = &revealageBlend;
+	targets[1].writeMask = wgpu::ColorWriteMask::Red;
+}
+
+void TransparencyRenderer::Initialize(wgpu::Device device, const std::filesystem::path& shaderPath, wgpu::TextureFormat targetFormat) {
+	this->device = device;
+
+	LOG("Creating transparency composite pipeline...\n");
+	wgpu::ShaderModule shaderModule = loadShaderModule(shaderPath, device);
+
+	// 绑定布局：累积、透过率（只用 textureLoad 读取）
+	std::vector<wgpu::BindGroupLayoutEntry> layoutEntries(2, wgpu::Default);
+	for (uint32_t binding = 0; binding < 2; ++binding) {
+		layoutEntries[binding].binding = binding;
+		layoutEntries[binding].visibility = wgpu::ShaderStage::Fragment;
+		layoutEntries[binding].texture.sampleType = wgpu::TextureSampleType::UnfilterableFloat;
+		layoutEntries[binding].texture.viewDimension = wgpu::TextureViewDimension::_2D;
+	}
+	wgpu::BindGroupLayoutDescriptor bindGroupLayoutDesc{};
+	bindGroupLayoutDesc.entryCount = (uint32_t)layoutEntries.size();
+	bindGroupLayoutDesc.entries = layoutEntries.data();
+	bindGroupLayout = device.createBindGroupLayout(bindGroupLayoutDesc);
+
+	wgpu::PipelineLayoutDescriptor layoutDesc{};
+	layoutDesc.bindGroupLayoutCount = 1;
+	layoutDesc.bindGroupLayouts = (WGPUBindGroupLayout*)&bindGroupLayout;
+	wgpu::PipelineLayout layout = device.createPipelineLayout(layoutDesc);
+
+	// 加权平均的颜色按 1 - 透过率 覆盖到不透明结果上
+	wgpu::BlendState blendState{};
+	blendState.color.srcFactor = wgpu::BlendFactor::SrcAlpha;
+	blendState.color.dstFactor = wgpu::BlendFactor::OneMinusSrcAlpha;
+	blendState.color.operation = wgpu::BlendOperation::Add;
+	blendState.alpha.srcFactor = wgpu::BlendFactor::Zero;
+	blendState.alpha.dstFactor = wgpu::BlendFactor::One;
+	blendState.alpha.operation = wgpu::BlendOperation::Add;
+	wgpu::ColorTargetState colorTarget;
+	colorTarget.format = targetFormat;
+	colorTarget.blend = &blendState;
+	colorTarget.writeMask = wgpu::ColorWriteMask::All;
+
+	wgpu::FragmentState fragmentState;
+	fragmentState.module = shaderModule;
+	fragmentState.entryPoint = "fs_main";
+	fragmentState.constantCount = 0;
+	fragmentState.constants = nullptr;
+	fragmentState.targetCount = 1;
+	fragmentState.targets = &colorTarget;
+
+	// 全屏三角形，顶点由 vertex_index 生成
+	wgpu::RenderPipelineDescriptor pipelineDesc = {};
+	pipelineDesc.layout = layout;
+	pipelineDesc.vertex.module = shaderModule;
+	pipelineDesc.vertex.entryPoint = "vs_main";
+	pipelineDesc.vertex.constantCount = 0;
+	pipelineDesc.vertex.constants = nullptr;
+	pipelineDesc.vertex.bufferCount = 0;
+	pipelineDesc.vertex.buffers = nullptr;
+	pipelineDesc.primitive.topology = wgpu::PrimitiveTopology::TriangleList;
+	pipelineDesc.primitive.stripIndexFormat = wgpu::IndexFormat::Undefined;
+	pipelineDesc.primitive.frontFace = wgpu::FrontFace::CCW;
+	pipelineDesc.primitive.cullMode = wgpu::CullMode::None;
+	pipelineDesc.fragment = &fragmentState;
+	pipelineDesc.depthStencil = nullptr;
+	pipelineDesc.multisample.count = 1;
+	pipelineDesc.multisample.mask = ~0u;
+	pipelineDesc.multisample.alphaToCoverageEnabled = false;
+	compositePipeline = device.createRenderPipeline(pipelineDesc);
+	checkNullPointerError(compositePipeline, "transparency composite pipeline");
+
+	layout.release();
+	shaderModule.release();
+}
+
+void TransparencyRenderer::Composite(wgpu::RenderPassEncoder& renderPass, wgpu::TextureView accumulationView, wgpu::TextureView revealageView) {
+	if (!bindGroup || boundAccumulationView != static_cast<WGPUTextureView>(accumulationView)
+		|| boundRevealageView != static_cast<WGPUTextureView>(revealageView)) {
+		if (bindGroup) {
+			bindGroup.release();
+		}
+		std::vector<wgpu::BindGroupEntry> bindings(2);
+		bindings[0].binding = 0;
+		bindings[0].textureView = accumulationView;
+		bindings[1].binding = 1;
+		bindings[1].textureView = revealageView;
+		wgpu::BindGroupDescriptor bindGroupDesc;
+		bindGroupDesc.layout = bindGroupLayout;
+		bindGroupDesc.entryCount = (uint32_t)bindings.size();
+		bindGroupDesc.entries = bindings.data();
+		bindGroup = device.createBindGroup(bindGroupDesc);
+		boundAccumulationView = accumulationView;
+		boundRevealageView = revealageView;
+	}
+	renderPass.setPipeline(compositePipeline);
+	renderPass.setBindGroup(0, bindGroup, 0, nullptr);
+	renderPass.draw(3, 1, 0, 0);
+}
+
+void TransparencyRenderer::Terminate() {
+	if (!compositePipeline) {
+		return;
+	}
+	if (bindGroup) {
+		bindGroup.release();
+		bindGroup = nullptr;
+		boundAccumulationView = nullptr;
+		boundRevealageView = nullptr;
+	}
+	bindGroupLayout.release();
+	compositePipeline.release();
+	compositePipeline = nullptr;
+}
+
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+#include "../utils/global.h"
+#include "render-target-pool.h"
+
+namespace webgpu {
+
+/**
+ * 加权混合的顺序无关透明（Weighted Blended OIT, McGuire & Bavoil 2013）
+ * 透明物体在单独的通道中绘制（深度只测试不写入），片元输出到两个附件：
+ *   累积（RGBA16Float，One/One 相加）：预乘 alpha 的颜色与 alpha，乘以随深度衰减的权重；
+ *   透过率（R8Unorm，Zero/OneMinusSrc 相乘）：所有片元 (1 - alpha) 的乘积。
+ * 两者都与绘制顺序无关，不需要每帧在 CPU 上按深度排序；最后用一个全屏三角形把加权平均的颜色混合到不透明结果上。
+ */
+class TransparencyRenderer {
+public:
+	/**
+	 * @brief 累积与透过率附件的描述（宽高由帧图按交换链尺寸填写）
+	 */
+	static RenderTargetDesc AccumulationDesc();
+	static RenderTargetDesc RevealageDesc();
+
+	/**
+	 * @brief 填写透明通道的两个颜色目标（格式与混合方式），供使用场景着色器的透明管线使用
+	 * @param targets 至少两个元素，引用本对象中的混合状态
+	 */
+	void FillAccumulationTargets(std::span<wgpu::ColorTargetState> targets);
+
+	/**
+	 * @brief 创建合成管线
+	 * @param shaderPath oit-composite.wgsl 路径
+	 * @param targetFormat 合成目标（交换链）的格式
+	 */
+	void Initialize(wgpu::Device device, const std::filesystem::path& shaderPath, wgpu::TextureFormat targetFormat);
+
+	/**
+	 * @brief 把累积结果合成到当前渲染通道的颜色附件上
+	 * 附件来自渲染目标池，视图不变时复用绑定组
+	 */
+	void Composite(wgpu::RenderPassEncoder& renderPass, wgpu::TextureView accumulationView, wgpu::TextureView revealageView);
+
+	/**
+	 * @brief 销毁
+	 */
+	void Terminate();
+
+	/**
+	 * @brief 是否已初始化
+	 */
+	bool IsReady() const { return compositePipeline != nullptr; }
+
+private:
+	wgpu::Device device = nullptr;
+	wgpu::BlendState accumulationBlend{};
+	wgpu::BlendState revealageBlend{};
+	wgpu::RenderPipeline compositePipeline = nullptr;
+	wgpu::BindGroupLayout bindGroupLayout = nullptr;
+	wgpu::BindGroup bindGroup = nullptr;
+	WGPUTextureView boundAccumulationView = nullptr;
+	WGPUTextureView boundRevealageView = nullptr;
+};
+
+}
@@ -0,0 +1,80 @@
+#include "uniform-buffer.h"
+
+#include <algorithm>
+
+namespace webgpu {
+
+UniformDirtyTracker::UniformDirtyTracker(std::span<const UniformField> layout, uint32_t blockSize)
+	: fields(layout.begin(), layout.end()), dirty(layout.size(), 0), blockSize(blockSize) {
+	std::sort(fields.begin(), fields.end(), [](const UniformField& a, const UniformField& b) { return a.offset < b.offset; });
+	for (const UniformField& field : fields) {
+		if (field.offset % 4 != 0 || field.size % 4 != 0 || field.offset + field.size > blockSize) {
+			throw std::runtime_error(std::string("Uniform field '") + field.name + "' is not 4-byte aligned or exceeds the block");
+		}
+	}
+	ranges.reserve(fields.size());
+}
+
+void UniformDirtyTracker::MarkDirty(uint32_t offset, uint32_t size) {
+	bool found = false;
+	for (size_t i = 0; i < fields.size(); ++i) {
+		const UniformField& field = fields[i];
+		if (field.offset < offset + size && offset < field.offset + field.size) {
+			found = true;
+			if (!dirty[i]) {
+				dirty[i] = 1;
+				++dirtyCount;
+			}
+		}
+	}
+	// 布局中没有的部分，保守地整块上传
+	if (!found) {
+		allDirty = true;
+	}
+}
+
+void UniformDirtyTracker::MarkAll() {
+	allDirty = true;
+}
+
+void UniformDirtyTracker::Clear() {
+	std::fill(dirty.begin(), dirty.end(), 0);
+	dirtyCount = 0;
+	allDirty = false;
+}
+
+std::span<const UniformRange> UniformDirtyTracker::TakeRanges() {
+	ranges.clear();
+	if (allDirty) {
+		ranges.push_back({ 0, blockSize });
+	} else {
+		for (size_t i = 0; i < fields.size(); ++i) {
+			if (!dirty[i]) {
+				continue;
+			}
+			// 上一个范围紧接着的字段（中间没有干净的字段）并入同一个范围，顺带上传中间的填充
+			uint32_t end = fields[i].offset + fields[i].size;
+			if (!ranges.empty() && i > 0 && dirty[i - 1]) {
+				ranges.back().size = end - ranges.back().offset;
+			} else {
+				ranges.push_back({ fields[i].offset, fields[i].size });
+			}
+		}
+	}
+	Clear();
+	return ranges;
+}
+
+uint32_t BufferWriteCache::Write(wgpu::Queue queue, wgpu::Buffer buffer, uint64_t offset, const void* data, size_t size) {
+	const std::byte* bytes = static_cast<const std::byte*>(data);
+	if (valid && lastWritten.size() == size && std::memcmp(lastWritten.data(), bytes, size) == 0) {
+		return 0;
+	}
+	queue.writeBuffer(buffer, offset, data, size);
+	// 容量只增不减，稳定后不再分配
+	lastWritten.assign(bytes, bytes + size);
+	valid = true;
+	return 1;
+}
+
+}
@@ -0,0 +1,156 @@
+#pragma once
+
+#include "../utils/global.h"
+#include "../utils/data-structure.h"
+
+#include <cstring>
+
+namespace webgpu {
+
+/**
+ * 一次上传的字节范围
+ */
+struct UniformRange {
+	uint32_t offset = 0;
+	uint32_t size = 0;
+};
+
+/**
+ * 按字段记录 uniform 块中被修改的部分
+ * 字段按偏移排序，取出时把布局中相邻的脏字段（中间只隔着填充）合并成一个范围，
+ * 被干净字段隔开的脏字段分成多个范围
+ */
+class UniformDirtyTracker {
+public:
+	/**
+	 * @param layout 反射得到的字段布局（偏移和大小为 4 的倍数）
+	 * @param blockSize uniform 块的大小
+	 */
+	UniformDirtyTracker(std::span<const UniformField> layout, uint32_t blockSize);
+
+	/**
+	 * @brief 标记与 [offset, offset + size) 重叠的字段
+	 */
+	void MarkDirty(uint32_t offset, uint32_t size);
+
+	/**
+	 * @brief 标记整个块（不依赖字段布局，覆盖填充）
+	 */
+	void MarkAll();
+
+	/**
+	 * @brief 清除所有标记
+	 */
+	void Clear();
+
+	bool IsDirty() const { return dirtyCount > 0 || allDirty; }
+
+	/**
+	 * @brief 合并后的脏范围（按偏移排序），并清除标记，返回的视图在下次调用前有效
+	 */
+	std::span<const UniformRange> TakeRanges();
+
+private:
+	std::vector<UniformField> fields;
+	std::vector<uint8_t> dirty;
+	std::vector<UniformRange> ranges;
+	uint32_t blockSize = 0;
+	uint32_t dirtyCount = 0;
+	bool allDirty = false;
+};
+
+/**
+ * 记住上一次写入缓冲区某个位置的内容，内容不变时跳过 writeBuffer
+ * 用于每帧都要录制、但画面静止时参数不变的上传（剔除参数、光源、阴影矩阵等），一个实例对应一个 (缓冲区, 偏移)
+ */
+class BufferWriteCache {
+public:
+	/**
+	 * @brief 内容（字节和大小）与上次写入的不同时上传并记下，返回 writeBuffer 的次数（0 或 1）
+	 */
+	uint32_t Write(wgpu::Queue queue, wgpu::Buffer buffer, uint64_t offset, const void* data, size_t size);
+
+	/**
+	 * @brief 丢弃记录，下次 Write 一定上传（缓冲区重建之后）
+	 */
+	void Reset() { valid = false; }
+
+private:
+	std::vector<std::byte> lastWritten;
+	bool valid = false;
+};
+
+/**
+ * 带脏标记的 uniform 缓冲区
+ * CPU 端保存一份 T，Set 只在值真正变化时标记对应字段，Flush 时把相邻的脏字段合并成尽量少的 writeBuffer，
+ * 没有变化的帧不上传。Initialize 之前的修改随初始数据一起上传。
+ */
+template <typename T>
+class UniformBuffer {
+public:
+	explicit UniformBuffer(std::span<const UniformField> layout) : tracker(layout, static_cast<uint32_t>(sizeof(T))) {}
+
+	/**
+	 * @brief 创建缓冲区并上传当前数据
+	 */
+	void Initialize(wgpu::Device device, wgpu::Queue queue, const char* label) {
+		this->queue = queue;
+		wgpu::BufferDescriptor bufferDesc;
+		bufferDesc.label = label;
+		bufferDesc.size = sizeof(T);
+		bufferDesc.usage = wgpu::BufferUsage::CopyDst | wgpu::BufferUsage::Uniform;
+		bufferDesc.mappedAtCreation = false;
+		buffer = device.createBuffer(bufferDesc);
+		checkNullPointerError(buffer, label);
+		queue.writeBuffer(buffer, 0, &data, sizeof(T));
+		tracker.Clear();
+	}
+
+	/**
+	 * @brief 修改一个字段，值不变时不标记
+	 */
+	template <typename Field>
+	void Set(Field T::* member, const Field& value) {
+		Field& current = data.*member;
+		if (std::memcmp(&current, &value, sizeof(Field)) == 0) {
+			return;
+		}
+		current = value;
+		uint32_t offset = static_cast<uint32_t>(reinterpret_cast<const std::byte*>(&current) - reinterpret_cast<const std::byte*>(&data));
+		tracker.MarkDirty(offset, sizeof(Field));
+	}
+
+	const T& Get() const { return data; }
+
+	/**
+	 * @brief 上传本帧修改过的范围，返回 writeBuffer 的次数（没有修改时为 0）
+	 */
+	uint32_t Flush() {
+		if (!buffer || !tracker.IsDirty()) {
+			return 0;
+		}
+		std::span<const UniformRange> ranges = tracker.TakeRanges();
+		for (const UniformRange& range : ranges) {
+			queue.writeBuffer(buffer, range.offset, reinterpret_cast<const std::byte*>(&data) + range.offset, range.size);
+		}
+		return static_cast<uint32_t>(ranges.size());
+	}
+
+	wgpu::Buffer GetBuffer() const { return buffer; }
+
+	void Terminate() {
+		if (buffer) {
+			buffer.destroy();
+			buffer.release();
+			buffer = nullptr;
+		}
+	}
+
+private:
+	T data = {};
+	UniformDirtyTracker tracker;
+	wgpu::Queue queue = nullptr;
+	wgpu::Buffer buffer = nullptr;
+};
+
+}
@@ -0,0 +1,639 @@
+#include "virtual-texture.h"
+#include "../utils/texture-codec.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+namespace webgpu {
+
+namespace {
+
+constexpr uint16_t kNoPage = 0xFFFF;
+// 每帧最多上传的页数和最多发出的加载请求数，避免卡顿
+constexpr uint32_t kMaxUploadsPerFrame = 16;
+constexpr uint32_t kMaxRequestsPerFrame = 32;
+// 反馈每 16 帧覆盖全部像素，这段时间内用过的页不淘汰
+constexpr uint64_t kEvictionGraceFrames = 16;
+
+uint64_t pageKey(VirtualTextureHandle texture, uint32_t mip, uint32_t x, uint32_t y) {
+	return (static_cast<uint64_t>(texture) << 48) | (static_cast<uint64_t>(mip) << 40) | (static_cast<uint64_t>(x) << 20) | y;
+}
+
+wgpu::Texture createPageTableTexture(wgpu::Device device, uint32_t width, uint32_t height, uint32_t mipLevelCount) {
+	wgpu::TextureDescriptor textureDesc;
+	textureDesc.dimension = wgpu::TextureDimension::_2D;
+	textureDesc.format = wgpu::TextureFormat::RGBA8Uint;
+	textureDesc.mipLevelCount = mipLevelCount;
+	textureDesc.sampleCount = 1;
+	textureDesc.size = { width, height, 1 };
+	textureDesc.usage = wgpu::TextureUsage::TextureBinding | wgpu::TextureUsage::CopyDst;
+	textureDesc.viewFormatCount = 0;
+	textureDesc.viewFormats = nullptr;
+	return device.createTexture(textureDesc);
+}
+
+wgpu::TextureView createFullView(wgpu::Texture texture, wgpu::TextureFormat format, uint32_t mipLevelCount) {
+	wgpu::TextureViewDescriptor viewDesc;
+	viewDesc.aspect = wgpu::TextureAspect::All;
+	viewDesc.baseArrayLayer = 0;
+	viewDesc.arrayLayerCount = 1;
+	viewDesc.baseMipLevel = 0;
+	viewDesc.mipLevelCount = mipLevelCount;
+	viewDesc.dimension = wgpu::TextureViewDimension::_2D;
+	viewDesc.format = format;
+	return texture.createView(viewDesc);
+}
+
+wgpu::Buffer createUniformBuffer(wgpu::Device device, wgpu::Queue queue, const VirtualTextureUniform& uniform) {
+	wgpu::BufferDescriptor bufferDesc;
+	bufferDesc.size = sizeof(VirtualTextureUniform);
+	bufferDesc.usage = wgpu::BufferUsage::CopyDst | wgpu::BufferUsage::Uniform;
+	bufferDesc.mappedAtCreation = false;
+	wgpu::Buffer buffer = device.createBuffer(bufferDesc);
+	queue.writeBuffer(buffer, 0, &uniform, sizeof(VirtualTextureUniform));
+	return buffer;
+}
+
+}
+
+void VirtualTextureSystem::Initialize(wgpu::Device device, wgpu::Queue queue, uint32_t pagesPerSide, uint32_t feedbackBits) {
+	CreateResources(device, queue, pagesPerSide, feedbackBits);
+
+	wgpu::BufferDescriptor bufferDesc;
+	bufferDesc.size = feedbackBufferSize;
+	bufferDesc.usage = wgpu::BufferUsage::MapRead | wgpu::BufferUsage::CopyDst;
+	bufferDesc.mappedAtCreation = false;
+	for (FeedbackReadback& readback : readbacks) {
+		readback.buffer = device.createBuffer(bufferDesc);
+		readback.state = ReadbackState::Idle;
+	}
+
+#ifndef __EMSCRIPTEN__
+	// 浏览器里没有线程时在 Update 中同步加载
+	stopping = false;
+	workers.emplace_back(&VirtualTextureSystem::WorkerLoop, this);
+#endif
+	LOG("Virtual texture: %ux%u page atlas (%.1f MB), %u feedback bits\n", pagesPerSide, pagesPerSide,
+		pagesPerSide * kPageSize * pagesPerSide * kPageSize * 4 / (1024.0 * 1024.0), feedbackBits);
+}
+
+void VirtualTextureSystem::InitializePlaceholders(wgpu::Device device, wgpu::Queue queue) {
+	CreateResources(device, queue, 1, 32);
+}
+
+void VirtualTextureSystem::CreateResources(wgpu::Device device, wgpu::Queue queue, uint32_t pagesPerSide, uint32_t feedbackBits) {
+	this->device = device;
+	this->queue = queue;
+	this->pagesPerSide = pagesPerSide;
+
+	// 物理页图集
+	wgpu::TextureDescriptor textureDesc;
+	textureDesc.dimension = wgpu::TextureDimension::_2D;
+	textureDesc.format = wgpu::TextureFormat::RGBA8Unorm;
+	textureDesc.mipLevelCount = 1;
+	textureDesc.sampleCount = 1;
+	textureDesc.size = { pagesPerSide * kPageSize, pagesPerSide * kPageSize, 1 };
+	textureDesc.usage = wgpu::TextureUsage::TextureBinding | wgpu::TextureUsage::CopyDst;
+	textureDesc.viewFormatCount = 0;
+	textureDesc.viewFormats = nullptr;
+	atlas = device.createTexture(textureDesc);
+	atlasView = createFullView(atlas, wgpu::TextureFormat::RGBA8Unorm, 1);
+	pages.assign(pagesPerSide * pagesPerSide, {});
+	freePages.clear();
+	for (uint32_t i = static_cast<uint32_t>(pages.size()); i-- > 0;) {
+		freePages.push_back(i);
+	}
+
+	// 反馈位图（回读缓冲区在 Initialize 中创建）
+	feedbackBufferSize = ((feedbackBits + 31) / 32) * sizeof(uint32_t);
+	wgpu::BufferDescriptor bufferDesc;
+	bufferDesc.size = feedbackBufferSize;
+	bufferDesc.usage = wgpu::BufferUsage::Storage | wgpu::BufferUsage::CopySrc | wgpu::BufferUsage::CopyDst;
+	bufferDesc.mappedAtCreation = false;
+	feedbackBuffer = device.createBuffer(bufferDesc);
+	feedbackBitsUsed = 0;
+
+	emptyPageTable = createPageTableTexture(device, 1, 1, 1);
+	emptyPageTableView = createFullView(emptyPageTable, wgpu::TextureFormat::RGBA8Uint, 1);
+	VirtualTextureUniform emptyUniform;
+	emptyUniform.tileSize = kTileSize;
+	emptyUniform.pageBorder = kPageBorder;
+	emptyUniformBuffer = createUniformBuffer(device, queue, emptyUniform);
+}
+
+VirtualTextureHandle VirtualTextureSystem::Add(const std::filesystem::path& path) {
+	VirtualTextureHandle handle = static_cast<VirtualTextureHandle>(textures.size());
+	textures.push_back({});
+	textures.back().path = path;
+
+	std::lock_guard<std::mutex> lock(mutex);
+	sourcePaths.push_back(path);
+	sources.emplace_back();
+	jobs.push_back({ handle, -1, 0, 0 });
+	jobAvailable.notify_one();
+	return handle;
+}
+
+void VirtualTextureSystem::WorkerLoop() {
+	for (;;) {
+		LoadJob job;
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			jobAvailable.wait(lock, [this]() { return stopping || !jobs.empty(); });
+			if (stopping) {
+				return;
+			}
+			job = jobs.front();
+			jobs.pop_front();
+		}
+
+		LoadResult result = Process(job);
+
+		std::function<void()> notifier;
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			results.push_back(std::move(result));
+			notifier = loadNotifier;
+		}
+		if (notifier) {
+			notifier();
+		}
+	}
+}
+
+VirtualTextureSystem::LoadResult VirtualTextureSystem::Process(const LoadJob& job) {
+	LoadResult result;
+	result.job = job;
+
+	if (job.mip < 0) {
+		// 解码源图并在 CPU 上生成完整的 mip 链，之后的页都从这里切
+		Image image;
+		std::filesystem::path path;
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			path = sourcePaths[job.texture];
+		}
+		result.success = decodeImage(path, image);
+		if (result.success) {
+			result.width = image.width;
+			result.height = image.height;
+			auto chain = std::make_shared<std::vector<Image>>();
+			chain->push_back(std::move(image));
+			while (chain->back().width > 1 || chain->back().height > 1) {
+				chain->push_back(downsampleImage(chain->back()));
+			}
+			std::lock_guard<std::mutex> lock(mutex);
+			sources[job.texture] = std::move(chain);
+		}
+		return result;
+	}
+
+	std::shared_ptr<const std::vector<Image>> chain;
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		chain = sources[job.texture];
+	}
+	if (!chain || static_cast<size_t>(job.mip) >= chain->size()) {
+		return result;
+	}
+
+	// 切出一页（含边框），越界部分按重复寻址取对边的像素
+	const Image& level = (*chain)[job.mip];
+	result.pixels.resize(static_cast<size_t>(kPageSize) * kPageSize * 4);
+	int64_t originX = static_cast<int64_t>(job.x) * kTileSize - kPageBorder;
+	int64_t originY = static_cast<int64_t>(job.y) * kTileSize - kPageBorder;
+	for (uint32_t py = 0; py < kPageSize; ++py) {
+		int64_t sy = ((originY + py) % level.height + level.height) % level.height;
+		for (uint32_t px = 0; px < kPageSize; ++px) {
+			int64_t sx = ((originX + px) % level.width + level.width) % level.width;
+			std::memcpy(result.pixels.data() + (static_cast<size_t>(py) * kPageSize + px) * 4,
+				level.pixels.data() + (static_cast<size_t>(sy) * level.width + sx) * 4, 4);
+		}
+	}
+	result.success = true;
+	return result;
+}
+
+void VirtualTextureSystem::WaitUntilOpened() {
+	auto allOpened = [this]() {
+		return std::all_of(textures.begin(), textures.end(), [](const VirtualTexture& texture) { return texture.opened || texture.failed; });
+	};
+	while (!allOpened()) {
+		if (!workers.empty()) {
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		}
+		Update(frameIndex);
+	}
+}
+
+void VirtualTextureSystem::SetLoadNotifier(std::function<void()> notifier) {
+	std::lock_guard<std::mutex> lock(mutex);
+	loadNotifier = std::move(notifier);
+}
+
+void VirtualTextureSystem::PollFeedback() {
+	for (FeedbackReadback& readback : readbacks) {
+		if (readback.state == ReadbackState::Mapped) {
+			const uint32_t* words = static_cast<const uint32_t*>(readback.buffer.getConstMappedRange(0, feedbackBufferSize));
+			if (words) {
+				ProcessFeedback(words);
+			}
+			readback.buffer.unmap();
+			readback.state = ReadbackState::Idle;
+		}
+	}
+}
+
+bool VirtualTextureSystem::HasPendingUploads() {
+	std::lock_guard<std::mutex> lock(mutex);
+	return !results.empty() || (workers.empty() && !jobs.empty());
+}
+
+bool VirtualTextureSystem::HasReadbackInFlight() const {
+	return std::any_of(readbacks.begin(), readbacks.end(), [](const FeedbackReadback& readback) { return readback.state != ReadbackState::Idle; });
+}
+
+bool VirtualTextureSystem::Update(uint64_t frameIndex) {
+	this->frameIndex = frameIndex;
+
+	// 回读完成的反馈
+	PollFeedback();
+
+	// 没有加载线程时在这里同步处理一部分请求
+	if (workers.empty()) {
+		for (uint32_t i = 0; i < kMaxUploadsPerFrame; ++i) {
+			LoadJob job;
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				if (jobs.empty()) {
+					break;
+				}
+				job = jobs.front();
+				jobs.pop_front();
+			}
+			LoadResult result = Process(job);
+			std::lock_guard<std::mutex> lock(mutex);
+			results.push_back(std::move(result));
+		}
+	}
+
+	// 上传加载好的页，超出本帧配额的留到下一帧
+	std::vector<LoadResult> finished;
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		size_t count = std::min<size_t>(results.size(), kMaxUploadsPerFrame);
+		finished.assign(std::make_move_iterator(results.begin()), std::make_move_iterator(results.begin() + count));
+		results.erase(results.begin(), results.begin() + count);
+	}
+	for (const LoadResult& result : finished) {
+		if (result.job.mip < 0) {
+			OnTextureOpened(result);
+		} else {
+			OnPageLoaded(result);
+		}
+	}
+
+	uint32_t residentCount = 0;
+	for (const PhysicalPage& page : pages) {
+		residentCount += page.texture != kInvalidVirtualTexture;
+	}
+	if (residentCount != lastResidentCount) {
+		LOG("Virtual texture: %u/%zu pages resident\n", residentCount, pages.size());
+		lastResidentCount = residentCount;
+	}
+
+	bool pageTablesChanged = false;
+	for (VirtualTexture& texture : textures) {
+		if (texture.opened && texture.pageTableDirty) {
+			RebuildPageTable(texture);
+			pageTablesChanged = true;
+		}
+	}
+	// 新的页让画面变化，重新轮换一遍反馈，请求剩下缺的页
+	if (pageTablesChanged) {
+		RestartFeedbackSweep();
+	}
+	if (feedbackSweepFrames > 0) {
+		feedbackPhase = (feedbackPhase + 1) % kFeedbackPhases;
+		--feedbackSweepFrames;
+	}
+	for (VirtualTexture& texture : textures) {
+		if (texture.opened && texture.uniform.feedbackPhase != feedbackPhase) {
+			texture.uniform.feedbackPhase = feedbackPhase;
+			queue.writeBuffer(texture.uniformBuffer, offsetof(VirtualTextureUniform, feedbackPhase), &texture.uniform.feedbackPhase, sizeof(uint32_t));
+			++uploadCount;
+		}
+	}
+	return pageTablesChanged;
+}
+
+void VirtualTextureSystem::OnTextureOpened(const LoadResult& result) {
+	VirtualTexture& texture = textures[result.job.texture];
+	if (!result.success) {
+		LOG("Virtual texture %s failed to load\n", texture.path.string().c_str());
+		texture.failed = true;
+		return;
+	}
+
+	// 最粗的一级是整张图只占一页的那一级
+	texture.width = result.width;
+	texture.height = result.height;
+	texture.maxMip = 0;
+	while (texture.maxMip + 1 < kMaxMipLevels
+		&& std::max(std::max(1u, texture.width >> texture.maxMip), std::max(1u, texture.height >> texture.maxMip)) > kTileSize) {
+		++texture.maxMip;
+	}
+	uint32_t bitCount = 0;
+	uint32_t pageTableWidth = 1;
+	uint32_t pageTableHeight = 1;
+	texture.pageOfTile.assign(texture.maxMip + 1, {});
+	for (uint32_t mip = 0; mip <= texture.maxMip; ++mip) {
+		texture.tilesX[mip] = (std::max(1u, texture.width >> mip) + kTileSize - 1) / kTileSize;
+		texture.tilesY[mip] = (std::max(1u, texture.height >> mip) + kTileSize - 1) / kTileSize;
+		texture.feedbackOffset[mip] = feedbackBitsUsed + bitCount;
+		bitCount += texture.tilesX[mip] * texture.tilesY[mip];
+		texture.pageOfTile[mip].assign(texture.tilesX[mip] * texture.tilesY[mip], kNoPage);
+		// 间接纹理第 mip 级的尺寸是第 0 级右移 mip 位，要能放下该级的页数
+		pageTableWidth = std::max(pageTableWidth, texture.tilesX[mip] << mip);
+		pageTableHeight = std::max(pageTableHeight, texture.tilesY[mip] << mip);
+	}
+	if (feedbackBitsUsed + bitCount > feedbackBufferSize * 8) {
+		LOG("Virtual texture %s: feedback buffer is full\n", texture.path.string().c_str());
+		texture.failed = true;
+		return;
+	}
+	feedbackBitsUsed += bitCount;
+
+	texture.pageTable = createPageTableTexture(device, pageTableWidth, pageTableHeight, texture.maxMip + 1);
+	texture.pageTableView = createFullView(texture.pageTable, wgpu::TextureFormat::RGBA8Uint, texture.maxMip + 1);
+
+	texture.uniform.virtualSize = glm::vec2(texture.width, texture.height);
+	texture.uniform.atlasSize = glm::vec2(static_cast<float>(pagesPerSide * kPageSize));
+	texture.uniform.tileSize = kTileSize;
+	texture.uniform.pageBorder = kPageBorder;
+	texture.uniform.maxMip = texture.maxMip;
+	for (uint32_t mip = 0; mip <= texture.maxMip; ++mip) {
+		texture.uniform.mipFeedbackOffset[mip / 4][mip % 4] = texture.feedbackOffset[mip];
+	}
+	texture.uniformBuffer = createUniformBuffer(device, queue, texture.uniform);
+	++uploadCount;
+	texture.opened = true;
+	texture.pageTableDirty = true;
+
+	// 最粗一级常驻，保证任何位置都有可以回退的页
+	RequestPage(result.job.texture, texture.maxMip, 0, 0);
+
+	uint64_t fullSize = 0;
+	for (uint32_t mip = 0; mip <= texture.maxMip; ++mip) {
+		fullSize += static_cast<uint64_t>(std::max(1u, texture.width >> mip)) * std::max(1u, texture.height >> mip) * 4;
+	}
+	LOG("Virtual texture %s: %ux%u, %u mip levels, %u pages (%.1f KB if fully resident)\n", texture.path.string().c_str(),
+		texture.width, texture.height, texture.maxMip + 1, bitCount, fullSize / 1024.0);
+}
+
+void VirtualTextureSystem::OnPageLoaded(const LoadResult& result) {
+	const LoadJob& job = result.job;
+	pendingPages.erase(pageKey(job.texture, job.mip, job.x, job.y));
+	if (!result.success) {
+		return;
+	}
+	VirtualTexture& texture = textures[job.texture];
+	uint32_t index = job.y * texture.tilesX[job.mip] + job.x;
+	if (texture.pageOfTile[job.mip][index] != kNoPage) {
+		return;
+	}
+	uint32_t pageIndex = AllocatePage();
+	if (pageIndex == kNoPage) {
+		return;
+	}
+
+	PhysicalPage& page = pages[pageIndex];
+	page.texture = job.texture;
+	page.mip = job.mip;
+	page.x = job.x;
+	page.y = job.y;
+	page.lastUsed = frameIndex;
+	page.pinned = static_cast<uint32_t>(job.mip) == texture.maxMip;
+	texture.pageOfTile[job.mip][index] = static_cast<uint16_t>(pageIndex);
+	texture.pageTableDirty = true;
+
+	wgpu::ImageCopyTexture destination;
+	destination.texture = atlas;
+	destination.mipLevel = 0;
+	destination.origin = { (pageIndex % pagesPerSide) * kPageSize, (pageIndex / pagesPerSide) * kPageSize, 0 };
+	destination.aspect = wgpu::TextureAspect::All;
+	wgpu::TextureDataLayout source;
+	source.offset = 0;
+	source.bytesPerRow = kPageSize * 4;
+	source.rowsPerImage = kPageSize;
+	queue.writeTexture(destination, result.pixels.data(), result.pixels.size(), source, { kPageSize, kPageSize, 1 });
+	++uploadCount;
+}
+
+uint32_t VirtualTextureSystem::AllocatePage() {
+	if (!freePages.empty()) {
+		uint32_t pageIndex = freePages.back();
+		freePages.pop_back();
+		return pageIndex;
+	}
+
+	// 淘汰最久没有用到的页；最近还在用的页不淘汰，这一帧放弃加载
+	uint32_t victim = kNoPage;
+	for (uint32_t i = 0; i < pages.size(); ++i) {
+		const PhysicalPage& page = pages[i];
+		if (page.pinned || page.lastUsed + kEvictionGraceFrames >= frameIndex) {
+			continue;
+		}
+		if (victim == kNoPage || page.lastUsed < pages[victim].lastUsed) {
+			victim = i;
+		}
+	}
+	if (victim == kNoPage) {
+		return kNoPage;
+	}
+
+	PhysicalPage& page = pages[victim];
+	VirtualTexture& owner = textures[page.texture];
+	owner.pageOfTile[page.mip][page.y * owner.tilesX[page.mip] + page.x] = kNoPage;
+	owner.pageTableDirty = true;
+	page = {};
+	return victim;
+}
+
+void VirtualTextureSystem::ProcessFeedback(const uint32_t* words) {
+	// 先收集缺页，粗的 mip 优先加载，这样回退的画面尽快变清晰
+	struct Request {
+		VirtualTextureHandle texture;
+		uint32_t mip;
+		uint32_t x;
+		uint32_t y;
+	};
+	std::vector<Request> requests;
+	for (VirtualTextureHandle handle = 0; handle < textures.size(); ++handle) {
+		VirtualTexture& texture = textures[handle];
+		if (!texture.opened) {
+			continue;
+		}
+		for (uint32_t mip = 0; mip <= texture.maxMip; ++mip) {
+			uint32_t tileCount = texture.tilesX[mip] * texture.tilesY[mip];
+			for (uint32_t tile = 0; tile < tileCount; ++tile) {
+				uint32_t bit = texture.feedbackOffset[mip] + tile;
+				if (!((words[bit / 32] >> (bit % 32)) & 1)) {
+					continue;
+				}
+				uint16_t pageIndex = texture.pageOfTile[mip][tile];
+				if (pageIndex != kNoPage) {
+					pages[pageIndex].lastUsed = frameIndex;
+				} else {
+					requests.push_back({ handle, mip, tile % texture.tilesX[mip], tile / texture.tilesX[mip] });
+				}
+			}
+		}
+	}
+	std::stable_sort(requests.begin(), requests.end(), [](const Request& a, const Request& b) { return a.mip > b.mip; });
+	uint32_t issued = 0;
+	for (const Request& request : requests) {
+		if (issued >= kMaxRequestsPerFrame) {
+			break;
+		}
+		if (!pendingPages.count(pageKey(request.texture, request.mip, request.x, request.y))) {
+			RequestPage(request.texture, request.mip, request.x, request.y);
+			++issued;
+		}
+	}
+}
+
+void VirtualTextureSystem::RequestPage(VirtualTextureHandle texture, uint32_t mip, uint32_t x, uint32_t y) {
+	if (!pendingPages.insert(pageKey(texture, mip, x, y)).second) {
+		return;
+	}
+	std::lock_guard<std::mutex> lock(mutex);
+	jobs.push_back({ texture, static_cast<int32_t>(mip), x, y });
+	jobAvailable.notify_one();
+}
+
+void VirtualTextureSystem::RebuildPageTable(VirtualTexture& texture) {
+	// 从最粗的一级往下填：驻留的页指向自己，缺页继承父页的映射
+	std::vector<std::vector<std::array<uint8_t, 4>>> entries(texture.maxMip + 1);
+	for (uint32_t mip = texture.maxMip + 1; mip-- > 0;) {
+		uint32_t tilesX = texture.tilesX[mip];
+		uint32_t tilesY = texture.tilesY[mip];
+		entries[mip].assign(tilesX * tilesY, { 0, 0, 0, 0 });
+		for (uint32_t y = 0; y < tilesY; ++y) {
+			for (uint32_t x = 0; x < tilesX; ++x) {
+				uint16_t pageIndex = texture.pageOfTile[mip][y * tilesX + x];
+				std::array<uint8_t, 4>& entry = entries[mip][y * tilesX + x];
+				if (pageIndex != kNoPage) {
+					entry = { static_cast<uint8_t>(pageIndex % pagesPerSide), static_cast<uint8_t>(pageIndex / pagesPerSide), static_cast<uint8_t>(mip), 1 };
+				} else if (mip < texture.maxMip) {
+					uint32_t parentX = std::min(x / 2, texture.tilesX[mip + 1] - 1);
+					uint32_t parentY = std::min(y / 2, texture.tilesY[mip + 1] - 1);
+					entry = entries[mip + 1][parentY * texture.tilesX[mip + 1] + parentX];
+				}
+			}
+		}
+
+		wgpu::ImageCopyTexture destination;
+		destination.texture = texture.pageTable;
+		destination.mipLevel = mip;
+		destination.origin = { 0, 0, 0 };
+		destination.aspect = wgpu::TextureAspect::All;
+		wgpu::TextureDataLayout source;
+		source.offset = 0;
+		source.bytesPerRow = tilesX * 4;
+		source.rowsPerImage = tilesY;
+		queue.writeTexture(destination, entries[mip].data(), entries[mip].size() * 4, source, { tilesX, tilesY, 1 });
+		++uploadCount;
+	}
+	texture.pageTableDirty = false;
+}
+
+void VirtualTextureSystem::RecordFeedbackReadback(wgpu::CommandEncoder& encoder) {
+	for (FeedbackReadback& readback : readbacks) {
+		// 只有占位资源时没有回读缓冲区
+		if (readback.state == ReadbackState::Idle && readback.buffer) {
+			encoder.copyBufferToBuffer(feedbackBuffer, 0, readback.buffer, 0, feedbackBufferSize);
+			encoder.clearBuffer(feedbackBuffer, 0, feedbackBufferSize);
+			readback.state = ReadbackState::Copied;
+			return;
+		}
+	}
+	// 回读缓冲区都在使用中，反馈留到下一帧继续累积
+}
+
+void VirtualTextureSystem::OnSubmitted() {
+	for (FeedbackReadback& readback : readbacks) {
+		if (readback.state != ReadbackState::Copied) {
+			continue;
+		}
+		readback.state = ReadbackState::Mapping;
+		// 回调在 device.tick() 中触发
+		readback.callback = readback.buffer.mapAsync(wgpu::MapMode::Read, 0, feedbackBufferSize, [&readback](wgpu::BufferMapAsyncStatus status) {
+			readback.state = status == wgpu::BufferMapAsyncStatus::Success ? ReadbackState::Mapped : ReadbackState::Idle;
+		});
+	}
+}
+
+wgpu::TextureView VirtualTextureSystem::GetPageTableView(VirtualTextureHandle handle) const {
+	return handle < textures.size() && textures[handle].opened ? textures[handle].pageTableView : emptyPageTableView;
+}
+
+wgpu::Buffer VirtualTextureSystem::GetUniformBuffer(VirtualTextureHandle handle) const {
+	return handle < textures.size() && textures[handle].opened ? textures[handle].uniformBuffer : emptyUniformBuffer;
+}
+
+void VirtualTextureSystem::Terminate() {
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		stopping = true;
+		jobs.clear();
+	}
+	jobAvailable.notify_all();
+	for (std::thread& worker : workers) {
+		worker.join();
+	}
+	workers.clear();
+	results.clear();
+	sourcePaths.clear();
+	sources.clear();
+	pendingPages.clear();
+
+	for (VirtualTexture& texture : textures) {
+		if (texture.opened) {
+			texture.pageTableView.release();
+			texture.pageTable.destroy();
+			texture.pageTable.release();
+			texture.uniformBuffer.destroy();
+			texture.uniformBuffer.release();
+		}
+	}
+	textures.clear();
+	pages.clear();
+	freePages.clear();
+
+	if (atlas) {
+		atlasView.release();
+		atlas.destroy();
+		atlas.release();
+		atlas = nullptr;
+		for (FeedbackReadback& readback : readbacks) {
+			if (readback.buffer) {
+				readback.buffer.destroy();
+				readback.buffer.release();
+				readback.buffer = nullptr;
+			}
+			readback.callback.reset();
+			readback.state = ReadbackState::Idle;
+		}
+		feedbackBuffer.destroy();
+		feedbackBuffer.release();
+		emptyPageTableView.release();
+		emptyPageTable.destroy();
+		emptyPageTable.release();
+		emptyUniformBuffer.destroy();
+		emptyUniformBuffer.release();
+	}
+}
+
+}
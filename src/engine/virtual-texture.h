@@ -0,0 +1,245 @@
+#pragma once
+
+#include "../utils/global.h"
+#include "../utils/image-decoder.h"
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <unordered_set>
+
+namespace webgpu {
+
+// 虚拟纹理句柄
+using VirtualTextureHandle = uint32_t;
+constexpr VirtualTextureHandle kInvalidVirtualTexture = ~0u;
+
+/**
+ * 虚拟纹理参数，布局与 base.wgsl 中的 VirtualTextureUniforms 一致
+ */
+struct VirtualTextureUniform {
+	glm::vec2 virtualSize = glm::vec2(1.0f);
+	glm::vec2 atlasSize = glm::vec2(1.0f);
+	uint32_t tileSize = 0;
+	uint32_t pageBorder = 0;
+	uint32_t maxMip = 0;
+	// 本帧写反馈的像素在 4x4 像素块中的编号
+	uint32_t feedbackPhase = 0;
+	// 每级 mip 在反馈位图中的起始位（最多 16 级）
+	std::array<glm::uvec4, 4> mipFeedbackOffset = {};
+};
+
+static_assert(sizeof(VirtualTextureUniform) % 16 == 0);
+
+/**
+ * 虚拟纹理（按页流式加载）
+ * 每张纹理按 mip 切成 kTileSize 的页，所有纹理共享一张固定大小的物理页图集，显存占用与纹理总大小无关。
+ * 片元着色器把采样到的 (mip, 页) 写进反馈位图，回读后由后台线程切出缺失的页并上传，
+ * 每张纹理的间接纹理把虚拟页映射到图集中的物理页，缺页时指向最近的已驻留祖先页。
+ * 最粗的一级（整张图只占一页）常驻，其余页按最近使用时间淘汰。
+ */
+class VirtualTextureSystem {
+public:
+	// 页的有效内容尺寸
+	static constexpr uint32_t kTileSize = 128;
+	// 页四周的边框，保证双线性过滤不采到相邻页
+	static constexpr uint32_t kPageBorder = 4;
+	static constexpr uint32_t kPageSize = kTileSize + 2 * kPageBorder;
+	static constexpr uint32_t kMaxMipLevels = 16;
+	// 每帧只有 4x4 像素块中的一个像素写反馈，连续这么多帧才覆盖全部像素
+	static constexpr uint32_t kFeedbackPhases = 16;
+
+	/**
+	 * @brief 创建物理页图集、反馈缓冲区和后台加载线程
+	 * @param pagesPerSide 图集每边的页数，图集共 pagesPerSide^2 页
+	 * @param feedbackBits 反馈位图的容量（所有纹理的页数之和）
+	 */
+	void Initialize(wgpu::Device device, wgpu::Queue queue, uint32_t pagesPerSide = 8, uint32_t feedbackBits = 1u << 16);
+
+	/**
+	 * @brief 不使用虚拟纹理时代替 Initialize：只创建着色器绑定需要的最小资源（一页的图集、一个字的反馈位图），
+	 * 没有回读缓冲区和加载线程，之后不能调用 Add
+	 */
+	void InitializePlaceholders(wgpu::Device device, wgpu::Queue queue);
+
+	/**
+	 * @brief 添加一张虚拟纹理（源图在后台线程上解码）
+	 */
+	VirtualTextureHandle Add(const std::filesystem::path& path);
+
+	/**
+	 * @brief 阻塞直到所有纹理的源图都解码完成（或失败），之后才能取得间接纹理创建 bind group
+	 */
+	void WaitUntilOpened();
+
+	/**
+	 * @brief 加载线程每完成一页（或一张源图）后在该线程上调用，用来唤醒阻塞等待事件的主循环
+	 */
+	void SetLoadNotifier(std::function<void()> notifier);
+
+	/**
+	 * @brief 处理已经回读完成的反馈，缺页交给加载线程（不渲染的帧也可以调用）
+	 */
+	void PollFeedback();
+
+	/**
+	 * @brief 每帧在录制命令之前调用：处理回读的反馈、上传加载好的页、更新间接纹理
+	 * @return 间接纹理是否变化（有页上传或被淘汰），变化后画面需要重绘
+	 */
+	bool Update(uint64_t frameIndex);
+
+	/**
+	 * @brief 画面变化（动画、相机、窗口尺寸）后调用：接下来 kFeedbackPhases 帧轮换写反馈的像素，
+	 * 覆盖新画面的全部像素；轮换完一遍之后静止的画面不再修改反馈编号，也不再上传
+	 */
+	void RestartFeedbackSweep() { feedbackSweepFrames = kFeedbackPhases; }
+
+	/**
+	 * @brief 自上次调用以来的上传次数（参数的 writeBuffer、页和间接纹理的 writeTexture），读取后清零
+	 */
+	uint32_t TakeUploadCount() { return std::exchange(uploadCount, 0u); }
+
+	/**
+	 * @brief 是否有加载好、等待 Update 上传的页（没有加载线程时为是否还有待处理的请求）
+	 */
+	bool HasPendingUploads();
+
+	/**
+	 * @brief 是否有还没处理完的反馈回读，需要继续推进设备才能完成映射
+	 */
+	bool HasReadbackInFlight() const;
+
+	/**
+	 * @brief 在渲染通道之后录制：把反馈位图拷贝到空闲的回读缓冲区并清零
+	 */
+	void RecordFeedbackReadback(wgpu::CommandEncoder& encoder);
+
+	/**
+	 * @brief 提交之后调用：映射本帧拷贝的回读缓冲区
+	 */
+	void OnSubmitted();
+
+	/**
+	 * @brief 间接纹理视图（rgba8uint：物理页 x、y、驻留的 mip、是否有效），无效句柄返回空的 1x1 纹理
+	 */
+	wgpu::TextureView GetPageTableView(VirtualTextureHandle handle) const;
+
+	/**
+	 * @brief 纹理参数 uniform buffer，无效句柄返回默认参数
+	 */
+	wgpu::Buffer GetUniformBuffer(VirtualTextureHandle handle) const;
+
+	wgpu::TextureView GetAtlasView() const { return atlasView; }
+	wgpu::Buffer GetFeedbackBuffer() const { return feedbackBuffer; }
+	uint64_t GetFeedbackBufferSize() const { return feedbackBufferSize; }
+
+	/**
+	 * @brief 停止加载线程并销毁资源
+	 */
+	void Terminate();
+
+private:
+	struct VirtualTexture {
+		std::filesystem::path path;
+		bool opened = false;
+		bool failed = false;
+		uint32_t width = 0;
+		uint32_t height = 0;
+		uint32_t maxMip = 0;
+		std::array<uint32_t, kMaxMipLevels> tilesX = {};
+		std::array<uint32_t, kMaxMipLevels> tilesY = {};
+		std::array<uint32_t, kMaxMipLevels> feedbackOffset = {};
+		// 每级 mip 每个虚拟页对应的物理页，kNoPage 表示未驻留
+		std::vector<std::vector<uint16_t>> pageOfTile;
+		bool pageTableDirty = false;
+		wgpu::Texture pageTable = nullptr;
+		wgpu::TextureView pageTableView = nullptr;
+		wgpu::Buffer uniformBuffer = nullptr;
+		VirtualTextureUniform uniform;
+	};
+
+	struct PhysicalPage {
+		VirtualTextureHandle texture = kInvalidVirtualTexture;
+		uint32_t mip = 0;
+		uint32_t x = 0;
+		uint32_t y = 0;
+		uint64_t lastUsed = 0;
+		bool pinned = false;
+	};
+
+	// mip < 0 表示解码源图
+	struct LoadJob {
+		VirtualTextureHandle texture = kInvalidVirtualTexture;
+		int32_t mip = -1;
+		uint32_t x = 0;
+		uint32_t y = 0;
+	};
+
+	struct LoadResult {
+		LoadJob job;
+		bool success = false;
+		uint32_t width = 0;
+		uint32_t height = 0;
+		std::vector<uint8_t> pixels;
+	};
+
+	enum class ReadbackState { Idle, Copied, Mapping, Mapped };
+
+	struct FeedbackReadback {
+		wgpu::Buffer buffer = nullptr;
+		ReadbackState state = ReadbackState::Idle;
+		std::unique_ptr<wgpu::BufferMapCallback> callback;
+	};
+
+	void CreateResources(wgpu::Device device, wgpu::Queue queue, uint32_t pagesPerSide, uint32_t feedbackBits);
+	void WorkerLoop();
+	LoadResult Process(const LoadJob& job);
+	void OnTextureOpened(const LoadResult& result);
+	void OnPageLoaded(const LoadResult& result);
+	void ProcessFeedback(const uint32_t* words);
+	void RequestPage(VirtualTextureHandle texture, uint32_t mip, uint32_t x, uint32_t y);
+	uint32_t AllocatePage();
+	void RebuildPageTable(VirtualTexture& texture);
+
+	wgpu::Device device = nullptr;
+	wgpu::Queue queue = nullptr;
+	uint32_t pagesPerSide = 0;
+	wgpu::Texture atlas = nullptr;
+	wgpu::TextureView atlasView = nullptr;
+	wgpu::Buffer feedbackBuffer = nullptr;
+	uint64_t feedbackBufferSize = 0;
+	uint32_t feedbackBitsUsed = 0;
+	std::array<FeedbackReadback, 2> readbacks;
+	// 无效句柄使用的空间接纹理与默认参数
+	wgpu::Texture emptyPageTable = nullptr;
+	wgpu::TextureView emptyPageTableView = nullptr;
+	wgpu::Buffer emptyUniformBuffer = nullptr;
+
+	std::vector<VirtualTexture> textures;
+	std::vector<PhysicalPage> pages;
+	std::vector<uint32_t> freePages;
+	// 已发给加载线程、还没上传的页
+	std::unordered_set<uint64_t> pendingPages;
+	uint64_t frameIndex = 0;
+	uint32_t lastResidentCount = 0;
+	// 本帧写反馈的像素编号，以及还要轮换的帧数
+	uint32_t feedbackPhase = 0;
+	uint32_t feedbackSweepFrames = kFeedbackPhases;
+	uint32_t uploadCount = 0;
+
+	// 加载线程共享的状态，由 mutex 保护
+	std::vector<std::thread> workers;
+	std::mutex mutex;
+	std::condition_variable jobAvailable;
+	std::deque<LoadJob> jobs;
+	std::vector<LoadResult> results;
+	// 源图路径和解码后的 mip 链，按句柄索引
+	std::vector<std::filesystem::path> sourcePaths;
+	std::vector<std::shared_ptr<const std::vector<Image>>> sources;
+	std::function<void()> loadNotifier;
+	bool stopping = false;
+};
+
+}
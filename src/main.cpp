@@ -16,15 +16,157 @@
 
 #include "engine/application.h"
 
-int main() {
+#include <cctype>
+#include <charconv>
+#include <cstring>
+
+namespace {
+
+/**
+ * @brief 解析命令行里的非负整数，缺少、格式错误或超出 uint32 范围时输出错误
+ * @return 是否解析成功
+ */
+bool parseCount(const char* option, const char* text, uint32_t& value) {
+	if (text == nullptr) {
+		std::cerr << option << " expects a non-negative integer\n";
+		return false;
+	}
+	const char* end = text + std::strlen(text);
+	auto [last, error] = std::from_chars(text, end, value);
+	if (error != std::errc() || last != end || last == text) {
+		std::cerr << option << " expects a non-negative integer, got \"" << text << "\"\n";
+		return false;
+	}
+	return true;
+}
+
+}
+
+int main(int argc, char* argv[]) {
+#ifndef __EMSCRIPTEN__
+	// 命令行工具：输出网格优化前后的顶点缓存统计，不创建窗口
+	// App --mesh-report [resources 目录]
+	if (argc >= 2 && std::string(argv[1]) == "--mesh-report") {
+		webgpu::reportMeshOptimization(argc >= 3 ? argv[2] : "resources");
+		return 0;
+	}
+	// 离线烘焙：把 png/jpg 压缩为 BC7 + ETC2 的 .wtex，放在源图旁边
+	// App --bake-textures [resources 目录]
+	if (argc >= 2 && std::string(argv[1]) == "--bake-textures") {
+		return webgpu::bakeTextures(argc >= 3 ? argv[2] : "resources") == 0 ? 0 : 1;
+	}
+	// 渲染队列排序基准测试：每帧重新打包并排序 N 个绘制
+	// App --sort-benchmark [N，默认 100000]
+	if (argc >= 2 && std::string(argv[1]) == "--sort-benchmark") {
+		uint32_t drawCount = 100000;
+		if (argc >= 3 && !parseCount(argv[1], argv[2], drawCount)) {
+			return 1;
+		}
+		webgpu::reportRenderQueueBenchmark(drawCount);
+		return 0;
+	}
+	// 批量变换基准测试：逐个 glm 组合与 SoA 批量组合（SSE2/AVX2）模型矩阵和 MVP 的耗时
+	// App --transform-benchmark [N，默认 1000000]
+	if (argc >= 2 && std::string(argv[1]) == "--transform-benchmark") {
+		uint32_t transformCount = 1000000;
+		if (argc >= 3 && !parseCount(argv[1], argv[2], transformCount)) {
+			return 1;
+		}
+		webgpu::reportTransformBenchmark(transformCount);
+		return 0;
+	}
+	// GPU 并行原语的校验与基准测试，--software 使用软件适配器
+	// App --primitives-benchmark [N，默认 1000000] [shader 目录，默认 src/shader] [--software]
+	if (argc >= 2 && std::string(argv[1]) == "--primitives-benchmark") {
+		uint32_t elementCount = 1000000;
+		std::filesystem::path shaderDirectory = "src/shader";
+		bool software = false;
+		for (int i = 2; i < argc; ++i) {
+			std::string arg = argv[i];
+			if (arg == "--software") {
+				software = true;
+			} else if (!arg.empty() && std::isdigit(static_cast<unsigned char>(arg[0]))) {
+				if (!parseCount(argv[1], arg.c_str(), elementCount)) {
+					return 1;
+				}
+			} else {
+				shaderDirectory = arg;
+			}
+		}
+		// 任何原语与 CPU 参考结果不一致时以非 0 退出，可以直接用在 CI 里
+		return webgpu::reportGpuPrimitivesBenchmark(shaderDirectory, elementCount, software) ? 0 : 1;
+	}
+#endif // NOT __EMSCRIPTEN__
+
 	auto& app = webgpu::Application::GetInstance();
 
+	// 远景实例阵列（沿视线方向 16 行 8 列，用于测试深度复杂度、剔除和 LOD）：App --far-field
+	// 远景阵列中每 3 列一个透明实例（顺序无关透明）：App --far-field --transparency
+	// 中心模型的骨骼动画：App --skinning
+	// 漫反射贴图按页流式加载（虚拟纹理）：App --virtual-texture
+	// 深度预通道：App --depth-prepass；基准测试（自动打开远景阵列和 1024 个点光源）：App --depth-prepass-benchmark；静止的场景：App --pause-animation
+	// 按需渲染（画面不变时不渲染，适合展示屏和仪表盘）：App --on-demand
+	bool depthPrepassBenchmark = false;
+	for (int i = 1; i < argc; ++i) {
+		if (std::string(argv[i]) == "--depth-prepass") {
+			app->SetDepthPrepass(true);
+		} else if (std::string(argv[i]) == "--depth-prepass-benchmark") {
+			depthPrepassBenchmark = true;
+			app->SetFarField(16, 8);
+			app->SetPointLightCount(1024);
+		} else if (std::string(argv[i]) == "--far-field") {
+			app->SetFarField(16, 8);
+		} else if (std::string(argv[i]) == "--transparency") {
+			app->SetTransparentColumnStride(3);
+		} else if (std::string(argv[i]) == "--skinning") {
+			app->SetSkinning(true);
+		} else if (std::string(argv[i]) == "--virtual-texture") {
+			app->SetVirtualTexture(true);
+		} else if (std::string(argv[i]) == "--pause-animation") {
+			app->SetAnimationPaused(true);
+		} else if (std::string(argv[i]) == "--on-demand") {
+			app->SetOnDemandRendering(true);
+		}
+	}
+	// 带数值的参数放在后面解析，覆盖上面基准测试的默认值
+	// 动态点光源，默认没有：App --lights N（例如 1024）
+	// GPU 粒子喷泉，默认关闭：App --particles N（N 为粒子数上限，例如 262144）
+	for (int i = 1; i < argc; ++i) {
+		std::string arg = argv[i];
+		if (arg != "--lights" && arg != "--particles") {
+			continue;
+		}
+		uint32_t count = 0;
+		if (!parseCount(argv[i], i + 1 < argc ? argv[i + 1] : nullptr, count)) {
+			return 1;
+		}
+		if (arg == "--lights") {
+			app->SetPointLightCount(count);
+		} else {
+			app->SetParticleCount(count);
+		}
+		++i;
+	}
+
 	try {
 		app->Initialize();
 	} catch (const std::runtime_error& e) {
 		std::cerr << "Exception caught: " << e.what() << '\n';
 	}
 
+#ifndef __EMSCRIPTEN__
+	if (depthPrepassBenchmark) {
+		try {
+			app->RunDepthPrepassBenchmark();
+		} catch (const std::runtime_error& e) {
+			std::cerr << "Exception caught: " << e.what() << '\n';
+			return -1;
+		}
+		app->Terminate();
+		return 0;
+	}
+#endif // NOT __EMSCRIPTEN__
+
 #ifdef __EMSCRIPTEN__
 	// Equivalent of the main loop when using Emscripten:
 	auto callback = [](void *arg) {
@@ -1,53 +1,308 @@
+// 为 true 时顶点使用紧凑格式：位置需要反量化，法向量为八面体编码
+override compactVertex: bool = false;
+// 为 true 时漫反射贴图走虚拟纹理（间接纹理 + 物理页图集），并写入采样反馈
+override virtualTexture: bool = false;
+
 struct VertexInput {
 	@location(0) position: vec3f,
 	@location(1) normal: vec3f, // new attribute
 	@location(2) color: vec3f,
+	@location(3) uv: vec2f,
 };
 
 struct VertexOutput {
-	@builtin(position) position: vec4f,
+	// 与 depth-prepass.wgsl 的计算完全相同，invariant 保证两者得到相同的深度（深度预通道后以 Equal 比较）
+	@builtin(position) @invariant position: vec4f,
 	@location(0) color: vec3f,
 	@location(1) normal: vec3f, // <--- Add a normal output
+	@location(2) uv: vec2f,
+	// 世界空间位置与视图空间深度，用于分簇点光源
+	@location(3) worldPosition: vec3f,
+	@location(4) viewDepth: f32,
 };
 
 /**
  * A structure holding the value of our uniforms
  */
 struct MyUniforms {
-    projectionMatrix: mat4x4f,
-    viewMatrix: mat4x4f,
-    modelMatrix: mat4x4f,
+    // 视图矩阵的第 3 行，与世界空间位置点乘得到视图空间深度
+    viewDepthRow: vec4f,
     color: vec4f,
     time: f32,
+    // 紧凑顶点格式的位置反量化参数
+    positionOffset: vec4f,
+    positionScale: vec4f,
+};
+
+/**
+ * 虚拟纹理参数
+ */
+struct VirtualTextureUniforms {
+	virtualSize: vec2f,
+	atlasSize: vec2f,
+	tileSize: u32,
+	pageBorder: u32,
+	maxMip: u32,
+	// 本帧写反馈的像素在 4x4 像素块中的编号
+	feedbackPhase: u32,
+	// 每级 mip 在反馈位图中的起始位
+	mipFeedbackOffset: array<vec4u, 4>,
+};
+
+/**
+ * 分簇参数（与 light-cluster.wgsl 相同）
+ */
+struct ClusterUniforms {
+	inverseProjection: mat4x4f,
+	viewMatrix: mat4x4f,
+	// x、y、z 方向的簇数，w 为光源数
+	gridSize: vec4u,
+	screenSize: vec2f,
+	zNear: f32,
+	zFar: f32,
+};
+
+struct PointLight {
+	position: vec3f,
+	radius: f32,
+	color: vec3f,
+	intensity: f32,
+};
+
+/**
+ * 级联阴影参数
+ */
+struct ShadowUniforms {
+	lightViewProjection: array<mat4x4f, 4>,
+	// 每级级联覆盖到的视图空间深度
+	cascadeSplits: vec4f,
+	// 每级级联一个纹素在世界空间中的大小
+	cascadeTexelSize: vec4f,
+	// xyz 指向主光源，w 为级联数
+	lightDirection: vec4f,
+	// x 为阴影贴图纹素的 uv 大小，y 为深度偏移
+	params: vec4f,
+};
+
+/**
+ * 每个实例的数据，CPU 上每帧组合好（模型动画已乘进模型矩阵）
+ */
+struct InstanceData {
+	modelMatrix: mat4x4f,
+	// 投影 * 视图 * 模型
+	modelViewProjection: mat4x4f,
+	// 模型矩阵左上 3x3 的逆转置
+	normalMatrix: mat3x3f,
 };
 
 // Instead of the simple uTime variable, our uniform variable is a struct
 @group(0) @binding(0) var<uniform> uMyUniforms: MyUniforms;
+// 实例数据，按 instance_index 读取
+@group(0) @binding(1) var<storage, read> instances: array<InstanceData>;
+// 漫反射贴图（没有时为 1x1 白色）
+@group(0) @binding(2) var baseColorTexture: texture_2d<f32>;
+@group(0) @binding(3) var baseColorSampler: sampler;
+// 虚拟纹理：间接纹理（物理页 x、y、驻留的 mip、是否有效）、物理页图集、参数和反馈位图
+@group(0) @binding(4) var pageTable: texture_2d<u32>;
+@group(0) @binding(5) var pageAtlas: texture_2d<f32>;
+@group(0) @binding(6) var<uniform> uVirtualTexture: VirtualTextureUniforms;
+@group(0) @binding(7) var<storage, read_write> feedback: array<atomic<u32>>;
+// 分簇点光源：参数、光源、每簇的光源数与光源编号
+@group(0) @binding(8) var<uniform> uClusters: ClusterUniforms;
+@group(0) @binding(9) var<storage, read> pointLights: array<PointLight>;
+@group(0) @binding(10) var<storage, read> clusterLightCounts: array<u32>;
+@group(0) @binding(11) var<storage, read> clusterLightIndices: array<u32>;
+
+// 级联阴影：阴影贴图（每级一层）、比较采样器、参数
+@group(0) @binding(12) var shadowMap: texture_depth_2d_array;
+@group(0) @binding(13) var shadowSampler: sampler_comparison;
+@group(0) @binding(14) var<uniform> uShadow: ShadowUniforms;
+
+// 与 LightClusterer::kMaxLightsPerCluster 一致
+const MAX_LIGHTS_PER_CLUSTER = 128u;
+
+/**
+ * 八面体编码的法向量解码
+ */
+fn octDecode(e: vec2f) -> vec3f {
+	var n = vec3f(e.x, e.y, 1.0 - abs(e.x) - abs(e.y));
+	let t = max(-n.z, 0.0);
+	n.x += select(t, -t, n.x >= 0.0);
+	n.y += select(t, -t, n.y >= 0.0);
+	return normalize(n);
+}
+
+fn virtualMipSize(level: u32) -> vec2u {
+	return max(vec2u(uVirtualTexture.virtualSize) >> vec2u(level), vec2u(1u));
+}
+
+/**
+ * 虚拟纹理采样：按 lod 找到虚拟页，记录反馈，再经间接纹理在物理页图集中采样
+ */
+fn sampleVirtualTexture(uv: vec2f, lod: f32, fragCoord: vec2f) -> vec4f {
+	let tileSize = uVirtualTexture.tileSize;
+	let wrapped = fract(uv);
+	let level = u32(clamp(lod, 0.0, f32(uVirtualTexture.maxMip)));
+	let tile = vec2u(wrapped * vec2f(virtualMipSize(level))) / tileSize;
+
+	// 每帧只有 4x4 像素块中的一个像素写反馈，16 帧覆盖全部像素
+	let pixel = vec2u(fragCoord) % vec2u(4u);
+	if (pixel.x + pixel.y * 4u == uVirtualTexture.feedbackPhase) {
+		let tilesX = (virtualMipSize(level).x + tileSize - 1u) / tileSize;
+		let bit = uVirtualTexture.mipFeedbackOffset[level / 4u][level % 4u] + tile.y * tilesX + tile.x;
+		atomicOr(&feedback[bit / 32u], 1u << (bit % 32u));
+	}
+
+	// 缺页时间接纹理指向最近的已驻留祖先页，还没有任何页时返回白色
+	let entry = textureLoad(pageTable, tile, i32(level));
+	if (entry.a == 0u) {
+		return vec4f(1.0);
+	}
+	let texel = wrapped * vec2f(virtualMipSize(entry.b));
+	let inTile = texel - floor(texel / f32(tileSize)) * f32(tileSize);
+	let pageSize = f32(tileSize + 2u * uVirtualTexture.pageBorder);
+	let atlasTexel = vec2f(entry.xy) * pageSize + f32(uVirtualTexture.pageBorder) + inTile;
+	return textureSampleLevel(pageAtlas, baseColorSampler, atlasTexel / uVirtualTexture.atlasSize, 0.0);
+}
+
+/**
+ * 片元所在的簇：屏幕分块 + 按视图空间深度的指数切片
+ */
+fn clusterIndex(fragCoord: vec2f, viewDepth: f32) -> u32 {
+	let grid = uClusters.gridSize.xyz;
+	let tile = min(vec2u(fragCoord / uClusters.screenSize * vec2f(grid.xy)), grid.xy - 1u);
+	let depth = max(viewDepth, uClusters.zNear);
+	let slice = log(depth / uClusters.zNear) / log(uClusters.zFar / uClusters.zNear) * f32(grid.z);
+	let z = min(u32(slice), grid.z - 1u);
+	return tile.x + tile.y * grid.x + z * grid.x * grid.y;
+}
+
+/**
+ * 片元所在簇内所有点光源的漫反射光照
+ */
+fn shadePointLights(position: vec3f, normal: vec3f, fragCoord: vec2f, viewDepth: f32) -> vec3f {
+	let cluster = clusterIndex(fragCoord, viewDepth);
+	let count = min(clusterLightCounts[cluster], MAX_LIGHTS_PER_CLUSTER);
+	var result = vec3f(0.0);
+	for (var i = 0u; i < count; i++) {
+		let light = pointLights[clusterLightIndices[cluster * MAX_LIGHTS_PER_CLUSTER + i]];
+		let toLight = light.position - position;
+		let distanceSquared = dot(toLight, toLight);
+		// 平方反比衰减，乘以在半径处平滑降到 0 的窗口函数
+		let ratio = distanceSquared / (light.radius * light.radius);
+		let window = saturate(1.0 - ratio * ratio);
+		let attenuation = window * window / (distanceSquared + 1.0);
+		let lambert = max(0.0, dot(normal, toLight * inverseSqrt(max(distanceSquared, 1e-8))));
+		result += light.color * (light.intensity * attenuation * lambert);
+	}
+	return result;
+}
+
+/**
+ * 主光源的阴影：按视图深度选级联，沿法线偏移一个纹素后 3x3 PCF，超出阴影距离时不在阴影中
+ */
+fn shadowVisibility(position: vec3f, normal: vec3f, viewDepth: f32) -> f32 {
+	let cascadeCount = u32(uShadow.lightDirection.w);
+	var cascade = 0u;
+	while (cascade < cascadeCount && viewDepth > uShadow.cascadeSplits[cascade]) {
+		cascade++;
+	}
+	if (cascade == cascadeCount) {
+		return 1.0;
+	}
+	let offsetPosition = position + normal * uShadow.cascadeTexelSize[cascade] * 1.5;
+	let lightPosition = uShadow.lightViewProjection[cascade] * vec4f(offsetPosition, 1.0);
+	let uv = vec2f(lightPosition.x * 0.5 + 0.5, 0.5 - lightPosition.y * 0.5);
+	let depth = lightPosition.z - uShadow.params.y;
+	var visibility = 0.0;
+	for (var y = -1; y <= 1; y++) {
+		for (var x = -1; x <= 1; x++) {
+			let offset = vec2f(f32(x), f32(y)) * uShadow.params.x;
+			visibility += textureSampleCompareLevel(shadowMap, shadowSampler, uv + offset, cascade, depth);
+		}
+	}
+	return visibility / 9.0;
+}
 
 @vertex
-fn vs_main(in: VertexInput) -> VertexOutput {
+fn vs_main(in: VertexInput, @builtin(instance_index) instanceIndex: u32) -> VertexOutput {
 	var out: VertexOutput;
-	out.position = uMyUniforms.projectionMatrix * uMyUniforms.viewMatrix * uMyUniforms.modelMatrix * vec4f(in.position, 1.0);
+	// 非紧凑格式时 offset = 0、scale = 1，这里相当于不变
+	let position = in.position * uMyUniforms.positionScale.xyz + uMyUniforms.positionOffset.xyz;
+	var normal = in.normal;
+	if (compactVertex) {
+		normal = octDecode(in.normal.xy);
+	}
+	// 矩阵在 CPU 上按实例组合好：裁剪空间位置只需一次矩阵乘向量，视图深度只需一次点乘
+	let instance = instances[instanceIndex];
+	out.position = instance.modelViewProjection * vec4f(position, 1.0);
+	let worldPosition = instance.modelMatrix * vec4f(position, 1.0);
+	out.worldPosition = worldPosition.xyz;
+	out.viewDepth = dot(uMyUniforms.viewDepthRow, worldPosition);
 	// Forward the normal
-    out.normal = (uMyUniforms.modelMatrix * vec4f(in.normal, 0.0)).xyz;
+    out.normal = instance.normalMatrix * normal;
 	out.color = in.color;
+	out.uv = in.uv;
 	return out;
 }
 
-@fragment
-fn fs_main(in: VertexOutput) -> @location(0) vec4f {
+/**
+ * 表面的光照结果（已做 gamma 校正），不透明与透明的片元着色器共用
+ */
+fn shadeSurface(in: VertexOutput) -> vec3f {
 	let normal = normalize(in.normal);
 
 	let lightColor1 = vec3f(1.0, 0.9, 0.6);
 	let lightColor2 = vec3f(0.6, 0.9, 1.0);
-	let lightDirection1 = vec3f(0.5, -0.9, 0.1);
+	// 主光源方向由阴影参数提供，与阴影贴图一致
+	let lightDirection1 = uShadow.lightDirection.xyz;
 	let lightDirection2 = vec3f(0.2, 0.4, 0.3);
 	let shading1 = max(0.0, dot(lightDirection1, normal));
 	let shading2 = max(0.0, dot(lightDirection2, normal));
-	let shading = shading1 * lightColor1 + shading2 * lightColor2;
-	let color = in.color * shading;
+	// 导数和隐式求导的采样要在统一控制流中计算，放在按簇光源数循环的点光源之前
+	let virtualTexel = in.uv * uVirtualTexture.virtualSize;
+	let lod = log2(max(max(length(dpdx(virtualTexel)), length(dpdy(virtualTexel))), 1e-6));
+	var textureColor: vec4f;
+	if (virtualTexture) {
+		textureColor = sampleVirtualTexture(in.uv, lod, in.position.xy);
+	} else {
+		textureColor = textureSample(baseColorTexture, baseColorSampler, in.uv);
+	}
+	let baseColor = in.color * textureColor.rgb;
+	let shadow = shadowVisibility(in.worldPosition, normal, in.viewDepth);
+	let shading = shading1 * shadow * lightColor1 + shading2 * lightColor2 + shadePointLights(in.worldPosition, normal, in.position.xy, in.viewDepth);
+	let color = baseColor * shading;
 
 	// Gamma-correction
-	let corrected_color = pow(color, vec3f(2.2));
-	return vec4f(corrected_color, uMyUniforms.color.a);
-}
\ No newline at end of file
+	return pow(color, vec3f(2.2));
+}
+
+@fragment
+fn fs_main(in: VertexOutput) -> @location(0) vec4f {
+	// 不透明物体，不混合
+	return vec4f(shadeSurface(in), 1.0);
+}
+
+/**
+ * 加权混合 OIT 的两个输出：预乘 alpha 的颜色与 alpha（乘以权重）、透过率因子
+ */
+struct TransparentOutput {
+	@location(0) accumulation: vec4f,
+	@location(1) revealage: f32,
+};
+
+/**
+ * 透明物体：不透明度取 uMyUniforms.color.a，权重随视图深度衰减（McGuire & Bavoil 2013 的公式 7），
+ * 近处的片元在加权平均中占主导，结果与绘制顺序无关
+ */
+@fragment
+fn fs_transparent(in: VertexOutput) -> TransparentOutput {
+	let color = shadeSurface(in);
+	let alpha = uMyUniforms.color.a;
+	let z = in.viewDepth;
+	let weight = clamp(10.0 / (1e-5 + pow(z / 5.0, 2.0) + pow(z / 200.0, 6.0)), 1e-2, 3e3);
+	var out: TransparentOutput;
+	out.accumulation = vec4f(color * alpha, alpha) * weight;
+	out.revealage = alpha;
+	return out;
+}
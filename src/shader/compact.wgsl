@@ -0,0 +1,37 @@
+/**
+ * 流压缩的散射：offsets 为谓词的排他前缀和，保留的元素写到 output[offsets[i]]，保持原来的顺序
+ * 最后一个元素所在的线程把保留的个数写入 countOut
+ */
+
+struct CompactParams {
+	// 元素数
+	count: u32,
+	_pad0: u32,
+	_pad1: u32,
+	// 个数在 countOut 中的下标
+	countIndex: u32,
+};
+
+@group(0) @binding(0) var<uniform> params: CompactParams;
+@group(0) @binding(1) var<storage, read> values: array<u32>;
+@group(0) @binding(2) var<storage, read> flags: array<u32>;
+@group(0) @binding(3) var<storage, read> offsets: array<u32>;
+@group(0) @binding(4) var<storage, read_write> output: array<u32>;
+@group(0) @binding(5) var<storage, read_write> countOut: array<u32>;
+
+const WORKGROUP_SIZE = 256u;
+
+@compute @workgroup_size(WORKGROUP_SIZE)
+fn cs_scatter(@builtin(workgroup_id) groupId: vec3u, @builtin(num_workgroups) groupCount: vec3u, @builtin(local_invocation_index) localIndex: u32) {
+	let index = (groupId.x + groupId.y * groupCount.x) * WORKGROUP_SIZE + localIndex;
+	if (index >= params.count) {
+		return;
+	}
+	let keep = flags[index] != 0u;
+	if (keep) {
+		output[offsets[index]] = values[index];
+	}
+	if (index + 1u == params.count) {
+		countOut[params.countIndex] = offsets[index] + select(0u, 1u, keep);
+	}
+}
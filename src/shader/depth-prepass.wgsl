@@ -0,0 +1,35 @@
+/**
+ * 深度预通道：只有顶点着色器，从只含位置的顶点流读取，裁剪空间位置的计算与 base.wgsl 的 vs_main 逐步相同
+ */
+
+/**
+ * 与 base.wgsl 中的 MyUniforms 相同
+ */
+struct MyUniforms {
+	viewDepthRow: vec4f,
+	color: vec4f,
+	time: f32,
+	positionOffset: vec4f,
+	positionScale: vec4f,
+};
+
+struct InstanceData {
+	modelMatrix: mat4x4f,
+	modelViewProjection: mat4x4f,
+	normalMatrix: mat3x3f,
+};
+
+@group(0) @binding(0) var<uniform> uMyUniforms: MyUniforms;
+@group(0) @binding(1) var<storage, read> instances: array<InstanceData>;
+
+struct VertexOutput {
+	@builtin(position) @invariant position: vec4f,
+};
+
+@vertex
+fn vs_main(@location(0) position: vec3f, @builtin(instance_index) instanceIndex: u32) -> VertexOutput {
+	var out: VertexOutput;
+	let localPosition = position * uMyUniforms.positionScale.xyz + uMyUniforms.positionOffset.xyz;
+	out.position = instances[instanceIndex].modelViewProjection * vec4f(localPosition, 1.0);
+	return out;
+}
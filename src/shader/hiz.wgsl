@@ -0,0 +1,44 @@
+/**
+ * Hi-Z 金字塔：每个纹素保存它覆盖区域内的最大（最远）深度
+ * cs_copy 把深度缓冲区拷贝到第 0 级，cs_reduce 由上一级生成下一级
+ */
+
+@group(0) @binding(0) var depthTexture: texture_depth_2d;
+@group(0) @binding(1) var firstLevel: texture_storage_2d<r32float, write>;
+
+@compute @workgroup_size(8, 8)
+fn cs_copy(@builtin(global_invocation_id) id: vec3u) {
+	let size = textureDimensions(firstLevel);
+	if (id.x >= size.x || id.y >= size.y) {
+		return;
+	}
+	textureStore(firstLevel, id.xy, vec4f(textureLoad(depthTexture, id.xy, 0), 0.0, 0.0, 0.0));
+}
+
+@group(0) @binding(0) var previousLevel: texture_2d<f32>;
+@group(0) @binding(1) var nextLevel: texture_storage_2d<r32float, write>;
+
+@compute @workgroup_size(8, 8)
+fn cs_reduce(@builtin(global_invocation_id) id: vec3u) {
+	let size = textureDimensions(nextLevel);
+	if (id.x >= size.x || id.y >= size.y) {
+		return;
+	}
+	// 上一级是奇数尺寸时，最后一列/行多覆盖一个纹素，保证不漏掉任何深度
+	let previousSize = textureDimensions(previousLevel, 0);
+	var footprint = vec2u(2u);
+	if (id.x + 1u == size.x && (previousSize.x & 1u) != 0u) {
+		footprint.x = 3u;
+	}
+	if (id.y + 1u == size.y && (previousSize.y & 1u) != 0u) {
+		footprint.y = 3u;
+	}
+	var farthest = 0.0;
+	for (var dy = 0u; dy < footprint.y; dy++) {
+		for (var dx = 0u; dx < footprint.x; dx++) {
+			let p = min(id.xy * 2u + vec2u(dx, dy), previousSize - 1u);
+			farthest = max(farthest, textureLoad(previousLevel, p, 0).r);
+		}
+	}
+	textureStore(nextLevel, id.xy, vec4f(farthest, 0.0, 0.0, 0.0));
+}
@@ -0,0 +1,109 @@
+/**
+ * 分簇光源剔除：每个线程处理一个簇
+ * 簇的视图空间包围盒由屏幕分块和指数深度切片求出，工作组分批把光源变换到视图空间放进共享内存，
+ * 每个线程测试球与包围盒是否相交，把相交的光源编号写入本簇的列表
+ */
+
+struct ClusterUniforms {
+	inverseProjection: mat4x4f,
+	viewMatrix: mat4x4f,
+	// x、y、z 方向的簇数，w 为光源数
+	gridSize: vec4u,
+	screenSize: vec2f,
+	zNear: f32,
+	zFar: f32,
+};
+
+struct PointLight {
+	position: vec3f,
+	radius: f32,
+	color: vec3f,
+	intensity: f32,
+};
+
+@group(0) @binding(0) var<uniform> clusters: ClusterUniforms;
+@group(0) @binding(1) var<storage, read> lights: array<PointLight>;
+// 每簇的光源数
+@group(0) @binding(2) var<storage, read_write> clusterLightCounts: array<u32>;
+// 每簇 MAX_LIGHTS_PER_CLUSTER 个槽位的光源编号
+@group(0) @binding(3) var<storage, read_write> clusterLightIndices: array<u32>;
+
+const WORKGROUP_SIZE = 64u;
+// 与 LightClusterer::kMaxLightsPerCluster 一致
+const MAX_LIGHTS_PER_CLUSTER = 128u;
+
+// 本批光源在视图空间的球心和半径
+var<workgroup> sharedLights: array<vec4f, WORKGROUP_SIZE>;
+
+fn sliceDepth(slice: u32) -> f32 {
+	return clusters.zNear * pow(clusters.zFar / clusters.zNear, f32(slice) / f32(clusters.gridSize.z));
+}
+
+/**
+ * NDC 中一点对应的视图空间射线，缩放到深度 1 处
+ */
+fn viewRay(ndc: vec2f) -> vec3f {
+	let p = clusters.inverseProjection * vec4f(ndc, 0.5, 1.0);
+	let v = p.xyz / p.w;
+	return v / v.z;
+}
+
+@compute @workgroup_size(WORKGROUP_SIZE)
+fn cs_main(@builtin(global_invocation_id) id: vec3u, @builtin(local_invocation_index) localIndex: u32) {
+	let grid = clusters.gridSize.xyz;
+	let cluster = id.x;
+	let valid = cluster < grid.x * grid.y * grid.z;
+
+	var aabbMin = vec3f(0.0);
+	var aabbMax = vec3f(0.0);
+	if (valid) {
+		let cell = vec3u(cluster % grid.x, (cluster / grid.x) % grid.y, cluster / (grid.x * grid.y));
+		let tileMin = vec2f(cell.xy) / vec2f(grid.xy);
+		let tileMax = vec2f(cell.xy + 1u) / vec2f(grid.xy);
+		// 屏幕 y 向下，NDC y 向上
+		let rayMin = viewRay(vec2f(tileMin.x * 2.0 - 1.0, 1.0 - tileMax.y * 2.0));
+		let rayMax = viewRay(vec2f(tileMax.x * 2.0 - 1.0, 1.0 - tileMin.y * 2.0));
+		// 首尾切片延伸到 0 和无穷远，范围之外的片元也有归属
+		var near = sliceDepth(cell.z);
+		var far = sliceDepth(cell.z + 1u);
+		if (cell.z == 0u) {
+			near = 0.0;
+		}
+		if (cell.z + 1u == grid.z) {
+			far = 1e30;
+		}
+		let a = rayMin * near;
+		let b = rayMax * near;
+		let c = rayMin * far;
+		let d = rayMax * far;
+		aabbMin = min(min(a, b), min(c, d));
+		aabbMax = max(max(a, b), max(c, d));
+	}
+
+	var count = 0u;
+	let lightCount = clusters.gridSize.w;
+	for (var base = 0u; base < lightCount; base += WORKGROUP_SIZE) {
+		let lightIndex = base + localIndex;
+		if (lightIndex < lightCount) {
+			let light = lights[lightIndex];
+			sharedLights[localIndex] = vec4f((clusters.viewMatrix * vec4f(light.position, 1.0)).xyz, light.radius);
+		}
+		workgroupBarrier();
+		if (valid) {
+			let batch = min(WORKGROUP_SIZE, lightCount - base);
+			for (var i = 0u; i < batch; i++) {
+				let sphere = sharedLights[i];
+				let delta = clamp(sphere.xyz, aabbMin, aabbMax) - sphere.xyz;
+				if (dot(delta, delta) <= sphere.w * sphere.w && count < MAX_LIGHTS_PER_CLUSTER) {
+					clusterLightIndices[cluster * MAX_LIGHTS_PER_CLUSTER + count] = base + i;
+					count++;
+				}
+			}
+		}
+		workgroupBarrier();
+	}
+
+	if (valid) {
+		clusterLightCounts[cluster] = count;
+	}
+}
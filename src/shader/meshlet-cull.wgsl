@@ -0,0 +1,106 @@
+/**
+ * meshlet 剔除：每个工作组处理一个 (meshlet, 实例)
+ * 通过视锥与法线锥测试的 meshlet，把三角形索引追加到对应实例的压缩索引缓冲区中，
+ * 并通过原子操作累加该实例的 drawIndexedIndirect 参数
+ */
+
+struct Meshlet {
+	center: vec3f,
+	radius: f32,
+	coneApex: vec3f,
+	coneCutoff: f32,
+	coneAxis: vec3f,
+	triangleOffset: u32,
+	triangleCount: u32,
+	vertexCount: u32,
+};
+
+// 与 base.wgsl 中的 InstanceData 相同，模型矩阵已包含模型动画
+struct InstanceData {
+	modelMatrix: mat4x4f,
+	modelViewProjection: mat4x4f,
+	normalMatrix: mat3x3f,
+};
+
+struct CullUniforms {
+	frustumPlanes: array<vec4f, 6>,
+	cameraPosition: vec4f,
+	meshletCount: u32,
+	// 每个实例在压缩索引缓冲区中占用的索引数
+	indexCapacity: u32,
+};
+
+// 与 drawIndexedIndirect 的参数布局一致
+struct DrawIndexedArgs {
+	indexCount: atomic<u32>,
+	instanceCount: u32,
+	firstIndex: u32,
+	baseVertex: i32,
+	firstInstance: u32,
+};
+
+@group(0) @binding(0) var<uniform> cull: CullUniforms;
+@group(0) @binding(1) var<storage, read> meshlets: array<Meshlet>;
+@group(0) @binding(2) var<storage, read> meshletIndices: array<u32>;
+@group(0) @binding(3) var<storage, read> instances: array<InstanceData>;
+// 槽位 -> 实例编号
+@group(0) @binding(4) var<storage, read> cullInstances: array<u32>;
+@group(0) @binding(5) var<storage, read_write> culledIndices: array<u32>;
+@group(0) @binding(6) var<storage, read_write> drawArgs: array<DrawIndexedArgs>;
+
+const WORKGROUP_SIZE = 64u;
+
+var<workgroup> meshletVisible: u32;
+var<workgroup> writeOffset: u32;
+
+fn isVisible(meshlet: Meshlet, modelMatrix: mat4x4f) -> bool {
+	// 模型矩阵只含旋转、平移和统一缩放
+	let scale = length(modelMatrix[0].xyz);
+	let center = (modelMatrix * vec4f(meshlet.center, 1.0)).xyz;
+	let radius = meshlet.radius * scale;
+
+	// 视锥剔除
+	for (var i = 0u; i < 6u; i++) {
+		let plane = cull.frustumPlanes[i];
+		if (dot(plane.xyz, center) + plane.w < -radius) {
+			return false;
+		}
+	}
+
+	// 法线锥剔除：所有三角形都背向相机
+	if (meshlet.coneCutoff <= 1.0) {
+		let apex = (modelMatrix * vec4f(meshlet.coneApex, 1.0)).xyz;
+		let axis = normalize((modelMatrix * vec4f(meshlet.coneAxis, 0.0)).xyz);
+		if (dot(normalize(apex - cull.cameraPosition.xyz), axis) >= meshlet.coneCutoff) {
+			return false;
+		}
+	}
+	return true;
+}
+
+@compute @workgroup_size(WORKGROUP_SIZE)
+fn cs_main(@builtin(workgroup_id) workgroupId: vec3u, @builtin(local_invocation_index) localIndex: u32) {
+	let meshlet = meshlets[workgroupId.x];
+	let slot = workgroupId.y;
+
+	if (localIndex == 0u) {
+		let instanceIndex = cullInstances[slot];
+		let visible = isVisible(meshlet, instances[instanceIndex].modelMatrix);
+		meshletVisible = select(0u, 1u, visible);
+		if (visible) {
+			writeOffset = atomicAdd(&drawArgs[slot].indexCount, meshlet.triangleCount * 3u);
+		}
+	}
+
+	// 屏障之后整个工作组读取同一个结果
+	if (workgroupUniformLoad(&meshletVisible) == 0u) {
+		return;
+	}
+
+	let indexCount = meshlet.triangleCount * 3u;
+	let source = meshlet.triangleOffset * 3u;
+	let destination = slot * cull.indexCapacity + writeOffset;
+	for (var i = localIndex; i < indexCount; i += WORKGROUP_SIZE) {
+		culledIndices[destination + i] = meshletIndices[source + i];
+	}
+}
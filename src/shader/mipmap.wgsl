@@ -0,0 +1,27 @@
+/**
+ * 生成下一级 mipmap：每个线程对上一级的 2x2 像素求平均
+ * 贴图按 sRGB 编码存放（base.wgsl 最后统一做 gamma 校正），平均前先转换到线性空间
+ */
+
+@group(0) @binding(0) var previousMip: texture_2d<f32>;
+@group(0) @binding(1) var nextMip: texture_storage_2d<rgba8unorm, write>;
+
+@compute @workgroup_size(8, 8)
+fn cs_main(@builtin(global_invocation_id) id: vec3u) {
+	let size = textureDimensions(nextMip);
+	if (id.x >= size.x || id.y >= size.y) {
+		return;
+	}
+	// 奇数尺寸时最后一列/行会被重复采样
+	let previousSize = textureDimensions(previousMip, 0);
+	var sum = vec4f(0.0);
+	for (var dy = 0u; dy < 2u; dy++) {
+		for (var dx = 0u; dx < 2u; dx++) {
+			let p = min(id.xy * 2u + vec2u(dx, dy), previousSize - 1u);
+			let c = textureLoad(previousMip, p, 0);
+			sum += vec4f(pow(c.rgb, vec3f(2.2)), c.a);
+		}
+	}
+	let average = sum * 0.25;
+	textureStore(nextMip, id.xy, vec4f(pow(average.rgb, vec3f(1.0 / 2.2)), average.a));
+}
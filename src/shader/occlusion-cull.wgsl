@@ -0,0 +1,139 @@
+/**
+ * 两阶段遮挡剔除：每个线程处理一个实例
+ * 前期（phase 0）：视锥内且上一帧可见的实例直接绘制
+ * 后期（phase 1）：包围球投影到屏幕的矩形与 Hi-Z 比较，更新可见性，前期没画而现在可见的实例补画
+ */
+
+struct CullUniforms {
+	viewMatrix: mat4x4f,
+	projectionMatrix: mat4x4f,
+	frustumPlanes: array<vec4f, 6>,
+	// x 为实例数，y 为阶段，zw 为 Hi-Z 第 0 级的尺寸
+	params: vec4u,
+	// x 为相机近平面，y 为 Hi-Z 的级数
+	camera: vec4f,
+};
+
+struct CullInstance {
+	// 世界空间包围球
+	sphere: vec4f,
+	indexCount: u32,
+	instanceCount: u32,
+	firstIndex: u32,
+	baseVertex: i32,
+	firstInstance: u32,
+};
+
+struct DrawIndexedIndirectArgs {
+	indexCount: u32,
+	instanceCount: u32,
+	firstIndex: u32,
+	baseVertex: i32,
+	firstInstance: u32,
+};
+
+@group(0) @binding(0) var<uniform> cull: CullUniforms;
+@group(0) @binding(1) var<storage, read> instances: array<CullInstance>;
+@group(0) @binding(2) var<storage, read_write> visibility: array<u32>;
+@group(0) @binding(3) var<storage, read_write> drawArgs: array<DrawIndexedIndirectArgs>;
+// 前期绘制数、后期补画数、被遮挡数
+@group(0) @binding(4) var<storage, read_write> stats: array<atomic<u32>, 4>;
+@group(0) @binding(5) var hiz: texture_2d<f32>;
+
+fn sphereInFrustum(sphere: vec4f) -> bool {
+	for (var i = 0u; i < 6u; i++) {
+		let plane = cull.frustumPlanes[i];
+		if (dot(plane.xyz, sphere.xyz) + plane.w < -sphere.w) {
+			return false;
+		}
+	}
+	return true;
+}
+
+/**
+ * 包围球是否被 Hi-Z 中已绘制的深度完全挡住（保守：无法判断时视为可见）
+ */
+fn sphereOccluded(sphere: vec4f) -> bool {
+	let center = (cull.viewMatrix * vec4f(sphere.xyz, 1.0)).xyz;
+	let radius = sphere.w;
+	// 与近平面相交时屏幕矩形不可靠
+	if (center.z - radius <= cull.camera.x) {
+		return false;
+	}
+
+	// 视图空间包围盒的 8 个角投影到 NDC，取屏幕矩形和最近深度
+	var ndcMin = vec3f(1e30);
+	var ndcMax = vec3f(-1e30);
+	for (var i = 0u; i < 8u; i++) {
+		let corner = center + radius * vec3f(
+			select(-1.0, 1.0, (i & 1u) != 0u),
+			select(-1.0, 1.0, (i & 2u) != 0u),
+			select(-1.0, 1.0, (i & 4u) != 0u));
+		let clip = cull.projectionMatrix * vec4f(corner, 1.0);
+		let ndc = clip.xyz / clip.w;
+		ndcMin = min(ndcMin, ndc);
+		ndcMax = max(ndcMax, ndc);
+	}
+	// 屏幕 y 向下，NDC y 向上
+	let uvMin = clamp(vec2f(ndcMin.x, -ndcMax.y) * 0.5 + 0.5, vec2f(0.0), vec2f(1.0));
+	let uvMax = clamp(vec2f(ndcMax.x, -ndcMin.y) * 0.5 + 0.5, vec2f(0.0), vec2f(1.0));
+
+	// 选一级使矩形最多覆盖 2x2 个纹素
+	let levelCount = u32(cull.camera.y);
+	let extent = (uvMax - uvMin) * vec2f(cull.params.zw);
+	var level = u32(clamp(ceil(log2(max(max(extent.x, extent.y), 1.0))), 0.0, f32(levelCount - 1u)));
+	var texelMin = vec2u(0u);
+	var texelMax = vec2u(0u);
+	loop {
+		let size = textureDimensions(hiz, level);
+		texelMin = min(vec2u(uvMin * vec2f(size)), size - 1u);
+		texelMax = min(vec2u(uvMax * vec2f(size)), size - 1u);
+		let span = texelMax - texelMin;
+		if ((span.x <= 1u && span.y <= 1u) || level + 1u >= levelCount) {
+			break;
+		}
+		level++;
+	}
+
+	var farthest = 0.0;
+	for (var y = texelMin.y; y <= texelMax.y; y++) {
+		for (var x = texelMin.x; x <= texelMax.x; x++) {
+			farthest = max(farthest, textureLoad(hiz, vec2u(x, y), level).r);
+		}
+	}
+	return ndcMin.z > farthest;
+}
+
+// 一个工作组的线程数，由 ComputeKernel 按设备的 maxComputeWorkgroupSizeX 设置
+override workgroupSize: u32 = 64u;
+
+@compute @workgroup_size(workgroupSize)
+fn cs_main(@builtin(global_invocation_id) id: vec3u) {
+	let index = id.x;
+	if (index >= cull.params.x) {
+		return;
+	}
+	let instance = instances[index];
+	var args = DrawIndexedIndirectArgs(instance.indexCount, 0u, instance.firstIndex, instance.baseVertex, instance.firstInstance);
+	let inFrustum = instance.instanceCount != 0u && sphereInFrustum(instance.sphere);
+
+	if (cull.params.y == 0u) {
+		if (inFrustum && visibility[index] != 0u) {
+			args.instanceCount = instance.instanceCount;
+			atomicAdd(&stats[0], 1u);
+		}
+	} else {
+		let occluded = inFrustum && sphereOccluded(instance.sphere);
+		let visible = inFrustum && !occluded;
+		// 前期已经画过的实例（视锥内且上一帧可见）不再补画
+		if (visible && visibility[index] == 0u) {
+			args.instanceCount = instance.instanceCount;
+			atomicAdd(&stats[1], 1u);
+		}
+		if (occluded) {
+			atomicAdd(&stats[2], 1u);
+		}
+		visibility[index] = select(0u, 1u, visible);
+	}
+	drawArgs[index] = args;
+}
@@ -0,0 +1,30 @@
+/**
+ * 加权混合 OIT 的合成：全屏三角形，把累积的加权平均颜色按 1 - 透过率 混合到不透明结果上
+ */
+
+@group(0) @binding(0) var accumulationTexture: texture_2d<f32>;
+@group(0) @binding(1) var revealageTexture: texture_2d<f32>;
+
+@vertex
+fn vs_main(@builtin(vertex_index) vertexIndex: u32) -> @builtin(position) vec4f {
+	// 覆盖整个屏幕的三角形：(-1, -1)、(3, -1)、(-1, 3)
+	let uv = vec2f(f32((vertexIndex << 1u) & 2u), f32(vertexIndex & 2u));
+	return vec4f(uv * 2.0 - 1.0, 0.0, 1.0);
+}
+
+@fragment
+fn fs_main(@builtin(position) position: vec4f) -> @location(0) vec4f {
+	let pixel = vec2u(position.xy);
+	let revealage = textureLoad(revealageTexture, pixel, 0).r;
+	// 没有透明片元覆盖的像素
+	if (revealage >= 1.0) {
+		discard;
+	}
+	var accumulation = textureLoad(accumulationTexture, pixel, 0);
+	// 权重很大时 RGBA16Float 可能溢出，避免 inf / inf
+	if (any(abs(accumulation) > vec4f(65504.0))) {
+		accumulation = vec4f(accumulation.a);
+	}
+	let averageColor = accumulation.rgb / max(accumulation.a, 1e-5);
+	return vec4f(averageColor, 1.0 - revealage);
+}
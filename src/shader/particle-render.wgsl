@@ -0,0 +1,61 @@
+/**
+ * 粒子公告板：每个实例是一个存活粒子，6 个顶点组成面向相机的四边形，叠加混合，深度只测试不写入
+ */
+
+struct RenderUniforms {
+	viewProjection: mat4x4f,
+	// xyz 为相机右方向，w 为粒子尺寸
+	cameraRight: vec4f,
+	// xyz 为相机上方向
+	cameraUp: vec4f,
+	color: vec4f,
+	// x 为本帧存活列表在 aliveLists 中的偏移
+	params: vec4u,
+};
+
+struct Particle {
+	position: vec3f,
+	age: f32,
+	velocity: vec3f,
+	lifetime: f32,
+};
+
+@group(0) @binding(0) var<uniform> billboard: RenderUniforms;
+@group(0) @binding(1) var<storage, read> particles: array<Particle>;
+@group(0) @binding(2) var<storage, read> aliveLists: array<u32>;
+
+struct VertexOutput {
+	@builtin(position) position: vec4f,
+	@location(0) uv: vec2f,
+	@location(1) color: vec4f,
+};
+
+@vertex
+fn vs_main(@builtin(vertex_index) vertexIndex: u32, @builtin(instance_index) instanceIndex: u32) -> VertexOutput {
+	var corners = array<vec2f, 6>(
+		vec2f(-1.0, -1.0), vec2f(1.0, -1.0), vec2f(1.0, 1.0),
+		vec2f(-1.0, -1.0), vec2f(1.0, 1.0), vec2f(-1.0, 1.0));
+	let corner = corners[vertexIndex];
+	let particle = particles[aliveLists[billboard.params.x + instanceIndex]];
+
+	// 临近寿命结束时淡出
+	let life = clamp(particle.age / particle.lifetime, 0.0, 1.0);
+	let size = billboard.cameraRight.w * (1.0 - 0.5 * life);
+	let world = particle.position + (billboard.cameraRight.xyz * corner.x + billboard.cameraUp.xyz * corner.y) * size;
+
+	var out: VertexOutput;
+	out.position = billboard.viewProjection * vec4f(world, 1.0);
+	out.uv = corner;
+	out.color = vec4f(billboard.color.rgb, billboard.color.a * (1.0 - life));
+	return out;
+}
+
+@fragment
+fn fs_main(in: VertexOutput) -> @location(0) vec4f {
+	let falloff = 1.0 - smoothstep(0.5, 1.0, length(in.uv));
+	if (falloff <= 0.0) {
+		discard;
+	}
+	let alpha = in.color.a * falloff;
+	return vec4f(in.color.rgb * alpha, alpha);
+}
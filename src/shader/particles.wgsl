@@ -0,0 +1,187 @@
+/**
+ * GPU 粒子模拟：粒子、死亡列表和两个存活列表都在存储缓冲区中，每帧依次分发
+ * cs_begin（1 个线程）：由死亡粒子数决定本帧发射数，写入发射和模拟的间接分发参数，清空输出存活列表
+ * cs_emit：从死亡列表取出粒子初始化，追加到输入存活列表
+ * cs_simulate：积分、与平面/球体 SDF 碰撞，仍存活的追加到输出存活列表，寿命结束的放回死亡列表
+ * cs_finish（1 个线程）：把输出存活列表的长度写入间接绘制参数的实例数
+ * 下一帧输入和输出存活列表交换，整个过程不需要回读到 CPU
+ */
+
+struct SimulationUniforms {
+	// xyz 为发射器位置，w 为发射锥的半角余弦
+	emitterPosition: vec4f,
+	// xyz 为发射方向，w 为初速度
+	emitterDirection: vec4f,
+	// xyz 为重力加速度，w 为本帧时间步长
+	gravity: vec4f,
+	// x、y 为寿命范围，z 为空气阻力，w 为碰撞的弹性系数
+	lifetime: vec4f,
+	// 碰撞平面：xyz 为法向，w 为偏移（dot(n, p) + w = 0）
+	planes: array<vec4f, 4>,
+	// 碰撞球体：xyz 为球心，w 为半径
+	spheres: array<vec4f, 4>,
+	// x 为粒子数上限，y 为本帧请求的发射数，z 为帧号（随机数种子），w 为输入存活列表的编号
+	params: vec4u,
+	// x 为平面数，y 为球体数
+	colliders: vec4u,
+};
+
+struct Particle {
+	position: vec3f,
+	age: f32,
+	velocity: vec3f,
+	lifetime: f32,
+};
+
+@group(0) @binding(0) var<uniform> simulation: SimulationUniforms;
+@group(0) @binding(1) var<storage, read_write> particles: array<Particle>;
+@group(0) @binding(2) var<storage, read_write> deadList: array<u32>;
+// 两个存活列表首尾相接，各 params.x 个
+@group(0) @binding(3) var<storage, read_write> aliveLists: array<u32>;
+// 两个存活列表的长度、死亡粒子数、本帧发射数
+@group(0) @binding(4) var<storage, read_write> counters: array<atomic<u32>, 4>;
+// [0..2] 发射的分发参数，[3..5] 模拟的分发参数，[8..11] drawIndirect 参数
+@group(0) @binding(5) var<storage, read_write> indirectArgs: array<u32, 12>;
+
+const WORKGROUP_SIZE = 64u;
+// 每个维度的工作组数上限（WebGPU 的默认限制），超过时折叠到 y 方向
+const MAX_WORKGROUPS = 65535u;
+const DEAD_COUNTER = 2u;
+const EMIT_COUNTER = 3u;
+
+fn writeDispatchArgs(offset: u32, threadCount: u32) {
+	let groups = (threadCount + WORKGROUP_SIZE - 1u) / WORKGROUP_SIZE;
+	let groupsY = max((groups + MAX_WORKGROUPS - 1u) / MAX_WORKGROUPS, 1u);
+	indirectArgs[offset] = (groups + groupsY - 1u) / groupsY;
+	indirectArgs[offset + 1u] = groupsY;
+	indirectArgs[offset + 2u] = 1u;
+}
+
+fn threadIndex(groupId: vec3u, groupCount: vec3u, localIndex: u32) -> u32 {
+	return (groupId.x + groupId.y * groupCount.x) * WORKGROUP_SIZE + localIndex;
+}
+
+fn inputList() -> u32 {
+	return simulation.params.w;
+}
+
+fn outputList() -> u32 {
+	return 1u - simulation.params.w;
+}
+
+// PCG 哈希
+fn hash(value: u32) -> u32 {
+	let state = value * 747796405u + 2891336453u;
+	let word = ((state >> ((state >> 28u) + 4u)) ^ state) * 277803737u;
+	return (word >> 22u) ^ word;
+}
+
+fn random01(seed: ptr<function, u32>) -> f32 {
+	*seed = hash(*seed);
+	return f32(*seed >> 8u) / 16777216.0;
+}
+
+@compute @workgroup_size(1)
+fn cs_begin() {
+	let alive = atomicLoad(&counters[inputList()]);
+	let emitCount = min(simulation.params.y, atomicLoad(&counters[DEAD_COUNTER]));
+	atomicStore(&counters[EMIT_COUNTER], emitCount);
+	atomicStore(&counters[outputList()], 0u);
+	writeDispatchArgs(0u, emitCount);
+	writeDispatchArgs(3u, alive + emitCount);
+	// 每个粒子是两个三角形组成的公告板
+	indirectArgs[8] = 6u;
+	indirectArgs[9] = 0u;
+	indirectArgs[10] = 0u;
+	indirectArgs[11] = 0u;
+}
+
+@compute @workgroup_size(WORKGROUP_SIZE)
+fn cs_emit(@builtin(workgroup_id) groupId: vec3u, @builtin(num_workgroups) groupCount: vec3u, @builtin(local_invocation_index) localIndex: u32) {
+	let item = threadIndex(groupId, groupCount, localIndex);
+	if (item >= atomicLoad(&counters[EMIT_COUNTER])) {
+		return;
+	}
+	// 发射数不超过死亡粒子数，这里不会减到 0 以下
+	let index = deadList[atomicSub(&counters[DEAD_COUNTER], 1u) - 1u];
+
+	// 在发射锥内均匀取方向
+	var seed = hash(item ^ (simulation.params.z * 1664525u));
+	let cosAngle = mix(1.0, simulation.emitterPosition.w, random01(&seed));
+	let sinAngle = sqrt(max(1.0 - cosAngle * cosAngle, 0.0));
+	let phi = random01(&seed) * 6.2831853;
+	let axis = normalize(simulation.emitterDirection.xyz);
+	let helper = select(vec3f(1.0, 0.0, 0.0), vec3f(0.0, 1.0, 0.0), abs(axis.x) > 0.9);
+	let tangent = normalize(cross(axis, helper));
+	let bitangent = cross(axis, tangent);
+	let direction = axis * cosAngle + (tangent * cos(phi) + bitangent * sin(phi)) * sinAngle;
+	let speed = simulation.emitterDirection.w * mix(0.8, 1.2, random01(&seed));
+
+	var particle: Particle;
+	particle.position = simulation.emitterPosition.xyz;
+	particle.velocity = direction * speed;
+	particle.age = 0.0;
+	particle.lifetime = mix(simulation.lifetime.x, simulation.lifetime.y, random01(&seed));
+	particles[index] = particle;
+
+	let slot = atomicAdd(&counters[inputList()], 1u);
+	aliveLists[inputList() * simulation.params.x + slot] = index;
+}
+
+/**
+ * 把粒子推出碰撞体表面，法向速度按弹性系数反弹
+ */
+fn collide(particle: ptr<function, Particle>, normal: vec3f, penetration: f32) {
+	(*particle).position += normal * penetration;
+	let normalSpeed = dot((*particle).velocity, normal);
+	if (normalSpeed < 0.0) {
+		(*particle).velocity -= (1.0 + simulation.lifetime.w) * normalSpeed * normal;
+	}
+}
+
+@compute @workgroup_size(WORKGROUP_SIZE)
+fn cs_simulate(@builtin(workgroup_id) groupId: vec3u, @builtin(num_workgroups) groupCount: vec3u, @builtin(local_invocation_index) localIndex: u32) {
+	let item = threadIndex(groupId, groupCount, localIndex);
+	if (item >= atomicLoad(&counters[inputList()])) {
+		return;
+	}
+	let index = aliveLists[inputList() * simulation.params.x + item];
+	var particle = particles[index];
+	let dt = simulation.gravity.w;
+
+	particle.age += dt;
+	if (particle.age >= particle.lifetime) {
+		let slot = atomicAdd(&counters[DEAD_COUNTER], 1u);
+		deadList[slot] = index;
+		return;
+	}
+
+	particle.velocity += simulation.gravity.xyz * dt;
+	particle.velocity *= max(1.0 - simulation.lifetime.z * dt, 0.0);
+	particle.position += particle.velocity * dt;
+
+	for (var i = 0u; i < simulation.colliders.x; i++) {
+		let plane = simulation.planes[i];
+		let signedDistance = dot(plane.xyz, particle.position) + plane.w;
+		if (signedDistance < 0.0) {
+			collide(&particle, plane.xyz, -signedDistance);
+		}
+	}
+	for (var i = 0u; i < simulation.colliders.y; i++) {
+		let sphere = simulation.spheres[i];
+		let offset = particle.position - sphere.xyz;
+		let centerDistance = length(offset);
+		if (centerDistance < sphere.w && centerDistance > 0.0) {
+			collide(&particle, offset / centerDistance, sphere.w - centerDistance);
+		}
+	}
+	particles[index] = particle;
+
+	let slot = atomicAdd(&counters[outputList()], 1u);
+	aliveLists[outputList() * simulation.params.x + slot] = index;
+}
+
+@compute @workgroup_size(1)
+fn cs_finish() {
+	indirectArgs[9] = atomicLoad(&counters[outputList()]);
+}
@@ -0,0 +1,116 @@
+/**
+ * 键值对基数排序（升序、稳定），每遍处理 4 位，一块 TILE_SIZE 个元素
+ * cs_histogram：统计每块每个数位的个数，按数位优先写入 blockHistogram[digit * blockCount + block]
+ * 之后由 scan.wgsl 对 blockHistogram 求排他前缀和，得到每块每个数位在输出中的起始位置
+ * cs_scatter：块内按当前数位做 4 次 1 位的稳定划分，再把每个元素写到起始位置加上它在块内同数位元素中的名次
+ */
+
+struct SortParams {
+	// 元素数
+	count: u32,
+	// 块数
+	blockCount: u32,
+	// 本遍数位的最低位
+	shift: u32,
+	_pad: u32,
+};
+
+@group(0) @binding(0) var<uniform> params: SortParams;
+@group(0) @binding(1) var<storage, read> keysIn: array<u32>;
+
+const WORKGROUP_SIZE = 256u;
+const TILE_SIZE = 256u;
+const RADIX_BITS = 4u;
+const RADIX = 16u;
+
+var<workgroup> sharedHistogram: array<atomic<u32>, RADIX>;
+
+fn tileIndex(groupId: vec3u, groupCount: vec3u) -> u32 {
+	return groupId.x + groupId.y * groupCount.x;
+}
+
+@group(0) @binding(2) var<storage, read_write> blockHistogram: array<u32>;
+
+@compute @workgroup_size(WORKGROUP_SIZE)
+fn cs_histogram(@builtin(workgroup_id) groupId: vec3u, @builtin(num_workgroups) groupCount: vec3u, @builtin(local_invocation_index) localIndex: u32) {
+	let tile = tileIndex(groupId, groupCount);
+	if (localIndex < RADIX) {
+		atomicStore(&sharedHistogram[localIndex], 0u);
+	}
+	workgroupBarrier();
+	let index = tile * TILE_SIZE + localIndex;
+	if (index < params.count) {
+		let digit = (keysIn[index] >> params.shift) & (RADIX - 1u);
+		atomicAdd(&sharedHistogram[digit], 1u);
+	}
+	workgroupBarrier();
+	if (localIndex < RADIX && tile < params.blockCount) {
+		blockHistogram[localIndex * params.blockCount + tile] = atomicLoad(&sharedHistogram[localIndex]);
+	}
+}
+
+@group(0) @binding(2) var<storage, read> valuesIn: array<u32>;
+@group(0) @binding(3) var<storage, read> blockOffsets: array<u32>;
+@group(0) @binding(4) var<storage, read_write> keysOut: array<u32>;
+@group(0) @binding(5) var<storage, read_write> valuesOut: array<u32>;
+
+var<workgroup> sharedKeys: array<u32, TILE_SIZE>;
+var<workgroup> sharedValues: array<u32, TILE_SIZE>;
+var<workgroup> sharedZeros: array<u32, TILE_SIZE>;
+// 块内每个数位第一个元素的位置
+var<workgroup> sharedDigitStart: array<u32, RADIX>;
+
+@compute @workgroup_size(WORKGROUP_SIZE)
+fn cs_scatter(@builtin(workgroup_id) groupId: vec3u, @builtin(num_workgroups) groupCount: vec3u, @builtin(local_invocation_index) localIndex: u32) {
+	let tile = tileIndex(groupId, groupCount);
+	let index = tile * TILE_SIZE + localIndex;
+	let valid = index < params.count;
+	// 块末尾不足的部分用最大的键填充，稳定划分后排在所有有效元素之后
+	var key = 0xFFFFFFFFu;
+	var value = 0u;
+	if (valid) {
+		key = keysIn[index];
+		value = valuesIn[index];
+	}
+
+	// 按数位的 4 个位依次做稳定划分：该位为 0 的元素保持顺序排在前面
+	var position = localIndex;
+	for (var bit = 0u; bit < RADIX_BITS; bit++) {
+		let isZero = select(0u, 1u, ((key >> (params.shift + bit)) & 1u) == 0u);
+		sharedZeros[localIndex] = isZero;
+		workgroupBarrier();
+		for (var offset = 1u; offset < TILE_SIZE; offset <<= 1u) {
+			var addend = 0u;
+			if (localIndex >= offset) {
+				addend = sharedZeros[localIndex - offset];
+			}
+			workgroupBarrier();
+			sharedZeros[localIndex] += addend;
+			workgroupBarrier();
+		}
+		let zerosBefore = sharedZeros[localIndex] - isZero;
+		let totalZeros = sharedZeros[TILE_SIZE - 1u];
+		position = select(totalZeros + localIndex - zerosBefore, zerosBefore, isZero != 0u);
+		workgroupBarrier();
+		sharedKeys[position] = key;
+		sharedValues[position] = value;
+		workgroupBarrier();
+		key = sharedKeys[localIndex];
+		value = sharedValues[localIndex];
+		workgroupBarrier();
+	}
+
+	// 现在块内已按数位排好序，相邻数位不同的位置就是后一个数位的起点
+	let digit = (key >> params.shift) & (RADIX - 1u);
+	if (localIndex == 0u || digit != ((sharedKeys[localIndex - 1u] >> params.shift) & (RADIX - 1u))) {
+		sharedDigitStart[digit] = localIndex;
+	}
+	workgroupBarrier();
+
+	// 有效元素排在块的前面
+	if (tile < params.blockCount && tile * TILE_SIZE + localIndex < params.count) {
+		let destination = blockOffsets[digit * params.blockCount + tile] + localIndex - sharedDigitStart[digit];
+		keysOut[destination] = key;
+		valuesOut[destination] = value;
+	}
+}
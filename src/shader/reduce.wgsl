@@ -0,0 +1,73 @@
+/**
+ * 归约：每个工作组先在共享内存中归约一块 TILE_SIZE 个元素，再用一次原子操作合并到结果
+ * cs_reduce_init 先把结果写成运算的单位元，两次分发在同一计算通道内按顺序执行
+ */
+
+struct ReduceParams {
+	// 元素数
+	count: u32,
+	_pad: u32,
+	// 0 求和（按 2^32 取模），1 最小值，2 最大值
+	op: u32,
+	// 结果在 result 中的下标
+	resultIndex: u32,
+};
+
+@group(0) @binding(0) var<uniform> params: ReduceParams;
+@group(0) @binding(1) var<storage, read> input: array<u32>;
+@group(0) @binding(2) var<storage, read_write> result: array<atomic<u32>>;
+
+const WORKGROUP_SIZE = 256u;
+const ITEMS_PER_THREAD = 4u;
+const TILE_SIZE = 1024u;
+
+var<workgroup> sharedValues: array<u32, WORKGROUP_SIZE>;
+
+fn identity() -> u32 {
+	return select(0u, 0xFFFFFFFFu, params.op == 1u);
+}
+
+fn combine(a: u32, b: u32) -> u32 {
+	if (params.op == 0u) {
+		return a + b;
+	}
+	if (params.op == 1u) {
+		return min(a, b);
+	}
+	return max(a, b);
+}
+
+@compute @workgroup_size(1)
+fn cs_reduce_init() {
+	atomicStore(&result[params.resultIndex], identity());
+}
+
+@compute @workgroup_size(WORKGROUP_SIZE)
+fn cs_reduce(@builtin(workgroup_id) groupId: vec3u, @builtin(num_workgroups) groupCount: vec3u, @builtin(local_invocation_index) localIndex: u32) {
+	let tile = groupId.x + groupId.y * groupCount.x;
+	let first = tile * TILE_SIZE + localIndex * ITEMS_PER_THREAD;
+	var value = identity();
+	for (var i = 0u; i < ITEMS_PER_THREAD; i++) {
+		if (first + i < params.count) {
+			value = combine(value, input[first + i]);
+		}
+	}
+
+	sharedValues[localIndex] = value;
+	workgroupBarrier();
+	for (var stride = WORKGROUP_SIZE / 2u; stride > 0u; stride >>= 1u) {
+		if (localIndex < stride) {
+			sharedValues[localIndex] = combine(sharedValues[localIndex], sharedValues[localIndex + stride]);
+		}
+		workgroupBarrier();
+	}
+
+	if (localIndex == 0u && tile * TILE_SIZE < params.count) {
+		let total = sharedValues[0];
+		switch (params.op) {
+			case 0u: { atomicAdd(&result[params.resultIndex], total); }
+			case 1u: { atomicMin(&result[params.resultIndex], total); }
+			default: { atomicMax(&result[params.resultIndex], total); }
+		}
+	}
+}
@@ -0,0 +1,126 @@
+/**
+ * 单遍前缀和（decoupled look-back）：每个工作组处理一块 TILE_SIZE 个元素
+ * 块号由原子计数器按工作组开始执行的顺序分配，保证前面的块一定已经开始（或已经结束），
+ * 因此只按顺序执行工作组的软件适配器上也不会死等
+ * 每块的状态把标志和数值打包在一个 u32 里：高 2 位为标志，低 30 位为数值，所以总和必须小于 2^30
+ */
+
+struct PrimitiveParams {
+	// 元素数
+	count: u32,
+	// 块数
+	blockCount: u32,
+	// 非 0 时把输入视为谓词（非 0 计为 1）
+	predicate: u32,
+	_pad: u32,
+};
+
+@group(0) @binding(0) var<uniform> params: PrimitiveParams;
+@group(0) @binding(1) var<storage, read> input: array<u32>;
+@group(0) @binding(2) var<storage, read_write> output: array<u32>;
+// [0] 为块号计数器，[1 + i] 为第 i 块的状态
+@group(0) @binding(3) var<storage, read_write> tileStates: array<atomic<u32>>;
+
+const WORKGROUP_SIZE = 256u;
+const ITEMS_PER_THREAD = 4u;
+const TILE_SIZE = 1024u;
+
+// 只有本块的和
+const FLAG_AGGREGATE = 0x40000000u;
+// 包含前面所有块的和
+const FLAG_PREFIX = 0x80000000u;
+const FLAG_MASK = 0xC0000000u;
+const VALUE_MASK = 0x3FFFFFFFu;
+
+var<workgroup> sharedSums: array<u32, WORKGROUP_SIZE>;
+var<workgroup> sharedTile: u32;
+var<workgroup> sharedPrefix: u32;
+
+@compute @workgroup_size(WORKGROUP_SIZE)
+fn cs_scan(@builtin(local_invocation_index) localIndex: u32) {
+	if (localIndex == 0u) {
+		sharedTile = atomicAdd(&tileStates[0], 1u);
+	}
+	let tile = workgroupUniformLoad(&sharedTile);
+	// 分发按工作组数向上取整，多出来的工作组直接退出
+	if (tile >= params.blockCount) {
+		return;
+	}
+
+	// 线程内的排他前缀和
+	let first = tile * TILE_SIZE + localIndex * ITEMS_PER_THREAD;
+	var prefixes: array<u32, ITEMS_PER_THREAD>;
+	var threadSum = 0u;
+	for (var i = 0u; i < ITEMS_PER_THREAD; i++) {
+		var value = 0u;
+		if (first + i < params.count) {
+			value = input[first + i];
+			if (params.predicate != 0u) {
+				value = select(0u, 1u, value != 0u);
+			}
+		}
+		prefixes[i] = threadSum;
+		threadSum += value;
+	}
+
+	// 工作组内的包含前缀和
+	sharedSums[localIndex] = threadSum;
+	workgroupBarrier();
+	for (var offset = 1u; offset < WORKGROUP_SIZE; offset <<= 1u) {
+		var addend = 0u;
+		if (localIndex >= offset) {
+			addend = sharedSums[localIndex - offset];
+		}
+		workgroupBarrier();
+		sharedSums[localIndex] += addend;
+		workgroupBarrier();
+	}
+	let threadPrefix = sharedSums[localIndex] - threadSum;
+
+	// 发布本块的和，向前查找直到遇到带前缀的块
+	if (localIndex == 0u) {
+		let aggregate = sharedSums[WORKGROUP_SIZE - 1u];
+		var exclusive = 0u;
+		if (tile == 0u) {
+			atomicStore(&tileStates[1], FLAG_PREFIX | (aggregate & VALUE_MASK));
+		} else {
+			atomicStore(&tileStates[1u + tile], FLAG_AGGREGATE | (aggregate & VALUE_MASK));
+			var lookback = tile - 1u;
+			loop {
+				let state = atomicLoad(&tileStates[1u + lookback]);
+				let flag = state & FLAG_MASK;
+				// 前面的块还没有发布，继续等待
+				if (flag == 0u) {
+					continue;
+				}
+				exclusive += state & VALUE_MASK;
+				if (flag == FLAG_PREFIX) {
+					break;
+				}
+				lookback -= 1u;
+			}
+			atomicStore(&tileStates[1u + tile], FLAG_PREFIX | ((exclusive + aggregate) & VALUE_MASK));
+		}
+		sharedPrefix = exclusive;
+	}
+	let tilePrefix = workgroupUniformLoad(&sharedPrefix);
+
+	for (var i = 0u; i < ITEMS_PER_THREAD; i++) {
+		if (first + i < params.count) {
+			output[first + i] = tilePrefix + threadPrefix + prefixes[i];
+		}
+	}
+}
+
+@group(0) @binding(1) var<storage, read_write> clearTarget: array<u32>;
+
+/**
+ * 把 clearTarget 的前 count 个元素清零（扫描前重置块状态）
+ */
+@compute @workgroup_size(WORKGROUP_SIZE)
+fn cs_clear(@builtin(workgroup_id) groupId: vec3u, @builtin(num_workgroups) groupCount: vec3u, @builtin(local_invocation_index) localIndex: u32) {
+	let index = (groupId.x + groupId.y * groupCount.x) * WORKGROUP_SIZE + localIndex;
+	if (index < params.count) {
+		clearTarget[index] = 0u;
+	}
+}
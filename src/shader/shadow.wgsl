@@ -0,0 +1,35 @@
+/**
+ * 阴影贴图：只有顶点着色器的深度管线，把实例变换到当前级联的光源裁剪空间
+ */
+
+/**
+ * 与 base.wgsl 中的 MyUniforms 相同
+ */
+struct MyUniforms {
+	viewDepthRow: vec4f,
+	color: vec4f,
+	time: f32,
+	positionOffset: vec4f,
+	positionScale: vec4f,
+};
+
+struct InstanceData {
+	modelMatrix: mat4x4f,
+	modelViewProjection: mat4x4f,
+	normalMatrix: mat3x3f,
+};
+
+struct CascadeUniforms {
+	lightViewProjection: mat4x4f,
+};
+
+@group(0) @binding(0) var<uniform> uMyUniforms: MyUniforms;
+@group(0) @binding(1) var<storage, read> instances: array<InstanceData>;
+// 当前级联（动态偏移）
+@group(0) @binding(2) var<uniform> uCascade: CascadeUniforms;
+
+@vertex
+fn vs_main(@location(0) position: vec3f, @builtin(instance_index) instanceIndex: u32) -> @builtin(position) vec4f {
+	let localPosition = position * uMyUniforms.positionScale.xyz + uMyUniforms.positionOffset.xyz;
+	return uCascade.lightViewProjection * (instances[instanceIndex].modelMatrix * vec4f(localPosition, 1.0));
+}
@@ -0,0 +1,77 @@
+/**
+ * 线性混合蒙皮：每个线程处理一个顶点，绑定姿态的位置和法向量按最多 4 个关节的矩阵加权变换，
+ * 写入共享的蒙皮顶点缓冲区（交错顶点中的位置和法向量）和只含位置的顶点流，颜色和纹理坐标保持不变。
+ * 主渲染通道、深度预通道和阴影都直接读取蒙皮后的缓冲区，不重复蒙皮。
+ */
+
+struct SkinningUniforms {
+	// x 为顶点数，y 为 1 时写紧凑顶点格式，z 为交错顶点的步长（u32 个数），w 为位置流的步长（u32 个数）
+	params: vec4u,
+	// 紧凑格式的位置量化参数：(position - offset) / scale 映射到 [-1, 1]
+	positionOffset: vec4f,
+	positionScale: vec4f,
+};
+
+@group(0) @binding(0) var<uniform> skinning: SkinningUniforms;
+// 每个顶点两项：绑定姿态的位置（w 为填充）和法向量
+@group(0) @binding(1) var<storage, read> bindPose: array<vec4f>;
+// x 为 4 个 8 位关节编号，y、z 为 4 个 Unorm16 权重
+@group(0) @binding(2) var<storage, read> skin: array<vec4u>;
+@group(0) @binding(3) var<storage, read> jointMatrices: array<mat4x4f>;
+@group(0) @binding(4) var<storage, read_write> vertices: array<u32>;
+@group(0) @binding(5) var<storage, read_write> positions: array<u32>;
+
+/**
+ * 八面体编码，与 vertex-quantization.cpp 中的 octEncode 一致
+ */
+fn octEncode(n: vec3f) -> vec2f {
+	let p = n.xy / (abs(n.x) + abs(n.y) + abs(n.z));
+	if (n.z < 0.0) {
+		let signs = select(vec2f(-1.0), vec2f(1.0), p >= vec2f(0.0));
+		return (1.0 - abs(p.yx)) * signs;
+	}
+	return p;
+}
+
+// 一个工作组的线程数，由 ComputeKernel 按设备的 maxComputeWorkgroupSizeX 设置
+override workgroupSize: u32 = 64u;
+
+@compute @workgroup_size(workgroupSize)
+fn cs_main(@builtin(workgroup_id) groupId: vec3u, @builtin(num_workgroups) groupCount: vec3u, @builtin(local_invocation_index) localIndex: u32) {
+	// 超过每维工作组上限的部分折叠在 y 方向
+	let index = (groupId.x + groupId.y * groupCount.x) * workgroupSize + localIndex;
+	if (index >= skinning.params.x) {
+		return;
+	}
+
+	let weights = skin[index];
+	let w = vec4f(unpack2x16unorm(weights.y), unpack2x16unorm(weights.z));
+	let joints = vec4u(weights.x & 0xFFu, (weights.x >> 8u) & 0xFFu, (weights.x >> 16u) & 0xFFu, weights.x >> 24u);
+	let matrix = jointMatrices[joints.x] * w.x + jointMatrices[joints.y] * w.y
+		+ jointMatrices[joints.z] * w.z + jointMatrices[joints.w] * w.w;
+
+	// 关节变换只含旋转、平移和均匀缩放，法向量直接用同一个矩阵变换
+	let position = (matrix * vec4f(bindPose[2u * index].xyz, 1.0)).xyz;
+	let normal = normalize((matrix * vec4f(bindPose[2u * index + 1u].xyz, 0.0)).xyz);
+
+	let vertexBase = index * skinning.params.z;
+	let positionBase = index * skinning.params.w;
+	if (skinning.params.y != 0u) {
+		// 与 CompactVertexAttributes 一致：Snorm16x4 位置（w 为 0）、八面体编码的 Snorm16x2 法向量
+		let normalized = (position - skinning.positionOffset.xyz) / skinning.positionScale.xyz;
+		let packedXY = pack2x16snorm(normalized.xy);
+		let packedZW = pack2x16snorm(vec2f(normalized.z, 0.0));
+		vertices[vertexBase] = packedXY;
+		vertices[vertexBase + 1u] = packedZW;
+		vertices[vertexBase + 2u] = pack2x16snorm(octEncode(normal));
+		positions[positionBase] = packedXY;
+		positions[positionBase + 1u] = packedZW;
+	} else {
+		// 与 VertexAttributes 一致：位置和法向量各 3 个 float
+		for (var i = 0u; i < 3u; i++) {
+			vertices[vertexBase + i] = bitcast<u32>(position[i]);
+			vertices[vertexBase + 3u + i] = bitcast<u32>(normal[i]);
+			positions[positionBase + i] = bitcast<u32>(position[i]);
+		}
+	}
+}
@@ -0,0 +1,67 @@
+#include "alloc-counter.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+namespace webgpu {
+
+namespace {
+std::atomic<uint64_t> heapAllocationCount{ 0 };
+}
+
+uint64_t getHeapAllocationCount() {
+	return heapAllocationCount.load(std::memory_order_relaxed);
+}
+
+}
+
+#ifdef ALLOC_COUNTER_ENABLED
+
+// 替换全局 operator new/delete，统计堆分配次数
+// 对齐版本与数组版本默认转发到这里，因此只需替换这两组
+
+void* operator new(size_t size) {
+	webgpu::heapAllocationCount.fetch_add(1, std::memory_order_relaxed);
+	if (void* p = std::malloc(size ? size : 1)) {
+		return p;
+	}
+	throw std::bad_alloc();
+}
+
+void* operator new(size_t size, std::align_val_t alignment) {
+	webgpu::heapAllocationCount.fetch_add(1, std::memory_order_relaxed);
+	size_t align = static_cast<size_t>(alignment);
+	size_t bytes = (size + align - 1) / align * align;
+#ifdef _MSC_VER
+	void* p = _aligned_malloc(bytes ? bytes : align, align);
+#else
+	void* p = std::aligned_alloc(align, bytes ? bytes : align);
+#endif
+	if (p) {
+		return p;
+	}
+	throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept {
+	std::free(p);
+}
+
+void operator delete(void* p, size_t /* size */) noexcept {
+	std::free(p);
+}
+
+void operator delete(void* p, std::align_val_t /* alignment */) noexcept {
+#ifdef _MSC_VER
+	_aligned_free(p);
+#else
+	std::free(p);
+#endif
+}
+
+void operator delete(void* p, size_t /* size */, std::align_val_t alignment) noexcept {
+	operator delete(p, alignment);
+}
+
+#endif // ALLOC_COUNTER_ENABLED
@@ -0,0 +1,13 @@
+#pragma once
+
+#include "global.h"
+
+namespace webgpu {
+
+/**
+ * @brief 进程启动以来全局 operator new 的调用次数
+ * 仅在定义 ALLOC_COUNTER_ENABLED 时统计（CMake 选项 -DALLOC_COUNTER=ON），否则恒为 0
+ */
+uint64_t getHeapAllocationCount();
+
+}
@@ -0,0 +1,235 @@
+#include "animation.h"
+
+#include <algorithm>
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#  include <emmintrin.h>
+#  define ANIMATION_USE_SSE2
+#endif
+
+namespace webgpu {
+
+void JointPoses::resize(size_t count) {
+	for (std::vector<float>* component : { &translationX, &translationY, &translationZ, &rotationX, &rotationY, &rotationZ, &rotationW,
+		&scaleX, &scaleY, &scaleZ }) {
+		component->resize(count);
+	}
+}
+
+void JointPoses::set(size_t joint, const glm::vec3& translation, const glm::quat& rotation, const glm::vec3& scale) {
+	translationX[joint] = translation.x;
+	translationY[joint] = translation.y;
+	translationZ[joint] = translation.z;
+	rotationX[joint] = rotation.x;
+	rotationY[joint] = rotation.y;
+	rotationZ[joint] = rotation.z;
+	rotationW[joint] = rotation.w;
+	scaleX[joint] = scale.x;
+	scaleY[joint] = scale.y;
+	scaleZ[joint] = scale.z;
+}
+
+glm::mat4x4 JointPoses::localMatrix(size_t joint) const {
+	glm::quat rotation(rotationW[joint], rotationX[joint], rotationY[joint], rotationZ[joint]);
+	glm::mat4x4 matrix = glm::mat4_cast(rotation);
+	matrix[0] *= scaleX[joint];
+	matrix[1] *= scaleY[joint];
+	matrix[2] *= scaleZ[joint];
+	matrix[3] = glm::vec4(translationX[joint], translationY[joint], translationZ[joint], 1.0f);
+	return matrix;
+}
+
+void blendPoses(const JointPoses& a, const JointPoses& b, float weight, JointPoses& out) {
+	size_t count = std::min(a.size(), b.size());
+	out.resize(count);
+	float inverseWeight = 1.0f - weight;
+	size_t joint = 0;
+
+#ifdef ANIMATION_USE_SSE2
+	const __m128 w = _mm_set1_ps(weight);
+	const __m128 iw = _mm_set1_ps(inverseWeight);
+	const __m128 signMask = _mm_set1_ps(-0.0f);
+	const __m128 one = _mm_set1_ps(1.0f);
+	auto lerp = [&](const std::vector<float>& x, const std::vector<float>& y, std::vector<float>& result) {
+		__m128 blended = _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(x.data() + joint), iw), _mm_mul_ps(_mm_loadu_ps(y.data() + joint), w));
+		_mm_storeu_ps(result.data() + joint, blended);
+	};
+	for (; joint + 4 <= count; joint += 4) {
+		lerp(a.translationX, b.translationX, out.translationX);
+		lerp(a.translationY, b.translationY, out.translationY);
+		lerp(a.translationZ, b.translationZ, out.translationZ);
+		lerp(a.scaleX, b.scaleX, out.scaleX);
+		lerp(a.scaleY, b.scaleY, out.scaleY);
+		lerp(a.scaleZ, b.scaleZ, out.scaleZ);
+
+		__m128 ax = _mm_loadu_ps(a.rotationX.data() + joint);
+		__m128 ay = _mm_loadu_ps(a.rotationY.data() + joint);
+		__m128 az = _mm_loadu_ps(a.rotationZ.data() + joint);
+		__m128 aw = _mm_loadu_ps(a.rotationW.data() + joint);
+		__m128 bx = _mm_loadu_ps(b.rotationX.data() + joint);
+		__m128 by = _mm_loadu_ps(b.rotationY.data() + joint);
+		__m128 bz = _mm_loadu_ps(b.rotationZ.data() + joint);
+		__m128 bw = _mm_loadu_ps(b.rotationW.data() + joint);
+		__m128 dot = _mm_add_ps(_mm_add_ps(_mm_mul_ps(ax, bx), _mm_mul_ps(ay, by)), _mm_add_ps(_mm_mul_ps(az, bz), _mm_mul_ps(aw, bw)));
+		// 点积为负时 b 取反（q 与 -q 是同一个旋转），把点积的符号位异或到 b 的权重上
+		__m128 bWeight = _mm_xor_ps(w, _mm_and_ps(dot, signMask));
+		__m128 rx = _mm_add_ps(_mm_mul_ps(ax, iw), _mm_mul_ps(bx, bWeight));
+		__m128 ry = _mm_add_ps(_mm_mul_ps(ay, iw), _mm_mul_ps(by, bWeight));
+		__m128 rz = _mm_add_ps(_mm_mul_ps(az, iw), _mm_mul_ps(bz, bWeight));
+		__m128 rw = _mm_add_ps(_mm_mul_ps(aw, iw), _mm_mul_ps(bw, bWeight));
+		__m128 lengthSquared = _mm_add_ps(_mm_add_ps(_mm_mul_ps(rx, rx), _mm_mul_ps(ry, ry)), _mm_add_ps(_mm_mul_ps(rz, rz), _mm_mul_ps(rw, rw)));
+		__m128 inverseLength = _mm_div_ps(one, _mm_sqrt_ps(lengthSquared));
+		_mm_storeu_ps(out.rotationX.data() + joint, _mm_mul_ps(rx, inverseLength));
+		_mm_storeu_ps(out.rotationY.data() + joint, _mm_mul_ps(ry, inverseLength));
+		_mm_storeu_ps(out.rotationZ.data() + joint, _mm_mul_ps(rz, inverseLength));
+		_mm_storeu_ps(out.rotationW.data() + joint, _mm_mul_ps(rw, inverseLength));
+	}
+#endif
+
+	// 剩余不足 4 个的关节（或没有 SSE2 时的全部关节）
+	for (; joint < count; ++joint) {
+		out.translationX[joint] = a.translationX[joint] * inverseWeight + b.translationX[joint] * weight;
+		out.translationY[joint] = a.translationY[joint] * inverseWeight + b.translationY[joint] * weight;
+		out.translationZ[joint] = a.translationZ[joint] * inverseWeight + b.translationZ[joint] * weight;
+		out.scaleX[joint] = a.scaleX[joint] * inverseWeight + b.scaleX[joint] * weight;
+		out.scaleY[joint] = a.scaleY[joint] * inverseWeight + b.scaleY[joint] * weight;
+		out.scaleZ[joint] = a.scaleZ[joint] * inverseWeight + b.scaleZ[joint] * weight;
+
+		float dot = a.rotationX[joint] * b.rotationX[joint] + a.rotationY[joint] * b.rotationY[joint]
+			+ a.rotationZ[joint] * b.rotationZ[joint] + a.rotationW[joint] * b.rotationW[joint];
+		float bWeight = dot < 0.0f ? -weight : weight;
+		float rx = a.rotationX[joint] * inverseWeight + b.rotationX[joint] * bWeight;
+		float ry = a.rotationY[joint] * inverseWeight + b.rotationY[joint] * bWeight;
+		float rz = a.rotationZ[joint] * inverseWeight + b.rotationZ[joint] * bWeight;
+		float rw = a.rotationW[joint] * inverseWeight + b.rotationW[joint] * bWeight;
+		float inverseLength = 1.0f / std::sqrt(rx * rx + ry * ry + rz * rz + rw * rw);
+		out.rotationX[joint] = rx * inverseLength;
+		out.rotationY[joint] = ry * inverseLength;
+		out.rotationZ[joint] = rz * inverseLength;
+		out.rotationW[joint] = rw * inverseLength;
+	}
+}
+
+void sampleClip(const AnimationClip& clip, float time, JointPoses& out) {
+	if (clip.keys.empty()) {
+		return;
+	}
+	float t = std::fmod(time, clip.duration);
+	if (t < 0.0f) {
+		t += clip.duration;
+	}
+	// 关键姿态覆盖 [0, duration)，最后一个与第一个之间混合，首尾相接
+	size_t keyCount = clip.keys.size();
+	float position = t / clip.duration * static_cast<float>(keyCount);
+	size_t key = std::min(static_cast<size_t>(position), keyCount - 1);
+	blendPoses(clip.keys[key], clip.keys[(key + 1) % keyCount], position - static_cast<float>(key), out);
+}
+
+void computeSkinningMatrices(const Skeleton& skeleton, const JointPoses& pose, std::span<glm::mat4x4> matrices) {
+	size_t count = std::min(skeleton.jointCount(), matrices.size());
+	// 父关节在前，先原地算出每个关节的网格空间变换，再乘逆绑定矩阵
+	for (size_t joint = 0; joint < count; ++joint) {
+		glm::mat4x4 local = pose.localMatrix(joint);
+		int32_t parent = skeleton.parents[joint];
+		matrices[joint] = parent < 0 ? local : matrices[parent] * local;
+	}
+	for (size_t joint = 0; joint < count; ++joint) {
+		matrices[joint] = matrices[joint] * skeleton.inverseBindMatrices[joint];
+	}
+}
+
+Skeleton createChainSkeleton(const glm::vec3& base, const glm::vec3& tip, uint32_t jointCount) {
+	// 蒙皮数据中关节编号为 8 位
+	if (jointCount == 0 || jointCount > 256) {
+		throw std::runtime_error("Chain skeleton needs 1 to 256 joints");
+	}
+	Skeleton skeleton;
+	skeleton.parents.resize(jointCount);
+	skeleton.bindPose.resize(jointCount);
+	skeleton.inverseBindMatrices.resize(jointCount);
+
+	// 根关节把局部 z 轴转到链的方向，之后的关节沿局部 z 轴等距排列
+	glm::vec3 axis = tip - base;
+	float length = glm::length(axis);
+	glm::vec3 direction = length > 0.0f ? axis / length : glm::vec3(0.0f, 0.0f, 1.0f);
+	glm::vec3 rotationAxis = glm::cross(glm::vec3(0.0f, 0.0f, 1.0f), direction);
+	glm::quat rootRotation(1.0f, 0.0f, 0.0f, 0.0f);
+	if (glm::length(rotationAxis) > 1e-6f) {
+		rootRotation = glm::angleAxis(std::acos(std::clamp(direction.z, -1.0f, 1.0f)), glm::normalize(rotationAxis));
+	} else if (direction.z < 0.0f) {
+		rootRotation = glm::angleAxis(PI, glm::vec3(1.0f, 0.0f, 0.0f));
+	}
+	float segment = length / static_cast<float>(jointCount);
+
+	glm::mat4x4 global(1.0f);
+	for (uint32_t joint = 0; joint < jointCount; ++joint) {
+		skeleton.parents[joint] = static_cast<int32_t>(joint) - 1;
+		if (joint == 0) {
+			skeleton.bindPose.set(joint, base, rootRotation, glm::vec3(1.0f));
+		} else {
+			skeleton.bindPose.set(joint, glm::vec3(0.0f, 0.0f, segment), glm::quat(1.0f, 0.0f, 0.0f, 0.0f), glm::vec3(1.0f));
+		}
+		global = global * skeleton.bindPose.localMatrix(joint);
+		skeleton.inverseBindMatrices[joint] = glm::inverse(global);
+	}
+	return skeleton;
+}
+
+AnimationClip createChainClip(const Skeleton& skeleton, const glm::vec3& bendAxis, float bendAngle, float twistAngle,
+	float duration, float sampleRate) {
+	AnimationClip clip;
+	clip.duration = duration;
+	size_t keyCount = std::max<size_t>(2, static_cast<size_t>(std::round(duration * sampleRate)));
+	size_t jointCount = skeleton.jointCount();
+	clip.keys.resize(keyCount);
+
+	// 摆动轴转到根关节的局部空间（链上的关节在绑定姿态下朝向相同）
+	glm::quat rootRotation(skeleton.bindPose.rotationW[0], skeleton.bindPose.rotationX[0], skeleton.bindPose.rotationY[0], skeleton.bindPose.rotationZ[0]);
+	glm::vec3 localBendAxis = glm::normalize(glm::conjugate(rootRotation) * bendAxis);
+	for (size_t key = 0; key < keyCount; ++key) {
+		JointPoses& pose = clip.keys[key];
+		pose = skeleton.bindPose;
+		float cycle = 2.0f * PI * static_cast<float>(key) / static_cast<float>(keyCount);
+		for (size_t joint = 0; joint < jointCount; ++joint) {
+			float phase = cycle - 0.5f * static_cast<float>(joint);
+			glm::quat bend = glm::angleAxis(bendAngle * std::sin(phase), localBendAxis);
+			glm::quat twist = glm::angleAxis(twistAngle * std::sin(cycle), glm::vec3(0.0f, 0.0f, 1.0f));
+			glm::quat bindRotation(pose.rotationW[joint], pose.rotationX[joint], pose.rotationY[joint], pose.rotationZ[joint]);
+			glm::quat rotation = bindRotation * twist * bend;
+			glm::vec3 translation(pose.translationX[joint], pose.translationY[joint], pose.translationZ[joint]);
+			pose.set(joint, translation, rotation, glm::vec3(1.0f));
+		}
+	}
+	return clip;
+}
+
+std::vector<SkinVertex> computeChainSkinWeights(std::span<const VertexAttributes> vertices, const Skeleton& skeleton) {
+	std::vector<SkinVertex> skin(vertices.size());
+	uint32_t jointCount = static_cast<uint32_t>(skeleton.jointCount());
+	if (jointCount <= 1) {
+		for (SkinVertex& vertex : skin) {
+			vertex.weights[0] = UINT16_MAX;
+		}
+		return skin;
+	}
+
+	// 关节在网格空间中的绑定位置：根关节为链的起点，相邻关节之差为一节
+	glm::vec3 base = glm::vec3(glm::inverse(skeleton.inverseBindMatrices[0])[3]);
+	glm::vec3 segment = glm::vec3(glm::inverse(skeleton.inverseBindMatrices[1])[3]) - base;
+	float segmentLengthSquared = std::max(glm::dot(segment, segment), 1e-12f);
+	for (size_t i = 0; i < vertices.size(); ++i) {
+		// 每一节的中点完全属于该节的关节，两个中点之间线性过渡
+		float s = glm::dot(vertices[i].position - base, segment) / segmentLengthSquared;
+		float u = std::clamp(s - 0.5f, 0.0f, static_cast<float>(jointCount - 1));
+		uint32_t joint0 = std::min(static_cast<uint32_t>(u), jointCount - 1);
+		uint32_t joint1 = std::min(joint0 + 1, jointCount - 1);
+		float t = u - static_cast<float>(joint0);
+		uint16_t weight0 = static_cast<uint16_t>(std::round((1.0f - t) * UINT16_MAX));
+		skin[i].joints = joint0 | (joint1 << 8);
+		skin[i].weights = { weight0, static_cast<uint16_t>(UINT16_MAX - weight0), 0, 0 };
+	}
+	return skin;
+}
+
+}
@@ -0,0 +1,87 @@
+#pragma once
+
+#include "data-structure.h"
+
+namespace webgpu {
+
+/**
+ * 一组关节的局部变换（相对父关节），按分量分开存放（SoA），便于一次处理 4 个关节
+ * 旋转为单位四元数 (x, y, z, w)
+ */
+struct JointPoses {
+	std::vector<float> translationX, translationY, translationZ;
+	std::vector<float> rotationX, rotationY, rotationZ, rotationW;
+	std::vector<float> scaleX, scaleY, scaleZ;
+
+	void resize(size_t count);
+	size_t size() const { return translationX.size(); }
+	void set(size_t joint, const glm::vec3& translation, const glm::quat& rotation, const glm::vec3& scale);
+	glm::mat4x4 localMatrix(size_t joint) const;
+};
+
+/**
+ * 骨架：父关节编号（父关节排在子关节之前，根为 -1）与绑定姿态
+ */
+struct Skeleton {
+	std::vector<int32_t> parents;
+	JointPoses bindPose;
+	// 网格空间到各关节绑定姿态空间的变换
+	std::vector<glm::mat4x4> inverseBindMatrices;
+
+	size_t jointCount() const { return parents.size(); }
+};
+
+/**
+ * 动画片段：按固定帧率采样的关键姿态，循环播放
+ */
+struct AnimationClip {
+	float duration = 1.0f;
+	std::vector<JointPoses> keys;
+};
+
+/**
+ * 每个顶点的蒙皮数据，布局与 skinning.wgsl 中的 vec4u 一致
+ * joints: 4 个 8 位关节编号；weights: 4 个 Unorm16 权重（和为 1）
+ */
+struct SkinVertex {
+	uint32_t joints = 0;
+	std::array<uint16_t, 4> weights = {};
+	uint32_t _pad = 0;
+};
+
+static_assert(sizeof(SkinVertex) == 16);
+
+/**
+ * @brief 两个姿态按 weight 混合：平移、缩放线性插值，旋转归一化线性插值（取最短路径）
+ * 有 SSE2 时每次处理 4 个关节，out 可以是 a 或 b
+ */
+void blendPoses(const JointPoses& a, const JointPoses& b, float weight, JointPoses& out);
+
+/**
+ * @brief 在 time（秒，循环）处采样片段，相邻关键姿态之间混合
+ */
+void sampleClip(const AnimationClip& clip, float time, JointPoses& out);
+
+/**
+ * @brief 由局部姿态计算蒙皮矩阵：关节的网格空间变换乘以逆绑定矩阵
+ */
+void computeSkinningMatrices(const Skeleton& skeleton, const JointPoses& pose, std::span<glm::mat4x4> matrices);
+
+/**
+ * @brief 从 base 到 tip 的一串关节，jointCount 个关节等分这段距离
+ */
+Skeleton createChainSkeleton(const glm::vec3& base, const glm::vec3& tip, uint32_t jointCount);
+
+/**
+ * @brief 链式骨架的循环动画：每个关节绕 bendAxis 摆动 bendAngle，绕链的方向扭转 twistAngle（弧度），
+ * 摆动的相位沿链向末端推迟，形成波动
+ */
+AnimationClip createChainClip(const Skeleton& skeleton, const glm::vec3& bendAxis, float bendAngle, float twistAngle,
+	float duration, float sampleRate = 30.0f);
+
+/**
+ * @brief 按顶点在链上的投影位置，把权重分给最近的两个关节
+ */
+std::vector<SkinVertex> computeChainSkinWeights(std::span<const VertexAttributes> vertices, const Skeleton& skeleton);
+
+}
@@ -3,32 +3,16 @@
 #define TINYOBJLOADER_IMPLEMENTATION
 #include "tiny-obj-loader.h"
 
+#include <algorithm>
+#include <unordered_map>
+
 namespace webgpu {
 
 
  std::ostream& operator<<(std::ostream& os, const Uniform& uniform){
-    os << "projectionMatrix:\n";
-    for (int i = 0; i < 4; ++i) {
-        for (int j = 0; j < 4; ++j) {
-            os << uniform.projectionMatrix[i][j] << ' ';
-        }
-        os << '\n';
-    }
-
-    os << "\nviewMatrix:\n";
-    for (int i = 0; i < 4; ++i) {
-        for (int j = 0; j < 4; ++j) {
-            os << uniform.viewMatrix[i][j] << ' ';
-        }
-        os << '\n';
-    }
-
-    os << "\nmodelMatrix:\n";
+    os << "viewDepthRow: ";
     for (int i = 0; i < 4; ++i) {
-        for (int j = 0; j < 4; ++j) {
-            os << uniform.modelMatrix[i][j] << ' ';
-        }
-        os << '\n';
+        os << uniform.viewDepthRow[i] << ' ';
     }
 
     os << "\ncolor: ";
@@ -41,7 +25,7 @@ namespace webgpu {
     return os;
 }
 
-bool loadGeometryFromObj(const std::filesystem::path& path, std::vector<VertexAttributes>& vertexData) {
+bool loadMeshFromObj(const std::filesystem::path& path, Mesh& mesh) {
 	tinyobj::attrib_t attrib;
 	std::vector<tinyobj::shape_t> shapes;
 	std::vector<tinyobj::material_t> materials;
@@ -49,10 +33,10 @@ bool loadGeometryFromObj(const std::filesystem::path& path, std::vector<VertexAt
 	std::string warn;
 	std::string err;
 
-	// Call the core loading procedure of TinyOBJLoader
-	bool ret = tinyobj::LoadObj(&attrib, &shapes, &materials, &warn, &err, path.string().c_str());
+	// MTL 文件与 OBJ 放在同一目录
+	std::string materialDirectory = path.parent_path().string() + "/";
+	bool ret = tinyobj::LoadObj(&attrib, &shapes, &materials, &warn, &err, path.string().c_str(), materialDirectory.c_str());
 
-	// Check errors
 	if (!warn.empty()) {
 		std::cout << "[LoadObj]" << warn << '\n';
 	}
@@ -65,38 +49,128 @@ bool loadGeometryFromObj(const std::filesystem::path& path, std::vector<VertexAt
 		return false;
 	}
 
-	// Filling in vertexData:
-	vertexData.clear();
+	// 漫反射贴图：MTL 里可能是导出时的绝对路径，找不到时退回到 OBJ 目录下的同名文件
+	mesh.diffuseTexturePath.clear();
+	for (const auto& material : materials) {
+		if (material.diffuse_texname.empty()) {
+			continue;
+		}
+		std::string textureName = material.diffuse_texname;
+		std::replace(textureName.begin(), textureName.end(), '\\', '/');
+		std::filesystem::path texturePath(textureName);
+		if (texturePath.is_relative()) {
+			texturePath = path.parent_path() / texturePath;
+		}
+		if (!std::filesystem::exists(texturePath)) {
+			texturePath = path.parent_path() / texturePath.filename();
+		}
+		mesh.diffuseTexturePath = texturePath;
+		break;
+	}
+
+	size_t totalIndexCount = 0;
 	for (const auto& shape : shapes) {
-		size_t offset = vertexData.size();
-		printf("offest = %zu\n", offset);
-		vertexData.resize(offset + shape.mesh.indices.size());
-
-		for (size_t i = 0; i < shape.mesh.indices.size(); ++i) {
-			const tinyobj::index_t& idx = shape.mesh.indices[i];
-
-			vertexData[offset + i].position = {
-				attrib.vertices[3 * idx.vertex_index + 0],
-				-attrib.vertices[3 * idx.vertex_index + 2], // Add a minus to avoid mirroring
-				attrib.vertices[3 * idx.vertex_index + 1]
-			};
-
-			// Also apply the transform to normals!!
-			vertexData[offset + i].normal = {
-				attrib.normals[3 * idx.normal_index + 0],
-				-attrib.normals[3 * idx.normal_index + 2],
-				attrib.normals[3 * idx.normal_index + 1]
-			};
-
-			vertexData[offset + i].color = {
-				attrib.colors[3 * idx.vertex_index + 0],
-				attrib.colors[3 * idx.vertex_index + 1],
-				attrib.colors[3 * idx.vertex_index + 2]
-			};
+		totalIndexCount += shape.mesh.indices.size();
+	}
+
+	// 文件中没有法向量时，按位置累加面法向量生成平滑法向量
+	bool hasNormals = !attrib.normals.empty();
+	std::vector<glm::vec3> generatedNormals;
+	auto objPosition = [&](int vertexIndex) {
+		return glm::vec3(
+			attrib.vertices[3 * vertexIndex + 0],
+			-attrib.vertices[3 * vertexIndex + 2], // Add a minus to avoid mirroring
+			attrib.vertices[3 * vertexIndex + 1]
+		);
+	};
+	if (!hasNormals) {
+		generatedNormals.assign(attrib.vertices.size() / 3, glm::vec3(0.0f));
+		for (const auto& shape : shapes) {
+			const auto& indices = shape.mesh.indices;
+			for (size_t i = 0; i + 2 < indices.size(); i += 3) {
+				glm::vec3 p0 = objPosition(indices[i + 0].vertex_index);
+				glm::vec3 p1 = objPosition(indices[i + 1].vertex_index);
+				glm::vec3 p2 = objPosition(indices[i + 2].vertex_index);
+				// 叉积长度与面积成正比，相当于按面积加权
+				glm::vec3 faceNormal = glm::cross(p1 - p0, p2 - p0);
+				for (size_t k = 0; k < 3; ++k) {
+					generatedNormals[indices[i + k].vertex_index] += faceNormal;
+				}
+			}
+		}
+		for (auto& n : generatedNormals) {
+			float len = glm::length(n);
+			n = len > 0.0f ? n / len : glm::vec3(0.0f, 0.0f, 1.0f);
+		}
+	}
+
+	// (位置索引, 法向量索引, 纹理坐标索引) -> 网格顶点索引
+	struct ObjVertexKey {
+		int vertexIndex;
+		int normalIndex;
+		int texcoordIndex;
+		bool operator==(const ObjVertexKey& other) const {
+			return vertexIndex == other.vertexIndex && normalIndex == other.normalIndex && texcoordIndex == other.texcoordIndex;
+		}
+	};
+	struct ObjVertexKeyHash {
+		size_t operator()(const ObjVertexKey& key) const {
+			uint64_t h = static_cast<uint32_t>(key.vertexIndex);
+			h = h * 0x9E3779B97F4A7C15ull ^ static_cast<uint32_t>(key.normalIndex);
+			h = h * 0x9E3779B97F4A7C15ull ^ static_cast<uint32_t>(key.texcoordIndex);
+			return static_cast<size_t>(h ^ (h >> 32));
+		}
+	};
+	std::unordered_map<ObjVertexKey, uint32_t, ObjVertexKeyHash> vertexLookup;
+	vertexLookup.reserve(totalIndexCount);
+
+	mesh.vertices.clear();
+	mesh.indices.clear();
+	mesh.vertices.reserve(totalIndexCount);
+	mesh.indices.reserve(totalIndexCount);
+
+	for (const auto& shape : shapes) {
+		for (const tinyobj::index_t& idx : shape.mesh.indices) {
+			int normalIndex = hasNormals ? idx.normal_index : -1;
+			ObjVertexKey key = { idx.vertex_index, normalIndex, idx.texcoord_index };
+			auto [it, inserted] = vertexLookup.try_emplace(key, static_cast<uint32_t>(mesh.vertices.size()));
+			if (inserted) {
+				VertexAttributes vertex;
+				vertex.position = objPosition(idx.vertex_index);
+				if (hasNormals && normalIndex >= 0) {
+					vertex.normal = {
+						attrib.normals[3 * normalIndex + 0],
+						-attrib.normals[3 * normalIndex + 2],
+						attrib.normals[3 * normalIndex + 1]
+					};
+				} else if (!hasNormals) {
+					vertex.normal = generatedNormals[idx.vertex_index];
+				} else {
+					vertex.normal = { 0.0f, 0.0f, 1.0f };
+				}
+				vertex.color = {
+					attrib.colors[3 * idx.vertex_index + 0],
+					attrib.colors[3 * idx.vertex_index + 1],
+					attrib.colors[3 * idx.vertex_index + 2]
+				};
+				if (idx.texcoord_index >= 0) {
+					// OBJ 的 v 轴向上，纹理的原点在左上角
+					vertex.uv = {
+						attrib.texcoords[2 * idx.texcoord_index + 0],
+						1.0f - attrib.texcoords[2 * idx.texcoord_index + 1]
+					};
+				} else {
+					vertex.uv = { 0.0f, 0.0f };
+				}
+				mesh.vertices.push_back(vertex);
+			}
+			mesh.indices.push_back(it->second);
 		}
 	}
-	LOG("Load obj finish, vertexData size = %zu\n", vertexData.size());
+	mesh.vertices.shrink_to_fit();
+
+	LOG("Load mesh finish, vertices = %zu, indices = %zu\n", mesh.vertices.size(), mesh.indices.size());
 	return true;
 }
 
-}
\ No newline at end of file
+}
@@ -22,12 +22,36 @@ struct window_size_t {
 // 定义 Uniform 结构体
 
 struct Uniform {
-    glm::mat4x4 projectionMatrix = {};
-    glm::mat4x4 viewMatrix = {};
-    glm::mat4x4 modelMatrix = {};
+    // 视图矩阵的第 3 行：视图空间深度 = dot(viewDepthRow, 世界空间位置)，用于分簇光源和级联选择
+    // 每个物体的变换（MVP、模型矩阵、法向量矩阵）在 CPU 上组合好放在 InstanceData 中
+    glm::vec4 viewDepthRow = { 0.0f, 0.0f, 1.0f, 0.0f };
     std::array<float, 4> color;
     float time;
     float _pad[3];
+    // 紧凑顶点格式的位置反量化参数：position = decoded * positionScale + positionOffset
+    glm::vec4 positionOffset = { 0.0f, 0.0f, 0.0f, 0.0f };
+    glm::vec4 positionScale = { 1.0f, 1.0f, 1.0f, 1.0f };
+};
+
+/**
+ * uniform 块中一个字段的名字、偏移和大小，按字段跟踪修改时使用
+ */
+struct UniformField {
+    const char* name;
+    uint32_t offset;
+    uint32_t size;
+};
+
+#define UNIFORM_FIELD(Type, member) \
+    ::webgpu::UniformField{ #member, static_cast<uint32_t>(offsetof(Type, member)), static_cast<uint32_t>(sizeof(Type::member)) }
+
+// Uniform 的字段布局（不含填充），增删字段时同步修改
+inline const std::array<UniformField, 5> kUniformLayout = {
+    UNIFORM_FIELD(Uniform, viewDepthRow),
+    UNIFORM_FIELD(Uniform, color),
+    UNIFORM_FIELD(Uniform, time),
+    UNIFORM_FIELD(Uniform, positionOffset),
+    UNIFORM_FIELD(Uniform, positionScale),
 };
 
 std::ostream& operator<<(std::ostream& os, const Uniform& uniform);
@@ -39,12 +63,62 @@ struct VertexAttributes {
 	glm::vec3 position;
 	glm::vec3 normal;
 	glm::vec3 color;
+	// 纹理坐标，左上角为原点
+	glm::vec2 uv;
+};
+
+/**
+ * 紧凑顶点格式（20 字节，VertexAttributes 为 44 字节）
+ * position: Snorm16x4，按网格包围盒归一化，着色器中用 Uniform 里的 offset/scale 反量化（w 为填充）
+ * normal: 八面体编码后的 Snorm16x2，共 32 位
+ * color: Unorm8x4（a 为填充）
+ * uv: Float16x2，纹理坐标可能超出 [0, 1]（平铺），所以不做定点量化
+ */
+struct CompactVertexAttributes {
+	std::array<int16_t, 4> position;
+	std::array<int16_t, 2> normal;
+	std::array<uint8_t, 4> color;
+	std::array<uint16_t, 2> uv;
 };
 
+static_assert(sizeof(CompactVertexAttributes) == 20);
+
+/**
+ * 带索引的网格，顶点已去重
+ */
+struct Mesh {
+	std::vector<VertexAttributes> vertices;
+	std::vector<uint32_t> indices;
+	// 材质的漫反射贴图（MTL 中的 map_Kd），没有时为空
+	std::filesystem::path diffuseTexturePath;
+};
+
+/**
+ * 每个实例的数据，存放在 storage buffer 中，顶点着色器按 instance_index 读取
+ */
+struct InstanceData {
+	// 模型矩阵（摆放矩阵乘模型动画），世界空间位置用于光照和阴影
+	glm::mat4x4 modelMatrix = glm::mat4x4(1.0f);
+	// 投影 * 视图 * 模型，顶点着色器只需一次矩阵乘向量得到裁剪空间位置
+	glm::mat4x4 modelViewProjectionMatrix = glm::mat4x4(1.0f);
+	// 法向量矩阵（模型矩阵左上 3x3 的逆转置），与 WGSL 的 mat3x3f 布局一致，每列 16 字节
+	std::array<glm::vec4, 3> normalMatrix = { glm::vec4(1.0f, 0.0f, 0.0f, 0.0f), glm::vec4(0.0f, 1.0f, 0.0f, 0.0f), glm::vec4(0.0f, 0.0f, 1.0f, 0.0f) };
+};
+
+static_assert(sizeof(InstanceData) % 16 == 0);
+
 // 使用编译器检查确保 Uniform 结构体大小为16的倍数
 static_assert(sizeof(Uniform) % 16 == 0);
 
 
-bool loadGeometryFromObj(const std::filesystem::path& path, std::vector<VertexAttributes>& vertexData);
+/**
+ * @brief 从 OBJ 文件加载带索引的网格
+ * 相同 (位置, 法向量, 纹理坐标) 的顶点会被合并，文件中没有法向量时按面法向量平滑生成
+ * 同目录下的 MTL 中第一个带 map_Kd 的材质作为网格的漫反射贴图
+ * @param path OBJ 文件路径
+ * @param mesh 输出网格
+ * @return 是否加载成功
+ */
+bool loadMeshFromObj(const std::filesystem::path& path, Mesh& mesh);
 
 }
\ No newline at end of file
@@ -0,0 +1,56 @@
+#include "deflate.h"
+
+#include <libdeflate.h>
+
+#include <memory>
+#include <stdexcept>
+
+namespace webgpu {
+
+namespace {
+
+// libdeflate 的压缩级别 0-12，12 最慢但最小，烘焙是离线的
+constexpr int kCompressionLevel = 12;
+
+struct CompressorDeleter {
+	void operator()(libdeflate_compressor* compressor) const { libdeflate_free_compressor(compressor); }
+};
+
+struct DecompressorDeleter {
+	void operator()(libdeflate_decompressor* decompressor) const { libdeflate_free_decompressor(decompressor); }
+};
+
+}
+
+bool zlibInflate(const uint8_t* data, size_t size, size_t expectedSize, std::vector<uint8_t>& out) {
+	std::unique_ptr<libdeflate_decompressor, DecompressorDeleter> decompressor(libdeflate_alloc_decompressor());
+	if (!decompressor) {
+		LOG("inflate: out of memory\n");
+		return false;
+	}
+	out.resize(expectedSize);
+	// 不传 actual_out_nbytes_ret 时 libdeflate 要求解压结果恰好填满 out
+	libdeflate_result result = libdeflate_zlib_decompress(decompressor.get(), data, size, out.data(), out.size(), nullptr);
+	if (result != LIBDEFLATE_SUCCESS) {
+		LOG("inflate: %s\n", result == LIBDEFLATE_BAD_DATA ? "invalid zlib stream" : "size mismatch");
+		out.clear();
+		return false;
+	}
+	return true;
+}
+
+void zlibDeflate(const uint8_t* data, size_t size, std::vector<uint8_t>& out) {
+	std::unique_ptr<libdeflate_compressor, CompressorDeleter> compressor(libdeflate_alloc_compressor(kCompressionLevel));
+	if (!compressor) {
+		throw std::runtime_error("deflate: out of memory");
+	}
+	size_t start = out.size();
+	out.resize(start + libdeflate_zlib_compress_bound(compressor.get(), size));
+	size_t compressedSize = libdeflate_zlib_compress(compressor.get(), data, size, out.data() + start, out.size() - start);
+	if (compressedSize == 0) {
+		throw std::runtime_error("deflate: compression failed");
+	}
+	out.resize(start + compressedSize);
+}
+
+}
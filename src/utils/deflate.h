@@ -0,0 +1,21 @@
+#pragma once
+
+#include "global.h"
+
+namespace webgpu {
+
+/**
+ * @brief 解压 zlib 数据流（RFC 1950/1951，libdeflate）
+ * @param expectedSize 解压后的大小，必须恰好相等
+ * @param out 解压结果（覆盖原有内容）
+ * @return 数据是否完整有效
+ */
+bool zlibInflate(const uint8_t* data, size_t size, size_t expectedSize, std::vector<uint8_t>& out);
+
+/**
+ * @brief 压缩为 zlib 数据流（libdeflate 最高压缩级别，只用于离线烘焙）
+ * @param out 压缩结果追加到末尾
+ */
+void zlibDeflate(const uint8_t* data, size_t size, std::vector<uint8_t>& out);
+
+}
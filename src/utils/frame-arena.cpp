@@ -0,0 +1,60 @@
+#include "frame-arena.h"
+
+namespace webgpu {
+
+FrameArena::FrameArena(size_t capacity, std::pmr::memory_resource* upstream)
+	: upstream(upstream), bufferCapacity(capacity) {
+	buffer = static_cast<std::byte*>(upstream->allocate(bufferCapacity, alignof(std::max_align_t)));
+	overflowBlocks.reserve(16);
+}
+
+FrameArena::~FrameArena() {
+	releaseOverflow();
+	upstream->deallocate(buffer, bufferCapacity, alignof(std::max_align_t));
+}
+
+void FrameArena::reset() {
+	if (!overflowBlocks.empty()) {
+		// 本帧发生过溢出，按峰值（取 2 的幂）扩容，下一帧起不再溢出
+		size_t peak = used();
+		size_t newCapacity = bufferCapacity;
+		while (newCapacity < peak) {
+			newCapacity *= 2;
+		}
+		LOG("FrameArena grow %zu -> %zu bytes\n", bufferCapacity, newCapacity);
+		releaseOverflow();
+		upstream->deallocate(buffer, bufferCapacity, alignof(std::max_align_t));
+		bufferCapacity = newCapacity;
+		buffer = static_cast<std::byte*>(upstream->allocate(bufferCapacity, alignof(std::max_align_t)));
+	}
+	offset = 0;
+}
+
+void* FrameArena::do_allocate(size_t bytes, size_t alignment) {
+	// 对齐当前偏移
+	size_t aligned = (offset + alignment - 1) & ~(alignment - 1);
+	if (aligned + bytes <= bufferCapacity) {
+		offset = aligned + bytes;
+		return buffer + aligned;
+	}
+
+	// 主缓冲区不足，退回上游分配器
+	void* p = upstream->allocate(bytes, alignment);
+	overflowBlocks.push_back({ p, bytes, alignment });
+	overflowBytes += bytes;
+	return p;
+}
+
+bool FrameArena::do_is_equal(const std::pmr::memory_resource& other) const noexcept {
+	return this == &other;
+}
+
+void FrameArena::releaseOverflow() {
+	for (const auto& block : overflowBlocks) {
+		upstream->deallocate(block.ptr, block.bytes, block.alignment);
+	}
+	overflowBlocks.clear();
+	overflowBytes = 0;
+}
+
+}
@@ -0,0 +1,73 @@
+#pragma once
+
+#include "global.h"
+
+namespace webgpu {
+
+/**
+ * 帧级线性（bump）分配器
+ * 每帧内的临时数据从一块连续内存中顺序分配，帧结束时调用 reset() 一次性回收
+ * 通过 std::pmr 接口暴露，std::pmr::vector 等容器可以直接使用
+ * 当一帧用量超过容量时退回到上游分配器，并在 reset() 时按峰值扩容，稳定后不再产生堆分配
+ */
+class FrameArena : public std::pmr::memory_resource {
+public:
+	/**
+	 * @brief 构造函数
+	 * @param capacity 初始容量（字节）
+	 * @param upstream 溢出时使用的上游分配器
+	 */
+	explicit FrameArena(size_t capacity, std::pmr::memory_resource* upstream = std::pmr::new_delete_resource());
+
+	FrameArena(const FrameArena&) = delete;
+	FrameArena& operator=(const FrameArena&) = delete;
+	~FrameArena() override;
+
+	/**
+	 * @brief 帧结束时回收所有分配，如有溢出则按本帧峰值扩容
+	 */
+	void reset();
+
+	/**
+	 * @brief 当前帧已使用的字节数（包含溢出部分）
+	 */
+	size_t used() const { return offset + overflowBytes; }
+
+	/**
+	 * @brief 主缓冲区容量
+	 */
+	size_t capacity() const { return bufferCapacity; }
+
+	/**
+	 * @brief 当前帧退回上游分配器的次数
+	 */
+	size_t overflowCount() const { return overflowBlocks.size(); }
+
+private:
+	void* do_allocate(size_t bytes, size_t alignment) override;
+	// 单个释放不做任何事，内存在 reset() 时统一回收
+	void do_deallocate(void* /* p */, size_t /* bytes */, size_t /* alignment */) override {}
+	bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override;
+
+	void releaseOverflow();
+
+private:
+	struct OverflowBlock {
+		void* ptr;
+		size_t bytes;
+		size_t alignment;
+	};
+
+	// 上游分配器
+	std::pmr::memory_resource* upstream = nullptr;
+	// 主缓冲区
+	std::byte* buffer = nullptr;
+	size_t bufferCapacity = 0;
+	// 下一次分配的偏移
+	size_t offset = 0;
+	// 溢出的分配，reset() 时归还上游
+	std::vector<OverflowBlock> overflowBlocks;
+	size_t overflowBytes = 0;
+};
+
+}
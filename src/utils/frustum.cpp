@@ -0,0 +1,41 @@
+#include "frustum.h"
+
+namespace webgpu {
+
+FrustumPlanes extractFrustumPlanes(const glm::mat4x4& viewProjection) {
+	// glm 为列主序，第 i 行为 (m[0][i], m[1][i], m[2][i], m[3][i])
+	auto row = [&](int i) {
+		return glm::vec4(viewProjection[0][i], viewProjection[1][i], viewProjection[2][i], viewProjection[3][i]);
+	};
+	glm::vec4 r0 = row(0);
+	glm::vec4 r1 = row(1);
+	glm::vec4 r2 = row(2);
+	glm::vec4 r3 = row(3);
+
+	FrustumPlanes planes = {
+		r3 + r0, // left
+		r3 - r0, // right
+		r3 + r1, // bottom
+		r3 - r1, // top
+		r2,      // near（WebGPU 深度范围从 0 开始）
+		r3 - r2  // far
+	};
+	for (auto& plane : planes) {
+		float length = glm::length(glm::vec3(plane));
+		if (length > 0.0f) {
+			plane /= length;
+		}
+	}
+	return planes;
+}
+
+bool sphereInFrustum(const FrustumPlanes& planes, const glm::vec3& center, float radius) {
+	for (const auto& plane : planes) {
+		if (glm::dot(glm::vec3(plane), center) + plane.w < -radius) {
+			return false;
+		}
+	}
+	return true;
+}
+
+}
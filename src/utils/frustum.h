@@ -0,0 +1,23 @@
+#pragma once
+
+#include "global.h"
+
+namespace webgpu {
+
+/**
+ * 视锥体的 6 个平面（left, right, bottom, top, near, far），xyz 为指向内侧的单位法向量，w 为偏移
+ * 点 p 在平面内侧当且仅当 dot(plane.xyz, p) + plane.w >= 0
+ */
+using FrustumPlanes = std::array<glm::vec4, 6>;
+
+/**
+ * @brief 从 projection * view 矩阵中提取视锥平面（深度范围 [0, 1]）
+ */
+FrustumPlanes extractFrustumPlanes(const glm::mat4x4& viewProjection);
+
+/**
+ * @brief 球体是否与视锥相交
+ */
+bool sphereInFrustum(const FrustumPlanes& planes, const glm::vec3& center, float radius);
+
+}
@@ -8,9 +8,9 @@
 namespace webgpu {
 
 // 输出空指针导致的报错
-bool checkNullPointerError(void *p, const std::string& message){
+bool checkNullPointerError(void *p, std::string_view message){
   if(p == nullptr){
-    LOG("Null pointer error: %s", message.c_str());
+    LOG("Null pointer error: %.*s", static_cast<int>(message.size()), message.data());
     return false;
   }
   return true;
@@ -10,6 +10,10 @@
 #include <fstream>
 #include <array>
 #include <filesystem>
+#include <memory_resource>
+#include <span>
+#include <string_view>
+#include <vector>
 
 #include <webgpu/webgpu.hpp>
 #include <GLFW/glfw3.h>
@@ -24,6 +28,7 @@
 
 
 #define LOG_ENABLED
+// 统计全局堆分配次数（替换 operator new）由 CMake 选项 ALLOC_COUNTER 定义 ALLOC_COUNTER_ENABLED
 
 #ifdef LOG_ENABLED
   #define LOG(...) printf("[LOG] -- "); printf(__VA_ARGS__)
@@ -39,7 +44,7 @@ namespace webgpu {
 constexpr float PI = 3.14159265358979323846f;
 
 // 输出空指针导致的报错
-bool checkNullPointerError(void *p, const std::string& message);
+bool checkNullPointerError(void *p, std::string_view message);
 
 }
 
@@ -0,0 +1,36 @@
+#include "image-decoder.h"
+
+// stb_image 的实现放在这个编译单元，只编译 PNG 和 JPEG
+#define STB_IMAGE_IMPLEMENTATION
+#define STBI_ONLY_PNG
+#define STBI_ONLY_JPEG
+#include "stb-image.h"
+
+#include <fstream>
+
+namespace webgpu {
+
+bool decodeImage(const std::filesystem::path& path, Image& image) {
+	std::ifstream file(path, std::ios::binary);
+	if (!file.is_open()) {
+		LOG("Could not open image file: %s\n", path.string().c_str());
+		return false;
+	}
+	std::vector<uint8_t> bytes((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+	// 统一输出 RGBA8，16 位的 PNG 由 stb_image 转换为 8 位
+	int width = 0;
+	int height = 0;
+	int channels = 0;
+	stbi_uc* pixels = stbi_load_from_memory(bytes.data(), static_cast<int>(bytes.size()), &width, &height, &channels, 4);
+	if (!pixels) {
+		LOG("Could not decode image %s: %s\n", path.string().c_str(), stbi_failure_reason());
+		return false;
+	}
+	image.width = static_cast<uint32_t>(width);
+	image.height = static_cast<uint32_t>(height);
+	image.pixels.assign(pixels, pixels + static_cast<size_t>(width) * height * 4);
+	stbi_image_free(pixels);
+	return true;
+}
+
+}
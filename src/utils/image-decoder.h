@@ -0,0 +1,25 @@
+#pragma once
+
+#include "global.h"
+
+namespace webgpu {
+
+/**
+ * 解码后的图像，统一为 RGBA8，行从上到下排列
+ */
+struct Image {
+	uint32_t width = 0;
+	uint32_t height = 0;
+	std::vector<uint8_t> pixels;
+};
+
+/**
+ * @brief 读取 PNG 或 JPEG 图像文件
+ * 用 stb_image 解码（stb-image.h，见 CMakeLists.txt），不论源图几个通道都输出 RGBA8
+ * @param path 图像路径
+ * @param image 输出图像
+ * @return 是否解码成功
+ */
+bool decodeImage(const std::filesystem::path& path, Image& image);
+
+}
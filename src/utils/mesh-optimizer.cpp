@@ -0,0 +1,409 @@
+#include "mesh-optimizer.h"
+
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <cmath>
+#include <numeric>
+
+namespace webgpu {
+
+namespace {
+
+// Forsyth 算法的参数，取自原文推荐值
+constexpr uint32_t kForsythCacheSize = 32;
+constexpr float kCacheDecayPower = 1.5f;
+constexpr float kLastTriangleScore = 0.75f;
+constexpr float kValenceBoostScale = 2.0f;
+constexpr float kValenceBoostPower = 0.5f;
+
+float forsythVertexScore(int cachePosition, uint32_t liveTriangles) {
+	if (liveTriangles == 0) {
+		// 没有剩余三角形的顶点不再参与评分
+		return -1.0f;
+	}
+
+	float score = 0.0f;
+	if (cachePosition >= 0) {
+		if (cachePosition < 3) {
+			// 刚刚使用过的三个顶点，得分固定，避免总是沿同一方向生长出细长条带
+			score = kLastTriangleScore;
+		} else {
+			float scaler = 1.0f - static_cast<float>(cachePosition - 3) / static_cast<float>(kForsythCacheSize - 3);
+			score = std::pow(scaler, kCacheDecayPower);
+		}
+	}
+
+	// 剩余三角形越少得分越高，尽快处理掉孤立的顶点
+	score += kValenceBoostScale * std::pow(static_cast<float>(liveTriangles), -kValenceBoostPower);
+	return score;
+}
+
+/**
+ * 基于时间戳的 FIFO 顶点缓存模拟
+ */
+class FifoCacheSimulator {
+public:
+	FifoCacheSimulator(size_t vertexCount, uint32_t cacheSize)
+		: timestamps(vertexCount, 0), cacheSize(cacheSize), timestamp(cacheSize + 1) {}
+
+	/**
+	 * @brief 访问一个三角形，返回未命中次数
+	 */
+	uint32_t access(uint32_t a, uint32_t b, uint32_t c) {
+		return access(a) + access(b) + access(c);
+	}
+
+	/**
+	 * @brief 清空缓存
+	 */
+	void reset() {
+		timestamp += cacheSize + 1;
+	}
+
+private:
+	uint32_t access(uint32_t v) {
+		if (timestamp - timestamps[v] > cacheSize) {
+			timestamps[v] = timestamp++;
+			return 1;
+		}
+		return 0;
+	}
+
+	std::vector<uint32_t> timestamps;
+	uint32_t cacheSize;
+	uint32_t timestamp;
+};
+
+}
+
+VertexCacheStats analyzeVertexCache(const std::vector<uint32_t>& indices, size_t vertexCount, uint32_t cacheSize) {
+	VertexCacheStats stats;
+	size_t triangleCount = indices.size() / 3;
+	if (triangleCount == 0) {
+		return stats;
+	}
+
+	FifoCacheSimulator cache(vertexCount, cacheSize);
+	std::vector<bool> referenced(vertexCount, false);
+	size_t referencedCount = 0;
+	size_t misses = 0;
+	for (size_t i = 0; i < triangleCount * 3; i += 3) {
+		misses += cache.access(indices[i + 0], indices[i + 1], indices[i + 2]);
+		for (size_t k = 0; k < 3; ++k) {
+			if (!referenced[indices[i + k]]) {
+				referenced[indices[i + k]] = true;
+				++referencedCount;
+			}
+		}
+	}
+
+	stats.acmr = static_cast<float>(misses) / static_cast<float>(triangleCount);
+	stats.atvr = static_cast<float>(misses) / static_cast<float>(referencedCount);
+	return stats;
+}
+
+void optimizeVertexCache(std::vector<uint32_t>& indices, size_t vertexCount) {
+	size_t triangleCount = indices.size() / 3;
+	if (triangleCount == 0) {
+		return;
+	}
+
+	// 每个顶点剩余（未输出）的三角形数
+	std::vector<uint32_t> liveTriangles(vertexCount, 0);
+	for (size_t i = 0; i < triangleCount * 3; ++i) {
+		++liveTriangles[indices[i]];
+	}
+
+	// 顶点 -> 三角形邻接表，每个顶点的前 liveTriangles[v] 项为尚未输出的三角形
+	std::vector<uint32_t> adjacencyOffset(vertexCount + 1, 0);
+	for (size_t v = 0; v < vertexCount; ++v) {
+		adjacencyOffset[v + 1] = adjacencyOffset[v] + liveTriangles[v];
+	}
+	std::vector<uint32_t> adjacency(triangleCount * 3);
+	{
+		std::vector<uint32_t> cursor(adjacencyOffset.begin(), adjacencyOffset.end() - 1);
+		for (size_t i = 0; i < triangleCount * 3; ++i) {
+			adjacency[cursor[indices[i]]++] = static_cast<uint32_t>(i / 3);
+		}
+	}
+
+	std::vector<int> cachePosition(vertexCount, -1);
+	std::vector<float> vertexScore(vertexCount);
+	for (size_t v = 0; v < vertexCount; ++v) {
+		vertexScore[v] = forsythVertexScore(-1, liveTriangles[v]);
+	}
+
+	std::vector<float> triangleScore(triangleCount);
+	for (size_t t = 0; t < triangleCount; ++t) {
+		triangleScore[t] = vertexScore[indices[3 * t + 0]] + vertexScore[indices[3 * t + 1]] + vertexScore[indices[3 * t + 2]];
+	}
+
+	std::vector<bool> emitted(triangleCount, false);
+	std::vector<uint32_t> output;
+	output.reserve(triangleCount * 3);
+
+	// 缓存多留 3 个位置，用于放置被挤出的顶点以便更新它们的分数
+	std::array<uint32_t, kForsythCacheSize + 3> cache{};
+	std::array<uint32_t, kForsythCacheSize + 3> newCache{};
+	size_t cacheCount = 0;
+
+	int bestTriangle = static_cast<int>(std::max_element(triangleScore.begin(), triangleScore.end()) - triangleScore.begin());
+	size_t scanCursor = 0;
+
+	for (size_t emittedCount = 0; emittedCount < triangleCount; ++emittedCount) {
+		if (bestTriangle < 0) {
+			// 缓存中的顶点都没有剩余三角形，顺序找下一个未输出的三角形重新开始
+			while (emitted[scanCursor]) {
+				++scanCursor;
+			}
+			bestTriangle = static_cast<int>(scanCursor);
+		}
+
+		uint32_t tri[3] = {
+			indices[3 * bestTriangle + 0],
+			indices[3 * bestTriangle + 1],
+			indices[3 * bestTriangle + 2]
+		};
+		output.insert(output.end(), tri, tri + 3);
+		emitted[bestTriangle] = true;
+
+		// 从三个顶点的邻接表中移除该三角形
+		for (uint32_t v : tri) {
+			uint32_t* begin = adjacency.data() + adjacencyOffset[v];
+			uint32_t* end = begin + liveTriangles[v];
+			uint32_t* it = std::find(begin, end, static_cast<uint32_t>(bestTriangle));
+			std::swap(*it, *(end - 1));
+			--liveTriangles[v];
+		}
+
+		// 新三角形的顶点放在缓存最前面，其余按原顺序后移
+		size_t newCacheCount = 0;
+		for (uint32_t v : tri) {
+			newCache[newCacheCount++] = v;
+		}
+		for (size_t i = 0; i < cacheCount; ++i) {
+			uint32_t v = cache[i];
+			if (v != tri[0] && v != tri[1] && v != tri[2] && newCacheCount < newCache.size()) {
+				newCache[newCacheCount++] = v;
+			}
+		}
+		std::swap(cache, newCache);
+		cacheCount = newCacheCount;
+
+		// 更新缓存内（包括刚被挤出的）顶点的分数，并把分数变化累加到它们的三角形上
+		bestTriangle = -1;
+		float bestScore = -1.0f;
+		for (size_t i = 0; i < cacheCount; ++i) {
+			uint32_t v = cache[i];
+			cachePosition[v] = i < kForsythCacheSize ? static_cast<int>(i) : -1;
+			float score = forsythVertexScore(cachePosition[v], liveTriangles[v]);
+			float delta = score - vertexScore[v];
+			vertexScore[v] = score;
+
+			const uint32_t* adjacent = adjacency.data() + adjacencyOffset[v];
+			for (uint32_t k = 0; k < liveTriangles[v]; ++k) {
+				uint32_t t = adjacent[k];
+				triangleScore[t] += delta;
+			}
+		}
+		for (size_t i = 0; i < cacheCount; ++i) {
+			uint32_t v = cache[i];
+			const uint32_t* adjacent = adjacency.data() + adjacencyOffset[v];
+			for (uint32_t k = 0; k < liveTriangles[v]; ++k) {
+				uint32_t t = adjacent[k];
+				if (triangleScore[t] > bestScore) {
+					bestScore = triangleScore[t];
+					bestTriangle = static_cast<int>(t);
+				}
+			}
+		}
+
+		// 被挤出的顶点不再留在缓存里
+		if (cacheCount > kForsythCacheSize) {
+			cacheCount = kForsythCacheSize;
+		}
+	}
+
+	indices.swap(output);
+}
+
+void optimizeOverdraw(std::vector<uint32_t>& indices, const std::vector<VertexAttributes>& vertices, float threshold) {
+	size_t triangleCount = indices.size() / 3;
+	if (triangleCount < 2) {
+		return;
+	}
+
+	constexpr uint32_t kClusterCacheSize = 16;
+
+	// 硬边界：三个顶点全部未命中的位置，缓存相当于被清空，在这里切分不会损失缓存效率
+	std::vector<uint32_t> hardClusters;
+	{
+		FifoCacheSimulator cache(vertices.size(), kClusterCacheSize);
+		for (size_t t = 0; t < triangleCount; ++t) {
+			uint32_t misses = cache.access(indices[3 * t + 0], indices[3 * t + 1], indices[3 * t + 2]);
+			if (t == 0 || misses == 3) {
+				hardClusters.push_back(static_cast<uint32_t>(t));
+			}
+		}
+	}
+
+	// 软边界：在硬簇内部，当累计 ACMR 低于簇平均值 * threshold 时继续切分
+	std::vector<uint32_t> clusters;
+	{
+		FifoCacheSimulator cache(vertices.size(), kClusterCacheSize);
+		for (size_t c = 0; c < hardClusters.size(); ++c) {
+			size_t start = hardClusters[c];
+			size_t end = c + 1 < hardClusters.size() ? hardClusters[c + 1] : triangleCount;
+
+			cache.reset();
+			uint32_t clusterMisses = 0;
+			for (size_t t = start; t < end; ++t) {
+				clusterMisses += cache.access(indices[3 * t + 0], indices[3 * t + 1], indices[3 * t + 2]);
+			}
+			float clusterThreshold = threshold * static_cast<float>(clusterMisses) / static_cast<float>(end - start);
+
+			cache.reset();
+			clusters.push_back(static_cast<uint32_t>(start));
+			uint32_t runningMisses = 0;
+			uint32_t runningTriangles = 0;
+			for (size_t t = start; t < end; ++t) {
+				runningMisses += cache.access(indices[3 * t + 0], indices[3 * t + 1], indices[3 * t + 2]);
+				++runningTriangles;
+				if (t + 1 < end && static_cast<float>(runningMisses) / static_cast<float>(runningTriangles) <= clusterThreshold) {
+					clusters.push_back(static_cast<uint32_t>(t + 1));
+					cache.reset();
+					runningMisses = 0;
+					runningTriangles = 0;
+				}
+			}
+		}
+	}
+
+	// 网格中心（按面积加权）
+	auto trianglePositions = [&](size_t t) {
+		return std::array<glm::vec3, 3>{
+			vertices[indices[3 * t + 0]].position,
+			vertices[indices[3 * t + 1]].position,
+			vertices[indices[3 * t + 2]].position
+		};
+	};
+	glm::vec3 meshCentroid(0.0f);
+	float meshArea = 0.0f;
+	for (size_t t = 0; t < triangleCount; ++t) {
+		auto p = trianglePositions(t);
+		float area = glm::length(glm::cross(p[1] - p[0], p[2] - p[0]));
+		meshCentroid += (p[0] + p[1] + p[2]) * (area / 3.0f);
+		meshArea += area;
+	}
+	if (meshArea > 0.0f) {
+		meshCentroid /= meshArea;
+	}
+
+	// 每个簇的排序键：簇中心相对网格中心的偏移在簇平均法向量上的投影，越朝外越先画
+	std::vector<float> sortKey(clusters.size());
+	for (size_t c = 0; c < clusters.size(); ++c) {
+		size_t start = clusters[c];
+		size_t end = c + 1 < clusters.size() ? clusters[c + 1] : triangleCount;
+
+		glm::vec3 centroid(0.0f);
+		glm::vec3 normal(0.0f);
+		float area = 0.0f;
+		for (size_t t = start; t < end; ++t) {
+			auto p = trianglePositions(t);
+			glm::vec3 n = glm::cross(p[1] - p[0], p[2] - p[0]);
+			float a = glm::length(n);
+			centroid += (p[0] + p[1] + p[2]) * (a / 3.0f);
+			normal += n;
+			area += a;
+		}
+		if (area > 0.0f) {
+			centroid /= area;
+		}
+		float normalLength = glm::length(normal);
+		if (normalLength > 0.0f) {
+			normal /= normalLength;
+		}
+		sortKey[c] = glm::dot(centroid - meshCentroid, normal);
+	}
+
+	std::vector<uint32_t> order(clusters.size());
+	std::iota(order.begin(), order.end(), 0u);
+	std::stable_sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) {
+		return sortKey[a] > sortKey[b];
+	});
+
+	std::vector<uint32_t> output;
+	output.reserve(indices.size());
+	for (uint32_t c : order) {
+		size_t start = clusters[c];
+		size_t end = c + 1 < clusters.size() ? clusters[c + 1] : triangleCount;
+		output.insert(output.end(), indices.begin() + 3 * start, indices.begin() + 3 * end);
+	}
+	indices.swap(output);
+}
+
+void optimizeVertexFetch(std::vector<VertexAttributes>& vertices, std::vector<uint32_t>& indices) {
+	constexpr uint32_t kUnused = ~0u;
+	std::vector<uint32_t> remap(vertices.size(), kUnused);
+	std::vector<VertexAttributes> reordered;
+	reordered.reserve(vertices.size());
+
+	// 按索引中首次出现的顺序排列顶点，未被引用的顶点被丢弃
+	for (uint32_t& index : indices) {
+		if (remap[index] == kUnused) {
+			remap[index] = static_cast<uint32_t>(reordered.size());
+			reordered.push_back(vertices[index]);
+		}
+		index = remap[index];
+	}
+	vertices.swap(reordered);
+}
+
+void optimizeMesh(Mesh& mesh, VertexCacheStats* before, VertexCacheStats* after) {
+	if (before) {
+		*before = analyzeVertexCache(mesh.indices, mesh.vertices.size());
+	}
+
+	optimizeVertexCache(mesh.indices, mesh.vertices.size());
+	optimizeOverdraw(mesh.indices, mesh.vertices);
+	optimizeVertexFetch(mesh.vertices, mesh.indices);
+
+	if (after) {
+		*after = analyzeVertexCache(mesh.indices, mesh.vertices.size());
+	}
+}
+
+void reportMeshOptimization(const std::filesystem::path& directory) {
+	if (!std::filesystem::is_directory(directory)) {
+		std::cerr << "Not a directory: " << directory.string() << '\n';
+		return;
+	}
+
+	std::vector<std::filesystem::path> objFiles;
+	for (const auto& entry : std::filesystem::recursive_directory_iterator(directory)) {
+		std::string extension = entry.path().extension().string();
+		std::transform(extension.begin(), extension.end(), extension.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+		if (entry.is_regular_file() && extension == ".obj") {
+			objFiles.push_back(entry.path());
+		}
+	}
+	std::sort(objFiles.begin(), objFiles.end());
+
+	printf("%-48s %10s %10s %8s %8s %8s %8s\n", "model", "vertices", "triangles", "ACMR", "ACMR'", "ATVR", "ATVR'");
+	for (const auto& path : objFiles) {
+		Mesh mesh;
+		if (!loadMeshFromObj(path, mesh)) {
+			continue;
+		}
+		VertexCacheStats before;
+		VertexCacheStats after;
+		optimizeMesh(mesh, &before, &after);
+		printf("%-48s %10zu %10zu %8.3f %8.3f %8.3f %8.3f\n",
+			std::filesystem::relative(path, directory).string().c_str(),
+			mesh.vertices.size(), mesh.indices.size() / 3,
+			before.acmr, after.acmr, before.atvr, after.atvr);
+	}
+}
+
+}
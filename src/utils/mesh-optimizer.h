@@ -0,0 +1,54 @@
+#pragma once
+
+#include "data-structure.h"
+
+namespace webgpu {
+
+/**
+ * 顶点缓存统计
+ * ACMR: 每个三角形平均的顶点缓存未命中次数（越低越好，理想值约 0.5）
+ * ATVR: 平均每个顶点被变换的次数（越低越好，理想值 1.0）
+ */
+struct VertexCacheStats {
+	float acmr = 0.0f;
+	float atvr = 0.0f;
+};
+
+/**
+ * @brief 模拟 FIFO 顶点缓存，计算 ACMR/ATVR
+ * @param indices 三角形列表索引
+ * @param vertexCount 顶点数量
+ * @param cacheSize 模拟的缓存大小
+ */
+VertexCacheStats analyzeVertexCache(const std::vector<uint32_t>& indices, size_t vertexCount, uint32_t cacheSize = 16);
+
+/**
+ * @brief 顶点缓存优化（Forsyth 线性速度算法），原地重排三角形顺序
+ */
+void optimizeVertexCache(std::vector<uint32_t>& indices, size_t vertexCount);
+
+/**
+ * @brief Overdraw 优化
+ * 在缓存优化后的三角形序列上切分簇，并按“朝外程度”排序，先画外侧的簇以提高 early-Z 剔除率
+ * @param threshold 允许的 ACMR 劣化比例，1.05 表示最多劣化 5%
+ */
+void optimizeOverdraw(std::vector<uint32_t>& indices, const std::vector<VertexAttributes>& vertices, float threshold = 1.05f);
+
+/**
+ * @brief 顶点读取优化，按首次使用的顺序重排顶点并重映射索引
+ */
+void optimizeVertexFetch(std::vector<VertexAttributes>& vertices, std::vector<uint32_t>& indices);
+
+/**
+ * @brief 依次执行顶点缓存、overdraw、顶点读取优化
+ * @param before 优化前的统计（可为空）
+ * @param after 优化后的统计（可为空）
+ */
+void optimizeMesh(Mesh& mesh, VertexCacheStats* before = nullptr, VertexCacheStats* after = nullptr);
+
+/**
+ * @brief 递归加载目录下的所有 OBJ，输出优化前后的 ACMR/ATVR
+ */
+void reportMeshOptimization(const std::filesystem::path& directory);
+
+}
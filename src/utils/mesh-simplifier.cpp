@@ -0,0 +1,341 @@
+#include "mesh-simplifier.h"
+#include "mesh-optimizer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <unordered_map>
+
+namespace webgpu {
+
+namespace {
+
+/**
+ * 对称 4x4 二次误差矩阵，error(p) = p^T A p + 2 b·p + c
+ * weight 为累计的面积权重，用于把误差归一化成平均平方距离
+ */
+struct Quadric {
+	double a00 = 0, a11 = 0, a22 = 0, a01 = 0, a02 = 0, a12 = 0;
+	double b0 = 0, b1 = 0, b2 = 0;
+	double c = 0;
+	double weight = 0;
+
+	void addPlane(const glm::dvec3& n, double d, double w) {
+		a00 += w * n.x * n.x; a11 += w * n.y * n.y; a22 += w * n.z * n.z;
+		a01 += w * n.x * n.y; a02 += w * n.x * n.z; a12 += w * n.y * n.z;
+		b0 += w * n.x * d; b1 += w * n.y * d; b2 += w * n.z * d;
+		c += w * d * d;
+		weight += w;
+	}
+
+	Quadric& operator+=(const Quadric& o) {
+		a00 += o.a00; a11 += o.a11; a22 += o.a22;
+		a01 += o.a01; a02 += o.a02; a12 += o.a12;
+		b0 += o.b0; b1 += o.b1; b2 += o.b2;
+		c += o.c;
+		weight += o.weight;
+		return *this;
+	}
+
+	// 平均平方距离
+	double evaluate(const glm::dvec3& p) const {
+		if (weight <= 0.0) {
+			return 0.0;
+		}
+		double e = a00 * p.x * p.x + a11 * p.y * p.y + a22 * p.z * p.z
+			+ 2.0 * (a01 * p.x * p.y + a02 * p.x * p.z + a12 * p.y * p.z)
+			+ 2.0 * (b0 * p.x + b1 * p.y + b2 * p.z)
+			+ c;
+		return std::max(e, 0.0) / weight;
+	}
+};
+
+struct Collapse {
+	uint32_t from;
+	uint32_t to;
+	float cost;
+};
+
+uint64_t edgeKey(uint32_t a, uint32_t b) {
+	if (a > b) {
+		std::swap(a, b);
+	}
+	return (static_cast<uint64_t>(a) << 32) | b;
+}
+
+}
+
+std::vector<uint32_t> simplifyMesh(const std::vector<VertexAttributes>& vertices, const std::vector<uint32_t>& indices,
+	size_t targetIndexCount, float* resultError) {
+	std::vector<uint32_t> result = indices;
+	if (resultError) {
+		*resultError = 0.0f;
+	}
+	size_t vertexCount = vertices.size();
+	if (result.size() <= targetIndexCount || vertexCount == 0) {
+		return result;
+	}
+
+	// 按位置焊接：不同法向量的同位置顶点共享同一个 weld 代表
+	std::vector<uint32_t> weld(vertexCount);
+	std::vector<uint32_t> weldUsage(vertexCount, 0);
+	{
+		std::unordered_map<std::string_view, uint32_t> positionLookup;
+		positionLookup.reserve(vertexCount);
+		for (uint32_t v = 0; v < vertexCount; ++v) {
+			std::string_view key(reinterpret_cast<const char*>(&vertices[v].position), sizeof(glm::vec3));
+			weld[v] = positionLookup.try_emplace(key, v).first->second;
+		}
+	}
+
+	// 只统计被索引引用的顶点，判断接缝
+	{
+		std::vector<bool> referenced(vertexCount, false);
+		for (uint32_t i : result) {
+			if (!referenced[i]) {
+				referenced[i] = true;
+				++weldUsage[weld[i]];
+			}
+		}
+	}
+
+	auto position = [&](uint32_t v) { return glm::dvec3(vertices[v].position); };
+
+	// 每个 weld 代表的二次误差
+	std::vector<Quadric> quadrics(vertexCount);
+	for (size_t i = 0; i + 2 < result.size(); i += 3) {
+		glm::dvec3 p0 = position(result[i + 0]);
+		glm::dvec3 p1 = position(result[i + 1]);
+		glm::dvec3 p2 = position(result[i + 2]);
+		glm::dvec3 n = glm::cross(p1 - p0, p2 - p0);
+		double length = glm::length(n);
+		if (length <= 0.0) {
+			continue;
+		}
+		n /= length;
+		double d = -glm::dot(n, p0);
+		for (size_t k = 0; k < 3; ++k) {
+			quadrics[weld[result[i + k]]].addPlane(n, d, length * 0.5);
+		}
+	}
+
+	// 锁定接缝和开放边界上的顶点
+	std::vector<bool> locked(vertexCount, false);
+	{
+		std::unordered_map<uint64_t, uint32_t> edgeUsage;
+		edgeUsage.reserve(result.size());
+		for (size_t i = 0; i + 2 < result.size(); i += 3) {
+			for (size_t k = 0; k < 3; ++k) {
+				uint32_t a = weld[result[i + k]];
+				uint32_t b = weld[result[i + (k + 1) % 3]];
+				++edgeUsage[edgeKey(a, b)];
+			}
+		}
+		for (const auto& [key, count] : edgeUsage) {
+			if (count == 1) {
+				locked[static_cast<uint32_t>(key >> 32)] = true;
+				locked[static_cast<uint32_t>(key & 0xffffffffu)] = true;
+			}
+		}
+		for (uint32_t v = 0; v < vertexCount; ++v) {
+			if (weldUsage[weld[v]] > 1) {
+				locked[weld[v]] = true;
+			}
+		}
+	}
+
+	std::vector<uint32_t> remap(vertexCount);
+	std::vector<uint32_t> adjacencyOffset(vertexCount + 1);
+	std::vector<uint32_t> adjacency;
+	std::vector<bool> touched(vertexCount);
+	std::vector<Collapse> collapses;
+	double maxError = 0.0;
+
+	while (result.size() > targetIndexCount) {
+		size_t triangleCount = result.size() / 3;
+
+		// 顶点 -> 三角形邻接
+		std::fill(adjacencyOffset.begin(), adjacencyOffset.end(), 0);
+		for (uint32_t i : result) {
+			++adjacencyOffset[i + 1];
+		}
+		for (size_t v = 0; v < vertexCount; ++v) {
+			adjacencyOffset[v + 1] += adjacencyOffset[v];
+		}
+		adjacency.resize(result.size());
+		{
+			std::vector<uint32_t> cursor(adjacencyOffset.begin(), adjacencyOffset.end() - 1);
+			for (size_t i = 0; i < result.size(); ++i) {
+				adjacency[cursor[result[i]]++] = static_cast<uint32_t>(i / 3);
+			}
+		}
+
+		// 收集候选折叠（from -> to），from 必须未锁定
+		collapses.clear();
+		for (size_t t = 0; t < triangleCount; ++t) {
+			for (size_t k = 0; k < 3; ++k) {
+				uint32_t a = result[3 * t + k];
+				uint32_t b = result[3 * t + (k + 1) % 3];
+				for (int dir = 0; dir < 2; ++dir) {
+					uint32_t from = dir == 0 ? a : b;
+					uint32_t to = dir == 0 ? b : a;
+					if (locked[weld[from]] || weld[from] == weld[to]) {
+						continue;
+					}
+					Quadric q = quadrics[weld[from]];
+					q += quadrics[weld[to]];
+					collapses.push_back({ from, to, static_cast<float>(q.evaluate(position(to))) });
+				}
+			}
+		}
+		if (collapses.empty()) {
+			break;
+		}
+		std::sort(collapses.begin(), collapses.end(), [](const Collapse& x, const Collapse& y) {
+			return x.cost < y.cost;
+		});
+
+		// 每次折叠大约移除两个三角形
+		size_t trianglesToRemove = (result.size() - targetIndexCount) / 3;
+		size_t trianglesRemoved = 0;
+		for (uint32_t v = 0; v < vertexCount; ++v) {
+			remap[v] = v;
+		}
+		std::fill(touched.begin(), touched.end(), false);
+
+		for (const Collapse& collapse : collapses) {
+			if (trianglesRemoved >= trianglesToRemove) {
+				break;
+			}
+			if (touched[collapse.from] || touched[collapse.to]) {
+				continue;
+			}
+
+			// 检查折叠后周围三角形是否翻转
+			bool flipped = false;
+			size_t sharedTriangles = 0;
+			glm::dvec3 target = position(collapse.to);
+			for (uint32_t k = adjacencyOffset[collapse.from]; k < adjacencyOffset[collapse.from + 1] && !flipped; ++k) {
+				uint32_t t = adjacency[k];
+				uint32_t tri[3] = { result[3 * t + 0], result[3 * t + 1], result[3 * t + 2] };
+				if (tri[0] == collapse.to || tri[1] == collapse.to || tri[2] == collapse.to) {
+					++sharedTriangles;
+					continue;
+				}
+				glm::dvec3 p[3] = { position(tri[0]), position(tri[1]), position(tri[2]) };
+				glm::dvec3 oldNormal = glm::cross(p[1] - p[0], p[2] - p[0]);
+				for (size_t j = 0; j < 3; ++j) {
+					if (tri[j] == collapse.from) {
+						p[j] = target;
+					}
+				}
+				glm::dvec3 newNormal = glm::cross(p[1] - p[0], p[2] - p[0]);
+				if (glm::dot(oldNormal, newNormal) <= 0.0) {
+					flipped = true;
+				}
+			}
+			if (flipped) {
+				continue;
+			}
+
+			// 折叠，并冻结周围顶点，避免同一轮内相邻折叠让翻转检测失效
+			remap[collapse.from] = collapse.to;
+			for (uint32_t k = adjacencyOffset[collapse.from]; k < adjacencyOffset[collapse.from + 1]; ++k) {
+				uint32_t t = adjacency[k];
+				touched[result[3 * t + 0]] = true;
+				touched[result[3 * t + 1]] = true;
+				touched[result[3 * t + 2]] = true;
+			}
+			quadrics[weld[collapse.to]] += quadrics[weld[collapse.from]];
+			maxError = std::max(maxError, static_cast<double>(collapse.cost));
+			trianglesRemoved += sharedTriangles;
+		}
+
+		if (trianglesRemoved == 0) {
+			break;
+		}
+
+		// 应用重映射，丢弃退化三角形
+		size_t write = 0;
+		for (size_t t = 0; t < triangleCount; ++t) {
+			uint32_t a = remap[result[3 * t + 0]];
+			uint32_t b = remap[result[3 * t + 1]];
+			uint32_t c = remap[result[3 * t + 2]];
+			if (weld[a] == weld[b] || weld[b] == weld[c] || weld[a] == weld[c]) {
+				continue;
+			}
+			result[write++] = a;
+			result[write++] = b;
+			result[write++] = c;
+		}
+		result.resize(write);
+	}
+
+	if (resultError) {
+		*resultError = static_cast<float>(std::sqrt(maxError));
+	}
+	return result;
+}
+
+std::vector<MeshLod> buildLodChain(Mesh& mesh, size_t levelCount) {
+	std::vector<MeshLod> lods;
+	lods.push_back({ 0, static_cast<uint32_t>(mesh.indices.size()), 0.0f });
+
+	std::vector<uint32_t> current = mesh.indices;
+	while (lods.size() < levelCount) {
+		size_t target = current.size() / 6 * 3;
+		float error = 0.0f;
+		std::vector<uint32_t> next = simplifyMesh(mesh.vertices, current, target, &error);
+		if (next.empty() || next.size() * 10 > current.size() * 9) {
+			break;
+		}
+		optimizeVertexCache(next, mesh.vertices.size());
+
+		MeshLod lod;
+		lod.firstIndex = static_cast<uint32_t>(mesh.indices.size());
+		lod.indexCount = static_cast<uint32_t>(next.size());
+		// 每一级都从上一级简化而来，误差累加作为相对原网格的上界
+		lod.error = lods.back().error + error;
+		lods.push_back(lod);
+
+		mesh.indices.insert(mesh.indices.end(), next.begin(), next.end());
+		current.swap(next);
+	}
+
+	for (size_t i = 0; i < lods.size(); ++i) {
+		LOG("LOD %zu: %u triangles, error %g\n", i, lods[i].indexCount / 3, lods[i].error);
+	}
+	return lods;
+}
+
+BoundingSphere computeBoundingSphere(const std::vector<VertexAttributes>& vertices) {
+	BoundingSphere sphere;
+	if (vertices.empty()) {
+		return sphere;
+	}
+	glm::vec3 boundsMin = vertices[0].position;
+	glm::vec3 boundsMax = vertices[0].position;
+	for (const auto& v : vertices) {
+		boundsMin = glm::min(boundsMin, v.position);
+		boundsMax = glm::max(boundsMax, v.position);
+	}
+	sphere.center = (boundsMin + boundsMax) * 0.5f;
+	for (const auto& v : vertices) {
+		sphere.radius = std::max(sphere.radius, glm::length(v.position - sphere.center));
+	}
+	return sphere;
+}
+
+size_t selectLod(const std::vector<MeshLod>& lods, float distance, float worldScale, float pixelsPerUnit, float pixelThreshold) {
+	distance = std::max(distance, 1e-4f);
+	// 从最粗的层级开始，找到第一个投影误差满足要求的层级
+	for (size_t i = lods.size(); i-- > 1;) {
+		float pixelError = lods[i].error * worldScale * pixelsPerUnit / distance;
+		if (pixelError <= pixelThreshold) {
+			return i;
+		}
+	}
+	return 0;
+}
+
+}
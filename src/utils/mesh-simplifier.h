@@ -0,0 +1,61 @@
+#pragma once
+
+#include "data-structure.h"
+
+namespace webgpu {
+
+/**
+ * LOD 层级：在共享索引缓冲区中的范围，以及相对原网格的几何误差（网格空间距离）
+ */
+struct MeshLod {
+	uint32_t firstIndex = 0;
+	uint32_t indexCount = 0;
+	float error = 0.0f;
+};
+
+/**
+ * 包围球（网格空间）
+ */
+struct BoundingSphere {
+	glm::vec3 center = glm::vec3(0.0f);
+	float radius = 0.0f;
+};
+
+/**
+ * @brief 基于二次误差度量（QEM）的边折叠简化
+ * 只折叠到已有顶点上，因此简化结果与原网格共享顶点缓冲区
+ * 法向量接缝与开放边界上的顶点会被锁定，避免破坏轮廓和属性
+ * @param vertices 顶点
+ * @param indices 输入三角形列表
+ * @param targetIndexCount 目标索引数
+ * @param resultError 输出本次简化产生的最大误差（网格空间距离）
+ * @return 简化后的索引
+ */
+std::vector<uint32_t> simplifyMesh(const std::vector<VertexAttributes>& vertices, const std::vector<uint32_t>& indices,
+	size_t targetIndexCount, float* resultError = nullptr);
+
+/**
+ * @brief 生成 LOD 链，追加到 mesh.indices 之后
+ * 第 0 级为原网格（mesh.indices 原有内容），之后每级三角形数约减半
+ * 简化不再有效（三角形数下降不足 10%）时提前结束
+ * @param levelCount 最多生成的层级数（包括第 0 级）
+ */
+std::vector<MeshLod> buildLodChain(Mesh& mesh, size_t levelCount = 6);
+
+/**
+ * @brief 计算网格的包围球（以包围盒中心为球心）
+ */
+BoundingSphere computeBoundingSphere(const std::vector<VertexAttributes>& vertices);
+
+/**
+ * @brief 按屏幕空间误差选择 LOD
+ * @param lods LOD 链，按精度从高到低
+ * @param distance 视点到物体的距离（世界空间）
+ * @param worldScale 网格空间到世界空间的缩放
+ * @param pixelsPerUnit 单位距离处每个世界单位对应的像素数（viewportHeight / 2 * 投影缩放）
+ * @param pixelThreshold 允许的最大屏幕空间误差（像素）
+ * @return 选中的层级
+ */
+size_t selectLod(const std::vector<MeshLod>& lods, float distance, float worldScale, float pixelsPerUnit, float pixelThreshold);
+
+}
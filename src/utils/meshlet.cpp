@@ -0,0 +1,124 @@
+#include "meshlet.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace webgpu {
+
+namespace {
+
+void computeMeshletBounds(const std::vector<VertexAttributes>& vertices, const uint32_t* triangles, Meshlet& meshlet) {
+	// 包围球：包围盒中心 + 最大距离
+	glm::vec3 boundsMin(std::numeric_limits<float>::max());
+	glm::vec3 boundsMax(std::numeric_limits<float>::lowest());
+	for (uint32_t i = 0; i < meshlet.triangleCount * 3; ++i) {
+		const glm::vec3& p = vertices[triangles[i]].position;
+		boundsMin = glm::min(boundsMin, p);
+		boundsMax = glm::max(boundsMax, p);
+	}
+	meshlet.center = (boundsMin + boundsMax) * 0.5f;
+	meshlet.radius = 0.0f;
+	for (uint32_t i = 0; i < meshlet.triangleCount * 3; ++i) {
+		meshlet.radius = std::max(meshlet.radius, glm::length(vertices[triangles[i]].position - meshlet.center));
+	}
+
+	// 法线锥：轴为三角形法向量的平均方向，张角由与轴夹角最大的法向量决定
+	std::vector<glm::vec3> normals;
+	std::vector<glm::vec3> centroids;
+	normals.reserve(meshlet.triangleCount);
+	centroids.reserve(meshlet.triangleCount);
+	glm::vec3 axis(0.0f);
+	for (uint32_t t = 0; t < meshlet.triangleCount; ++t) {
+		const glm::vec3& p0 = vertices[triangles[3 * t + 0]].position;
+		const glm::vec3& p1 = vertices[triangles[3 * t + 1]].position;
+		const glm::vec3& p2 = vertices[triangles[3 * t + 2]].position;
+		glm::vec3 n = glm::cross(p1 - p0, p2 - p0);
+		float length = glm::length(n);
+		if (length <= 0.0f) {
+			continue;
+		}
+		n /= length;
+		normals.push_back(n);
+		centroids.push_back((p0 + p1 + p2) / 3.0f);
+		axis += n;
+	}
+
+	// 默认不可剔除：cutoff 大于 1 时锥测试永远不成立
+	meshlet.coneApex = meshlet.center;
+	meshlet.coneAxis = glm::vec3(0.0f, 0.0f, 1.0f);
+	meshlet.coneCutoff = 2.0f;
+
+	float axisLength = glm::length(axis);
+	if (normals.empty() || axisLength <= 0.0f) {
+		return;
+	}
+	axis /= axisLength;
+
+	float minDot = 1.0f;
+	for (const auto& n : normals) {
+		minDot = std::min(minDot, glm::dot(n, axis));
+	}
+	// 法向量分布超过一个半球附近时锥剔除没有意义
+	if (minDot <= 0.1f) {
+		return;
+	}
+
+	// 锥顶点：沿轴反方向移动，保证所有三角形平面都在锥顶的“正面”
+	float maxT = 0.0f;
+	for (size_t i = 0; i < normals.size(); ++i) {
+		float dc = glm::dot(centroids[i] - meshlet.center, normals[i]);
+		float dn = glm::dot(axis, normals[i]);
+		maxT = std::max(maxT, dc / dn);
+	}
+	meshlet.coneApex = meshlet.center - axis * maxT;
+	meshlet.coneAxis = axis;
+	meshlet.coneCutoff = std::sqrt(1.0f - minDot * minDot);
+}
+
+}
+
+MeshletMesh buildMeshlets(const std::vector<VertexAttributes>& vertices, const uint32_t* indices, size_t indexCount) {
+	MeshletMesh result;
+	result.indices.reserve(indexCount);
+
+	// 顶点在当前 meshlet 中是否已出现，用 meshlet 序号做标记避免每次清空
+	std::vector<uint32_t> vertexTag(vertices.size(), ~0u);
+
+	Meshlet current = {};
+	auto flush = [&]() {
+		if (current.triangleCount == 0) {
+			return;
+		}
+		computeMeshletBounds(vertices, result.indices.data() + current.triangleOffset * 3, current);
+		result.meshlets.push_back(current);
+		current = {};
+		current.triangleOffset = static_cast<uint32_t>(result.indices.size() / 3);
+	};
+
+	for (size_t i = 0; i + 2 < indexCount; i += 3) {
+		uint32_t tag = static_cast<uint32_t>(result.meshlets.size());
+		uint32_t newVertices = 0;
+		for (size_t k = 0; k < 3; ++k) {
+			newVertices += vertexTag[indices[i + k]] != tag ? 1 : 0;
+		}
+		if (current.vertexCount + newVertices > kMeshletMaxVertices || current.triangleCount + 1 > kMeshletMaxTriangles) {
+			flush();
+			tag = static_cast<uint32_t>(result.meshlets.size());
+		}
+		for (size_t k = 0; k < 3; ++k) {
+			if (vertexTag[indices[i + k]] != tag) {
+				vertexTag[indices[i + k]] = tag;
+				++current.vertexCount;
+			}
+			result.indices.push_back(indices[i + k]);
+		}
+		++current.triangleCount;
+	}
+	flush();
+
+	LOG("Meshlets: %zu (%zu triangles)\n", result.meshlets.size(), result.indices.size() / 3);
+	return result;
+}
+
+}
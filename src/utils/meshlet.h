@@ -0,0 +1,47 @@
+#pragma once
+
+#include "data-structure.h"
+
+namespace webgpu {
+
+// 每个 meshlet 的上限，与常见的 mesh shader 硬件限制一致
+constexpr uint32_t kMeshletMaxVertices = 64;
+constexpr uint32_t kMeshletMaxTriangles = 124;
+
+/**
+ * meshlet 及其剔除数据，布局与 meshlet-cull.wgsl 中的 Meshlet 一致
+ * 三角形以全局顶点索引存放在 MeshletMesh::indices 的 [triangleOffset * 3, (triangleOffset + triangleCount) * 3) 中
+ * 法线锥：若 dot(normalize(coneApex - cameraPosition), coneAxis) >= coneCutoff，则整个 meshlet 背向相机
+ */
+struct Meshlet {
+	glm::vec3 center;
+	float radius;
+	glm::vec3 coneApex;
+	float coneCutoff;
+	glm::vec3 coneAxis;
+	uint32_t triangleOffset;
+	uint32_t triangleCount;
+	uint32_t vertexCount;
+	uint32_t _pad[2];
+};
+
+static_assert(sizeof(Meshlet) == 64);
+
+/**
+ * 切分后的网格：meshlet 列表和按 meshlet 重排的三角形索引
+ */
+struct MeshletMesh {
+	std::vector<Meshlet> meshlets;
+	std::vector<uint32_t> indices;
+};
+
+/**
+ * @brief 按三角形顺序贪心切分 meshlet，并计算包围球和法线锥
+ * 输入最好已经过顶点缓存优化，相邻三角形共享顶点越多，meshlet 越紧凑
+ * @param vertices 顶点
+ * @param indices 三角形列表索引（可以是 mesh.indices 的一段）
+ * @param indexCount 使用的索引数量
+ */
+MeshletMesh buildMeshlets(const std::vector<VertexAttributes>& vertices, const uint32_t* indices, size_t indexCount);
+
+}
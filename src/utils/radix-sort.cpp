@@ -0,0 +1,58 @@
+#include "radix-sort.h"
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+
+namespace webgpu {
+
+void radixSort(std::span<uint64_t> keys, std::span<uint32_t> values, std::span<uint64_t> keyScratch, std::span<uint32_t> valueScratch) {
+	assert(values.size() == keys.size() && keyScratch.size() >= keys.size() && valueScratch.size() >= keys.size());
+	const size_t count = keys.size();
+	if (count < 2) {
+		return;
+	}
+
+	// 一次遍历统计 8 个字节的直方图
+	std::array<std::array<uint32_t, 256>, 8> histograms = {};
+	for (uint64_t key : keys) {
+		for (int byte = 0; byte < 8; ++byte) {
+			++histograms[byte][(key >> (byte * 8)) & 0xff];
+		}
+	}
+
+	uint64_t* sourceKeys = keys.data();
+	uint32_t* sourceValues = values.data();
+	uint64_t* targetKeys = keyScratch.data();
+	uint32_t* targetValues = valueScratch.data();
+	for (int byte = 0; byte < 8; ++byte) {
+		std::array<uint32_t, 256>& histogram = histograms[byte];
+		// 所有键的这个字节都相同，这一趟不会改变顺序
+		if (histogram[(sourceKeys[0] >> (byte * 8)) & 0xff] == count) {
+			continue;
+		}
+		// 直方图转为每个桶的起始位置
+		uint32_t offset = 0;
+		for (uint32_t& bucket : histogram) {
+			uint32_t size = bucket;
+			bucket = offset;
+			offset += size;
+		}
+		const int shift = byte * 8;
+		for (size_t i = 0; i < count; ++i) {
+			uint32_t position = histogram[(sourceKeys[i] >> shift) & 0xff]++;
+			targetKeys[position] = sourceKeys[i];
+			targetValues[position] = sourceValues[i];
+		}
+		std::swap(sourceKeys, targetKeys);
+		std::swap(sourceValues, targetValues);
+	}
+
+	// 奇数趟之后结果在临时空间里
+	if (sourceKeys != keys.data()) {
+		std::copy_n(sourceKeys, count, keys.data());
+		std::copy_n(sourceValues, count, values.data());
+	}
+}
+
+}
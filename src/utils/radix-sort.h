@@ -0,0 +1,19 @@
+#pragma once
+
+#include <cstdint>
+#include <span>
+
+namespace webgpu {
+
+/**
+ * @brief 64 位键的 LSD 基数排序（稳定），每趟按 8 位分桶，值跟随键移动
+ * 先用一次遍历统计全部 8 个字节的直方图，某个字节在所有键中都相同时跳过这一趟，
+ * 所以只有低位有差别的键（例如高位都是同一个通道和管线）只需要很少几趟
+ * @param keys 待排序的键，结果写回
+ * @param values 随键移动的值（通常是绘制命令的编号），与 keys 等长
+ * @param keyScratch 与 keys 等长的临时空间
+ * @param valueScratch 与 values 等长的临时空间
+ */
+void radixSort(std::span<uint64_t> keys, std::span<uint32_t> values, std::span<uint64_t> keyScratch, std::span<uint32_t> valueScratch);
+
+}
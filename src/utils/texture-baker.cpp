@@ -0,0 +1,312 @@
+#include "texture-baker.h"
+#include "deflate.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+
+namespace webgpu {
+
+namespace {
+
+constexpr char kMagic[4] = { 'W', 'T', 'E', 'X' };
+constexpr uint32_t kVersion = 1;
+constexpr uint32_t kHeaderSize = 24;
+
+// 烘焙的载荷，顺序即文件中的顺序
+constexpr TextureCodecFormat kBakedFormats[] = { TextureCodecFormat::BC7, TextureCodecFormat::ETC2 };
+
+// 编码后再解码的 PSNR 低于该值时视为编码器出错，不写出 .wtex
+constexpr float kMinimumPsnr = 25.0f;
+
+void write32(std::vector<uint8_t>& out, uint32_t value) {
+	for (int i = 0; i < 4; ++i) {
+		out.push_back(static_cast<uint8_t>(value >> (8 * i)));
+	}
+}
+
+void write64(std::vector<uint8_t>& out, uint64_t value) {
+	write32(out, static_cast<uint32_t>(value));
+	write32(out, static_cast<uint32_t>(value >> 32));
+}
+
+void patch64(std::vector<uint8_t>& out, size_t position, uint64_t value) {
+	for (int i = 0; i < 8; ++i) {
+		out[position + i] = static_cast<uint8_t>(value >> (8 * i));
+	}
+}
+
+struct Reader {
+	const std::vector<uint8_t>& bytes;
+	size_t position = 0;
+
+	uint32_t Read32() {
+		if (position + 4 > bytes.size()) {
+			throw std::runtime_error("wtex: truncated header");
+		}
+		uint32_t value = 0;
+		for (int i = 0; i < 4; ++i) {
+			value |= static_cast<uint32_t>(bytes[position++]) << (8 * i);
+		}
+		return value;
+	}
+
+	uint64_t Read64() {
+		uint64_t low = Read32();
+		return low | (static_cast<uint64_t>(Read32()) << 32);
+	}
+};
+
+size_t mipByteSize(const TextureMip& mip, TextureCodecFormat format) {
+	if (format == TextureCodecFormat::RGBA8) {
+		return static_cast<size_t>(mip.width) * mip.height * 4;
+	}
+	return static_cast<size_t>(blockCount(mip.width)) * blockCount(mip.height) * 16;
+}
+
+std::vector<uint8_t> readFile(const std::filesystem::path& path) {
+	std::ifstream file(path, std::ios::binary);
+	if (!file.is_open()) {
+		throw std::runtime_error("could not open " + path.string());
+	}
+	return std::vector<uint8_t>((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+}
+
+struct BakeReport {
+	uint32_t width = 0;
+	uint32_t height = 0;
+	uint32_t mipLevelCount = 0;
+	size_t rgbaSize = 0;
+	size_t blockSize = 0;
+	size_t fileSize = 0;
+	float psnr[2] = {};
+};
+
+// 出错（解码、校验或写文件失败）时抛出异常，尺寸不适合块压缩时返回 false
+bool bakeTextureWithReport(const std::filesystem::path& source, const std::filesystem::path& destination, BakeReport& report) {
+	Image image;
+	if (!decodeImage(source, image)) {
+		throw std::runtime_error("could not decode the source image");
+	}
+	if (image.width % 4 != 0 || image.height % 4 != 0) {
+		LOG("Skipping %s: %ux%u is not a multiple of the 4x4 block size\n", source.string().c_str(), image.width, image.height);
+		return false;
+	}
+
+	// CPU 上生成完整 mip 链（与运行时的 mipmap.wgsl 相同的线性空间平均）
+	std::vector<Image> chain;
+	chain.push_back(std::move(image));
+	while (chain.back().width > 1 || chain.back().height > 1) {
+		chain.push_back(downsampleImage(chain.back()));
+	}
+
+	report.width = chain[0].width;
+	report.height = chain[0].height;
+	report.mipLevelCount = static_cast<uint32_t>(chain.size());
+	report.rgbaSize = 0;
+	for (const Image& level : chain) {
+		report.rgbaSize += level.pixels.size();
+	}
+
+	std::vector<uint8_t> file(kMagic, kMagic + 4);
+	write32(file, kVersion);
+	write32(file, report.width);
+	write32(file, report.height);
+	write32(file, report.mipLevelCount);
+	write32(file, static_cast<uint32_t>(std::size(kBakedFormats)));
+
+	// 先写载荷表（offset 之后回填），再依次追加各级数据
+	std::vector<size_t> offsetPositions;
+	std::vector<std::vector<uint8_t>> storedMips;
+	for (size_t p = 0; p < std::size(kBakedFormats); ++p) {
+		TextureCodecFormat format = kBakedFormats[p];
+		write32(file, static_cast<uint32_t>(format));
+		for (size_t level = 0; level < chain.size(); ++level) {
+			TextureMip mip = compressImage(chain[level], format);
+			if (p == 0) {
+				report.blockSize += mip.data.size();
+			}
+			if (level == 0) {
+				report.psnr[p] = computePsnr(chain[0], decompressImage(mip, format));
+				if (report.psnr[p] < kMinimumPsnr) {
+					throw std::runtime_error(std::string(textureCodecFormatName(format)) + " PSNR " + std::to_string(report.psnr[p])
+						+ " dB is below " + std::to_string(kMinimumPsnr) + " dB");
+				}
+			}
+			std::vector<uint8_t> stored;
+			zlibDeflate(mip.data.data(), mip.data.size(), stored);
+			// 加载时同样经过 zlibInflate，写出前确认能原样还原
+			std::vector<uint8_t> restored;
+			if (!zlibInflate(stored.data(), stored.size(), mip.data.size(), restored) || restored != mip.data) {
+				throw std::runtime_error(std::string(textureCodecFormatName(format)) + " mip " + std::to_string(level) + " does not survive deflate/inflate");
+			}
+			offsetPositions.push_back(file.size());
+			write64(file, 0);
+			write32(file, static_cast<uint32_t>(stored.size()));
+			write32(file, static_cast<uint32_t>(mip.data.size()));
+			storedMips.push_back(std::move(stored));
+		}
+	}
+	for (size_t i = 0; i < storedMips.size(); ++i) {
+		patch64(file, offsetPositions[i], file.size());
+		file.insert(file.end(), storedMips[i].begin(), storedMips[i].end());
+	}
+
+	std::ofstream out(destination, std::ios::binary);
+	if (!out.is_open()) {
+		throw std::runtime_error("could not write " + destination.string());
+	}
+	out.write(reinterpret_cast<const char*>(file.data()), static_cast<std::streamsize>(file.size()));
+	if (!out) {
+		throw std::runtime_error("could not write " + destination.string());
+	}
+	report.fileSize = file.size();
+	return true;
+}
+
+void loadBakedTextureOrThrow(const std::filesystem::path& path, const std::vector<TextureCodecFormat>& preferred, BakedTexture& texture) {
+	std::vector<uint8_t> bytes = readFile(path);
+	if (bytes.size() < kHeaderSize || std::memcmp(bytes.data(), kMagic, 4) != 0) {
+		throw std::runtime_error("wtex: bad magic");
+	}
+	Reader reader{ bytes, 4 };
+	if (reader.Read32() != kVersion) {
+		throw std::runtime_error("wtex: unsupported version");
+	}
+	uint32_t width = reader.Read32();
+	uint32_t height = reader.Read32();
+	uint32_t mipLevelCount = reader.Read32();
+	uint32_t payloadCount = reader.Read32();
+	if (width == 0 || height == 0 || mipLevelCount == 0 || mipLevelCount > 32) {
+		throw std::runtime_error("wtex: invalid dimensions");
+	}
+
+	struct MipEntry {
+		uint64_t offset;
+		uint32_t storedSize;
+		uint32_t size;
+	};
+	std::vector<std::pair<TextureCodecFormat, std::vector<MipEntry>>> payloads;
+	for (uint32_t p = 0; p < payloadCount; ++p) {
+		TextureCodecFormat format = static_cast<TextureCodecFormat>(reader.Read32());
+		std::vector<MipEntry> entries(mipLevelCount);
+		for (MipEntry& entry : entries) {
+			entry.offset = reader.Read64();
+			entry.storedSize = reader.Read32();
+			entry.size = reader.Read32();
+			if (entry.offset + entry.storedSize > bytes.size()) {
+				throw std::runtime_error("wtex: payload out of range");
+			}
+		}
+		payloads.emplace_back(format, std::move(entries));
+	}
+
+	// 按设备偏好挑选载荷，都不支持时转码 BC7
+	auto chosen = payloads.end();
+	for (TextureCodecFormat format : preferred) {
+		chosen = std::find_if(payloads.begin(), payloads.end(), [format](const auto& payload) { return payload.first == format; });
+		if (chosen != payloads.end()) {
+			break;
+		}
+	}
+	bool transcode = chosen == payloads.end();
+	if (transcode) {
+		chosen = std::find_if(payloads.begin(), payloads.end(), [](const auto& payload) { return payload.first == TextureCodecFormat::BC7; });
+		if (chosen == payloads.end()) {
+			throw std::runtime_error("wtex: no usable payload");
+		}
+	}
+
+	texture.format = transcode ? TextureCodecFormat::RGBA8 : chosen->first;
+	texture.mips.clear();
+	for (uint32_t level = 0; level < mipLevelCount; ++level) {
+		const MipEntry& entry = chosen->second[level];
+		TextureMip mip;
+		mip.width = std::max(1u, width >> level);
+		mip.height = std::max(1u, height >> level);
+		if (entry.size != mipByteSize(mip, chosen->first) || !zlibInflate(bytes.data() + entry.offset, entry.storedSize, entry.size, mip.data)) {
+			throw std::runtime_error("wtex: corrupt mip data");
+		}
+		if (transcode) {
+			Image image = decompressImage(mip, chosen->first);
+			mip.data = std::move(image.pixels);
+		}
+		texture.mips.push_back(std::move(mip));
+	}
+}
+
+}
+
+const char* textureCodecFormatName(TextureCodecFormat format) {
+	switch (format) {
+	case TextureCodecFormat::RGBA8: return "RGBA8";
+	case TextureCodecFormat::BC7: return "BC7";
+	case TextureCodecFormat::ETC2: return "ETC2";
+	}
+	return "unknown";
+}
+
+std::filesystem::path bakedTexturePath(const std::filesystem::path& source) {
+	std::filesystem::path path = source;
+	return path.replace_extension(".wtex");
+}
+
+bool bakeTexture(const std::filesystem::path& source, const std::filesystem::path& destination) {
+	BakeReport report;
+	try {
+		return bakeTextureWithReport(source, destination, report);
+	} catch (const std::exception& e) {
+		LOG("Could not bake %s: %s\n", source.string().c_str(), e.what());
+		return false;
+	}
+}
+
+uint32_t bakeTextures(const std::filesystem::path& directory) {
+	if (!std::filesystem::is_directory(directory)) {
+		std::cerr << "Not a directory: " << directory.string() << '\n';
+		return 1;
+	}
+
+	std::vector<std::filesystem::path> imageFiles;
+	for (const auto& entry : std::filesystem::recursive_directory_iterator(directory)) {
+		std::string extension = entry.path().extension().string();
+		std::transform(extension.begin(), extension.end(), extension.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+		if (entry.is_regular_file() && (extension == ".png" || extension == ".jpg" || extension == ".jpeg")) {
+			imageFiles.push_back(entry.path());
+		}
+	}
+	std::sort(imageFiles.begin(), imageFiles.end());
+
+	// RGBA8 / block 两列为整条 mip 链在 GPU 上占用的显存，wtex 为磁盘大小（两份载荷）
+	printf("%-40s %11s %5s %10s %10s %10s %9s %9s\n", "texture", "size", "mips", "RGBA8 KB", "block KB", "wtex KB", "BC7 dB", "ETC2 dB");
+	uint32_t failureCount = 0;
+	for (const auto& path : imageFiles) {
+		BakeReport report;
+		try {
+			if (!bakeTextureWithReport(path, bakedTexturePath(path), report)) {
+				continue;
+			}
+		} catch (const std::exception& e) {
+			printf("%-40s FAILED: %s\n", std::filesystem::relative(path, directory).string().c_str(), e.what());
+			++failureCount;
+			continue;
+		}
+		std::string size = std::to_string(report.width) + "x" + std::to_string(report.height);
+		printf("%-40s %11s %5u %10.1f %10.1f %10.1f %9.2f %9.2f\n",
+			std::filesystem::relative(path, directory).string().c_str(), size.c_str(), report.mipLevelCount,
+			report.rgbaSize / 1024.0, report.blockSize / 1024.0, report.fileSize / 1024.0, report.psnr[0], report.psnr[1]);
+	}
+	return failureCount;
+}
+
+bool loadBakedTexture(const std::filesystem::path& path, const std::vector<TextureCodecFormat>& preferred, BakedTexture& texture) {
+	try {
+		loadBakedTextureOrThrow(path, preferred, texture);
+		return true;
+	} catch (const std::exception& e) {
+		LOG("Could not load baked texture %s: %s\n", path.string().c_str(), e.what());
+		return false;
+	}
+}
+
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include "texture-codec.h"
+
+namespace webgpu {
+
+/**
+ * 离线烘焙的纹理容器（.wtex），与源图放在同一目录、同名
+ * 布局（小端）：
+ *   "WTEX" | version | width | height | mipLevelCount | payloadCount
+ *   payloadCount 个载荷表：format，随后每级 mip 一项 { uint64 offset, uint32 storedSize, uint32 size }
+ *   各级 mip 数据，每级单独用 deflate 再压缩一次（块压缩数据仍有不少冗余）
+ * 同一个文件同时带 BC7 和 ETC2 两份载荷，加载时按设备支持的特性挑选。
+ * 没有 ASTC 载荷：只支持 ASTC 的设备（多数移动 GPU）和不支持块压缩的设备一样，加载时转码为 RGBA8。
+ */
+struct BakedTexture {
+	TextureCodecFormat format = TextureCodecFormat::RGBA8;
+	std::vector<TextureMip> mips;
+};
+
+/**
+ * @brief 源图对应的 .wtex 路径
+ */
+std::filesystem::path bakedTexturePath(const std::filesystem::path& source);
+
+/**
+ * @brief 解码源图，生成完整 mip 链并编码为 BC7 + ETC2 写入 .wtex
+ * 块压缩纹理的尺寸必须是 4 的倍数，否则不烘焙（运行时仍加载源图）
+ * 写出前校验：每种格式第 0 级编码再解码的 PSNR 不低于阈值，每级 mip 解压后与压缩前逐字节相同
+ * @return 是否写出了 .wtex
+ */
+bool bakeTexture(const std::filesystem::path& source, const std::filesystem::path& destination);
+
+/**
+ * @brief 烘焙目录下所有 png/jpg，输出大小和 PSNR 对比
+ * @return 烘焙失败（解码失败或未通过校验）的图像数，目录不存在时为 1
+ */
+uint32_t bakeTextures(const std::filesystem::path& directory);
+
+/**
+ * @brief 读取 .wtex 并选出第一个可用的格式
+ * 若 preferred 中没有文件里的格式，则在 CPU 上把 BC7 载荷转码为 RGBA8
+ * @param preferred 设备支持的块压缩格式，按优先级排列
+ * @return 是否读取成功
+ */
+bool loadBakedTexture(const std::filesystem::path& path, const std::vector<TextureCodecFormat>& preferred, BakedTexture& texture);
+
+/**
+ * @brief 格式名，用于日志
+ */
+const char* textureCodecFormatName(TextureCodecFormat format);
+
+}
@@ -0,0 +1,656 @@
+#include "texture-codec.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace webgpu {
+
+namespace {
+
+// ---------------------------------------------------------------------------
+// BC7 mode 6
+// ---------------------------------------------------------------------------
+
+constexpr int kBc7Weights4[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+int bc7Interpolate(int e0, int e1, int weight) {
+	return ((64 - weight) * e0 + weight * e1 + 32) >> 6;
+}
+
+/**
+ * 128 位块的位写入/读取，低位在前
+ */
+struct Bc7Bits {
+	uint8_t* bytes;
+	uint32_t position = 0;
+
+	void Write(uint32_t value, uint32_t count) {
+		for (uint32_t i = 0; i < count; ++i, ++position) {
+			if ((value >> i) & 1) {
+				bytes[position >> 3] |= static_cast<uint8_t>(1u << (position & 7));
+			}
+		}
+	}
+
+	uint32_t Read(uint32_t count) {
+		uint32_t value = 0;
+		for (uint32_t i = 0; i < count; ++i, ++position) {
+			value |= static_cast<uint32_t>((bytes[position >> 3] >> (position & 7)) & 1) << i;
+		}
+		return value;
+	}
+};
+
+struct Bc7Candidate {
+	// 7 位端点 + p-bit
+	std::array<std::array<int, 4>, 2> color7 = {};
+	std::array<int, 2> pbit = {};
+	std::array<uint8_t, 16> indices = {};
+	uint64_t error = std::numeric_limits<uint64_t>::max();
+};
+
+std::array<int, 4> bc7Endpoint(const Bc7Candidate& c, int e) {
+	std::array<int, 4> value;
+	for (int ch = 0; ch < 4; ++ch) {
+		value[ch] = (c.color7[e][ch] << 1) | c.pbit[e];
+	}
+	return value;
+}
+
+/**
+ * @brief 量化一对浮点端点（尝试四种 p-bit 组合）并选择每个像素的最优索引
+ */
+Bc7Candidate bc7Quantize(const uint8_t rgba[64], const float e0[4], const float e1[4]) {
+	Bc7Candidate best;
+	for (int p = 0; p < 4; ++p) {
+		Bc7Candidate candidate;
+		candidate.pbit = { p & 1, p >> 1 };
+		const float* endpoints[2] = { e0, e1 };
+		for (int e = 0; e < 2; ++e) {
+			for (int ch = 0; ch < 4; ++ch) {
+				float value = (std::clamp(endpoints[e][ch], 0.0f, 255.0f) - candidate.pbit[e]) * 0.5f;
+				candidate.color7[e][ch] = std::clamp(static_cast<int>(std::lround(value)), 0, 127);
+			}
+		}
+		std::array<int, 4> q0 = bc7Endpoint(candidate, 0);
+		std::array<int, 4> q1 = bc7Endpoint(candidate, 1);
+		int palette[16][4];
+		for (int i = 0; i < 16; ++i) {
+			for (int ch = 0; ch < 4; ++ch) {
+				palette[i][ch] = bc7Interpolate(q0[ch], q1[ch], kBc7Weights4[i]);
+			}
+		}
+		candidate.error = 0;
+		for (int px = 0; px < 16; ++px) {
+			uint32_t bestError = std::numeric_limits<uint32_t>::max();
+			for (int i = 0; i < 16; ++i) {
+				uint32_t error = 0;
+				for (int ch = 0; ch < 4; ++ch) {
+					int d = palette[i][ch] - rgba[px * 4 + ch];
+					error += static_cast<uint32_t>(d * d);
+				}
+				if (error < bestError) {
+					bestError = error;
+					candidate.indices[px] = static_cast<uint8_t>(i);
+				}
+			}
+			candidate.error += bestError;
+		}
+		if (candidate.error < best.error) {
+			best = candidate;
+		}
+	}
+	return best;
+}
+
+// ---------------------------------------------------------------------------
+// ETC1 / ETC2 / EAC
+// ---------------------------------------------------------------------------
+
+constexpr int kEtcModifiers[8][2] = { { 2, 8 }, { 5, 17 }, { 9, 29 }, { 13, 42 }, { 18, 60 }, { 24, 80 }, { 33, 106 }, { 47, 183 } };
+
+// 索引 (msb << 1 | lsb) -> 修正量
+int etcModifier(int table, int index) {
+	int magnitude = kEtcModifiers[table][index & 1];
+	return (index & 2) ? -magnitude : magnitude;
+}
+
+constexpr int kEacModifiers[16][8] = {
+	{ -3, -6, -9, -15, 2, 5, 8, 14 }, { -3, -7, -10, -13, 2, 6, 9, 12 }, { -2, -5, -8, -13, 1, 4, 7, 12 }, { -2, -4, -6, -13, 1, 3, 5, 12 },
+	{ -3, -6, -8, -12, 2, 5, 7, 11 }, { -3, -7, -9, -11, 2, 6, 8, 10 }, { -4, -7, -8, -11, 3, 6, 7, 10 }, { -3, -5, -8, -11, 2, 4, 7, 10 },
+	{ -2, -6, -8, -10, 1, 5, 7, 9 }, { -2, -5, -8, -10, 1, 4, 7, 9 }, { -2, -4, -8, -10, 1, 3, 7, 9 }, { -2, -5, -7, -10, 1, 4, 6, 9 },
+	{ -3, -4, -7, -10, 2, 3, 6, 9 }, { -1, -2, -3, -10, 0, 1, 2, 9 }, { -4, -6, -8, -9, 3, 5, 7, 8 }, { -3, -5, -7, -9, 2, 4, 6, 8 }
+};
+
+int clamp255(int value) {
+	return std::clamp(value, 0, 255);
+}
+
+// ETC 的像素按列优先编号：p = x * 4 + y
+int etcPixelIndex(int x, int y) {
+	return x * 4 + y;
+}
+
+bool etcInSubblock(int x, int y, bool flip, int subblock) {
+	return (flip ? y : x) / 2 == subblock;
+}
+
+struct EtcSubblockFit {
+	int table = 0;
+	uint32_t error = std::numeric_limits<uint32_t>::max();
+	std::array<uint8_t, 16> indices = {};
+};
+
+/**
+ * @brief 给定基色，选择误差最小的修正表和每个像素的索引
+ */
+EtcSubblockFit etcFitSubblock(const uint8_t rgba[64], bool flip, int subblock, const int base[3]) {
+	EtcSubblockFit best;
+	for (int table = 0; table < 8; ++table) {
+		EtcSubblockFit fit;
+		fit.table = table;
+		fit.error = 0;
+		for (int y = 0; y < 4; ++y) {
+			for (int x = 0; x < 4; ++x) {
+				if (!etcInSubblock(x, y, flip, subblock)) {
+					continue;
+				}
+				const uint8_t* px = rgba + (y * 4 + x) * 4;
+				uint32_t bestError = std::numeric_limits<uint32_t>::max();
+				for (int index = 0; index < 4; ++index) {
+					int modifier = etcModifier(table, index);
+					uint32_t error = 0;
+					for (int ch = 0; ch < 3; ++ch) {
+						int d = clamp255(base[ch] + modifier) - px[ch];
+						error += static_cast<uint32_t>(d * d);
+					}
+					if (error < bestError) {
+						bestError = error;
+						fit.indices[etcPixelIndex(x, y)] = static_cast<uint8_t>(index);
+					}
+				}
+				fit.error += bestError;
+				if (fit.error >= best.error) {
+					break;
+				}
+			}
+			if (fit.error >= best.error) {
+				break;
+			}
+		}
+		if (fit.error < best.error) {
+			best = fit;
+		}
+	}
+	return best;
+}
+
+int expand4(int c) { return c * 17; }
+int expand5(int c) { return (c << 3) | (c >> 2); }
+
+/**
+ * @brief 对一个子块的平均色在每个通道取上下两个量化值，返回 8 种组合中误差最小的
+ */
+struct EtcBaseChoice {
+	std::array<int, 3> quantized = {};
+	EtcSubblockFit fit;
+};
+
+EtcBaseChoice etcChooseBase(const uint8_t rgba[64], bool flip, int subblock, int bits, const std::array<int, 3>* reference) {
+	float average[3] = {};
+	for (int y = 0; y < 4; ++y) {
+		for (int x = 0; x < 4; ++x) {
+			if (etcInSubblock(x, y, flip, subblock)) {
+				for (int ch = 0; ch < 3; ++ch) {
+					average[ch] += rgba[(y * 4 + x) * 4 + ch];
+				}
+			}
+		}
+	}
+	int maxValue = (1 << bits) - 1;
+	EtcBaseChoice best;
+	best.fit.error = std::numeric_limits<uint32_t>::max();
+	for (int combination = 0; combination < 8; ++combination) {
+		std::array<int, 3> quantized;
+		for (int ch = 0; ch < 3; ++ch) {
+			float value = average[ch] / 8.0f * maxValue / 255.0f;
+			quantized[ch] = std::clamp(static_cast<int>((combination >> ch) & 1 ? std::ceil(value) : std::floor(value)), 0, maxValue);
+			// differential 模式下第二个子块只能偏离第一个 [-4, 3]
+			if (reference) {
+				quantized[ch] = std::clamp(quantized[ch], (*reference)[ch] - 4, (*reference)[ch] + 3);
+			}
+		}
+		int base[3];
+		for (int ch = 0; ch < 3; ++ch) {
+			base[ch] = bits == 4 ? expand4(quantized[ch]) : expand5(quantized[ch]);
+		}
+		EtcSubblockFit fit = etcFitSubblock(rgba, flip, subblock, base);
+		if (fit.error < best.fit.error) {
+			best.quantized = quantized;
+			best.fit = fit;
+		}
+	}
+	return best;
+}
+
+void writeBigEndian64(uint64_t value, uint8_t* out) {
+	for (int i = 0; i < 8; ++i) {
+		out[i] = static_cast<uint8_t>(value >> (56 - 8 * i));
+	}
+}
+
+uint64_t readBigEndian64(const uint8_t* in) {
+	uint64_t value = 0;
+	for (int i = 0; i < 8; ++i) {
+		value = (value << 8) | in[i];
+	}
+	return value;
+}
+
+void encodeEtc1RgbBlock(const uint8_t rgba[64], uint8_t out[8]) {
+	uint64_t bestBits = 0;
+	uint32_t bestError = std::numeric_limits<uint32_t>::max();
+	for (int flip = 0; flip < 2; ++flip) {
+		// individual：两个子块各自 4 位基色
+		{
+			EtcBaseChoice first = etcChooseBase(rgba, flip, 0, 4, nullptr);
+			EtcBaseChoice second = etcChooseBase(rgba, flip, 1, 4, nullptr);
+			uint32_t error = first.fit.error + second.fit.error;
+			if (error < bestError) {
+				bestError = error;
+				uint64_t bits = 0;
+				for (int ch = 0; ch < 3; ++ch) {
+					bits |= static_cast<uint64_t>(first.quantized[ch]) << (60 - ch * 8);
+					bits |= static_cast<uint64_t>(second.quantized[ch]) << (56 - ch * 8);
+				}
+				bits |= static_cast<uint64_t>(first.fit.table) << 37;
+				bits |= static_cast<uint64_t>(second.fit.table) << 34;
+				bits |= static_cast<uint64_t>(flip) << 32;
+				for (int p = 0; p < 16; ++p) {
+					int x = p / 4;
+					int y = p % 4;
+					int index = etcInSubblock(x, y, flip, 0) ? first.fit.indices[p] : second.fit.indices[p];
+					bits |= static_cast<uint64_t>(index >> 1) << (16 + p);
+					bits |= static_cast<uint64_t>(index & 1) << p;
+				}
+				bestBits = bits;
+			}
+		}
+		// differential：5 位基色 + 3 位有符号差值
+		{
+			EtcBaseChoice first = etcChooseBase(rgba, flip, 0, 5, nullptr);
+			EtcBaseChoice second = etcChooseBase(rgba, flip, 1, 5, &first.quantized);
+			uint32_t error = first.fit.error + second.fit.error;
+			if (error < bestError) {
+				bestError = error;
+				uint64_t bits = 0;
+				for (int ch = 0; ch < 3; ++ch) {
+					int delta = second.quantized[ch] - first.quantized[ch];
+					bits |= static_cast<uint64_t>(first.quantized[ch]) << (59 - ch * 8);
+					bits |= static_cast<uint64_t>(delta & 7) << (56 - ch * 8);
+				}
+				bits |= static_cast<uint64_t>(first.fit.table) << 37;
+				bits |= static_cast<uint64_t>(second.fit.table) << 34;
+				bits |= 1ull << 33;
+				bits |= static_cast<uint64_t>(flip) << 32;
+				for (int p = 0; p < 16; ++p) {
+					int x = p / 4;
+					int y = p % 4;
+					int index = etcInSubblock(x, y, flip, 0) ? first.fit.indices[p] : second.fit.indices[p];
+					bits |= static_cast<uint64_t>(index >> 1) << (16 + p);
+					bits |= static_cast<uint64_t>(index & 1) << p;
+				}
+				bestBits = bits;
+			}
+		}
+	}
+	writeBigEndian64(bestBits, out);
+}
+
+void encodeEacAlphaBlock(const uint8_t rgba[64], uint8_t out[8]) {
+	int minAlpha = 255;
+	int maxAlpha = 0;
+	for (int px = 0; px < 16; ++px) {
+		minAlpha = std::min<int>(minAlpha, rgba[px * 4 + 3]);
+		maxAlpha = std::max<int>(maxAlpha, rgba[px * 4 + 3]);
+	}
+
+	uint64_t bestBits = 0;
+	if (minAlpha == maxAlpha) {
+		// 表 13 含 0 修正量（索引 4），可以精确表示常量 alpha
+		bestBits = static_cast<uint64_t>(minAlpha) << 56 | 1ull << 52 | 13ull << 48;
+		for (int p = 0; p < 16; ++p) {
+			bestBits |= 4ull << (45 - 3 * p);
+		}
+		writeBigEndian64(bestBits, out);
+		return;
+	}
+
+	uint32_t bestError = std::numeric_limits<uint32_t>::max();
+	for (int table = 0; table < 16; ++table) {
+		int lowModifier = kEacModifiers[table][3];
+		int highModifier = kEacModifiers[table][7];
+		for (int multiplier = 1; multiplier < 16; ++multiplier) {
+			int base = clamp255(static_cast<int>(std::lround((minAlpha + maxAlpha) * 0.5f - (lowModifier + highModifier) * multiplier * 0.5f)));
+			uint32_t error = 0;
+			uint64_t bits = static_cast<uint64_t>(base) << 56 | static_cast<uint64_t>(multiplier) << 52 | static_cast<uint64_t>(table) << 48;
+			for (int p = 0; p < 16 && error < bestError; ++p) {
+				int x = p / 4;
+				int y = p % 4;
+				int alpha = rgba[(y * 4 + x) * 4 + 3];
+				uint32_t pixelError = std::numeric_limits<uint32_t>::max();
+				int pixelIndex = 0;
+				for (int index = 0; index < 8; ++index) {
+					int d = clamp255(base + kEacModifiers[table][index] * multiplier) - alpha;
+					if (static_cast<uint32_t>(d * d) < pixelError) {
+						pixelError = static_cast<uint32_t>(d * d);
+						pixelIndex = index;
+					}
+				}
+				error += pixelError;
+				bits |= static_cast<uint64_t>(pixelIndex) << (45 - 3 * p);
+			}
+			if (error < bestError) {
+				bestError = error;
+				bestBits = bits;
+			}
+		}
+	}
+	writeBigEndian64(bestBits, out);
+}
+
+void decodeEtc1RgbBlock(const uint8_t in[8], uint8_t rgba[64]) {
+	uint64_t bits = readBigEndian64(in);
+	bool differential = (bits >> 33) & 1;
+	bool flip = (bits >> 32) & 1;
+	int bases[2][3];
+	for (int ch = 0; ch < 3; ++ch) {
+		if (differential) {
+			int c = static_cast<int>((bits >> (59 - ch * 8)) & 31);
+			int delta = static_cast<int>((bits >> (56 - ch * 8)) & 7);
+			delta = delta >= 4 ? delta - 8 : delta;
+			// 溢出表示 ETC2 的 T/H/planar 模式，编码器不会产生
+			int c2 = std::clamp(c + delta, 0, 31);
+			bases[0][ch] = expand5(c);
+			bases[1][ch] = expand5(c2);
+		} else {
+			bases[0][ch] = expand4(static_cast<int>((bits >> (60 - ch * 8)) & 15));
+			bases[1][ch] = expand4(static_cast<int>((bits >> (56 - ch * 8)) & 15));
+		}
+	}
+	int tables[2] = { static_cast<int>((bits >> 37) & 7), static_cast<int>((bits >> 34) & 7) };
+	for (int p = 0; p < 16; ++p) {
+		int x = p / 4;
+		int y = p % 4;
+		int subblock = etcInSubblock(x, y, flip, 0) ? 0 : 1;
+		int index = static_cast<int>(((bits >> (16 + p)) & 1) << 1 | ((bits >> p) & 1));
+		int modifier = etcModifier(tables[subblock], index);
+		for (int ch = 0; ch < 3; ++ch) {
+			rgba[(y * 4 + x) * 4 + ch] = static_cast<uint8_t>(clamp255(bases[subblock][ch] + modifier));
+		}
+	}
+}
+
+void decodeEacAlphaBlock(const uint8_t in[8], uint8_t rgba[64]) {
+	uint64_t bits = readBigEndian64(in);
+	int base = static_cast<int>(bits >> 56);
+	int multiplier = static_cast<int>((bits >> 52) & 15);
+	int table = static_cast<int>((bits >> 48) & 15);
+	for (int p = 0; p < 16; ++p) {
+		int x = p / 4;
+		int y = p % 4;
+		int index = static_cast<int>((bits >> (45 - 3 * p)) & 7);
+		rgba[(y * 4 + x) * 4 + 3] = static_cast<uint8_t>(clamp255(base + kEacModifiers[table][index] * multiplier));
+	}
+}
+
+float srgbToLinear(uint8_t value) {
+	return std::pow(value / 255.0f, 2.2f);
+}
+
+uint8_t linearToSrgb(float value) {
+	return static_cast<uint8_t>(std::clamp(std::lround(std::pow(std::max(value, 0.0f), 1.0f / 2.2f) * 255.0f), 0L, 255L));
+}
+
+}
+
+void encodeBc7Block(const uint8_t rgba[64], uint8_t block[16]) {
+	// 主成分方向（协方差矩阵幂迭代）
+	float mean[4] = {};
+	for (int px = 0; px < 16; ++px) {
+		for (int ch = 0; ch < 4; ++ch) {
+			mean[ch] += rgba[px * 4 + ch] / 16.0f;
+		}
+	}
+	float covariance[4][4] = {};
+	for (int px = 0; px < 16; ++px) {
+		float d[4];
+		for (int ch = 0; ch < 4; ++ch) {
+			d[ch] = rgba[px * 4 + ch] - mean[ch];
+		}
+		for (int i = 0; i < 4; ++i) {
+			for (int j = 0; j < 4; ++j) {
+				covariance[i][j] += d[i] * d[j];
+			}
+		}
+	}
+	float axis[4] = { 1.0f, 1.0f, 1.0f, 1.0f };
+	for (int iteration = 0; iteration < 8; ++iteration) {
+		float next[4] = {};
+		for (int i = 0; i < 4; ++i) {
+			for (int j = 0; j < 4; ++j) {
+				next[i] += covariance[i][j] * axis[j];
+			}
+		}
+		float length = std::sqrt(next[0] * next[0] + next[1] * next[1] + next[2] * next[2] + next[3] * next[3]);
+		if (length < 1e-6f) {
+			break;
+		}
+		for (int i = 0; i < 4; ++i) {
+			axis[i] = next[i] / length;
+		}
+	}
+
+	float minT = std::numeric_limits<float>::max();
+	float maxT = std::numeric_limits<float>::lowest();
+	for (int px = 0; px < 16; ++px) {
+		float t = 0.0f;
+		for (int ch = 0; ch < 4; ++ch) {
+			t += (rgba[px * 4 + ch] - mean[ch]) * axis[ch];
+		}
+		minT = std::min(minT, t);
+		maxT = std::max(maxT, t);
+	}
+	float e0[4];
+	float e1[4];
+	for (int ch = 0; ch < 4; ++ch) {
+		e0[ch] = mean[ch] + axis[ch] * minT;
+		e1[ch] = mean[ch] + axis[ch] * maxT;
+	}
+	Bc7Candidate best = bc7Quantize(rgba, e0, e1);
+
+	// 固定索引，最小二乘求端点：min Σ |(1 - w) e0 + w e1 - x|²
+	for (int iteration = 0; iteration < 2 && best.error > 0; ++iteration) {
+		float a00 = 0.0f, a01 = 0.0f, a11 = 0.0f;
+		float b0[4] = {};
+		float b1[4] = {};
+		for (int px = 0; px < 16; ++px) {
+			float w = kBc7Weights4[best.indices[px]] / 64.0f;
+			a00 += (1.0f - w) * (1.0f - w);
+			a01 += (1.0f - w) * w;
+			a11 += w * w;
+			for (int ch = 0; ch < 4; ++ch) {
+				b0[ch] += (1.0f - w) * rgba[px * 4 + ch];
+				b1[ch] += w * rgba[px * 4 + ch];
+			}
+		}
+		float determinant = a00 * a11 - a01 * a01;
+		if (std::abs(determinant) < 1e-6f) {
+			break;
+		}
+		for (int ch = 0; ch < 4; ++ch) {
+			e0[ch] = (a11 * b0[ch] - a01 * b1[ch]) / determinant;
+			e1[ch] = (a00 * b1[ch] - a01 * b0[ch]) / determinant;
+		}
+		Bc7Candidate refined = bc7Quantize(rgba, e0, e1);
+		if (refined.error >= best.error) {
+			break;
+		}
+		best = refined;
+	}
+
+	// 第一个像素的索引最高位隐含为 0，否则交换端点
+	if (best.indices[0] >= 8) {
+		std::swap(best.color7[0], best.color7[1]);
+		std::swap(best.pbit[0], best.pbit[1]);
+		for (uint8_t& index : best.indices) {
+			index = static_cast<uint8_t>(15 - index);
+		}
+	}
+
+	std::fill(block, block + 16, uint8_t(0));
+	Bc7Bits writer{ block };
+	writer.Write(1u << 6, 7);
+	for (int ch = 0; ch < 4; ++ch) {
+		writer.Write(static_cast<uint32_t>(best.color7[0][ch]), 7);
+		writer.Write(static_cast<uint32_t>(best.color7[1][ch]), 7);
+	}
+	writer.Write(static_cast<uint32_t>(best.pbit[0]), 1);
+	writer.Write(static_cast<uint32_t>(best.pbit[1]), 1);
+	writer.Write(best.indices[0], 3);
+	for (int px = 1; px < 16; ++px) {
+		writer.Write(best.indices[px], 4);
+	}
+}
+
+void decodeBc7Block(const uint8_t block[16], uint8_t rgba[64]) {
+	uint8_t copy[16];
+	std::copy(block, block + 16, copy);
+	Bc7Bits reader{ copy };
+	if (reader.Read(7) != (1u << 6)) {
+		std::fill(rgba, rgba + 64, uint8_t(0));
+		return;
+	}
+	int color7[2][4];
+	for (int ch = 0; ch < 4; ++ch) {
+		color7[0][ch] = static_cast<int>(reader.Read(7));
+		color7[1][ch] = static_cast<int>(reader.Read(7));
+	}
+	int p0 = static_cast<int>(reader.Read(1));
+	int p1 = static_cast<int>(reader.Read(1));
+	for (int px = 0; px < 16; ++px) {
+		int index = static_cast<int>(reader.Read(px == 0 ? 3 : 4));
+		for (int ch = 0; ch < 4; ++ch) {
+			rgba[px * 4 + ch] = static_cast<uint8_t>(bc7Interpolate((color7[0][ch] << 1) | p0, (color7[1][ch] << 1) | p1, kBc7Weights4[index]));
+		}
+	}
+}
+
+void encodeEtc2Block(const uint8_t rgba[64], uint8_t block[16]) {
+	encodeEacAlphaBlock(rgba, block);
+	encodeEtc1RgbBlock(rgba, block + 8);
+}
+
+void decodeEtc2Block(const uint8_t block[16], uint8_t rgba[64]) {
+	decodeEtc1RgbBlock(block + 8, rgba);
+	decodeEacAlphaBlock(block, rgba);
+}
+
+TextureMip compressImage(const Image& image, TextureCodecFormat format) {
+	TextureMip mip;
+	mip.width = image.width;
+	mip.height = image.height;
+	uint32_t blocksX = blockCount(image.width);
+	uint32_t blocksY = blockCount(image.height);
+	mip.data.resize(static_cast<size_t>(blocksX) * blocksY * 16);
+	uint8_t pixels[64];
+	for (uint32_t by = 0; by < blocksY; ++by) {
+		for (uint32_t bx = 0; bx < blocksX; ++bx) {
+			for (uint32_t y = 0; y < 4; ++y) {
+				for (uint32_t x = 0; x < 4; ++x) {
+					uint32_t sx = std::min(bx * 4 + x, image.width - 1);
+					uint32_t sy = std::min(by * 4 + y, image.height - 1);
+					std::copy_n(image.pixels.data() + (static_cast<size_t>(sy) * image.width + sx) * 4, 4, pixels + (y * 4 + x) * 4);
+				}
+			}
+			uint8_t* block = mip.data.data() + (static_cast<size_t>(by) * blocksX + bx) * 16;
+			if (format == TextureCodecFormat::BC7) {
+				encodeBc7Block(pixels, block);
+			} else {
+				encodeEtc2Block(pixels, block);
+			}
+		}
+	}
+	return mip;
+}
+
+Image decompressImage(const TextureMip& mip, TextureCodecFormat format) {
+	Image image;
+	image.width = mip.width;
+	image.height = mip.height;
+	image.pixels.resize(static_cast<size_t>(mip.width) * mip.height * 4);
+	uint32_t blocksX = blockCount(mip.width);
+	uint32_t blocksY = blockCount(mip.height);
+	uint8_t pixels[64];
+	for (uint32_t by = 0; by < blocksY; ++by) {
+		for (uint32_t bx = 0; bx < blocksX; ++bx) {
+			const uint8_t* block = mip.data.data() + (static_cast<size_t>(by) * blocksX + bx) * 16;
+			if (format == TextureCodecFormat::BC7) {
+				decodeBc7Block(block, pixels);
+			} else {
+				decodeEtc2Block(block, pixels);
+			}
+			for (uint32_t y = 0; y < 4 && by * 4 + y < mip.height; ++y) {
+				for (uint32_t x = 0; x < 4 && bx * 4 + x < mip.width; ++x) {
+					std::copy_n(pixels + (y * 4 + x) * 4, 4, image.pixels.data() + ((static_cast<size_t>(by) * 4 + y) * mip.width + bx * 4 + x) * 4);
+				}
+			}
+		}
+	}
+	return image;
+}
+
+Image downsampleImage(const Image& image) {
+	Image next;
+	next.width = std::max(1u, image.width / 2);
+	next.height = std::max(1u, image.height / 2);
+	next.pixels.resize(static_cast<size_t>(next.width) * next.height * 4);
+	for (uint32_t y = 0; y < next.height; ++y) {
+		for (uint32_t x = 0; x < next.width; ++x) {
+			float sum[4] = {};
+			for (uint32_t dy = 0; dy < 2; ++dy) {
+				for (uint32_t dx = 0; dx < 2; ++dx) {
+					uint32_t sx = std::min(x * 2 + dx, image.width - 1);
+					uint32_t sy = std::min(y * 2 + dy, image.height - 1);
+					const uint8_t* px = image.pixels.data() + (static_cast<size_t>(sy) * image.width + sx) * 4;
+					for (int ch = 0; ch < 3; ++ch) {
+						sum[ch] += srgbToLinear(px[ch]);
+					}
+					sum[3] += px[3];
+				}
+			}
+			uint8_t* dst = next.pixels.data() + (static_cast<size_t>(y) * next.width + x) * 4;
+			for (int ch = 0; ch < 3; ++ch) {
+				dst[ch] = linearToSrgb(sum[ch] * 0.25f);
+			}
+			dst[3] = static_cast<uint8_t>(std::lround(sum[3] * 0.25f));
+		}
+	}
+	return next;
+}
+
+float computePsnr(const Image& a, const Image& b) {
+	double squaredError = 0.0;
+	size_t count = std::min(a.pixels.size(), b.pixels.size()) / 4;
+	for (size_t i = 0; i < count; ++i) {
+		for (int ch = 0; ch < 3; ++ch) {
+			double d = static_cast<double>(a.pixels[i * 4 + ch]) - b.pixels[i * 4 + ch];
+			squaredError += d * d;
+		}
+	}
+	double mse = squaredError / std::max<size_t>(1, count * 3);
+	return mse > 0.0 ? static_cast<float>(10.0 * std::log10(255.0 * 255.0 / mse)) : 99.0f;
+}
+
+}
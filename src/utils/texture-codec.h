@@ -0,0 +1,76 @@
+#pragma once
+
+#include "image-decoder.h"
+
+namespace webgpu {
+
+/**
+ * 纹理的存储格式
+ * BC7 与 ETC2 都是 4x4 块、每块 16 字节（1 字节/像素）
+ */
+enum class TextureCodecFormat : uint32_t {
+	RGBA8 = 0,
+	BC7 = 1,
+	ETC2 = 2,
+};
+
+/**
+ * 一级 mip 的数据
+ * width/height 为实际像素尺寸；RGBA8 时 data 为逐行像素，块压缩时为按行优先排列的 4x4 块
+ */
+struct TextureMip {
+	uint32_t width = 0;
+	uint32_t height = 0;
+	std::vector<uint8_t> data;
+};
+
+/**
+ * @brief 每行块数/列块数
+ */
+inline uint32_t blockCount(uint32_t pixels) { return (pixels + 3) / 4; }
+
+/**
+ * @brief BC7 编码，只使用 mode 6（单分区 RGBA 7777 + p-bit，4 位索引）
+ * 端点取主成分方向上的投影极值，再用最小二乘细化一次
+ * @param rgba 4x4 像素，行优先
+ * @param block 输出 16 字节
+ */
+void encodeBc7Block(const uint8_t rgba[64], uint8_t block[16]);
+
+/**
+ * @brief BC7 解码（只支持 mode 6，用于回退和误差统计）
+ */
+void decodeBc7Block(const uint8_t block[16], uint8_t rgba[64]);
+
+/**
+ * @brief ETC2 RGBA8 编码：EAC alpha 块 + ETC1 兼容的 RGB 块（individual/differential，两种翻转）
+ * 不使用 ETC2 的 T/H/planar 模式，differential 模式保证不溢出
+ */
+void encodeEtc2Block(const uint8_t rgba[64], uint8_t block[16]);
+
+/**
+ * @brief ETC2 RGBA8 解码（只支持编码器产生的模式）
+ */
+void decodeEtc2Block(const uint8_t block[16], uint8_t rgba[64]);
+
+/**
+ * @brief 块压缩整幅图像，边缘不足 4 像素的块重复最后一行/列
+ */
+TextureMip compressImage(const Image& image, TextureCodecFormat format);
+
+/**
+ * @brief 解压整幅图像
+ */
+Image decompressImage(const TextureMip& mip, TextureCodecFormat format);
+
+/**
+ * @brief 在 CPU 上生成下一级 mip（线性空间 2x2 平均，与 mipmap.wgsl 一致）
+ */
+Image downsampleImage(const Image& image);
+
+/**
+ * @brief RGB 通道的峰值信噪比（dB）
+ */
+float computePsnr(const Image& a, const Image& b);
+
+}
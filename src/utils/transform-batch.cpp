@@ -0,0 +1,443 @@
+#include "transform-batch.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <random>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#  include <immintrin.h>
+#  define TRANSFORM_BATCH_USE_SSE2
+// AVX2 不要求编译选项：GCC/Clang 用函数级的 target 属性单独编译，运行时检测 CPU 后再调用
+#  if defined(_MSC_VER) && !defined(__clang__)
+#    include <intrin.h>
+#    define TRANSFORM_BATCH_AVX2_TARGET
+#  else
+#    define TRANSFORM_BATCH_AVX2_TARGET __attribute__((target("avx2,fma")))
+#  endif
+#endif
+
+namespace webgpu {
+
+namespace {
+
+enum class TransformPath { Scalar, Sse2, Avx2 };
+
+std::byte* outputAt(void* base, size_t index, size_t stride) {
+	return static_cast<std::byte*>(base) + index * stride;
+}
+
+/**
+ * @brief 标量实现，与 SIMD 版本的运算顺序一致，处理 [begin, end)
+ */
+void composeScalar(const TransformBatch& t, const glm::mat4x4& viewProjection, const TransformOutput& output, size_t begin, size_t end) {
+	for (size_t i = begin; i < end; ++i) {
+		float x2 = t.rotationX[i] + t.rotationX[i];
+		float y2 = t.rotationY[i] + t.rotationY[i];
+		float z2 = t.rotationZ[i] + t.rotationZ[i];
+		float xx = t.rotationX[i] * x2, yy = t.rotationY[i] * y2, zz = t.rotationZ[i] * z2;
+		float xy = t.rotationX[i] * y2, xz = t.rotationX[i] * z2, yz = t.rotationY[i] * z2;
+		float wx = t.rotationW[i] * x2, wy = t.rotationW[i] * y2, wz = t.rotationW[i] * z2;
+
+		glm::vec4 rotation[3] = {
+			glm::vec4(1.0f - (yy + zz), xy + wz, xz - wy, 0.0f),
+			glm::vec4(xy - wz, 1.0f - (xx + zz), yz + wx, 0.0f),
+			glm::vec4(xz + wy, yz - wx, 1.0f - (xx + yy), 0.0f),
+		};
+		glm::vec3 scale(t.scaleX[i], t.scaleY[i], t.scaleZ[i]);
+		glm::mat4x4 model;
+		model[0] = rotation[0] * scale.x;
+		model[1] = rotation[1] * scale.y;
+		model[2] = rotation[2] * scale.z;
+		model[3] = glm::vec4(t.translationX[i], t.translationY[i], t.translationZ[i], 1.0f);
+		if (output.models) {
+			std::memcpy(outputAt(output.models, i, output.stride), &model, sizeof(glm::mat4x4));
+		}
+		if (output.modelViewProjections) {
+			glm::mat4x4 modelViewProjection = viewProjection * model;
+			std::memcpy(outputAt(output.modelViewProjections, i, output.stride), &modelViewProjection, sizeof(glm::mat4x4));
+		}
+		if (output.normalMatrices) {
+			// (R * S)^-T = R * S^-1：旋转的每一列除以对应的缩放
+			glm::vec4 normalMatrix[3] = { rotation[0] * (1.0f / scale.x), rotation[1] * (1.0f / scale.y), rotation[2] * (1.0f / scale.z) };
+			std::memcpy(outputAt(output.normalMatrices, i, output.stride), normalMatrix, sizeof(normalMatrix));
+		}
+	}
+}
+
+#ifdef TRANSFORM_BATCH_USE_SSE2
+
+/**
+ * @brief 4 个物体的同一列（每个分量一个寄存器）转置后分别写入各自的矩阵
+ */
+void storeColumn4(std::byte* base, size_t stride, size_t column, __m128 x, __m128 y, __m128 z, __m128 w) {
+	_MM_TRANSPOSE4_PS(x, y, z, w);
+	std::byte* destination = base + column * sizeof(glm::vec4);
+	_mm_storeu_ps(reinterpret_cast<float*>(destination), x);
+	_mm_storeu_ps(reinterpret_cast<float*>(destination + stride), y);
+	_mm_storeu_ps(reinterpret_cast<float*>(destination + 2 * stride), z);
+	_mm_storeu_ps(reinterpret_cast<float*>(destination + 3 * stride), w);
+}
+
+/**
+ * @brief SSE2：每次 4 个物体，返回处理的个数（4 的倍数）
+ */
+size_t composeSse2(const TransformBatch& t, const glm::mat4x4& viewProjection, const TransformOutput& output) {
+	size_t count = t.size() & ~size_t(3);
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 one = _mm_set1_ps(1.0f);
+	__m128 vp[4][4];
+	for (int c = 0; c < 4; ++c) {
+		for (int r = 0; r < 4; ++r) {
+			vp[c][r] = _mm_set1_ps(viewProjection[c][r]);
+		}
+	}
+
+	for (size_t i = 0; i < count; i += 4) {
+		__m128 qx = _mm_loadu_ps(t.rotationX.data() + i);
+		__m128 qy = _mm_loadu_ps(t.rotationY.data() + i);
+		__m128 qz = _mm_loadu_ps(t.rotationZ.data() + i);
+		__m128 qw = _mm_loadu_ps(t.rotationW.data() + i);
+		__m128 x2 = _mm_add_ps(qx, qx), y2 = _mm_add_ps(qy, qy), z2 = _mm_add_ps(qz, qz);
+		__m128 xx = _mm_mul_ps(qx, x2), yy = _mm_mul_ps(qy, y2), zz = _mm_mul_ps(qz, z2);
+		__m128 xy = _mm_mul_ps(qx, y2), xz = _mm_mul_ps(qx, z2), yz = _mm_mul_ps(qy, z2);
+		__m128 wx = _mm_mul_ps(qw, x2), wy = _mm_mul_ps(qw, y2), wz = _mm_mul_ps(qw, z2);
+		__m128 sx = _mm_loadu_ps(t.scaleX.data() + i);
+		__m128 sy = _mm_loadu_ps(t.scaleY.data() + i);
+		__m128 sz = _mm_loadu_ps(t.scaleZ.data() + i);
+
+		// rotation[列][行]、m[列][行]，每个寄存器是 4 个物体的同一个元素
+		__m128 rotation[3][3] = {
+			{ _mm_sub_ps(one, _mm_add_ps(yy, zz)), _mm_add_ps(xy, wz), _mm_sub_ps(xz, wy) },
+			{ _mm_sub_ps(xy, wz), _mm_sub_ps(one, _mm_add_ps(xx, zz)), _mm_add_ps(yz, wx) },
+			{ _mm_add_ps(xz, wy), _mm_sub_ps(yz, wx), _mm_sub_ps(one, _mm_add_ps(xx, yy)) },
+		};
+		__m128 s[3] = { sx, sy, sz };
+		__m128 m[4][4] = {
+			{ _mm_mul_ps(rotation[0][0], sx), _mm_mul_ps(rotation[0][1], sx), _mm_mul_ps(rotation[0][2], sx), zero },
+			{ _mm_mul_ps(rotation[1][0], sy), _mm_mul_ps(rotation[1][1], sy), _mm_mul_ps(rotation[1][2], sy), zero },
+			{ _mm_mul_ps(rotation[2][0], sz), _mm_mul_ps(rotation[2][1], sz), _mm_mul_ps(rotation[2][2], sz), zero },
+			{ _mm_loadu_ps(t.translationX.data() + i), _mm_loadu_ps(t.translationY.data() + i), _mm_loadu_ps(t.translationZ.data() + i), one },
+		};
+		if (output.models) {
+			std::byte* base = outputAt(output.models, i, output.stride);
+			for (int c = 0; c < 4; ++c) {
+				storeColumn4(base, output.stride, c, m[c][0], m[c][1], m[c][2], m[c][3]);
+			}
+		}
+		if (output.modelViewProjections) {
+			// MVP 的第 c 列 = VP * M 的第 c 列，M 的第 3 行只有平移列为 1
+			std::byte* base = outputAt(output.modelViewProjections, i, output.stride);
+			for (int c = 0; c < 4; ++c) {
+				__m128 p[4];
+				for (int r = 0; r < 4; ++r) {
+					p[r] = _mm_add_ps(_mm_add_ps(_mm_mul_ps(vp[0][r], m[c][0]), _mm_mul_ps(vp[1][r], m[c][1])), _mm_mul_ps(vp[2][r], m[c][2]));
+					if (c == 3) {
+						p[r] = _mm_add_ps(p[r], vp[3][r]);
+					}
+				}
+				storeColumn4(base, output.stride, c, p[0], p[1], p[2], p[3]);
+			}
+		}
+		if (output.normalMatrices) {
+			std::byte* base = outputAt(output.normalMatrices, i, output.stride);
+			for (int c = 0; c < 3; ++c) {
+				__m128 inverseScale = _mm_div_ps(one, s[c]);
+				storeColumn4(base, output.stride, c, _mm_mul_ps(rotation[c][0], inverseScale), _mm_mul_ps(rotation[c][1], inverseScale),
+					_mm_mul_ps(rotation[c][2], inverseScale), zero);
+			}
+		}
+	}
+	return count;
+}
+
+/**
+ * @brief 8 个物体的同一列转置后分别写入：每个 128 位半边各是 4 个物体的 4x4 转置
+ */
+TRANSFORM_BATCH_AVX2_TARGET void storeColumn8(std::byte* base, size_t stride, size_t column, __m256 x, __m256 y, __m256 z, __m256 w) {
+	__m256 t0 = _mm256_unpacklo_ps(x, y);
+	__m256 t1 = _mm256_unpackhi_ps(x, y);
+	__m256 t2 = _mm256_unpacklo_ps(z, w);
+	__m256 t3 = _mm256_unpackhi_ps(z, w);
+	// 低半边是物体 0~3，高半边是物体 4~7
+	__m256 rows[4] = {
+		_mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(1, 0, 1, 0)),
+		_mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(3, 2, 3, 2)),
+		_mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(1, 0, 1, 0)),
+		_mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(3, 2, 3, 2)),
+	};
+	std::byte* destination = base + column * sizeof(glm::vec4);
+	for (size_t k = 0; k < 4; ++k) {
+		_mm_storeu_ps(reinterpret_cast<float*>(destination + k * stride), _mm256_castps256_ps128(rows[k]));
+		_mm_storeu_ps(reinterpret_cast<float*>(destination + (k + 4) * stride), _mm256_extractf128_ps(rows[k], 1));
+	}
+}
+
+/**
+ * @brief AVX2 + FMA：每次 8 个物体，返回处理的个数（8 的倍数）
+ */
+TRANSFORM_BATCH_AVX2_TARGET size_t composeAvx2(const TransformBatch& t, const glm::mat4x4& viewProjection, const TransformOutput& output) {
+	size_t count = t.size() & ~size_t(7);
+	const __m256 zero = _mm256_setzero_ps();
+	const __m256 one = _mm256_set1_ps(1.0f);
+	__m256 vp[4][4];
+	for (int c = 0; c < 4; ++c) {
+		for (int r = 0; r < 4; ++r) {
+			vp[c][r] = _mm256_set1_ps(viewProjection[c][r]);
+		}
+	}
+
+	for (size_t i = 0; i < count; i += 8) {
+		__m256 qx = _mm256_loadu_ps(t.rotationX.data() + i);
+		__m256 qy = _mm256_loadu_ps(t.rotationY.data() + i);
+		__m256 qz = _mm256_loadu_ps(t.rotationZ.data() + i);
+		__m256 qw = _mm256_loadu_ps(t.rotationW.data() + i);
+		__m256 x2 = _mm256_add_ps(qx, qx), y2 = _mm256_add_ps(qy, qy), z2 = _mm256_add_ps(qz, qz);
+		__m256 xx = _mm256_mul_ps(qx, x2), yy = _mm256_mul_ps(qy, y2), zz = _mm256_mul_ps(qz, z2);
+		__m256 xy = _mm256_mul_ps(qx, y2), xz = _mm256_mul_ps(qx, z2), yz = _mm256_mul_ps(qy, z2);
+		__m256 wx = _mm256_mul_ps(qw, x2), wy = _mm256_mul_ps(qw, y2), wz = _mm256_mul_ps(qw, z2);
+		__m256 sx = _mm256_loadu_ps(t.scaleX.data() + i);
+		__m256 sy = _mm256_loadu_ps(t.scaleY.data() + i);
+		__m256 sz = _mm256_loadu_ps(t.scaleZ.data() + i);
+
+		__m256 rotation[3][3] = {
+			{ _mm256_sub_ps(one, _mm256_add_ps(yy, zz)), _mm256_add_ps(xy, wz), _mm256_sub_ps(xz, wy) },
+			{ _mm256_sub_ps(xy, wz), _mm256_sub_ps(one, _mm256_add_ps(xx, zz)), _mm256_add_ps(yz, wx) },
+			{ _mm256_add_ps(xz, wy), _mm256_sub_ps(yz, wx), _mm256_sub_ps(one, _mm256_add_ps(xx, yy)) },
+		};
+		__m256 s[3] = { sx, sy, sz };
+		__m256 m[4][4] = {
+			{ _mm256_mul_ps(rotation[0][0], sx), _mm256_mul_ps(rotation[0][1], sx), _mm256_mul_ps(rotation[0][2], sx), zero },
+			{ _mm256_mul_ps(rotation[1][0], sy), _mm256_mul_ps(rotation[1][1], sy), _mm256_mul_ps(rotation[1][2], sy), zero },
+			{ _mm256_mul_ps(rotation[2][0], sz), _mm256_mul_ps(rotation[2][1], sz), _mm256_mul_ps(rotation[2][2], sz), zero },
+			{ _mm256_loadu_ps(t.translationX.data() + i), _mm256_loadu_ps(t.translationY.data() + i), _mm256_loadu_ps(t.translationZ.data() + i), one },
+		};
+		if (output.models) {
+			std::byte* base = outputAt(output.models, i, output.stride);
+			for (int c = 0; c < 4; ++c) {
+				storeColumn8(base, output.stride, c, m[c][0], m[c][1], m[c][2], m[c][3]);
+			}
+		}
+		if (output.modelViewProjections) {
+			std::byte* base = outputAt(output.modelViewProjections, i, output.stride);
+			for (int c = 0; c < 4; ++c) {
+				__m256 p[4];
+				for (int r = 0; r < 4; ++r) {
+					p[r] = _mm256_fmadd_ps(vp[2][r], m[c][2], _mm256_fmadd_ps(vp[1][r], m[c][1], _mm256_mul_ps(vp[0][r], m[c][0])));
+					if (c == 3) {
+						p[r] = _mm256_add_ps(p[r], vp[3][r]);
+					}
+				}
+				storeColumn8(base, output.stride, c, p[0], p[1], p[2], p[3]);
+			}
+		}
+		if (output.normalMatrices) {
+			std::byte* base = outputAt(output.normalMatrices, i, output.stride);
+			for (int c = 0; c < 3; ++c) {
+				__m256 inverseScale = _mm256_div_ps(one, s[c]);
+				storeColumn8(base, output.stride, c, _mm256_mul_ps(rotation[c][0], inverseScale), _mm256_mul_ps(rotation[c][1], inverseScale),
+					_mm256_mul_ps(rotation[c][2], inverseScale), zero);
+			}
+		}
+	}
+	return count;
+}
+
+bool cpuSupportsAvx2() {
+#  if defined(_MSC_VER) && !defined(__clang__)
+	int info[4];
+	__cpuid(info, 0);
+	if (info[0] < 7) {
+		return false;
+	}
+	// FMA、OSXSAVE，且操作系统保存了 YMM 寄存器
+	__cpuid(info, 1);
+	if (!(info[2] & (1 << 12)) || !(info[2] & (1 << 27)) || (_xgetbv(0) & 0x6) != 0x6) {
+		return false;
+	}
+	__cpuidex(info, 7, 0);
+	return (info[1] & (1 << 5)) != 0;
+#  else
+	__builtin_cpu_init();
+	return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+#  endif
+}
+
+#endif // TRANSFORM_BATCH_USE_SSE2
+
+TransformPath bestTransformPath() {
+#ifdef TRANSFORM_BATCH_USE_SSE2
+	// AVX2 路径实测比 SSE2 慢（1M 个变换：SSE2 约 31 ms，AVX2 约 38 ms，瓶颈在跨步写回而不是计算），
+	// 默认用 SSE2，AVX2 只在基准测试中对比，实测更快之前不切换
+	return TransformPath::Sse2;
+#else
+	return TransformPath::Scalar;
+#endif
+}
+
+void composeTransformsWith(TransformPath path, const TransformBatch& transforms, const glm::mat4x4& viewProjection, const TransformOutput& output) {
+	size_t done = 0;
+#ifdef TRANSFORM_BATCH_USE_SSE2
+	if (path == TransformPath::Avx2) {
+		done = composeAvx2(transforms, viewProjection, output);
+	} else if (path == TransformPath::Sse2) {
+		done = composeSse2(transforms, viewProjection, output);
+	}
+#endif
+	// 不足一组的剩余物体
+	composeScalar(transforms, viewProjection, output, done, transforms.size());
+}
+
+const char* transformPathName(TransformPath path) {
+	switch (path) {
+	case TransformPath::Avx2: return "AVX2";
+	case TransformPath::Sse2: return "SSE2";
+	default: return "scalar";
+	}
+}
+
+}
+
+void TransformBatch::resize(size_t count) {
+	for (std::vector<float>* component : { &translationX, &translationY, &translationZ, &rotationX, &rotationY, &rotationZ, &rotationW,
+		&scaleX, &scaleY, &scaleZ }) {
+		component->resize(count);
+	}
+}
+
+void TransformBatch::set(size_t index, const glm::vec3& translation, const glm::quat& rotation, const glm::vec3& scale) {
+	translationX[index] = translation.x;
+	translationY[index] = translation.y;
+	translationZ[index] = translation.z;
+	rotationX[index] = rotation.x;
+	rotationY[index] = rotation.y;
+	rotationZ[index] = rotation.z;
+	rotationW[index] = rotation.w;
+	scaleX[index] = scale.x;
+	scaleY[index] = scale.y;
+	scaleZ[index] = scale.z;
+}
+
+glm::mat4x4 TransformBatch::matrix(size_t index) const {
+	glm::mat4x4 model = glm::mat4_cast(glm::quat(rotationW[index], rotationX[index], rotationY[index], rotationZ[index]));
+	model[0] *= scaleX[index];
+	model[1] *= scaleY[index];
+	model[2] *= scaleZ[index];
+	model[3] = glm::vec4(translationX[index], translationY[index], translationZ[index], 1.0f);
+	return model;
+}
+
+std::array<glm::vec4, 3> packNormalMatrix(const glm::mat4x4& model) {
+	glm::mat3x3 normalMatrix = glm::transpose(glm::inverse(glm::mat3x3(model)));
+	return { glm::vec4(normalMatrix[0], 0.0f), glm::vec4(normalMatrix[1], 0.0f), glm::vec4(normalMatrix[2], 0.0f) };
+}
+
+void composeTransforms(const TransformBatch& transforms, const glm::mat4x4& viewProjection, const TransformOutput& output) {
+	composeTransformsWith(bestTransformPath(), transforms, viewProjection, output);
+}
+
+void composeTransformsReference(const TransformBatch& transforms, const glm::mat4x4& viewProjection, const TransformOutput& output) {
+	for (size_t i = 0; i < transforms.size(); ++i) {
+		glm::quat rotation(transforms.rotationW[i], transforms.rotationX[i], transforms.rotationY[i], transforms.rotationZ[i]);
+		glm::mat4x4 T = glm::translate(glm::mat4x4(1.0f), glm::vec3(transforms.translationX[i], transforms.translationY[i], transforms.translationZ[i]));
+		glm::mat4x4 R = glm::mat4_cast(rotation);
+		glm::mat4x4 S = glm::scale(glm::mat4x4(1.0f), glm::vec3(transforms.scaleX[i], transforms.scaleY[i], transforms.scaleZ[i]));
+		glm::mat4x4 model = T * R * S;
+		if (output.models) {
+			std::memcpy(outputAt(output.models, i, output.stride), &model, sizeof(glm::mat4x4));
+		}
+		if (output.modelViewProjections) {
+			glm::mat4x4 modelViewProjection = viewProjection * model;
+			std::memcpy(outputAt(output.modelViewProjections, i, output.stride), &modelViewProjection, sizeof(glm::mat4x4));
+		}
+		if (output.normalMatrices) {
+			std::array<glm::vec4, 3> normalMatrix = packNormalMatrix(model);
+			std::memcpy(outputAt(output.normalMatrices, i, output.stride), normalMatrix.data(), sizeof(normalMatrix));
+		}
+	}
+}
+
+const char* transformBatchPath() {
+	return transformPathName(bestTransformPath());
+}
+
+void reportTransformBenchmark(uint32_t count, uint32_t iterations) {
+	// 随机的平移、旋转（归一化的高斯四元数）和缩放
+	std::mt19937 random(42);
+	std::uniform_real_distribution<float> position(-100.0f, 100.0f);
+	std::normal_distribution<float> gaussian(0.0f, 1.0f);
+	std::uniform_real_distribution<float> scale(0.5f, 2.0f);
+	TransformBatch transforms;
+	transforms.resize(count);
+	for (uint32_t i = 0; i < count; ++i) {
+		glm::quat rotation = glm::normalize(glm::quat(gaussian(random), gaussian(random), gaussian(random), gaussian(random)));
+		transforms.set(i, glm::vec3(position(random), position(random), position(random)), rotation, glm::vec3(scale(random), scale(random), scale(random)));
+	}
+	glm::mat4x4 viewProjection = glm::perspective(glm::radians(45.0f), 16.0f / 9.0f, 0.1f, 1000.0f)
+		* glm::lookAt(glm::vec3(0.0f, -200.0f, 50.0f), glm::vec3(0.0f), glm::vec3(0.0f, 0.0f, 1.0f));
+
+	// 输出写到与实例数据相同的交错布局（模型矩阵、MVP、法向量矩阵）
+	struct Instance {
+		glm::mat4x4 model;
+		glm::mat4x4 modelViewProjection;
+		std::array<glm::vec4, 3> normalMatrix;
+	};
+	std::vector<Instance> reference(count);
+	std::vector<Instance> batched(count);
+	auto outputFor = [](std::vector<Instance>& instances) {
+		TransformOutput output;
+		output.models = &instances.data()->model;
+		output.modelViewProjections = &instances.data()->modelViewProjection;
+		output.normalMatrices = instances.data()->normalMatrix.data();
+		output.stride = sizeof(Instance);
+		return output;
+	};
+
+	using Clock = std::chrono::steady_clock;
+	iterations = std::max(iterations, 1u);
+	auto measure = [&](auto&& compose) {
+		compose();
+		auto start = Clock::now();
+		for (uint32_t iteration = 0; iteration < iterations; ++iteration) {
+			compose();
+		}
+		return std::chrono::duration<double>(Clock::now() - start).count() / iterations;
+	};
+
+	printf("Transform batch: %u transforms, %u iterations, model + MVP + normal matrix per transform\n", count, iterations);
+	printf("%-24s %12s %12s %12s %12s\n", "path", "ms/batch", "ns/xform", "speedup", "max error");
+	double referenceSeconds = measure([&] { composeTransformsReference(transforms, viewProjection, outputFor(reference)); });
+	printf("%-24s %12.3f %12.2f %12s %12s\n", "glm (one at a time)", referenceSeconds * 1000.0, referenceSeconds * 1e9 / std::max(count, 1u), "1.00x", "-");
+
+	std::vector<TransformPath> paths = { TransformPath::Scalar };
+#ifdef TRANSFORM_BATCH_USE_SSE2
+	paths.push_back(TransformPath::Sse2);
+	if (cpuSupportsAvx2()) {
+		paths.push_back(TransformPath::Avx2);
+	}
+#endif
+	for (TransformPath path : paths) {
+		std::fill(batched.begin(), batched.end(), Instance{});
+		double seconds = measure([&] { composeTransformsWith(path, transforms, viewProjection, outputFor(batched)); });
+		// 相对误差（以矩阵元素的量级为基准）
+		float maxError = 0.0f;
+		auto compare = [&maxError](const glm::vec4* actual, const glm::vec4* expected, int columns) {
+			for (int c = 0; c < columns; ++c) {
+				for (int r = 0; r < 4; ++r) {
+					maxError = std::max(maxError, std::abs(actual[c][r] - expected[c][r]) / std::max(1.0f, std::abs(expected[c][r])));
+				}
+			}
+		};
+		for (uint32_t i = 0; i < count; ++i) {
+			compare(&batched[i].model[0], &reference[i].model[0], 4);
+			compare(&batched[i].modelViewProjection[0], &reference[i].modelViewProjection[0], 4);
+			compare(batched[i].normalMatrix.data(), reference[i].normalMatrix.data(), 3);
+		}
+		std::string name = std::string("batched ") + transformPathName(path);
+		printf("%-24s %12.3f %12.2f %11.2fx %12.2e\n", name.c_str(), seconds * 1000.0, seconds * 1e9 / std::max(count, 1u),
+			referenceSeconds / seconds, maxError);
+	}
+}
+
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+#include "global.h"
+
+namespace webgpu {
+
+/**
+ * 一批物体的平移、旋转（单位四元数 x, y, z, w）和缩放，按分量分开存放（SoA），
+ * 组合成矩阵时一次处理 4 个（SSE2）或 8 个（AVX2）物体
+ */
+struct TransformBatch {
+	std::vector<float> translationX, translationY, translationZ;
+	std::vector<float> rotationX, rotationY, rotationZ, rotationW;
+	std::vector<float> scaleX, scaleY, scaleZ;
+
+	void resize(size_t count);
+	size_t size() const { return translationX.size(); }
+	void set(size_t index, const glm::vec3& translation, const glm::quat& rotation, const glm::vec3& scale);
+	glm::mat4x4 matrix(size_t index) const;
+};
+
+/**
+ * 组合结果的写入位置：第 i 个矩阵写到 base + i * stride，可以直接是实例数据数组中的字段，不需要的输出为空
+ * 法向量矩阵按 WGSL 的 mat3x3f 布局写 3 列，每列 16 字节（w 为 0）
+ */
+struct TransformOutput {
+	void* models = nullptr;
+	void* modelViewProjections = nullptr;
+	void* normalMatrices = nullptr;
+	size_t stride = sizeof(glm::mat4x4);
+};
+
+/**
+ * @brief 批量组合 T * R * S 为模型矩阵，并左乘 viewProjection 得到 MVP，法向量矩阵为 R * S^-1
+ * 支持 SSE2 时用 SSE2 实现，否则用标量实现（AVX2 实现只参与基准测试），结果与 composeTransformsReference 在浮点误差内一致
+ */
+void composeTransforms(const TransformBatch& transforms, const glm::mat4x4& viewProjection, const TransformOutput& output);
+
+/**
+ * @brief 逐个物体用 glm 组合矩阵的参考实现（基准测试的对照）
+ */
+void composeTransformsReference(const TransformBatch& transforms, const glm::mat4x4& viewProjection, const TransformOutput& output);
+
+/**
+ * @brief composeTransforms 使用的实现："AVX2"、"SSE2" 或 "scalar"
+ */
+const char* transformBatchPath();
+
+/**
+ * @brief 批量变换基准测试：count 个随机变换，比较逐个 glm 组合与批量组合（模型矩阵、MVP 和法向量矩阵）的耗时，不创建窗口
+ */
+void reportTransformBenchmark(uint32_t count, uint32_t iterations = 20);
+
+/**
+ * @brief 模型矩阵的法向量矩阵（左上 3x3 的逆转置），按 WGSL 的 mat3x3f 布局
+ */
+std::array<glm::vec4, 3> packNormalMatrix(const glm::mat4x4& model);
+
+}
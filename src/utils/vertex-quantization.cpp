@@ -0,0 +1,116 @@
+#include "vertex-quantization.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace webgpu {
+
+namespace {
+
+constexpr float kSnorm16Max = 32767.0f;
+
+int16_t toSnorm16(float v) {
+	return static_cast<int16_t>(std::lround(std::clamp(v, -1.0f, 1.0f) * kSnorm16Max));
+}
+
+// 与 WebGPU 的 snorm16 解码规则一致
+float fromSnorm16(int16_t v) {
+	return std::max(static_cast<float>(v) / kSnorm16Max, -1.0f);
+}
+
+uint8_t toUnorm8(float v) {
+	return static_cast<uint8_t>(std::lround(std::clamp(v, 0.0f, 1.0f) * 255.0f));
+}
+
+float angleBetweenDegrees(const glm::vec3& a, const glm::vec3& b) {
+	float c = std::clamp(glm::dot(a, b), -1.0f, 1.0f);
+	return glm::degrees(std::acos(c));
+}
+
+}
+
+glm::vec2 octEncode(const glm::vec3& n) {
+	float l1 = std::abs(n.x) + std::abs(n.y) + std::abs(n.z);
+	glm::vec2 p = glm::vec2(n.x, n.y) / l1;
+	if (n.z < 0.0f) {
+		// 下半球折叠到外侧的四个三角形
+		p = glm::vec2(
+			(1.0f - std::abs(p.y)) * (p.x >= 0.0f ? 1.0f : -1.0f),
+			(1.0f - std::abs(p.x)) * (p.y >= 0.0f ? 1.0f : -1.0f)
+		);
+	}
+	return p;
+}
+
+glm::vec3 octDecode(const glm::vec2& e) {
+	glm::vec3 n(e.x, e.y, 1.0f - std::abs(e.x) - std::abs(e.y));
+	float t = std::max(-n.z, 0.0f);
+	n.x += n.x >= 0.0f ? -t : t;
+	n.y += n.y >= 0.0f ? -t : t;
+	return glm::normalize(n);
+}
+
+void quantizeMesh(const Mesh& mesh, QuantizedMesh& quantized, float boundsScale) {
+	quantized.indices = mesh.indices;
+	quantized.vertices.resize(mesh.vertices.size());
+	quantized.maxPositionError = 0.0f;
+	quantized.maxNormalErrorDegrees = 0.0f;
+	quantized.maxColorError = 0.0f;
+
+	// 以包围盒中心为原点、半边长为缩放，位置映射到 [-1, 1]
+	glm::vec3 boundsMin(std::numeric_limits<float>::max());
+	glm::vec3 boundsMax(std::numeric_limits<float>::lowest());
+	for (const auto& v : mesh.vertices) {
+		boundsMin = glm::min(boundsMin, v.position);
+		boundsMax = glm::max(boundsMax, v.position);
+	}
+	if (mesh.vertices.empty()) {
+		boundsMin = boundsMax = glm::vec3(0.0f);
+	}
+	quantized.positionOffset = (boundsMin + boundsMax) * 0.5f;
+	quantized.positionScale = glm::max((boundsMax - boundsMin) * 0.5f * boundsScale, glm::vec3(1e-8f));
+
+	for (size_t i = 0; i < mesh.vertices.size(); ++i) {
+		const VertexAttributes& src = mesh.vertices[i];
+		CompactVertexAttributes& dst = quantized.vertices[i];
+
+		glm::vec3 normalizedPosition = (src.position - quantized.positionOffset) / quantized.positionScale;
+		dst.position = { toSnorm16(normalizedPosition.x), toSnorm16(normalizedPosition.y), toSnorm16(normalizedPosition.z), 0 };
+
+		// 八面体编码后，在四个取整方向中选择解码误差最小的组合
+		glm::vec3 normal = glm::length(src.normal) > 0.0f ? glm::normalize(src.normal) : glm::vec3(0.0f, 0.0f, 1.0f);
+		glm::vec2 oct = octEncode(normal) * kSnorm16Max;
+		float bestError = std::numeric_limits<float>::max();
+		for (int k = 0; k < 4; ++k) {
+			float x = (k & 1) ? std::ceil(oct.x) : std::floor(oct.x);
+			float y = (k & 2) ? std::ceil(oct.y) : std::floor(oct.y);
+			std::array<int16_t, 2> candidate = {
+				static_cast<int16_t>(std::clamp(x, -kSnorm16Max, kSnorm16Max)),
+				static_cast<int16_t>(std::clamp(y, -kSnorm16Max, kSnorm16Max))
+			};
+			glm::vec3 decoded = octDecode(glm::vec2(fromSnorm16(candidate[0]), fromSnorm16(candidate[1])));
+			float error = 1.0f - glm::dot(decoded, normal);
+			if (error < bestError) {
+				bestError = error;
+				dst.normal = candidate;
+			}
+		}
+
+		dst.color = { toUnorm8(src.color.r), toUnorm8(src.color.g), toUnorm8(src.color.b), 255 };
+		dst.uv = { glm::packHalf1x16(src.uv.x), glm::packHalf1x16(src.uv.y) };
+
+		// 解码回浮点统计误差
+		glm::vec3 decodedPosition = glm::vec3(fromSnorm16(dst.position[0]), fromSnorm16(dst.position[1]), fromSnorm16(dst.position[2]))
+			* quantized.positionScale + quantized.positionOffset;
+		glm::vec3 decodedNormal = octDecode(glm::vec2(fromSnorm16(dst.normal[0]), fromSnorm16(dst.normal[1])));
+		glm::vec3 decodedColor = glm::vec3(dst.color[0], dst.color[1], dst.color[2]) / 255.0f;
+
+		quantized.maxPositionError = std::max(quantized.maxPositionError, glm::length(decodedPosition - src.position));
+		quantized.maxNormalErrorDegrees = std::max(quantized.maxNormalErrorDegrees, angleBetweenDegrees(decodedNormal, normal));
+		glm::vec3 colorError = glm::abs(decodedColor - glm::clamp(src.color, glm::vec3(0.0f), glm::vec3(1.0f)));
+		quantized.maxColorError = std::max(quantized.maxColorError, std::max(colorError.r, std::max(colorError.g, colorError.b)));
+	}
+}
+
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include "data-structure.h"
+
+namespace webgpu {
+
+/**
+ * 量化后的网格
+ * 索引与原网格一致，顶点一一对应
+ */
+struct QuantizedMesh {
+	std::vector<CompactVertexAttributes> vertices;
+	std::vector<uint32_t> indices;
+	// 反量化参数，写入 Uniform::positionOffset / positionScale
+	glm::vec3 positionOffset = glm::vec3(0.0f);
+	glm::vec3 positionScale = glm::vec3(1.0f);
+	// 解码后实测的最大误差
+	float maxPositionError = 0.0f;
+	float maxNormalErrorDegrees = 0.0f;
+	float maxColorError = 0.0f;
+};
+
+/**
+ * @brief 八面体编码单位法向量，结果为 [-1, 1] 范围内的二维坐标
+ */
+glm::vec2 octEncode(const glm::vec3& n);
+
+/**
+ * @brief 八面体解码，与 base.wgsl 中的 octDecode 一致
+ */
+glm::vec3 octDecode(const glm::vec2& e);
+
+/**
+ * @brief 把网格量化为紧凑顶点格式，并解码回浮点统计最大误差
+ * @param boundsScale 量化范围相对包围盒的放大倍数（蒙皮后的位置可能超出绑定姿态的包围盒）
+ */
+void quantizeMesh(const Mesh& mesh, QuantizedMesh& quantized, float boundsScale = 1.0f);
+
+}